@@ -13,12 +13,15 @@
 // - Zero backwards/forwards compatibility
 // - Serialization code for anything complex has to be manually written.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
 #include <deque>
+#include <functional>
 #include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <type_traits>
@@ -36,6 +39,100 @@
 template <typename T>
 constexpr bool IsTriviallyCopyable = std::is_trivially_copyable<std::remove_volatile_t<T>>::value;
 
+// A write buffer that grows in chunks. PointerWrap can write into it in a single pass, since
+// nothing has to be known about the final size up front and nothing that has been written is
+// ever moved. Each new chunk is a multiple of the first chunk's size, and at least as large as
+// everything before it or the write that needs it, so that big arrays are copied in one piece.
+// Clearing the buffer keeps the chunks, so that reusing it doesn't allocate.
+class ChunkedWriteBuffer
+{
+public:
+  static constexpr size_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+
+  explicit ChunkedWriteBuffer(size_t first_chunk_size = DEFAULT_CHUNK_SIZE)
+      : m_first_chunk_size(first_chunk_size)
+  {
+  }
+
+  DOLPHIN_FORCE_INLINE void Write(const void* data, size_t size)
+  {
+    if (m_write_ptr && size <= static_cast<size_t>(m_chunk_end - m_write_ptr))
+    {
+      memcpy(m_write_ptr, data, size);
+      m_write_ptr += size;
+      m_size += size;
+      return;
+    }
+    WriteSlow(static_cast<const u8*>(data), size);
+  }
+
+  void Clear()
+  {
+    m_size = 0;
+    m_used_chunks = 0;
+    m_write_ptr = nullptr;
+    m_chunk_end = nullptr;
+  }
+
+  size_t GetSize() const { return m_size; }
+  size_t GetChunkCount() const { return m_used_chunks; }
+  const u8* GetChunk(size_t index) const { return m_chunks[index].data.get(); }
+  // Every chunk except the last one is full.
+  size_t GetChunkDataSize(size_t index) const
+  {
+    return std::min(m_chunks[index].size, m_size - m_chunks[index].offset);
+  }
+
+  void CopyTo(u8* out) const
+  {
+    for (size_t i = 0; i < m_used_chunks; ++i)
+      memcpy(out + m_chunks[i].offset, GetChunk(i), GetChunkDataSize(i));
+  }
+
+private:
+  struct Chunk
+  {
+    std::unique_ptr<u8[]> data;
+    size_t offset;
+    size_t size;
+  };
+
+  void WriteSlow(const u8* data, size_t size)
+  {
+    while (size != 0)
+    {
+      if (m_write_ptr == m_chunk_end)
+      {
+        if (m_used_chunks == m_chunks.size())
+        {
+          // Big enough for the rest of this write too, so that big arrays stay in one piece
+          const size_t rounded_size =
+              (size + m_first_chunk_size - 1) / m_first_chunk_size * m_first_chunk_size;
+          const size_t chunk_size = std::max({m_first_chunk_size, m_size, rounded_size});
+          m_chunks.push_back(Chunk{std::unique_ptr<u8[]>(new u8[chunk_size]), m_size, chunk_size});
+        }
+        const Chunk& chunk = m_chunks[m_used_chunks++];
+        m_write_ptr = chunk.data.get();
+        m_chunk_end = m_write_ptr + chunk.size;
+      }
+
+      const size_t write_size = std::min(size, static_cast<size_t>(m_chunk_end - m_write_ptr));
+      memcpy(m_write_ptr, data, write_size);
+      m_write_ptr += write_size;
+      m_size += write_size;
+      data += write_size;
+      size -= write_size;
+    }
+  }
+
+  std::vector<Chunk> m_chunks;
+  size_t m_first_chunk_size;
+  size_t m_size = 0;
+  size_t m_used_chunks = 0;
+  u8* m_write_ptr = nullptr;
+  u8* m_chunk_end = nullptr;
+};
+
 // Wrapper class
 class PointerWrap
 {
@@ -53,6 +150,12 @@ public:
 
 public:
   PointerWrap(u8** ptr_, Mode mode_) : ptr(ptr_), mode(mode_) {}
+  // Writes into a ChunkedWriteBuffer instead of the memory at *ptr, so that a MODE_MEASURE pass
+  // isn't needed to size the output first. *ptr still advances by the number of bytes written.
+  PointerWrap(u8** ptr_, ChunkedWriteBuffer* write_buffer)
+      : ptr(ptr_), mode(MODE_WRITE), m_write_buffer(write_buffer)
+  {
+  }
   void SetMode(Mode mode_) { mode = mode_; }
   Mode GetMode() const { return mode; }
   template <typename K, class V>
@@ -163,6 +266,23 @@ public:
     DoArray(arr, static_cast<u32>(N));
   }
 
+  // Large blocks of emulated memory (RAM, ARAM, ...) can be given to a handler instead of being
+  // copied through the buffer, so that incremental snapshots only need to store what changed.
+  // Without a handler, this is the same as DoArray.
+  using MemoryRegionHandler = std::function<void(u8* data, u32 size)>;
+  void SetMemoryRegionHandler(MemoryRegionHandler handler)
+  {
+    m_memory_region_handler = std::move(handler);
+  }
+
+  void DoMemoryRegion(u8* data, u32 size)
+  {
+    if (m_memory_region_handler)
+      m_memory_region_handler(data, size);
+    else
+      DoArray(data, size);
+  }
+
   void Do(Common::Flag& flag)
   {
     bool s = flag.IsSet();
@@ -249,6 +369,9 @@ public:
   }
 
 private:
+  ChunkedWriteBuffer* m_write_buffer = nullptr;
+  MemoryRegionHandler m_memory_region_handler;
+
   template <typename T>
   void DoContainer(T& x)
   {
@@ -264,7 +387,10 @@ private:
       break;
 
     case MODE_WRITE:
-      memcpy(*ptr, data, size);
+      if (m_write_buffer)
+        m_write_buffer->Write(data, size);
+      else
+        memcpy(*ptr, data, size);
       break;
 
     case MODE_MEASURE:
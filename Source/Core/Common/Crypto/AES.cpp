@@ -2,10 +2,22 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
 #include <mbedtls/aes.h>
 
+#include "Common/CPUDetect.h"
 #include "Common/Crypto/AES.h"
 
+#if defined(_M_X86)
+#include "Common/Intrinsics.h"
+#elif defined(_M_ARM_64) && defined(__ARM_FEATURE_CRYPTO)
+#include <arm_neon.h>
+#endif
+
 namespace Common
 {
 namespace AES
@@ -35,5 +47,235 @@ std::vector<u8> Encrypt(const u8* key, u8* iv, const u8* src, size_t size)
 {
   return DecryptEncrypt(key, iv, src, size, Mode::Encrypt);
 }
+
+namespace
+{
+constexpr size_t NUM_ROUND_KEYS = 11;
+constexpr size_t BLOCK_SIZE = 16;
+
+// The standard AES-128 encryption key schedule, one round key per 16 bytes.
+using RoundKeys = std::array<std::array<u8, BLOCK_SIZE>, NUM_ROUND_KEYS>;
+
+RoundKeys ExpandKey(const u8* key)
+{
+  // mbedtls stores the schedule as little endian words, which is the byte order of the key
+  mbedtls_aes_context ctx;
+  mbedtls_aes_init(&ctx);
+  mbedtls_aes_setkey_enc(&ctx, key, 128);
+  RoundKeys round_keys;
+  for (size_t i = 0; i < NUM_ROUND_KEYS; ++i)
+  {
+    for (size_t j = 0; j < BLOCK_SIZE; ++j)
+      round_keys[i][j] = static_cast<u8>(ctx.rk[i * 4 + j / 4] >> (j % 4 * 8));
+  }
+  mbedtls_aes_free(&ctx);
+  return round_keys;
+}
+
+class ContextGeneric final : public Context
+{
+public:
+  ContextGeneric(const u8* key, Mode mode) : m_mode(mode)
+  {
+    mbedtls_aes_init(&m_ctx);
+    if (mode == Mode::Encrypt)
+      mbedtls_aes_setkey_enc(&m_ctx, key, 128);
+    else
+      mbedtls_aes_setkey_dec(&m_ctx, key, 128);
+  }
+  ~ContextGeneric() override { mbedtls_aes_free(&m_ctx); }
+
+  void CryptCBC(const u8* iv, const u8* in, u8* out, size_t size) const override
+  {
+    u8 iv_copy[BLOCK_SIZE];
+    std::memcpy(iv_copy, iv, sizeof(iv_copy));
+    // mbedtls only reads the context, it just isn't declared const
+    mbedtls_aes_crypt_cbc(const_cast<mbedtls_aes_context*>(&m_ctx),
+                          m_mode == Mode::Encrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT,
+                          size, iv_copy, in, out);
+  }
+
+private:
+  mbedtls_aes_context m_ctx;
+  Mode m_mode;
+};
+
+#if defined(_M_X86)
+class ContextAESNI final : public Context
+{
+public:
+  FUNCTION_TARGET_AES ContextAESNI(const u8* key, Mode mode) : m_mode(mode)
+  {
+    // The equivalent inverse cipher uses the round keys in reverse order,
+    // with InvMixColumns applied to all but the first and the last one.
+    // They are reversed before loading them, as __m128i loses its attributes
+    // when it is used as a template argument (-Wignored-attributes).
+    RoundKeys round_keys = ExpandKey(key);
+    if (mode == Mode::Decrypt)
+      std::reverse(round_keys.begin(), round_keys.end());
+
+    for (size_t i = 0; i < NUM_ROUND_KEYS; ++i)
+      m_keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys[i].data()));
+
+    if (mode == Mode::Decrypt)
+    {
+      for (size_t i = 1; i < NUM_ROUND_KEYS - 1; ++i)
+        m_keys[i] = _mm_aesimc_si128(m_keys[i]);
+    }
+  }
+
+  void CryptCBC(const u8* iv, const u8* in, u8* out, size_t size) const override
+  {
+    if (m_mode == Mode::Encrypt)
+      EncryptCBC(iv, in, out, size / BLOCK_SIZE);
+    else
+      DecryptCBC(iv, in, out, size / BLOCK_SIZE);
+  }
+
+private:
+  FUNCTION_TARGET_AES void EncryptCBC(const u8* iv, const u8* in, u8* out, size_t blocks) const
+  {
+    // Every block depends on the previous one, so encryption can't be interleaved
+    __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+    for (size_t i = 0; i < blocks; ++i)
+    {
+      const __m128i plain = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i);
+      state = _mm_xor_si128(_mm_xor_si128(state, plain), m_keys[0]);
+      for (size_t round = 1; round < NUM_ROUND_KEYS - 1; ++round)
+        state = _mm_aesenc_si128(state, m_keys[round]);
+      state = _mm_aesenclast_si128(state, m_keys[NUM_ROUND_KEYS - 1]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + i, state);
+    }
+  }
+
+  FUNCTION_TARGET_AES void DecryptCBC(const u8* iv, const u8* in, u8* out, size_t blocks) const
+  {
+    // CBC decryption of each block only depends on ciphertext, so several blocks are kept
+    // in flight at once to hide the latency of AESDEC
+    constexpr size_t LANES = 8;
+
+    __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+    size_t i = 0;
+    for (; i + LANES <= blocks; i += LANES)
+    {
+      __m128i cipher[LANES];
+      __m128i state[LANES];
+      for (size_t j = 0; j < LANES; ++j)
+      {
+        cipher[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i + j);
+        state[j] = _mm_xor_si128(cipher[j], m_keys[0]);
+      }
+      for (size_t round = 1; round < NUM_ROUND_KEYS - 1; ++round)
+      {
+        for (size_t j = 0; j < LANES; ++j)
+          state[j] = _mm_aesdec_si128(state[j], m_keys[round]);
+      }
+      for (size_t j = 0; j < LANES; ++j)
+      {
+        state[j] = _mm_aesdeclast_si128(state[j], m_keys[NUM_ROUND_KEYS - 1]);
+        state[j] = _mm_xor_si128(state[j], j == 0 ? previous : cipher[j - 1]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + i + j, state[j]);
+      }
+      previous = cipher[LANES - 1];
+    }
+
+    for (; i < blocks; ++i)
+    {
+      const __m128i cipher = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i);
+      __m128i state = _mm_xor_si128(cipher, m_keys[0]);
+      for (size_t round = 1; round < NUM_ROUND_KEYS - 1; ++round)
+        state = _mm_aesdec_si128(state, m_keys[round]);
+      state = _mm_aesdeclast_si128(state, m_keys[NUM_ROUND_KEYS - 1]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + i, _mm_xor_si128(state, previous));
+      previous = cipher;
+    }
+  }
+
+  __m128i m_keys[NUM_ROUND_KEYS];
+  Mode m_mode;
+};
+#endif
+
+#if defined(_M_ARM_64) && defined(__ARM_FEATURE_CRYPTO)
+class ContextNEON final : public Context
+{
+public:
+  ContextNEON(const u8* key, Mode mode) : m_mode(mode)
+  {
+    RoundKeys round_keys = ExpandKey(key);
+    if (mode == Mode::Decrypt)
+      std::reverse(round_keys.begin(), round_keys.end());
+
+    for (size_t i = 0; i < NUM_ROUND_KEYS; ++i)
+      m_keys[i] = vld1q_u8(round_keys[i].data());
+
+    if (mode == Mode::Decrypt)
+    {
+      for (size_t i = 1; i < NUM_ROUND_KEYS - 1; ++i)
+        m_keys[i] = vaesimcq_u8(m_keys[i]);
+    }
+  }
+
+  void CryptCBC(const u8* iv, const u8* in, u8* out, size_t size) const override
+  {
+    const size_t blocks = size / BLOCK_SIZE;
+    uint8x16_t previous = vld1q_u8(iv);
+
+    if (m_mode == Mode::Encrypt)
+    {
+      for (size_t i = 0; i < blocks; ++i)
+      {
+        // AESE adds the round key before SubBytes/ShiftRows, so the first key goes in there
+        uint8x16_t state = veorq_u8(previous, vld1q_u8(in + i * BLOCK_SIZE));
+        for (size_t round = 0; round < NUM_ROUND_KEYS - 2; ++round)
+          state = vaesmcq_u8(vaeseq_u8(state, m_keys[round]));
+        state = vaeseq_u8(state, m_keys[NUM_ROUND_KEYS - 2]);
+        previous = veorq_u8(state, m_keys[NUM_ROUND_KEYS - 1]);
+        vst1q_u8(out + i * BLOCK_SIZE, previous);
+      }
+      return;
+    }
+
+    for (size_t i = 0; i < blocks; ++i)
+    {
+      const uint8x16_t cipher = vld1q_u8(in + i * BLOCK_SIZE);
+      uint8x16_t state = cipher;
+      for (size_t round = 0; round < NUM_ROUND_KEYS - 2; ++round)
+        state = vaesimcq_u8(vaesdq_u8(state, m_keys[round]));
+      state = vaesdq_u8(state, m_keys[NUM_ROUND_KEYS - 2]);
+      state = veorq_u8(state, m_keys[NUM_ROUND_KEYS - 1]);
+      vst1q_u8(out + i * BLOCK_SIZE, veorq_u8(state, previous));
+      previous = cipher;
+    }
+  }
+
+private:
+  uint8x16_t m_keys[NUM_ROUND_KEYS];
+  Mode m_mode;
+};
+#endif
+
+std::unique_ptr<Context> CreateContext(const u8* key, Mode mode)
+{
+#if defined(_M_X86)
+  if (cpu_info.bAES)
+    return std::make_unique<ContextAESNI>(key, mode);
+#elif defined(_M_ARM_64) && defined(__ARM_FEATURE_CRYPTO)
+  if (cpu_info.bAES)
+    return std::make_unique<ContextNEON>(key, mode);
+#endif
+  return std::make_unique<ContextGeneric>(key, mode);
+}
+}  // namespace
+
+std::unique_ptr<Context> CreateContextEncrypt(const u8* key)
+{
+  return CreateContext(key, Mode::Encrypt);
+}
+
+std::unique_ptr<Context> CreateContextDecrypt(const u8* key)
+{
+  return CreateContext(key, Mode::Decrypt);
+}
 }  // namespace AES
 }  // namespace Common
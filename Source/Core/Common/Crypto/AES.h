@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -23,5 +24,20 @@ std::vector<u8> DecryptEncrypt(const u8* key, u8* iv, const u8* src, size_t size
 // Convenience functions
 std::vector<u8> Decrypt(const u8* key, u8* iv, const u8* src, size_t size);
 std::vector<u8> Encrypt(const u8* key, u8* iv, const u8* src, size_t size);
+
+// An expanded 128-bit key for one direction. The key schedule is computed once and never
+// modified afterwards, so a single context can be used by several threads at the same time.
+class Context
+{
+public:
+  virtual ~Context() = default;
+
+  // CBC over size bytes (a multiple of 16). The IV is not modified. in and out may be equal.
+  virtual void CryptCBC(const u8* iv, const u8* in, u8* out, size_t size) const = 0;
+};
+
+// Uses AES-NI or the ARMv8 crypto extensions when the host CPU supports them.
+std::unique_ptr<Context> CreateContextEncrypt(const u8* key);
+std::unique_ptr<Context> CreateContextDecrypt(const u8* key);
 }  // namespace AES
 }  // namespace Common
@@ -100,6 +100,8 @@ public:
   bool IsFile() const;
   // Returns the size of a file (or returns 0 if the path doesn't refer to a file)
   u64 GetSize() const;
+  // Returns the last modification time in seconds since the epoch (or 0 if the path doesn't exist)
+  u64 GetModificationTime() const;
 
 private:
   struct stat m_stat;
@@ -0,0 +1,181 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+// A hash map with integer keys that stores its elements in a single array, using open
+// addressing with linear probing. Erasing shifts the following elements back instead of
+// leaving tombstones, so lookups never get slower over time.
+//
+// Unlike std::unordered_map, looking up a key doesn't need to chase any pointers, and
+// inserting or erasing an element doesn't allocate. Pointers to the values are invalidated
+// by any insertion or erasure.
+template <typename Key, typename Value>
+class FlatHashMap final
+{
+  static_assert(std::is_integral<Key>() && std::is_unsigned<Key>(),
+                "FlatHashMap keys must be unsigned integers");
+
+public:
+  FlatHashMap() { m_slots.resize(MIN_CAPACITY); }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  // Returns nullptr if the key isn't in the map.
+  Value* Find(Key key)
+  {
+    const size_t index = FindIndex(key);
+    return index == NOT_FOUND ? nullptr : &m_slots[index].value;
+  }
+
+  const Value* Find(Key key) const
+  {
+    const size_t index = FindIndex(key);
+    return index == NOT_FOUND ? nullptr : &m_slots[index].value;
+  }
+
+  // Inserts a value-initialized element if the key isn't in the map yet.
+  Value& operator[](Key key)
+  {
+    // Keep the load factor at or below 3/4, so that probe sequences stay short.
+    if ((m_size + 1) * 4 > m_slots.size() * 3)
+      Rehash(m_slots.size() * 2);
+
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = Hash(key) & mask;; i = (i + 1) & mask)
+    {
+      Slot& slot = m_slots[i];
+      if (!slot.used)
+      {
+        slot.used = true;
+        slot.key = key;
+        slot.value = Value();
+        ++m_size;
+        return slot.value;
+      }
+      if (slot.key == key)
+        return slot.value;
+    }
+  }
+
+  // Returns whether the key was in the map.
+  bool Erase(Key key)
+  {
+    size_t hole = FindIndex(key);
+    if (hole == NOT_FOUND)
+      return false;
+
+    // Move back every following element of the cluster that would not be found anymore once
+    // the hole is left empty, i.e. whose home slot isn't cyclically in (hole, i].
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = (hole + 1) & mask; m_slots[i].used; i = (i + 1) & mask)
+    {
+      const size_t home = Hash(m_slots[i].key) & mask;
+      if (((i - home) & mask) >= ((i - hole) & mask))
+      {
+        m_slots[hole] = std::move(m_slots[i]);
+        hole = i;
+      }
+    }
+
+    m_slots[hole].used = false;
+    m_slots[hole].value = Value();
+    --m_size;
+    return true;
+  }
+
+  // Removes all elements but keeps the allocated storage.
+  void Clear()
+  {
+    for (Slot& slot : m_slots)
+    {
+      if (slot.used)
+      {
+        slot.used = false;
+        slot.value = Value();
+      }
+    }
+    m_size = 0;
+  }
+
+  // Calls f(key, value) for every element, in no particular order. f must not insert or
+  // erase elements.
+  template <typename Function>
+  void ForEach(Function f)
+  {
+    for (Slot& slot : m_slots)
+    {
+      if (slot.used)
+        f(slot.key, slot.value);
+    }
+  }
+
+  template <typename Function>
+  void ForEach(Function f) const
+  {
+    for (const Slot& slot : m_slots)
+    {
+      if (slot.used)
+        f(slot.key, slot.value);
+    }
+  }
+
+private:
+  struct Slot
+  {
+    Key key{};
+    bool used = false;
+    Value value{};
+  };
+
+  static constexpr size_t MIN_CAPACITY = 16;
+  static constexpr size_t NOT_FOUND = ~size_t(0);
+
+  static size_t Hash(Key key)
+  {
+    // Fibonacci hashing. Keys are often addresses with zeroes in their low bits,
+    // so the high bits of the product are folded into the low bits that get used.
+    const u64 product = static_cast<u64>(key) * UINT64_C(0x9E3779B97F4A7C15);
+    return static_cast<size_t>(product ^ (product >> 32));
+  }
+
+  size_t FindIndex(Key key) const
+  {
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = Hash(key) & mask;; i = (i + 1) & mask)
+    {
+      const Slot& slot = m_slots[i];
+      if (!slot.used)
+        return NOT_FOUND;
+      if (slot.key == key)
+        return i;
+    }
+  }
+
+  void Rehash(size_t capacity)
+  {
+    std::vector<Slot> old_slots(capacity);
+    m_slots.swap(old_slots);
+    m_size = 0;
+    for (Slot& slot : old_slots)
+    {
+      if (slot.used)
+        (*this)[slot.key] = std::move(slot.value);
+    }
+  }
+
+  std::vector<Slot> m_slots;
+  size_t m_size = 0;
+};
+}  // namespace Common
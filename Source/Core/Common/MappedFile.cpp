@@ -0,0 +1,150 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Common/MappedFile.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/Logging/Log.h"
+
+namespace File
+{
+MappedFile::~MappedFile()
+{
+  Unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this != &other)
+  {
+    Unmap();
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+#ifdef _WIN32
+    std::swap(m_mapping_handle, other.m_mapping_handle);
+#endif
+  }
+  return *this;
+}
+
+bool MappedFile::Map(IOFile& file)
+{
+  Unmap();
+
+  if (!file.IsOpen())
+    return false;
+
+  const u64 size = file.GetSize();
+  if (size == 0 || size > std::numeric_limits<size_t>::max())
+    return false;
+
+#ifdef _WIN32
+  const HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file.GetHandle())));
+  if (file_handle == INVALID_HANDLE_VALUE)
+    return false;
+
+  const HANDLE mapping_handle =
+      CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping_handle)
+  {
+    ERROR_LOG(COMMON, "CreateFileMapping failed: %s", GetLastErrorString().c_str());
+    return false;
+  }
+
+  void* data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+  if (!data)
+  {
+    ERROR_LOG(COMMON, "MapViewOfFile failed: %s", GetLastErrorString().c_str());
+    CloseHandle(mapping_handle);
+    return false;
+  }
+
+  m_mapping_handle = mapping_handle;
+#else
+  void* data = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED,
+                    fileno(file.GetHandle()), 0);
+  if (data == MAP_FAILED)
+  {
+    ERROR_LOG(COMMON, "mmap failed: %s", LastStrerrorString().c_str());
+    return false;
+  }
+#endif
+
+  m_data = static_cast<const u8*>(data);
+  m_size = size;
+  return true;
+}
+
+void MappedFile::Unmap()
+{
+  if (!m_data)
+    return;
+
+#ifdef _WIN32
+  UnmapViewOfFile(m_data);
+  CloseHandle(m_mapping_handle);
+  m_mapping_handle = nullptr;
+#else
+  munmap(const_cast<u8*>(m_data), static_cast<size_t>(m_size));
+#endif
+
+  m_data = nullptr;
+  m_size = 0;
+}
+
+void MappedFile::Advise(u64 offset, u64 size, AccessPattern pattern) const
+{
+#ifndef _WIN32
+  if (!m_data || offset >= m_size)
+    return;
+  size = std::min(size, m_size - offset);
+
+  // madvise wants a page aligned start address
+  static const u64 page_size = static_cast<u64>(sysconf(_SC_PAGESIZE));
+  const u64 aligned_offset = offset - offset % page_size;
+  size += offset - aligned_offset;
+
+  int advice = MADV_NORMAL;
+  switch (pattern)
+  {
+  case AccessPattern::Normal:
+    advice = MADV_NORMAL;
+    break;
+  case AccessPattern::Sequential:
+    advice = MADV_SEQUENTIAL;
+    break;
+  case AccessPattern::Random:
+    advice = MADV_RANDOM;
+    break;
+  case AccessPattern::WillNeed:
+    advice = MADV_WILLNEED;
+    break;
+  }
+
+  madvise(const_cast<u8*>(m_data) + aligned_offset, static_cast<size_t>(size), advice);
+#endif
+}
+
+}  // namespace File
@@ -0,0 +1,58 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+namespace File
+{
+class IOFile;
+
+// A read-only mapping of a whole file into the address space.
+// Reading from the mapping is served straight from the OS page cache, without a system call.
+// Note that I/O errors (or the file being truncated by someone else) are reported as
+// access violations rather than as failed reads.
+class MappedFile
+{
+public:
+  enum class AccessPattern
+  {
+    Normal,
+    Sequential,
+    Random,
+    // The range will be accessed soon, so the OS should start reading it in
+    WillNeed,
+  };
+
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  // Maps the file that is currently open in the given IOFile. The IOFile can be closed
+  // afterwards. Fails for empty files and when the address space is too small.
+  bool Map(IOFile& file);
+  void Unmap();
+
+  bool IsMapped() const { return m_data != nullptr; }
+  const u8* GetData() const { return m_data; }
+  u64 GetSize() const { return m_size; }
+
+  // A hint to the OS. Does nothing on systems that have no equivalent.
+  void Advise(u64 offset, u64 size, AccessPattern pattern) const;
+
+private:
+  const u8* m_data = nullptr;
+  u64 m_size = 0;
+#ifdef _WIN32
+  void* m_mapping_handle = nullptr;
+#endif
+};
+
+}  // namespace File
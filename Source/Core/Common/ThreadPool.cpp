@@ -0,0 +1,92 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Common/ThreadPool.h"
+
+#include <utility>
+
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+
+namespace Common
+{
+ThreadPool::ThreadPool(size_t num_workers, std::string name) : m_name(std::move(name))
+{
+  m_workers.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i)
+    m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+  }
+  m_work_cv.notify_all();
+  for (std::thread& worker : m_workers)
+    worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+  if (count == 0)
+    return;
+
+  if (count == 1 || m_workers.empty())
+  {
+    for (size_t i = 0; i < count; ++i)
+      function(i);
+    return;
+  }
+
+  std::lock_guard<std::mutex> caller_lock(m_caller_mutex);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_function = &function;
+  m_next_item = 0;
+  m_item_count = count;
+  ++m_job_id;
+  m_work_cv.notify_all();
+
+  RunItems(lock);
+  m_done_cv.wait(lock, [this] { return m_items_running == 0; });
+  m_function = nullptr;
+}
+
+void ThreadPool::RunItems(std::unique_lock<std::mutex>& lock)
+{
+  while (m_next_item < m_item_count)
+  {
+    const size_t item = m_next_item++;
+    const std::function<void(size_t)>& function = *m_function;
+    ++m_items_running;
+
+    lock.unlock();
+    function(item);
+    lock.lock();
+
+    --m_items_running;
+  }
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+  Common::SetCurrentThreadName(StringFromFormat("%s %zu", m_name.c_str(), index).c_str());
+
+  size_t last_job_id = 0;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+  {
+    m_work_cv.wait(lock, [&] { return m_shutdown || m_job_id != last_job_id; });
+    if (m_shutdown)
+      return;
+    last_job_id = m_job_id;
+
+    RunItems(lock);
+    if (m_items_running == 0)
+      m_done_cv.notify_one();
+  }
+}
+}  // namespace Common
@@ -0,0 +1,56 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for splitting a loop over independent items.
+// The calling thread always takes part in the work, so a pool with zero workers
+// simply runs everything on the caller.
+
+namespace Common
+{
+class ThreadPool
+{
+public:
+  ThreadPool(size_t num_workers, std::string name);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t GetWorkerCount() const { return m_workers.size(); }
+
+  // Calls function(i) for every i in [0, count) and returns once all calls have finished.
+  // The order of the calls is unspecified. Concurrent calls are serialized.
+  void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+
+private:
+  void WorkerLoop(size_t index);
+  // Runs items of the current job until there are none left.
+  void RunItems(std::unique_lock<std::mutex>& lock);
+
+  std::string m_name;
+  std::vector<std::thread> m_workers;
+
+  std::mutex m_caller_mutex;
+
+  std::mutex m_mutex;
+  std::condition_variable m_work_cv;
+  std::condition_variable m_done_cv;
+  const std::function<void(size_t)>* m_function = nullptr;
+  size_t m_job_id = 0;
+  size_t m_next_item = 0;
+  size_t m_item_count = 0;
+  size_t m_items_running = 0;
+  bool m_shutdown = false;
+};
+}  // namespace Common
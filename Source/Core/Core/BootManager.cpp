@@ -44,6 +44,7 @@
 #include "Core/NetPlayProto.h"
 #include "Core/PowerPC/PowerPC.h"
 
+#include "DiscIO/Blob.h"
 #include "DiscIO/Enums.h"
 
 #include "VideoCommon/VideoBackendBase.h"
@@ -234,6 +235,10 @@ bool BootCore(std::unique_ptr<BootParameters> boot)
 
   config_cache.SaveConfig(StartUp);
 
+  DiscIO::SectorReader::SetCacheMemoryBudget(
+      static_cast<size_t>(std::max(Config::Get(Config::MAIN_DISC_CACHE_SIZE), 0)) * 1024 * 1024);
+  DiscIO::SetMemoryMappingEnabled(Config::Get(Config::MAIN_MEMORY_MAP_DISC_IMAGES));
+
   if (!StartUp.SetPathsAndGameMetadata(*boot))
     return false;
 
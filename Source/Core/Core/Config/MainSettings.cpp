@@ -20,7 +20,11 @@ const ConfigInfo<bool> MAIN_LOAD_IPL_DUMP{{System::Main, "Core", "LoadIPLDump"},
 const ConfigInfo<PowerPC::CPUCore> MAIN_CPU_CORE{{System::Main, "Core", "CPUCore"},
                                                  PowerPC::DefaultCPUCore()};
 const ConfigInfo<bool> MAIN_JIT_FOLLOW_BRANCH{{System::Main, "Core", "JITFollowBranch"}, true};
+const ConfigInfo<bool> MAIN_JIT_ASYNC_COMPILE{{System::Main, "Core", "JITAsyncCompile"}, false};
+const ConfigInfo<bool> MAIN_JIT_BLOCK_PROFILE{{System::Main, "Core", "JITBlockProfile"}, false};
 const ConfigInfo<bool> MAIN_FASTMEM{{System::Main, "Core", "Fastmem"}, true};
+const ConfigInfo<bool> MAIN_PAGE_TABLE_FASTMEM{{System::Main, "Core", "PageTableFastmem"},
+                                               false};
 const ConfigInfo<bool> MAIN_DSP_HLE{{System::Main, "Core", "DSPHLE"}, true};
 const ConfigInfo<int> MAIN_TIMING_VARIANCE{{System::Main, "Core", "TimingVariance"}, 40};
 const ConfigInfo<bool> MAIN_CPU_THREAD{{System::Main, "Core", "CPUThread"}, true};
@@ -87,6 +91,9 @@ const ConfigInfo<int> MAIN_SYNC_GPU_MIN_DISTANCE{{System::Main, "Core", "SyncGpu
                                                  -200000};
 const ConfigInfo<float> MAIN_SYNC_GPU_OVERCLOCK{{System::Main, "Core", "SyncGpuOverclock"}, 1.0f};
 const ConfigInfo<bool> MAIN_FAST_DISC_SPEED{{System::Main, "Core", "FastDiscSpeed"}, false};
+const ConfigInfo<int> MAIN_DISC_CACHE_SIZE{{System::Main, "Core", "DiscCacheSize"}, 16};
+const ConfigInfo<bool> MAIN_MEMORY_MAP_DISC_IMAGES{{System::Main, "Core", "MemoryMapDiscImages"},
+                                                    false};
 const ConfigInfo<bool> MAIN_LOW_DCBZ_HACK{{System::Main, "Core", "LowDCBZHack"}, false};
 const ConfigInfo<bool> MAIN_FPRF{{System::Main, "Core", "FPRF"}, false};
 const ConfigInfo<bool> MAIN_ACCURATE_NANS{{System::Main, "Core", "AccurateNaNs"}, false};
@@ -103,6 +110,9 @@ const ConfigInfo<u32> MAIN_CUSTOM_RTC_VALUE{{System::Main, "Core", "CustomRTCVal
 const ConfigInfo<bool> MAIN_ENABLE_SIGNATURE_CHECKS{{System::Main, "Core", "EnableSignatureChecks"},
                                                     true};
 const ConfigInfo<bool> MAIN_REDUCE_POLLING_RATE{{System::Main, "Core", "ReducePollingRate"}, false};
+const ConfigInfo<bool> MAIN_ENABLE_REWIND{{System::Main, "Core", "EnableRewind"}, false};
+const ConfigInfo<int> MAIN_REWIND_BUFFER_SIZE{{System::Main, "Core", "RewindBufferSize"}, 512};
+const ConfigInfo<int> MAIN_REWIND_INTERVAL{{System::Main, "Core", "RewindInterval"}, 15};
 
 // Main.DSP
 
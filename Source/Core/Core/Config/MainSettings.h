@@ -21,7 +21,10 @@ extern const ConfigInfo<bool> MAIN_SKIP_IPL;
 extern const ConfigInfo<bool> MAIN_LOAD_IPL_DUMP;
 extern const ConfigInfo<PowerPC::CPUCore> MAIN_CPU_CORE;
 extern const ConfigInfo<bool> MAIN_JIT_FOLLOW_BRANCH;
+extern const ConfigInfo<bool> MAIN_JIT_ASYNC_COMPILE;
+extern const ConfigInfo<bool> MAIN_JIT_BLOCK_PROFILE;
 extern const ConfigInfo<bool> MAIN_FASTMEM;
+extern const ConfigInfo<bool> MAIN_PAGE_TABLE_FASTMEM;
 // Should really be in the DSP section, but we're kind of stuck with bad decisions made in the past.
 extern const ConfigInfo<bool> MAIN_DSP_HLE;
 extern const ConfigInfo<int> MAIN_TIMING_VARIANCE;
@@ -63,6 +66,9 @@ extern const ConfigInfo<int> MAIN_SYNC_GPU_MAX_DISTANCE;
 extern const ConfigInfo<int> MAIN_SYNC_GPU_MIN_DISTANCE;
 extern const ConfigInfo<float> MAIN_SYNC_GPU_OVERCLOCK;
 extern const ConfigInfo<bool> MAIN_FAST_DISC_SPEED;
+// In MiB
+extern const ConfigInfo<int> MAIN_DISC_CACHE_SIZE;
+extern const ConfigInfo<bool> MAIN_MEMORY_MAP_DISC_IMAGES;
 extern const ConfigInfo<bool> MAIN_LOW_DCBZ_HACK;
 extern const ConfigInfo<bool> MAIN_FPRF;
 extern const ConfigInfo<bool> MAIN_ACCURATE_NANS;
@@ -77,6 +83,11 @@ extern const ConfigInfo<bool> MAIN_CUSTOM_RTC_ENABLE;
 extern const ConfigInfo<u32> MAIN_CUSTOM_RTC_VALUE;
 extern const ConfigInfo<bool> MAIN_ENABLE_SIGNATURE_CHECKS;
 extern const ConfigInfo<bool> MAIN_REDUCE_POLLING_RATE;
+extern const ConfigInfo<bool> MAIN_ENABLE_REWIND;
+// In MiB
+extern const ConfigInfo<int> MAIN_REWIND_BUFFER_SIZE;
+// In video fields
+extern const ConfigInfo<int> MAIN_REWIND_INTERVAL;
 
 // Main.DSP
 
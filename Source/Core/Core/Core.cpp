@@ -60,6 +60,7 @@
 #include "Core/PatchEngine.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/SamplingProfiler.h"
 #include "Core/State.h"
 #include "Core/WiiRoot.h"
 
@@ -344,7 +345,9 @@ static void CpuThread(const std::optional<std::string>& savestate_path, bool del
 #endif
 
   // Enter CPU run loop. When we leave it - we are done.
+  Profiler::RegisterCPUThread();
   CPU::Run();
+  Profiler::UnregisterCPUThread();
 
   s_is_started = false;
 
@@ -814,21 +817,26 @@ void UpdateTitle()
       // interested.
       static u64 ticks = 0;
       static u64 idleTicks = 0;
+      static u64 idleSkips = 0;
       u64 newTicks = CoreTiming::GetTicks();
       u64 newIdleTicks = CoreTiming::GetIdleTicks();
+      u64 newIdleSkips = CoreTiming::GetIdleSkips();
 
       u64 diff = (newTicks - ticks) / 1000000;
       u64 idleDiff = (newIdleTicks - idleTicks) / 1000000;
+      u64 idleSkipsDiff = newIdleSkips - idleSkips;
 
       ticks = newTicks;
       idleTicks = newIdleTicks;
+      idleSkips = newIdleSkips;
 
       float TicksPercentage =
           (float)diff / (float)(SystemTimers::GetTicksPerSecond() / 1000000) * 100;
 
-      SFPS += StringFromFormat(" | CPU: ~%i MHz [Real: %i + IdleSkip: %i] / %i MHz (~%3.0f%%)",
-                               (int)(diff), (int)(diff - idleDiff), (int)(idleDiff),
-                               SystemTimers::GetTicksPerSecond() / 1000000, TicksPercentage);
+      SFPS += StringFromFormat(
+          " | CPU: ~%i MHz [Real: %i + IdleSkip: %i (%i/s)] / %i MHz (~%3.0f%%)", (int)(diff),
+          (int)(diff - idleDiff), (int)(idleDiff), (int)(idleSkipsDiff * 1000 / ElapseTime),
+          SystemTimers::GetTicksPerSecond() / 1000000, TicksPercentage);
     }
   }
 
@@ -5,6 +5,7 @@
 #include "Core/CoreTiming.h"
 
 #include <algorithm>
+#include <array>
 #include <cinttypes>
 #include <mutex>
 #include <string>
@@ -12,6 +13,7 @@
 #include <vector>
 
 #include "Common/Assert.h"
+#include "Common/BitSet.h"
 #include "Common/ChunkFile.h"
 #include "Common/Logging/Log.h"
 #include "Common/SPSCQueue.h"
@@ -27,10 +29,14 @@
 
 namespace CoreTiming
 {
+static constexpr u32 NO_EVENT = UINT32_MAX;
+
 struct EventType
 {
   TimedCallback callback;
   const std::string* name;
+  // The most recently scheduled pending event of this type, see EventNode.
+  u32 first_event = NO_EVENT;
 };
 
 struct Event
@@ -42,10 +48,6 @@ struct Event
 };
 
 // Sort by time, unless the times are the same, in which case sort by the order added to the queue
-static bool operator>(const Event& left, const Event& right)
-{
-  return std::tie(left.time, left.fifo_order) > std::tie(right.time, right.fifo_order);
-}
 static bool operator<(const Event& left, const Event& right)
 {
   return std::tie(left.time, left.fifo_order) < std::tie(right.time, right.fifo_order);
@@ -56,11 +58,40 @@ static bool operator<(const Event& left, const Event& right)
 static std::unordered_map<std::string, EventType> s_event_types;
 
 // STATE_TO_SAVE
-// The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-// We don't use std::priority_queue because we need to be able to serialize, unserialize and
-// erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't accomodated
-// by the standard adaptor class.
-static std::vector<Event> s_event_queue;
+// The pending events are kept in a hierarchical timing wheel. Each level has WHEEL_SLOTS slots,
+// and a slot of level N spans WHEEL_SLOTS^N cycles. An event goes into the lowest level on which
+// its time and s_wheel_time only differ in the digit of that level (or into the slot of
+// s_wheel_time if it is in the past), so scheduling and removing an event take constant time.
+// The earliest event is always in the first occupied slot of the lowest occupied level. Before
+// an event of a higher level runs, the wheel time is moved to it and the events of its slot are
+// moved down to lower levels. Events too far in the future for the wheel are kept in an overflow
+// list until the wheel is empty.
+//
+// Events of the same slot are taken out in (time, fifo_order) order, so the order in which events
+// run doesn't depend on how they are stored.
+static constexpr u32 WHEEL_LEVELS = 4;
+static constexpr u32 WHEEL_SLOT_BITS = 8;
+static constexpr u32 WHEEL_SLOTS = 1 << WHEEL_SLOT_BITS;
+static constexpr u32 OVERFLOW_SLOT = WHEEL_LEVELS * WHEEL_SLOTS;
+
+struct EventNode
+{
+  Event event;
+  u32 slot;
+  // The events in the same slot and the events of the same type form doubly linked lists.
+  u32 prev_in_slot;
+  u32 next_in_slot;
+  u32 prev_of_type;
+  u32 next_of_type;
+};
+
+static std::vector<EventNode> s_event_nodes;
+static std::vector<u32> s_free_event_nodes;
+static std::array<u32, OVERFLOW_SLOT + 1> s_slots;
+static std::array<std::array<u64, WHEEL_SLOTS / 64>, WHEEL_LEVELS> s_occupied_slots;
+static s64 s_wheel_time;
+static size_t s_event_count;
+
 static u64 s_event_fifo_id;
 static std::mutex s_ts_write_lock;
 static Common::SPSCQueue<Event, false> s_ts_queue;
@@ -69,6 +100,8 @@ static float s_last_OC_factor;
 static constexpr int MAX_SLICE_LENGTH = 20000;
 
 static s64 s_idled_cycles;
+// Not saved in savestates, this is only for statistics.
+static u64 s_idle_skips;
 static u32 s_fake_dec_start_value;
 static u64 s_fake_dec_start_ticks;
 
@@ -100,6 +133,184 @@ static int CyclesToDowncount(int cycles)
   return static_cast<int>(cycles * s_last_OC_factor);
 }
 
+static void SetSlotOccupied(u32 slot, bool occupied)
+{
+  if (slot == OVERFLOW_SLOT)
+    return;
+
+  u64& bits = s_occupied_slots[slot / WHEEL_SLOTS][slot % WHEEL_SLOTS / 64];
+  const u64 bit = UINT64_C(1) << (slot % 64);
+  if (occupied)
+    bits |= bit;
+  else
+    bits &= ~bit;
+}
+
+static u32 GetSlotForTime(s64 time)
+{
+  const u64 wheel_time = static_cast<u64>(s_wheel_time);
+  const u64 slot_time = static_cast<u64>(std::max(time, s_wheel_time));
+  for (u32 level = 0; level < WHEEL_LEVELS; ++level)
+  {
+    const u32 shift = level * WHEEL_SLOT_BITS;
+    if (((slot_time ^ wheel_time) >> shift) < WHEEL_SLOTS)
+      return level * WHEEL_SLOTS + static_cast<u32>((slot_time >> shift) % WHEEL_SLOTS);
+  }
+  return OVERFLOW_SLOT;
+}
+
+static void LinkIntoSlot(u32 index)
+{
+  EventNode& node = s_event_nodes[index];
+  node.slot = GetSlotForTime(node.event.time);
+  node.prev_in_slot = NO_EVENT;
+  node.next_in_slot = s_slots[node.slot];
+  if (node.next_in_slot != NO_EVENT)
+    s_event_nodes[node.next_in_slot].prev_in_slot = index;
+  s_slots[node.slot] = index;
+  SetSlotOccupied(node.slot, true);
+}
+
+static void UnlinkFromSlot(u32 index)
+{
+  const EventNode& node = s_event_nodes[index];
+  if (node.next_in_slot != NO_EVENT)
+    s_event_nodes[node.next_in_slot].prev_in_slot = node.prev_in_slot;
+
+  if (node.prev_in_slot != NO_EVENT)
+  {
+    s_event_nodes[node.prev_in_slot].next_in_slot = node.next_in_slot;
+  }
+  else
+  {
+    s_slots[node.slot] = node.next_in_slot;
+    if (node.next_in_slot == NO_EVENT)
+      SetSlotOccupied(node.slot, false);
+  }
+}
+
+static void AddEvent(const Event& ev)
+{
+  u32 index;
+  if (s_free_event_nodes.empty())
+  {
+    index = static_cast<u32>(s_event_nodes.size());
+    s_event_nodes.emplace_back();
+  }
+  else
+  {
+    index = s_free_event_nodes.back();
+    s_free_event_nodes.pop_back();
+  }
+
+  EventNode& node = s_event_nodes[index];
+  node.event = ev;
+  LinkIntoSlot(index);
+
+  node.prev_of_type = NO_EVENT;
+  node.next_of_type = ev.type->first_event;
+  if (node.next_of_type != NO_EVENT)
+    s_event_nodes[node.next_of_type].prev_of_type = index;
+  ev.type->first_event = index;
+
+  ++s_event_count;
+}
+
+static Event TakeEvent(u32 index)
+{
+  EventNode& node = s_event_nodes[index];
+  UnlinkFromSlot(index);
+
+  if (node.next_of_type != NO_EVENT)
+    s_event_nodes[node.next_of_type].prev_of_type = node.prev_of_type;
+  if (node.prev_of_type != NO_EVENT)
+    s_event_nodes[node.prev_of_type].next_of_type = node.next_of_type;
+  else
+    node.event.type->first_event = node.next_of_type;
+
+  const Event ev = node.event;
+  node.event.type = nullptr;
+  s_free_event_nodes.push_back(index);
+  --s_event_count;
+  return ev;
+}
+
+static u32 GetEarliestEventInSlot(u32 slot)
+{
+  u32 earliest = s_slots[slot];
+  if (earliest == NO_EVENT)
+    return NO_EVENT;
+
+  for (u32 i = s_event_nodes[earliest].next_in_slot; i != NO_EVENT;
+       i = s_event_nodes[i].next_in_slot)
+  {
+    if (s_event_nodes[i].event < s_event_nodes[earliest].event)
+      earliest = i;
+  }
+  return earliest;
+}
+
+// Returns the index of the earliest pending event, or NO_EVENT if there is none.
+static u32 GetEarliestEvent()
+{
+  for (u32 level = 0; level < WHEEL_LEVELS; ++level)
+  {
+    for (u32 i = 0; i < s_occupied_slots[level].size(); ++i)
+    {
+      const u64 bits = s_occupied_slots[level][i];
+      if (bits != 0)
+        return GetEarliestEventInSlot(level * WHEEL_SLOTS + i * 64 +
+                                      Common::LeastSignificantSetBit(bits));
+    }
+  }
+  return GetEarliestEventInSlot(OVERFLOW_SLOT);
+}
+
+// Takes out the earliest pending event if it is due at the given time.
+static bool TakeDueEvent(s64 time, Event* ev)
+{
+  while (true)
+  {
+    const u32 index = GetEarliestEvent();
+    if (index == NO_EVENT || s_event_nodes[index].event.time > time)
+      return false;
+
+    const u32 slot = s_event_nodes[index].slot;
+    s_wheel_time = std::max(s_wheel_time, s_event_nodes[index].event.time);
+    if (slot < WHEEL_SLOTS)
+    {
+      *ev = TakeEvent(index);
+      return true;
+    }
+
+    // Moving the wheel time to the earliest event keeps every other event in a valid slot,
+    // except for the events of this slot, which now belong to lower levels.
+    u32 next = s_slots[slot];
+    s_slots[slot] = NO_EVENT;
+    SetSlotOccupied(slot, false);
+    while (next != NO_EVENT)
+    {
+      const u32 i = next;
+      next = s_event_nodes[i].next_in_slot;
+      LinkIntoSlot(i);
+    }
+  }
+}
+
+// Returns the pending events sorted by (time, fifo_order).
+static std::vector<Event> GetPendingEvents()
+{
+  std::vector<Event> events;
+  events.reserve(s_event_count);
+  for (const EventNode& node : s_event_nodes)
+  {
+    if (node.event.type)
+      events.push_back(node.event);
+  }
+  std::sort(events.begin(), events.end());
+  return events;
+}
+
 EventType* RegisterEvent(const std::string& name, TimedCallback callback)
 {
   // check for existing type with same name.
@@ -117,7 +328,7 @@ EventType* RegisterEvent(const std::string& name, TimedCallback callback)
 
 void UnregisterAllEvents()
 {
-  ASSERT_MSG(POWERPC, s_event_queue.empty(), "Cannot unregister events with events pending");
+  ASSERT_MSG(POWERPC, s_event_count == 0, "Cannot unregister events with events pending");
   s_event_types.clear();
 }
 
@@ -129,6 +340,8 @@ void Init()
   g.slice_length = MAX_SLICE_LENGTH;
   g.global_timer = 0;
   s_idled_cycles = 0;
+  s_idle_skips = 0;
+  ClearPendingEvents();
 
   // The time between CoreTiming being intialized and the first call to Advance() is considered
   // the slice boundary between slice -1 and slice 0. Dispatcher loops must call Advance() before
@@ -142,6 +355,9 @@ void Init()
 
 void Shutdown()
 {
+  INFO_LOG(POWERPC, "Skipped %" PRIi64 " idle cycles %" PRIu64 " times", s_idled_cycles,
+           s_idle_skips);
+
   std::lock_guard<std::mutex> lk(s_ts_write_lock);
   MoveEvents();
   ClearPendingEvents();
@@ -165,7 +381,10 @@ void DoState(PointerWrap& p)
   p.DoMarker("CoreTimingData");
 
   MoveEvents();
-  p.DoEachElement(s_event_queue, [](PointerWrap& pw, Event& ev) {
+  std::vector<Event> events;
+  if (p.GetMode() != PointerWrap::MODE_READ)
+    events = GetPendingEvents();
+  p.DoEachElement(events, [](PointerWrap& pw, Event& ev) {
     pw.Do(ev.time);
     pw.Do(ev.fifo_order);
 
@@ -199,10 +418,13 @@ void DoState(PointerWrap& p)
   p.DoMarker("CoreTimingEvents");
 
   // When loading from a save state, we must assume the Event order is random and meaningless.
-  // The exact layout of the heap in memory is implementation defined, therefore it is platform
-  // and library version specific.
+  // Older versions saved the events in the order of a binary heap.
   if (p.GetMode() == PointerWrap::MODE_READ)
-    std::make_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
+  {
+    ClearPendingEvents();
+    for (const Event& ev : events)
+      AddEvent(ev);
+  }
 }
 
 // This should only be called from the CPU thread. If you are calling
@@ -223,9 +445,23 @@ u64 GetIdleTicks()
   return static_cast<u64>(s_idled_cycles);
 }
 
+u64 GetIdleSkips()
+{
+  return s_idle_skips;
+}
+
 void ClearPendingEvents()
 {
-  s_event_queue.clear();
+  s_event_nodes.clear();
+  s_free_event_nodes.clear();
+  s_slots.fill(NO_EVENT);
+  for (auto& level : s_occupied_slots)
+    level.fill(0);
+  s_event_count = 0;
+  for (auto& event_type : s_event_types)
+    event_type.second.first_event = NO_EVENT;
+
+  s_wheel_time = g.global_timer;
 }
 
 void ScheduleEvent(s64 cycles_into_future, EventType* event_type, u64 userdata, FromThread from)
@@ -253,8 +489,7 @@ void ScheduleEvent(s64 cycles_into_future, EventType* event_type, u64 userdata,
     if (!s_is_global_timer_sane)
       ForceExceptionCheck(cycles_into_future);
 
-    s_event_queue.emplace_back(Event{timeout, s_event_fifo_id++, userdata, event_type});
-    std::push_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
+    AddEvent(Event{timeout, s_event_fifo_id++, userdata, event_type});
   }
   else
   {
@@ -273,15 +508,12 @@ void ScheduleEvent(s64 cycles_into_future, EventType* event_type, u64 userdata,
 
 void RemoveEvent(EventType* event_type)
 {
-  auto itr = std::remove_if(s_event_queue.begin(), s_event_queue.end(),
-                            [&](const Event& e) { return e.type == event_type; });
+  // Timers are reset before their event types are registered.
+  if (!event_type)
+    return;
 
-  // Removing random items breaks the invariant so we have to re-establish it.
-  if (itr != s_event_queue.end())
-  {
-    s_event_queue.erase(itr, s_event_queue.end());
-    std::make_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
-  }
+  while (event_type->first_event != NO_EVENT)
+    TakeEvent(event_type->first_event);
 }
 
 void RemoveAllEvents(EventType* event_type)
@@ -307,8 +539,7 @@ void MoveEvents()
   for (Event ev; s_ts_queue.Pop(ev);)
   {
     ev.fifo_order = s_event_fifo_id++;
-    s_event_queue.emplace_back(std::move(ev));
-    std::push_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
+    AddEvent(ev);
   }
 }
 
@@ -324,11 +555,9 @@ void Advance()
 
   s_is_global_timer_sane = true;
 
-  while (!s_event_queue.empty() && s_event_queue.front().time <= g.global_timer)
+  Event evt;
+  while (TakeDueEvent(g.global_timer, &evt))
   {
-    Event evt = std::move(s_event_queue.front());
-    std::pop_heap(s_event_queue.begin(), s_event_queue.end(), std::greater<Event>());
-    s_event_queue.pop_back();
     // NOTICE_LOG(POWERPC, "[Scheduler] %-20s (%lld, %lld)", evt.type->name->c_str(),
     //            g.global_timer, evt.time);
     evt.type->callback(evt.userdata, g.global_timer - evt.time);
@@ -337,10 +566,11 @@ void Advance()
   s_is_global_timer_sane = false;
 
   // Still events left (scheduled in the future)
-  if (!s_event_queue.empty())
+  const u32 next_event = GetEarliestEvent();
+  if (next_event != NO_EVENT)
   {
-    g.slice_length = static_cast<int>(
-        std::min<s64>(s_event_queue.front().time - g.global_timer, MAX_SLICE_LENGTH));
+    g.slice_length = static_cast<int>(std::min<s64>(
+        s_event_nodes[next_event].event.time - g.global_timer, MAX_SLICE_LENGTH));
   }
 
   PowerPC::ppcState.downcount = CyclesToDowncount(g.slice_length);
@@ -354,9 +584,7 @@ void Advance()
 
 void LogPendingEvents()
 {
-  auto clone = s_event_queue;
-  std::sort(clone.begin(), clone.end());
-  for (const Event& ev : clone)
+  for (const Event& ev : GetPendingEvents())
   {
     INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %s", g.global_timer,
              ev.time, ev.type->name->c_str());
@@ -366,10 +594,13 @@ void LogPendingEvents()
 // Should only be called from the CPU thread after the PPC clock has changed
 void AdjustEventQueueTimes(u32 new_ppc_clock, u32 old_ppc_clock)
 {
-  for (Event& ev : s_event_queue)
+  std::vector<Event> events = GetPendingEvents();
+  ClearPendingEvents();
+  for (Event& ev : events)
   {
     const s64 ticks = (ev.time - g.global_timer) * new_ppc_clock / old_ppc_clock;
     ev.time = g.global_timer + ticks;
+    AddEvent(ev);
   }
 }
 
@@ -384,6 +615,7 @@ void Idle()
   }
 
   s_idled_cycles += DowncountToCycles(PowerPC::ppcState.downcount);
+  s_idle_skips++;
   PowerPC::ppcState.downcount = 0;
 }
 
@@ -392,9 +624,7 @@ std::string GetScheduledEventsSummary()
   std::string text = "Scheduled events\n";
   text.reserve(1000);
 
-  auto clone = s_event_queue;
-  std::sort(clone.begin(), clone.end());
-  for (const Event& ev : clone)
+  for (const Event& ev : GetPendingEvents())
   {
     text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", ev.type->name->c_str(), ev.time,
                              ev.userdata);
@@ -46,6 +46,8 @@ typedef void (*TimedCallback)(u64 userdata, s64 cyclesLate);
 // doing something evil
 u64 GetTicks();
 u64 GetIdleTicks();
+// How many times Idle() was called.
+u64 GetIdleSkips();
 
 void DoState(PointerWrap& p);
 
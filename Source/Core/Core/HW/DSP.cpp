@@ -148,7 +148,7 @@ static const int DSP_MAIL_SLICE = 72;
 void DoState(PointerWrap& p)
 {
   if (!s_ARAM.wii_mode)
-    p.DoArray(s_ARAM.ptr, s_ARAM.size);
+    p.DoMemoryRegion(s_ARAM.ptr, s_ARAM.size);
   p.DoPOD(s_dspState);
   p.DoPOD(s_audioDMA);
   p.DoPOD(s_arDMA);
@@ -12,12 +12,15 @@
 #include <algorithm>
 #include <cstring>
 #include <memory>
+#include <unordered_map>
 
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Common/MemArena.h"
+#include "Common/MemoryUtil.h"
 #include "Common/Swap.h"
+#include "Core/Config/MainSettings.h"
 #include "Core/ConfigManager.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/DSP.h"
@@ -164,6 +167,18 @@ static PhysicalMemoryRegion physical_regions[] = {
 
 static std::vector<LogicalMemoryView> logical_mapped_entries;
 
+// Pages translated by the page table, by logical address. Unlike the BAT mappings, these are
+// made one page at a time as the JITs fault on them.
+struct PageTableView
+{
+  void* mapped_pointer;
+  bool writeable;
+};
+
+constexpr u32 PAGE_TABLE_PAGE_SIZE = 0x1000;
+static bool page_table_mapping_enabled = false;
+static std::unordered_map<u32, PageTableView> page_table_mapped_entries;
+
 void Init()
 {
   bool wii = SConfig::GetInstance().bWii;
@@ -209,6 +224,12 @@ void Init()
 
 #ifndef _ARCH_32
   logical_base = physical_base + 0x200000000;
+
+  // Windows can only map views at 64 KiB boundaries, which is too coarse for the page table.
+#ifndef _WIN32
+  page_table_mapping_enabled =
+      SConfig::GetInstance().bFastmem && Config::Get(Config::MAIN_PAGE_TABLE_FASTMEM);
+#endif
 #endif
 
   if (wii)
@@ -222,8 +243,18 @@ void Init()
   m_IsInitialized = true;
 }
 
+static void ClearPageTableMappings()
+{
+  for (auto& entry : page_table_mapped_entries)
+    g_arena.ReleaseView(entry.second.mapped_pointer, PAGE_TABLE_PAGE_SIZE);
+  page_table_mapped_entries.clear();
+}
+
 void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table)
 {
+  // The BATs take priority, and might now cover pages that were mapped by the page table.
+  ClearPageTableMappings();
+
   for (auto& entry : logical_mapped_entries)
   {
     g_arena.ReleaseView(entry.mapped_pointer, entry.mapped_size);
@@ -263,17 +294,71 @@ void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table)
   }
 }
 
+bool MapPageTablePage(u32 logical_address, u32 translated_address, bool writeable)
+{
+  if (!page_table_mapping_enabled)
+    return false;
+
+  u8* base = logical_base + logical_address;
+  auto it = page_table_mapped_entries.find(logical_address);
+  if (it != page_table_mapped_entries.end())
+  {
+    if (writeable && !it->second.writeable)
+    {
+      Common::UnWriteProtectMemory(base, PAGE_TABLE_PAGE_SIZE);
+      it->second.writeable = true;
+    }
+    return true;
+  }
+
+  for (const auto& physical_region : physical_regions)
+  {
+    if (!*physical_region.out_pointer || translated_address < physical_region.physical_address ||
+        translated_address - physical_region.physical_address >= physical_region.size)
+    {
+      continue;
+    }
+
+    const u32 position =
+        physical_region.shm_position + translated_address - physical_region.physical_address;
+    void* mapped_pointer = g_arena.CreateView(position, PAGE_TABLE_PAGE_SIZE, base);
+    if (!mapped_pointer)
+    {
+      ERROR_LOG(MEMMAP, "Failed to map page table translation %08x -> %08x", logical_address,
+                translated_address);
+      return false;
+    }
+    if (!writeable)
+      Common::WriteProtectMemory(mapped_pointer, PAGE_TABLE_PAGE_SIZE);
+
+    page_table_mapped_entries.emplace(logical_address, PageTableView{mapped_pointer, writeable});
+    return true;
+  }
+
+  return false;
+}
+
+void UnmapPageTablePage(u32 logical_address)
+{
+  auto it = page_table_mapped_entries.find(logical_address);
+  if (it == page_table_mapped_entries.end())
+    return;
+
+  g_arena.ReleaseView(it->second.mapped_pointer, PAGE_TABLE_PAGE_SIZE);
+  page_table_mapped_entries.erase(it);
+}
+
 void DoState(PointerWrap& p)
 {
   bool wii = SConfig::GetInstance().bWii;
-  p.DoArray(m_pRAM, RAM_SIZE);
+  p.DoMemoryRegion(m_pRAM, RAM_SIZE);
   p.DoArray(m_pL1Cache, L1_CACHE_SIZE);
   p.DoMarker("Memory RAM");
   if (m_pFakeVMEM)
-    p.DoArray(m_pFakeVMEM, FAKEVMEM_SIZE);
+    p.DoMemoryRegion(m_pFakeVMEM, FAKEVMEM_SIZE);
   p.DoMarker("Memory FakeVMEM");
   if (wii)
-    p.DoArray(m_pEXRAM, EXRAM_SIZE);
+    p.DoMemoryRegion(m_pEXRAM, EXRAM_SIZE);
   p.DoMarker("Memory EXRAM");
 }
 
@@ -292,6 +377,8 @@ void Shutdown()
     g_arena.ReleaseView(*region.out_pointer, region.size);
     *region.out_pointer = nullptr;
   }
+  ClearPageTableMappings();
+  page_table_mapping_enabled = false;
   for (auto& entry : logical_mapped_entries)
   {
     g_arena.ReleaseView(entry.mapped_pointer, entry.mapped_size);
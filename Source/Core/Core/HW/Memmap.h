@@ -66,6 +66,12 @@ void DoState(PointerWrap& p);
 
 void UpdateLogicalMemory(const PowerPC::BatTable& dbat_table);
 
+// Pages translated by the page table are mapped into the logical address space one at a time,
+// when the JITs fault on them. Read-only pages fault again on the first write. Returns false
+// if this is disabled or the page isn't in RAM.
+bool MapPageTablePage(u32 logical_address, u32 translated_address, bool writeable);
+void UnmapPageTablePage(u32 logical_address);
+
 void Clear();
 
 // Routines to access physically addressed memory, designed for use by
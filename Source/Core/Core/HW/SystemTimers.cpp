@@ -294,6 +294,10 @@ void Shutdown()
 {
   Common::Timer::RestoreResolution();
   s_localtime_rtc_offset = 0;
+
+  // The event types are freed along with CoreTiming, but the decrementer is set by
+  // PowerPC::Reset on the next boot before Init registers it again.
+  et_Dec = nullptr;
 }
 
 }  // namespace
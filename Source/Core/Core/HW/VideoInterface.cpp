@@ -24,6 +24,7 @@
 #include "Core/HW/ProcessorInterface.h"
 #include "Core/HW/SI/SI.h"
 #include "Core/HW/SystemTimers.h"
+#include "Core/State.h"
 
 #include "DiscIO/Enums.h"
 
@@ -723,6 +724,7 @@ static void BeginField(FieldType field, u64 ticks)
 static void EndField()
 {
   Core::VideoThrottle();
+  State::UpdateRewindBuffer();
 }
 
 // Purpose: Send VI interrupt when triggered
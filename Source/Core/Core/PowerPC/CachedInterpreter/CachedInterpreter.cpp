@@ -4,6 +4,7 @@
 
 #include "Core/PowerPC/CachedInterpreter/CachedInterpreter.h"
 
+#include "Common/BitUtils.h"
 #include "Common/CommonTypes.h"
 #include "Common/Logging/Log.h"
 #include "Core/ConfigManager.h"
@@ -12,6 +13,7 @@
 #include "Core/HW/CPU.h"
 #include "Core/PowerPC/Gekko.h"
 #include "Core/PowerPC/Jit64Common/Jit64Base.h"
+#include "Core/PowerPC/MMU.h"
 #include "Core/PowerPC/PPCAnalyst.h"
 #include "Core/PowerPC/PowerPC.h"
 
@@ -20,32 +22,81 @@ struct CachedInterpreter::Instruction
   using CommonCallback = void (*)(UGeckoInstruction);
   using ConditionalCallback = bool (*)(u32);
 
+  // The types after Conditional are handled inline by RunCode, with their operands decoded
+  // when the block is compiled. Must be in the same order as the dispatch table in RunCode.
+  enum class Type : u8
+  {
+    Abort,
+    Common,
+    Conditional,
+    LoadImmediate,
+    AddImmediate,
+    OrImmediate,
+    XorImmediate,
+    RotateAndMask,
+    Add,
+    Subtract,
+    Or,
+    And,
+    Compare,
+    CompareLogical,
+    CompareImmediate,
+    CompareLogicalImmediate,
+    CompareAndBranch,
+    CompareLogicalAndBranch,
+    CompareImmediateAndBranch,
+    CompareLogicalImmediateAndBranch,
+    LoadWord,
+    LoadHalf,
+    LoadByte,
+    StoreWord,
+    StoreWordUpdate,
+    StoreHalf,
+    StoreByte,
+    NumTypes,
+  };
+
   Instruction() {}
   Instruction(const CommonCallback c, UGeckoInstruction i)
       : common_callback(c), data(i.hex), type(Type::Common)
   {
   }
 
-  Instruction(const ConditionalCallback c, u32 d)
-      : conditional_callback(c), data(d), type(Type::Conditional)
+  Instruction(const ConditionalCallback c, u32 value)
+      : conditional_callback(c), data(value), type(Type::Conditional)
   {
   }
 
-  enum class Type
+  Instruction(Type t, u32 dest, u32 src_a, u32 src_b, u32 imm)
+      : common_callback(nullptr), data(imm), type(t), d(static_cast<u8>(dest)),
+        a(static_cast<u8>(src_a)), b(static_cast<u8>(src_b))
   {
-    Abort,
-    Common,
-    Conditional,
-  };
+  }
 
   union
   {
-    const CommonCallback common_callback;
-    const ConditionalCallback conditional_callback;
+    CommonCallback common_callback;
+    ConditionalCallback conditional_callback;
+
+    // For compares fused with the conditional branch after them, where the branch goes
+    // depending on the value of the CR bit it tests.
+    struct
+    {
+      u32 target_if_set;
+      u32 target_if_clear;
+    };
   };
 
+  // The instruction, or an immediate for the specialized types.
   u32 data = 0;
   Type type = Type::Abort;
+
+  // Register operands of the specialized types. d is the destination, or the CR field for
+  // compares. For fused compares, it is the CR bit that the branch tests, which is always in the
+  // compared field. Rotates keep the shift amount in b.
+  u8 d = 0;
+  u8 a = 0;
+  u8 b = 0;
 };
 
 CachedInterpreter::CachedInterpreter() = default;
@@ -54,6 +105,9 @@ CachedInterpreter::~CachedInterpreter() = default;
 
 void CachedInterpreter::Init()
 {
+  // Four instructions to a cache line.
+  static_assert(sizeof(Instruction) <= 16, "Instruction should stay small");
+
   m_code.reserve(CODE_SIZE / sizeof(Instruction));
 
   jo.enableBlocklink = false;
@@ -85,26 +139,283 @@ void CachedInterpreter::ExecuteOneBlock()
     return;
   }
 
-  const Instruction* code = reinterpret_cast<const Instruction*>(normal_entry);
+  RunCode(reinterpret_cast<const Instruction*>(normal_entry));
+}
 
-  for (; code->type != Instruction::Type::Abort; ++code)
+template <typename T>
+static u32 CompareResult(T a, T b)
+{
+  u32 f;
+  if (a < b)
+    f = 0x8;
+  else if (a > b)
+    f = 0x4;
+  else
+    f = 0x2;
+
+  if (PowerPC::GetXER_SO())
+    f |= 0x1;
+  return f;
+}
+
+static void CompareAndBranch(u32 bi, u32 f, u32 target_if_set, u32 target_if_clear)
+{
+  PowerPC::SetCRField(bi >> 2, f);
+  NPC = (f & (0x8 >> (bi & 3))) ? target_if_set : target_if_clear;
+}
+
+// GCC and Clang can jump straight from one handler to the next through a table of label
+// addresses, which gives every handler its own indirect branch for the predictor to learn.
+// Everything else falls back to a switch.
+#if defined(__GNUC__) || defined(__clang__)
+#define CACHED_INTERPRETER_COMPUTED_GOTO
+#endif
+
+void CachedInterpreter::RunCode(const Instruction* code)
+{
+  using Type = Instruction::Type;
+
+#ifdef CACHED_INTERPRETER_COMPUTED_GOTO
+  static const void* const dispatch_table[] = {
+      &&Abort,
+      &&Common,
+      &&Conditional,
+      &&LoadImmediate,
+      &&AddImmediate,
+      &&OrImmediate,
+      &&XorImmediate,
+      &&RotateAndMask,
+      &&Add,
+      &&Subtract,
+      &&Or,
+      &&And,
+      &&Compare,
+      &&CompareLogical,
+      &&CompareImmediate,
+      &&CompareLogicalImmediate,
+      &&CompareAndBranch,
+      &&CompareLogicalAndBranch,
+      &&CompareImmediateAndBranch,
+      &&CompareLogicalImmediateAndBranch,
+      &&LoadWord,
+      &&LoadHalf,
+      &&LoadByte,
+      &&StoreWord,
+      &&StoreWordUpdate,
+      &&StoreHalf,
+      &&StoreByte,
+  };
+  static_assert(sizeof(dispatch_table) / sizeof(dispatch_table[0]) ==
+                    static_cast<size_t>(Type::NumTypes),
+                "The dispatch table must cover all instruction types");
+
+#define HANDLER(name) name:
+#define NEXT()                                                                                     \
+  do                                                                                               \
+  {                                                                                                \
+    ++code;                                                                                        \
+    goto* dispatch_table[static_cast<size_t>(code->type)];                                         \
+  } while (0)
+
+  goto* dispatch_table[static_cast<size_t>(code->type)];
+#else
+#define HANDLER(name) case Type::name:
+#define NEXT()                                                                                     \
+  ++code;                                                                                          \
+  continue
+
+  for (;;)
   {
     switch (code->type)
     {
-    case Instruction::Type::Common:
-      code->common_callback(UGeckoInstruction(code->data));
-      break;
+#endif
 
-    case Instruction::Type::Conditional:
-      if (code->conditional_callback(code->data))
-        return;
-      break;
+  HANDLER(Abort)
+  {
+    return;
+  }
+
+  HANDLER(Common)
+  {
+    code->common_callback(UGeckoInstruction(code->data));
+    NEXT();
+  }
+
+  HANDLER(Conditional)
+  {
+    if (code->conditional_callback(code->data))
+      return;
+    NEXT();
+  }
+
+  HANDLER(LoadImmediate)
+  {
+    rGPR[code->d] = code->data;
+    NEXT();
+  }
+
+  HANDLER(AddImmediate)
+  {
+    rGPR[code->d] = rGPR[code->a] + code->data;
+    NEXT();
+  }
+
+  HANDLER(OrImmediate)
+  {
+    rGPR[code->d] = rGPR[code->a] | code->data;
+    NEXT();
+  }
+
+  HANDLER(XorImmediate)
+  {
+    rGPR[code->d] = rGPR[code->a] ^ code->data;
+    NEXT();
+  }
+
+  HANDLER(RotateAndMask)
+  {
+    rGPR[code->d] = Common::RotateLeft(rGPR[code->a], code->b) & code->data;
+    NEXT();
+  }
+
+  HANDLER(Add)
+  {
+    rGPR[code->d] = rGPR[code->a] + rGPR[code->b];
+    NEXT();
+  }
+
+  HANDLER(Subtract)
+  {
+    rGPR[code->d] = rGPR[code->b] - rGPR[code->a];
+    NEXT();
+  }
+
+  HANDLER(Or)
+  {
+    rGPR[code->d] = rGPR[code->a] | rGPR[code->b];
+    NEXT();
+  }
+
+  HANDLER(And)
+  {
+    rGPR[code->d] = rGPR[code->a] & rGPR[code->b];
+    NEXT();
+  }
+
+  HANDLER(Compare)
+  {
+    PowerPC::SetCRField(code->d, CompareResult<s32>(rGPR[code->a], rGPR[code->b]));
+    NEXT();
+  }
+
+  HANDLER(CompareLogical)
+  {
+    PowerPC::SetCRField(code->d, CompareResult<u32>(rGPR[code->a], rGPR[code->b]));
+    NEXT();
+  }
+
+  HANDLER(CompareImmediate)
+  {
+    PowerPC::SetCRField(code->d, CompareResult<s32>(rGPR[code->a], code->data));
+    NEXT();
+  }
+
+  HANDLER(CompareLogicalImmediate)
+  {
+    PowerPC::SetCRField(code->d, CompareResult<u32>(rGPR[code->a], code->data));
+    NEXT();
+  }
+
+  HANDLER(CompareAndBranch)
+  {
+    CompareAndBranch(code->d, CompareResult<s32>(rGPR[code->a], rGPR[code->b]),
+                     code->target_if_set, code->target_if_clear);
+    NEXT();
+  }
 
+  HANDLER(CompareLogicalAndBranch)
+  {
+    CompareAndBranch(code->d, CompareResult<u32>(rGPR[code->a], rGPR[code->b]),
+                     code->target_if_set, code->target_if_clear);
+    NEXT();
+  }
+
+  HANDLER(CompareImmediateAndBranch)
+  {
+    CompareAndBranch(code->d, CompareResult<s32>(rGPR[code->a], code->data),
+                     code->target_if_set, code->target_if_clear);
+    NEXT();
+  }
+
+  HANDLER(CompareLogicalImmediateAndBranch)
+  {
+    CompareAndBranch(code->d, CompareResult<u32>(rGPR[code->a], code->data),
+                     code->target_if_set, code->target_if_clear);
+    NEXT();
+  }
+
+  // Like the interpreter, loads leave the destination alone if they cause a DSI.
+  HANDLER(LoadWord)
+  {
+    const u32 value = PowerPC::Read_U32(rGPR[code->a] + code->data);
+    if (!(PowerPC::ppcState.Exceptions & EXCEPTION_DSI))
+      rGPR[code->d] = value;
+    NEXT();
+  }
+
+  HANDLER(LoadHalf)
+  {
+    const u32 value = PowerPC::Read_U16(rGPR[code->a] + code->data);
+    if (!(PowerPC::ppcState.Exceptions & EXCEPTION_DSI))
+      rGPR[code->d] = value;
+    NEXT();
+  }
+
+  HANDLER(LoadByte)
+  {
+    const u32 value = PowerPC::Read_U8(rGPR[code->a] + code->data);
+    if (!(PowerPC::ppcState.Exceptions & EXCEPTION_DSI))
+      rGPR[code->d] = value;
+    NEXT();
+  }
+
+  HANDLER(StoreWord)
+  {
+    PowerPC::Write_U32(rGPR[code->d], rGPR[code->a] + code->data);
+    NEXT();
+  }
+
+  HANDLER(StoreWordUpdate)
+  {
+    const u32 address = rGPR[code->a] + code->data;
+    PowerPC::Write_U32(rGPR[code->d], address);
+    if (!(PowerPC::ppcState.Exceptions & EXCEPTION_DSI))
+      rGPR[code->a] = address;
+    NEXT();
+  }
+
+  HANDLER(StoreHalf)
+  {
+    PowerPC::Write_U16(static_cast<u16>(rGPR[code->d]), rGPR[code->a] + code->data);
+    NEXT();
+  }
+
+  HANDLER(StoreByte)
+  {
+    PowerPC::Write_U8(static_cast<u8>(rGPR[code->d]), rGPR[code->a] + code->data);
+    NEXT();
+  }
+
+#ifndef CACHED_INTERPRETER_COMPUTED_GOTO
     default:
       ERROR_LOG(POWERPC, "Unknown CachedInterpreter Instruction: %d", static_cast<int>(code->type));
-      break;
+      NEXT();
     }
   }
+#endif
+
+#undef HANDLER
+#undef NEXT
 }
 
 void CachedInterpreter::Run()
@@ -147,6 +458,13 @@ static void WriteBrokenBlockNPC(UGeckoInstruction data)
   NPC = data.hex;
 }
 
+static void CheckIdle(UGeckoInstruction data)
+{
+  // The interpreter already skips ahead on its own for the simplest idle loops.
+  if (NPC == data.hex && PowerPC::ppcState.downcount > 0)
+    CoreTiming::Idle();
+}
+
 static bool CheckFPU(u32 data)
 {
   if (!MSR.FP)
@@ -196,6 +514,156 @@ bool CachedInterpreter::HandleFunctionHooking(u32 address)
   });
 }
 
+bool CachedInterpreter::CompileSpecialized(const PPCAnalyst::CodeOp& op)
+{
+  using Type = Instruction::Type;
+  const UGeckoInstruction inst = op.inst;
+
+  switch (inst.OPCD)
+  {
+  case 10:  // cmpli
+    m_code.emplace_back(Type::CompareLogicalImmediate, inst.CRFD, inst.RA, 0, inst.UIMM);
+    return true;
+  case 11:  // cmpi
+    m_code.emplace_back(Type::CompareImmediate, inst.CRFD, inst.RA, 0, inst.SIMM_16);
+    return true;
+  case 14:  // addi
+  case 15:  // addis
+  {
+    const u32 simm = static_cast<u32>(inst.SIMM_16);
+    const u32 imm = inst.OPCD == 14 ? simm : simm << 16;
+    if (inst.RA == 0)
+      m_code.emplace_back(Type::LoadImmediate, inst.RD, 0, 0, imm);
+    else
+      m_code.emplace_back(Type::AddImmediate, inst.RD, inst.RA, 0, imm);
+    return true;
+  }
+  case 21:  // rlwinmx
+    if (inst.Rc)
+      return false;
+    m_code.emplace_back(Type::RotateAndMask, inst.RA, inst.RS, inst.SH,
+                        MakeRotationMask(inst.MB, inst.ME));
+    return true;
+  case 24:  // ori
+  case 25:  // oris
+    m_code.emplace_back(Type::OrImmediate, inst.RA, inst.RS, 0,
+                        inst.OPCD == 24 ? inst.UIMM : inst.UIMM << 16);
+    return true;
+  case 26:  // xori
+  case 27:  // xoris
+    m_code.emplace_back(Type::XorImmediate, inst.RA, inst.RS, 0,
+                        inst.OPCD == 26 ? inst.UIMM : inst.UIMM << 16);
+    return true;
+  case 31:
+    // Only the forms that don't touch CR0 or XER. SUBOP10 includes the OE bit.
+    if (inst.Rc)
+      return false;
+    switch (inst.SUBOP10)
+    {
+    case 0:  // cmp
+      m_code.emplace_back(Type::Compare, inst.CRFD, inst.RA, inst.RB, 0);
+      return true;
+    case 28:  // andx
+      m_code.emplace_back(Type::And, inst.RA, inst.RS, inst.RB, 0);
+      return true;
+    case 32:  // cmpl
+      m_code.emplace_back(Type::CompareLogical, inst.CRFD, inst.RA, inst.RB, 0);
+      return true;
+    case 40:  // subfx
+      m_code.emplace_back(Type::Subtract, inst.RD, inst.RA, inst.RB, 0);
+      return true;
+    case 266:  // addx
+      m_code.emplace_back(Type::Add, inst.RD, inst.RA, inst.RB, 0);
+      return true;
+    case 444:  // orx
+      m_code.emplace_back(Type::Or, inst.RA, inst.RS, inst.RB, 0);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // Loads and stores relative to r0 are absolute, which is rare enough to leave to the
+  // interpreter.
+  if (inst.RA == 0)
+    return false;
+
+  switch (inst.OPCD)
+  {
+  case 32:  // lwz
+    m_code.emplace_back(Type::LoadWord, inst.RD, inst.RA, 0, inst.SIMM_16);
+    return true;
+  case 34:  // lbz
+    m_code.emplace_back(Type::LoadByte, inst.RD, inst.RA, 0, inst.SIMM_16);
+    return true;
+  case 36:  // stw
+    m_code.emplace_back(Type::StoreWord, inst.RS, inst.RA, 0, inst.SIMM_16);
+    return true;
+  case 37:  // stwu
+    m_code.emplace_back(Type::StoreWordUpdate, inst.RS, inst.RA, 0, inst.SIMM_16);
+    return true;
+  case 38:  // stb
+    m_code.emplace_back(Type::StoreByte, inst.RS, inst.RA, 0, inst.SIMM_16);
+    return true;
+  case 40:  // lhz
+    m_code.emplace_back(Type::LoadHalf, inst.RD, inst.RA, 0, inst.SIMM_16);
+    return true;
+  case 44:  // sth
+    m_code.emplace_back(Type::StoreHalf, inst.RS, inst.RA, 0, inst.SIMM_16);
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool CachedInterpreter::CompileCompareAndBranch(const PPCAnalyst::CodeOp& op,
+                                                const PPCAnalyst::CodeOp& branch)
+{
+  using Type = Instruction::Type;
+  const UGeckoInstruction inst = op.inst;
+  const UGeckoInstruction branch_inst = branch.inst;
+
+  // A bc that ends the block and only tests the CR field that was just compared to, without
+  // touching CTR or LR. Idle loops, including the one that the interpreter detects in bcx, are
+  // left alone.
+  if (branch_inst.OPCD != 16 || branch_inst.LK || branch.skip || branch.isIdleLoop ||
+      !(branch.opinfo->flags & FL_ENDBLOCK) || (branch_inst.BO & 0x10) ||
+      !(branch_inst.BO & BO_DONT_DECREMENT_FLAG) || branch_inst.BI >> 2 != inst.CRFD ||
+      branch_inst.hex == 0x4182fff8)
+  {
+    return false;
+  }
+  if (HLE::GetFirstFunctionIndex(branch.address) != 0)
+    return false;
+  if (SConfig::GetInstance().bEnableDebugging &&
+      PowerPC::breakpoints.IsAddressBreakPoint(branch.address))
+  {
+    return false;
+  }
+
+  Instruction fused;
+  const u32 bi = branch_inst.BI;
+  if (inst.OPCD == 10)
+    fused = Instruction(Type::CompareLogicalImmediateAndBranch, bi, inst.RA, 0, inst.UIMM);
+  else if (inst.OPCD == 11)
+    fused = Instruction(Type::CompareImmediateAndBranch, bi, inst.RA, 0, inst.SIMM_16);
+  else if (inst.OPCD == 31 && inst.SUBOP10 == 0 && !inst.Rc)
+    fused = Instruction(Type::CompareAndBranch, bi, inst.RA, inst.RB, 0);
+  else if (inst.OPCD == 31 && inst.SUBOP10 == 32 && !inst.Rc)
+    fused = Instruction(Type::CompareLogicalAndBranch, bi, inst.RA, inst.RB, 0);
+  else
+    return false;
+
+  const u32 offset = SignExt16(branch_inst.BD << 2);
+  const u32 target = branch_inst.AA ? offset : branch.address + offset;
+  const u32 fallthrough = branch.address + 4;
+  const bool branch_if_set = (branch_inst.BO >> 3) & 1;
+  fused.target_if_set = branch_if_set ? target : fallthrough;
+  fused.target_if_clear = branch_if_set ? fallthrough : target;
+  m_code.push_back(fused);
+  return true;
+}
+
 void CachedInterpreter::Jit(u32 address)
 {
   if (m_code.size() >= CODE_SIZE / sizeof(Instruction) - 0x1000 ||
@@ -256,11 +724,24 @@ void CachedInterpreter::Jit(u32 address)
         js.firstFPInstructionFound = true;
       }
 
+      // The branch after a compare can be folded into it, though its cycles still count.
+      if (i + 1 < code_block.m_num_instructions &&
+          CompileCompareAndBranch(op, m_code_buffer[i + 1]))
+      {
+        ++i;
+        js.downcountAmount += m_code_buffer[i].opinfo->numCycles;
+        m_code.emplace_back(EndBlock, js.downcountAmount);
+        continue;
+      }
+
       if (endblock || memcheck)
         m_code.emplace_back(WritePC, op.address);
-      m_code.emplace_back(PPCTables::GetInterpreterOp(op.inst), op.inst);
+      if (!CompileSpecialized(op))
+        m_code.emplace_back(PPCTables::GetInterpreterOp(op.inst), op.inst);
       if (memcheck)
         m_code.emplace_back(CheckDSI, js.downcountAmount);
+      if (op.isIdleLoop)
+        m_code.emplace_back(CheckIdle, js.blockStart);
       if (endblock)
         m_code.emplace_back(EndBlock, js.downcountAmount);
     }
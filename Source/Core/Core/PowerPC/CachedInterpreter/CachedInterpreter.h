@@ -27,6 +27,9 @@ public:
   void SingleStep() override;
 
   void Jit(u32 address) override;
+  // Runs the block at PC, or compiles it if there is none yet. Jit64 uses this while it
+  // compiles blocks in the background.
+  void ExecuteOneBlock();
 
   JitBaseBlockCache* GetBlockCache() override { return &m_block_cache; }
   const char* GetName() const override { return "Cached Interpreter"; }
@@ -36,9 +39,11 @@ private:
   struct Instruction;
 
   u8* GetCodePtr();
-  void ExecuteOneBlock();
+  static void RunCode(const Instruction* code);
 
   bool HandleFunctionHooking(u32 address);
+  bool CompileSpecialized(const PPCAnalyst::CodeOp& op);
+  bool CompileCompareAndBranch(const PPCAnalyst::CodeOp& op, const PPCAnalyst::CodeOp& branch);
 
   BlockCache m_block_cache{*this};
   std::vector<Instruction> m_code;
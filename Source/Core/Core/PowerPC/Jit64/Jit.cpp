@@ -4,6 +4,7 @@
 
 #include "Core/PowerPC/Jit64/Jit.h"
 
+#include <algorithm>
 #include <map>
 #include <string>
 
@@ -19,6 +20,7 @@
 #include "Common/PerformanceCounter.h"
 #include "Common/StringUtil.h"
 #include "Common/x64ABI.h"
+#include "Core/Config/MainSettings.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/HLE/HLE.h"
@@ -26,6 +28,7 @@
 #include "Core/HW/GPFifo.h"
 #include "Core/HW/ProcessorInterface.h"
 #include "Core/PatchEngine.h"
+#include "Core/PowerPC/CachedInterpreter/CachedInterpreter.h"
 #include "Core/PowerPC/Jit64/JitAsm.h"
 #include "Core/PowerPC/Jit64/JitRegCache.h"
 #include "Core/PowerPC/Jit64Common/FarCodeCache.h"
@@ -48,6 +51,7 @@ using namespace PowerPC;
 // Features:
 // * Basic block linking
 // * Fast dispatcher
+// * Hot blocks are recompiled as traces along their usual path
 
 // Unfeatures:
 // * Does not recompile all instructions - sometimes falls back to inserting a CALL to the
@@ -244,10 +248,30 @@ void Jit64::Init()
                               !SConfig::GetInstance().bEnableDebugging;
   m_cleanup_after_stackfault = false;
 
+  // Traces are formed by following branches, and recompiling blocks behind the back of the
+  // debugger would be confusing.
+  m_enable_tiering =
+      SConfig::GetInstance().bJITFollowBranch && !SConfig::GetInstance().bEnableDebugging;
+  m_trace_addresses.clear();
+  analyzer.SetBranchPredictor([this](u32, u32 destination) { return IsHotAddress(destination); });
+
   m_stack = nullptr;
   if (m_enable_blr_optimization)
     AllocStack();
 
+  // Blocks are recorded and precompiled if enabled. Precompiled blocks would ignore
+  // breakpoints though.
+  m_enable_block_profile =
+      Config::Get(Config::MAIN_JIT_BLOCK_PROFILE) && !SConfig::GetInstance().bEnableDebugging;
+
+  // Blocks are compiled in the background if enabled. The debugger expects to be able to stop
+  // at every block as it gets compiled though.
+  if (Config::Get(Config::MAIN_JIT_ASYNC_COMPILE) && !SConfig::GetInstance().bEnableDebugging)
+  {
+    m_fallback = std::make_unique<CachedInterpreter>();
+    m_fallback->Init();
+  }
+
   blocks.Init();
   asm_routines.Init(m_stack ? (m_stack + STACK_SIZE) : nullptr);
 
@@ -261,10 +285,28 @@ void Jit64::Init()
   code_block.m_gpa = &js.gpa;
   code_block.m_fpa = &js.fpa;
   EnableOptimization();
+
+  if (m_fallback)
+  {
+    m_request_analyzer = analyzer;
+    m_request_code_buffer.resize(code_buffer_size);
+    m_compile_thread = std::make_unique<Common::WorkQueueThread<CompileRequest*>>(
+        [this](CompileRequest* request) {
+          CompileRequestedBlock(*request);
+          if (--m_compiles_in_flight == 0)
+            m_compiles_done.Set();
+        });
+  }
 }
 
 void Jit64::ClearCache()
 {
+  FinishPendingCompiles();
+  if (m_fallback)
+    m_fallback->ClearCache();
+  if (m_enable_block_profile)
+    m_block_profile.Record(blocks);
+
   blocks.Clear();
   trampolines.ClearCodeSpace();
   m_far_code.ClearCodeSpace();
@@ -272,16 +314,63 @@ void Jit64::ClearCache()
   ClearCodeSpace();
   Clear();
   UpdateMemoryOptions();
+  m_trace_addresses.clear();
+}
+
+void Jit64::ClearSafe()
+{
+  FinishPendingCompiles();
+  if (m_fallback)
+    m_fallback->ClearSafe();
+
+  blocks.Clear();
+  m_trace_addresses.clear();
+}
+
+void Jit64::InvalidateICache(u32 address, u32 size, bool forced)
+{
+  FinishPendingCompiles();
+  if (m_fallback)
+    m_fallback->InvalidateICache(address, size, forced);
+
+  blocks.InvalidateICache(address, size, forced);
+
+  // Like the exception addresses, a trace is only dropped when the code was modified, as the
+  // branches it follows may go elsewhere now.
+  if (!forced)
+  {
+    for (auto it = m_trace_addresses.begin(); it != m_trace_addresses.end();)
+    {
+      if (*it - address < size)
+        it = m_trace_addresses.erase(it);
+      else
+        ++it;
+    }
+  }
 }
 
 void Jit64::Shutdown()
 {
+  FinishPendingCompiles();
+  m_compile_thread.reset();
+  if (m_enable_block_profile)
+  {
+    m_block_profile.Record(blocks);
+    m_block_profile.SetGame("");
+  }
+
   FreeStack();
   FreeCodeSpace();
 
   blocks.Shutdown();
   m_far_code.Shutdown();
   m_const_pool.Shutdown();
+
+  if (m_fallback)
+  {
+    m_fallback->Shutdown();
+    m_fallback.reset();
+  }
 }
 
 void Jit64::FallBackToInterpreter(UGeckoInstruction inst)
@@ -307,8 +396,9 @@ void Jit64::FallBackToInterpreter(UGeckoInstruction inst)
     }
     else
     {
+      // The next instruction in the block is at the destination of a followed branch.
       MOV(32, R(RSCRATCH), PPCSTATE(npc));
-      CMP(32, R(RSCRATCH), Imm32(js.compilerPC + 4));
+      CMP(32, R(RSCRATCH), Imm32(js.op[1].address));
       FixupBranch c = J_CC(CC_Z);
       MOV(32, PPCSTATE(pc), R(RSCRATCH));
       WriteExceptionExit();
@@ -331,10 +421,33 @@ void Jit64::DoNothing(UGeckoInstruction _inst)
   // Yup, just don't do anything.
 }
 
+// First-tier blocks that run this many times are recompiled as traces.
+constexpr u32 TIER_UP_THRESHOLD = 1000;
+
+// The most blocks that are compiled in the background during one timeslice. Each of them
+// needs room for the biggest possible block in the code space.
+constexpr size_t MAX_PENDING_COMPILES = 16;
+constexpr size_t MAX_BLOCK_SIZE = 0x10000;
+
+// The most blocks that are compiled from the block profile at once, to bound the stall.
+constexpr size_t MAX_PRECOMPILED_BLOCKS = 1000;
+
 static const bool ImHereDebug = false;
 static const bool ImHereLog = false;
 static std::map<u32, int> been_here;
 
+static void TierUpTrampoline(Jit64& jit, u32 em_address)
+{
+  jit.TierUp(em_address);
+}
+
+static void CopySpeculatedRegisters(std::array<u32, 8>* gqrs, std::array<u32, 32>* gprs)
+{
+  for (size_t i = 0; i < gqrs->size(); i++)
+    (*gqrs)[i] = GQR(i);
+  std::copy_n(PowerPC::ppcState.gpr, gprs->size(), gprs->begin());
+}
+
 static void ImHere()
 {
   static File::IOFile f;
@@ -599,6 +712,20 @@ void Jit64::Jit(u32 em_address)
     ClearCache();
   }
 
+  if (m_enable_block_profile)
+  {
+    UpdateBlockProfile(em_address);
+    if (blocks.GetBlockFromStartAddress(em_address, MSR.Hex))
+      return;
+  }
+
+  // Keeping netplay peers and movies in sync would need everyone to agree on the setting.
+  if (m_compile_thread && !Core::WantsDeterminism())
+  {
+    RunWhileCompiling(em_address);
+    return;
+  }
+
   std::size_t block_size = m_code_buffer.size();
 
   if (SConfig::GetInstance().bEnableDebugging)
@@ -626,6 +753,13 @@ void Jit64::Jit(u32 em_address)
     }
   }
 
+  // Hot blocks are compiled as traces, which follow conditional branches in the direction
+  // they usually go, so that registers stay allocated across what used to be several blocks.
+  if (m_enable_tiering && m_trace_addresses.count(em_address) != 0)
+    analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  else
+    analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+
   // Analyze the block, collect all instructions it is made of (including inlining,
   // if that is enabled), reorder instructions for optimal performance, and join joinable
   // instructions.
@@ -641,11 +775,162 @@ void Jit64::Jit(u32 em_address)
     return;
   }
 
+  CopySpeculatedRegisters(&m_compile_gqrs, &m_compile_gprs);
+
   JitBlock* b = blocks.AllocateBlock(em_address);
   DoJit(em_address, b, nextPC);
   blocks.FinalizeBlock(*b, jo.enableBlocklink, code_block.m_physical_addresses);
 }
 
+void Jit64::UpdateBlockProfile(u32 em_address)
+{
+  const std::string& game_id = SConfig::GetInstance().GetGameID();
+  if (game_id != m_block_profile.GetGame())
+  {
+    m_block_profile.Record(blocks);
+    m_block_profile.SetGame(game_id);
+  }
+
+  // Reaching a block of the profile means that its code has been loaded, likely along with
+  // more of the profile. Compiling ahead changes when blocks see the speculated registers,
+  // so this is left out when the emulation has to be deterministic.
+  if (m_block_profile.IsPending(em_address) && !Core::WantsDeterminism())
+    PrecompileProfiledBlocks(em_address);
+}
+
+void Jit64::PrecompileProfiledBlocks(u32 em_address)
+{
+  const u32 msr_bits = MSR.Hex & JitBaseBlockCache::JIT_CACHE_MSR_MASK;
+  const auto entries =
+      m_block_profile.TakeLoadedBlocks(em_address, msr_bits, MAX_PRECOMPILED_BLOCKS);
+  analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  for (const JitBlockProfile::Entry& entry : entries)
+  {
+    if (IsAlmostFull() || m_far_code.IsAlmostFull())
+      break;
+    if (blocks.GetBlockFromStartAddress(entry.address, MSR.Hex))
+      continue;
+
+    const u32 next_pc =
+        analyzer.Analyze(entry.address, &code_block, &m_code_buffer, m_code_buffer.size());
+    if (code_block.m_memory_exception ||
+        JitBlockProfile::HashInstructions(code_block.m_physical_addresses) != entry.hash)
+    {
+      continue;
+    }
+
+    CopySpeculatedRegisters(&m_compile_gqrs, &m_compile_gprs);
+    JitBlock* b = blocks.AllocateBlock(entry.address);
+    DoJit(entry.address, b, next_pc);
+    blocks.FinalizeBlock(*b, jo.enableBlocklink, code_block.m_physical_addresses);
+  }
+
+  INFO_LOG(DYNA_REC, "Precompiled %zu blocks from the JIT profile", entries.size());
+}
+
+void Jit64::RunWhileCompiling(u32 em_address)
+{
+  const size_t space_left = std::min(GetSpaceLeft(), m_far_code.GetSpaceLeft());
+  m_max_pending_compiles = std::min(MAX_PENDING_COMPILES, space_left / MAX_BLOCK_SIZE);
+
+  // Carry on without compiled code until the end of the timeslice, or until there is compiled
+  // code for where the CPU is, and pick up any other blocks that need compiling on the way.
+  // This only depends on the emulated state, never on how fast the compile thread is.
+  const CPU::State* state_ptr = CPU::GetStatePtr();
+  do
+  {
+    if (!IsCompilePending(PC))
+    {
+      if (blocks.GetBlockFromStartAddress(PC, MSR.Hex))
+        break;
+      RequestCompile(PC);
+    }
+    m_fallback->ExecuteOneBlock();
+  } while (PowerPC::ppcState.downcount > 0 && *state_ptr == CPU::State::Running);
+
+  FinishPendingCompiles();
+}
+
+bool Jit64::IsCompilePending(u32 em_address) const
+{
+  const u32 msr_bits = MSR.Hex & JitBaseBlockCache::JIT_CACHE_MSR_MASK;
+  return std::any_of(m_pending_compiles.begin(), m_pending_compiles.end(),
+                     [&](const std::unique_ptr<CompileRequest>& request) {
+                       return request->block->effectiveAddress == em_address &&
+                              request->block->msrBits == msr_bits;
+                     });
+}
+
+void Jit64::RequestCompile(u32 em_address)
+{
+  if (m_pending_compiles.size() >= m_max_pending_compiles)
+    return;
+
+  auto request = std::make_unique<CompileRequest>();
+  request->code_block.m_stats = &request->stats;
+  request->code_block.m_gpa = &request->gpa;
+  request->code_block.m_fpa = &request->fpa;
+
+  request->trace = m_enable_tiering && m_trace_addresses.count(em_address) != 0;
+  if (request->trace)
+    m_request_analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  else
+    m_request_analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+
+  request->next_pc = m_request_analyzer.Analyze(em_address, &request->code_block,
+                                                &m_request_code_buffer, code_buffer_size);
+
+  // Leave raising the ISI to the fallback.
+  if (request->code_block.m_memory_exception)
+    return;
+
+  const auto code_begin = m_request_code_buffer.begin();
+  request->code.assign(code_begin, code_begin + request->code_block.m_num_instructions);
+  CopySpeculatedRegisters(&request->gqrs, &request->gprs);
+  request->block = blocks.AllocateBlock(em_address);
+
+  m_pending_compiles.push_back(std::move(request));
+  ++m_compiles_in_flight;
+  m_compile_thread->EmplaceItem(m_pending_compiles.back().get());
+}
+
+void Jit64::CompileRequestedBlock(CompileRequest& request)
+{
+  std::copy(request.code.begin(), request.code.end(), m_code_buffer.begin());
+  code_block = request.code_block;
+  code_block.m_stats = &js.st;
+  code_block.m_gpa = &js.gpa;
+  code_block.m_fpa = &js.fpa;
+  js.st = request.stats;
+  js.gpa = request.gpa;
+  js.fpa = request.fpa;
+
+  if (request.trace)
+    analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+  else
+    analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE);
+
+  m_compile_gqrs = request.gqrs;
+  m_compile_gprs = request.gprs;
+  DoJit(request.block->effectiveAddress, request.block, request.next_pc);
+}
+
+void Jit64::FinishPendingCompiles()
+{
+  if (m_pending_compiles.empty())
+    return;
+
+  while (m_compiles_in_flight != 0)
+    m_compiles_done.Wait();
+
+  for (const auto& request : m_pending_compiles)
+  {
+    blocks.FinalizeBlock(*request->block, jo.enableBlocklink,
+                         request->code_block.m_physical_addresses);
+  }
+  m_pending_compiles.clear();
+}
+
 u8* Jit64::DoJit(u32 em_address, JitBlock* b, u32 nextPC)
 {
   js.firstFPInstructionFound = false;
@@ -689,6 +974,23 @@ u8* Jit64::DoJit(u32 em_address, JitBlock* b, u32 nextPC)
     ADD(64, MDisp(ABI_PARAM1, offset), Imm8(1));
     ABI_CallFunction(QueryPerformanceCounter);
   }
+  // Count how often first-tier blocks run, and have them recompiled once they are hot.
+  if (m_enable_tiering && !analyzer.HasOption(PPCAnalyst::PPCAnalyzer::OPTION_TRACE))
+  {
+    MOV(64, R(RSCRATCH), ImmPtr(&b->run_count));
+    ADD(32, MatR(RSCRATCH), Imm8(1));
+    CMP(32, MatR(RSCRATCH), Imm32(TIER_UP_THRESHOLD));
+    FixupBranch hot = J_CC(CC_E, true);
+
+    SwitchToFarCode();
+    SetJumpTarget(hot);
+    MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_CallFunctionPC(TierUpTrampoline, this, js.blockStart);
+    ABI_PopRegistersAndAdjustStack({}, 0);
+    JMP(asm_routines.dispatcher_no_check, true);
+    SwitchToNearCode();
+  }
 #if defined(_DEBUG) || defined(DEBUGFAST) || defined(NAN_CHECK)
   // should help logged stack-traces become more accurate
   MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
@@ -729,7 +1031,7 @@ u8* Jit64::DoJit(u32 em_address, JitBlock* b, u32 nextPC)
       // the start of the block in case our guess turns out wrong.
       for (int gqr : gqr_static)
       {
-        u32 value = GQR(gqr);
+        u32 value = m_compile_gqrs[gqr];
         js.constantGqr[gqr] = value;
         CMP_or_TEST(32, PPCSTATE(spr[SPR_GQR0 + gqr]), Imm32(value));
         J_CC(CC_NZ, target);
@@ -962,6 +1264,32 @@ u8* Jit64::DoJit(u32 em_address, JitBlock* b, u32 nextPC)
   return normal_entry;
 }
 
+void Jit64::TierUp(u32 em_address)
+{
+  m_trace_addresses.insert(em_address);
+
+  // The dispatcher compiles the trace when it doesn't find the block anymore.
+  if (JitBlock* block = blocks.GetBlockFromStartAddress(em_address, MSR.Hex))
+    blocks.EraseBlock(*block);
+}
+
+bool Jit64::IsHotAddress(u32 address)
+{
+  if (m_trace_addresses.count(address) != 0)
+    return true;
+
+  // A block that has run at least half as often as it takes to tier up is likely on the hot path.
+  // This can't tell which branch leads to the block, but is good enough for loops.
+  const JitBlock* block = blocks.GetBlockFromStartAddress(address, MSR.Hex);
+  return block && block->run_count >= TIER_UP_THRESHOLD / 2;
+}
+
+bool Jit64::IsDataTranslationEnabled() const
+{
+  // The CPU may have moved on since the block was requested.
+  return UReg_MSR(js.curBlock->msrBits).DR;
+}
+
 BitSet8 Jit64::ComputeStaticGQRs(const PPCAnalyst::CodeBlock& cb) const
 {
   return cb.m_gqr_used & ~cb.m_gqr_modified;
@@ -1007,9 +1335,10 @@ void Jit64::IntializeSpeculativeConstants()
   const u8* target = nullptr;
   for (auto i : code_block.m_gpr_inputs)
   {
-    u32 compileTimeValue = PowerPC::ppcState.gpr[i];
-    if (PowerPC::IsOptimizableGatherPipeWrite(compileTimeValue) ||
-        PowerPC::IsOptimizableGatherPipeWrite(compileTimeValue - 0x8000) ||
+    u32 compileTimeValue = m_compile_gprs[i];
+    if ((IsDataTranslationEnabled() &&
+         (PowerPC::IsOptimizableGatherPipeWrite(compileTimeValue) ||
+          PowerPC::IsOptimizableGatherPipeWrite(compileTimeValue - 0x8000))) ||
         compileTimeValue == 0xCC000000)
     {
       if (!target)
@@ -18,7 +18,15 @@
 // ----------
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
 #include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/WorkQueueThread.h"
 #include "Common/x64ABI.h"
 #include "Common/x64Emitter.h"
 #include "Core/PowerPC/Jit64/FPURegCache.h"
@@ -27,6 +35,10 @@
 #include "Core/PowerPC/Jit64/JitRegCache.h"
 #include "Core/PowerPC/Jit64Common/Jit64Base.h"
 #include "Core/PowerPC/JitCommon/JitCache.h"
+#include "Core/PowerPC/JitCommon/JitProfile.h"
+#include "Core/PowerPC/PPCAnalyst.h"
+
+class CachedInterpreter;
 
 namespace PPCAnalyst
 {
@@ -53,6 +65,8 @@ public:
 
   void Jit(u32 em_address) override;
   u8* DoJit(u32 em_address, JitBlock* b, u32 nextPC);
+  // Called by a first-tier block once it has run often enough to be recompiled as a trace.
+  void TierUp(u32 em_address);
 
   BitSet32 CallerSavedRegistersInUse() const;
   BitSet8 ComputeStaticGQRs(const PPCAnalyst::CodeBlock&) const;
@@ -63,6 +77,9 @@ public:
   void Trace();
 
   void ClearCache() override;
+  void ClearSafe() override;
+  void InvalidateICache(u32 address, u32 size, bool forced) override;
+  void FinishPendingCompiles() override;
 
   const CommonAsmRoutines* GetAsmRoutines() override { return &asm_routines; }
   const char* GetName() const override { return "JIT64"; }
@@ -245,6 +262,33 @@ private:
   void AllocStack();
   void FreeStack();
 
+  bool IsHotAddress(u32 address);
+
+  // A block that is analyzed on the CPU thread and compiled on the compile thread.
+  struct CompileRequest
+  {
+    JitBlock* block;
+    u32 next_pc;
+    bool trace;
+    PPCAnalyst::CodeBlock code_block;
+    PPCAnalyst::BlockStats stats;
+    PPCAnalyst::BlockRegStats gpa;
+    PPCAnalyst::BlockRegStats fpa;
+    std::vector<PPCAnalyst::CodeOp> code;
+    std::array<u32, 8> gqrs;
+    std::array<u32, 32> gprs;
+  };
+
+  bool IsDataTranslationEnabled() const override;
+
+  void UpdateBlockProfile(u32 em_address);
+  void PrecompileProfiledBlocks(u32 em_address);
+
+  void RunWhileCompiling(u32 em_address);
+  bool IsCompilePending(u32 em_address) const;
+  void RequestCompile(u32 em_address);
+  void CompileRequestedBlock(CompileRequest& request);
+
   GPRRegCache gpr{*this};
   FPURegCache fpr{*this};
 
@@ -253,4 +297,28 @@ private:
   bool m_enable_blr_optimization;
   bool m_cleanup_after_stackfault;
   u8* m_stack;
+
+  bool m_enable_tiering;
+  // The addresses of hot blocks, which are compiled as traces.
+  std::unordered_set<u32> m_trace_addresses;
+
+  bool m_enable_block_profile;
+  JitBlockProfile m_block_profile;
+
+  // The GQR and GPR values that the block being compiled speculates on. They are copied when
+  // the block is requested, as the CPU carries on while compiling in the background.
+  std::array<u32, 8> m_compile_gqrs;
+  std::array<u32, 32> m_compile_gprs;
+
+  // Background compilation. While blocks are compiled, the CPU thread keeps going in
+  // m_fallback, and it only waits for them at a point that is given by the emulated state.
+  // This way, how long compiling takes can't change what gets executed.
+  std::unique_ptr<Common::WorkQueueThread<CompileRequest*>> m_compile_thread;
+  std::unique_ptr<CachedInterpreter> m_fallback;
+  PPCAnalyst::PPCAnalyzer m_request_analyzer;
+  std::vector<PPCAnalyst::CodeOp> m_request_code_buffer;
+  std::vector<std::unique_ptr<CompileRequest>> m_pending_compiles;
+  size_t m_max_pending_compiles = 0;
+  std::atomic<size_t> m_compiles_in_flight{0};
+  Common::Event m_compiles_done;
 };
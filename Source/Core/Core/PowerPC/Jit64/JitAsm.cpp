@@ -187,9 +187,13 @@ void Jit64AsmRoutineManager::Generate()
   ABI_CallFunction(JitTrampoline);
   ABI_PopRegistersAndAdjustStack({}, 0);
 
+  // When compiling in the background, the rest of the timeslice might have been run already.
+  CMP(32, PPCSTATE(downcount), Imm32(0));
+  FixupBranch timeslice_done = J_CC(CC_LE, true);
   JMP(dispatcher_no_check, true);
 
   SetJumpTarget(bail);
+  SetJumpTarget(timeslice_done);
   do_timing = GetCodePtr();
 
   // make sure npc contains the next pc (needed for exception checking in CoreTiming::Advance)
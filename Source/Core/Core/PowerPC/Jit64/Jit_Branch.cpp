@@ -96,7 +96,7 @@ void Jit64::bx(UGeckoInstruction inst)
   if (inst.LK)
     AND(32, PPCSTATE(cr), Imm32(~(0xFF000000)));
 #endif
-  if (destination == js.compilerPC)
+  if (destination == js.compilerPC || js.op->isIdleLoop)
   {
     ABI_PushRegistersAndAdjustStack({}, 0);
     ABI_CallFunction(CoreTiming::Idle);
@@ -154,6 +154,22 @@ void Jit64::bcx(UGeckoInstruction inst)
     return;
   }
 
+  // A trace continues at the destination of the branch, so the side exit is the path where
+  // the branch isn't taken. It is rarely used, so keep it out of the way in far code.
+  if (!js.isLastInstruction && js.op->traceFollowsBranch)
+  {
+    SwitchToFarCode();
+    if ((inst.BO & BO_DONT_CHECK_CONDITION) == 0)
+      SetJumpTarget(pConditionDontBranch);
+    if ((inst.BO & BO_DONT_DECREMENT_FLAG) == 0)
+      SetJumpTarget(pCTRDontBranch);
+    gpr.Flush(RegCache::FlushMode::MaintainState);
+    fpr.Flush(RegCache::FlushMode::MaintainState);
+    WriteExit(js.compilerPC + 4);
+    SwitchToNearCode();
+    return;
+  }
+
   u32 destination;
   if (inst.AA)
     destination = SignExt16(inst.BD << 2);
@@ -162,7 +178,19 @@ void Jit64::bcx(UGeckoInstruction inst)
 
   gpr.Flush(RegCache::FlushMode::MaintainState);
   fpr.Flush(RegCache::FlushMode::MaintainState);
-  WriteExit(destination, inst.LK, js.compilerPC + 4);
+  if (js.op->isIdleLoop)
+  {
+    // The loop can only be left once an event has happened, so skip ahead to the next one.
+    ABI_PushRegistersAndAdjustStack({}, 0);
+    ABI_CallFunction(CoreTiming::Idle);
+    ABI_PopRegistersAndAdjustStack({}, 0);
+    MOV(32, PPCSTATE(pc), Imm32(destination));
+    WriteExceptionExit();
+  }
+  else
+  {
+    WriteExit(destination, inst.LK, js.compilerPC + 4);
+  }
 
   if ((inst.BO & BO_DONT_CHECK_CONDITION) == 0)
     SetJumpTarget(pConditionDontBranch);
@@ -359,6 +359,11 @@ bool Jit64::CheckMergedBranch(u32 crf) const
   if (!CanMergeNextInstructions(1))
     return false;
 
+  // Merged branches always exit the block when taken, which a trace doesn't want.
+  // bcx also has to skip ahead to the next event when an idle loop branch is taken.
+  if (js.op[1].traceFollowsBranch || js.op[1].isIdleLoop)
+    return false;
+
   const UGeckoInstruction& next = js.op[1].inst;
   return (((next.OPCD == 16 /* bcx */) ||
            ((next.OPCD == 19) && (next.SUBOP10 == 528) /* bcctrx */) ||
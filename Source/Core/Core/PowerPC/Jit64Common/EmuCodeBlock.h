@@ -125,6 +125,10 @@ public:
   void Clear();
 
 protected:
+  // Whether the code being emitted runs with data address translation on. This is MSR.DR by
+  // default, but a JIT that doesn't compile on the CPU thread must go by the block instead.
+  virtual bool IsDataTranslationEnabled() const;
+
   ConstantPool m_const_pool;
   FarCodeCache m_far_code;
   u8* m_near_code;  // Backed up when we switch to far code.
@@ -18,6 +18,7 @@
 #include "Common/x64Reg.h"
 #include "Core/HW/Memmap.h"
 #include "Core/MachineContext.h"
+#include "Core/PowerPC/MMU.h"
 #include "Core/PowerPC/PPCAnalyst.h"
 
 // This generates some fairly heavy trampolines, but it doesn't really hurt.
@@ -32,7 +33,20 @@ bool Jitx86Base::HandleFault(uintptr_t access_address, SContext* ctx)
 
   const auto logical_base_ptr = reinterpret_cast<uintptr_t>(Memory::logical_base);
   if (access_address >= logical_base_ptr && access_address < logical_base_ptr + 0x100010000)
-    return BackPatch(static_cast<u32>(access_address - logical_base_ptr), ctx);
+  {
+    const u32 em_address = static_cast<u32>(access_address - logical_base_ptr);
+
+    // Pages translated by the page table are only mapped once they are accessed. If that's
+    // what happened, the access can be retried as is.
+    const auto it = m_back_patch_info.find(reinterpret_cast<u8*>(ctx->CTX_PC));
+    if (access_address < logical_base_ptr + 0x100000000 && it != m_back_patch_info.end() &&
+        PowerPC::MapPageTableAddress(em_address, !it->second.read))
+    {
+      return true;
+    }
+
+    return BackPatch(em_address, ctx);
+  }
 
   return false;
 }
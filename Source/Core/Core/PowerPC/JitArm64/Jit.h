@@ -169,6 +169,7 @@ private:
   struct FastmemArea
   {
     u32 length;
+    u32 flags;
     const u8* slowmem_code;
   };
 
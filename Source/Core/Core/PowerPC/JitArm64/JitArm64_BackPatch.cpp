@@ -166,12 +166,14 @@ void JitArm64::EmitBackpatchRoutine(u32 flags, bool fastmem, bool do_farcode, AR
         m_handler_to_loc[handler] = handler_loc;
         fastmem_area->slowmem_code = handler_loc;
         fastmem_area->length = fastmem_end - fastmem_start;
+        fastmem_area->flags = flags;
       }
       else
       {
         const u8* handler_loc = handler_loc_iter->second;
         fastmem_area->slowmem_code = handler_loc;
         fastmem_area->length = fastmem_end - fastmem_start;
+        fastmem_area->flags = flags;
         return;
       }
     }
@@ -314,6 +316,17 @@ bool JitArm64::HandleFastmemFault(uintptr_t access_address, SContext* ctx)
   if ((const u8*)ctx->CTX_PC - fault_location > fastmem_area_length)
     return false;
 
+  // Pages translated by the page table are only mapped once they are accessed. If that's
+  // what happened, the access can be retried as is.
+  const uintptr_t logical_base = reinterpret_cast<uintptr_t>(Memory::logical_base);
+  const bool write = (slow_handler_iter->second.flags &
+                      (BackPatchInfo::FLAG_STORE | BackPatchInfo::FLAG_ZERO_256)) != 0;
+  if (access_address >= logical_base && access_address < logical_base + 0x100000000 &&
+      PowerPC::MapPageTableAddress(static_cast<u32>(access_address - logical_base), write))
+  {
+    return true;
+  }
+
   ARM64XEmitter emitter((u8*)fault_location);
 
   emitter.BL(slow_handler_iter->second.slowmem_code);
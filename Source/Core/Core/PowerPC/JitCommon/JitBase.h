@@ -119,6 +119,17 @@ public:
 
   virtual void Jit(u32 em_address) = 0;
 
+  // Used by the emulated CPU to drop blocks. JITs that compile blocks in the background
+  // override these to wait for those blocks first, as they are about to enter the cache.
+  virtual void ClearSafe() { GetBlockCache()->Clear(); }
+  virtual void InvalidateICache(u32 address, u32 size, bool forced)
+  {
+    GetBlockCache()->InvalidateICache(address, size, forced);
+  }
+  // Waits for the blocks that are being compiled in the background, e.g. before changing state
+  // that the compiler reads, like the BAT tables.
+  virtual void FinishPendingCompiles() {}
+
   virtual const CommonAsmRoutinesBase* GetAsmRoutines() = 0;
 
   virtual bool HandleFault(uintptr_t access_address, SContext* ctx) = 0;
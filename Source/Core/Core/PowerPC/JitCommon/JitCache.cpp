@@ -13,9 +13,10 @@
 #include <array>
 #include <cstring>
 #include <functional>
-#include <map>
 #include <set>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/JitRegister.h"
@@ -32,10 +33,30 @@
 
 using namespace Gen;
 
+static void EraseAddressRange(std::unordered_set<u32>& addresses, u32 address, u32 length)
+{
+  // Erasing every address in the range is slow for large ranges like DMA transfers.
+  if (length / 4 > addresses.size())
+  {
+    for (auto it = addresses.begin(); it != addresses.end();)
+    {
+      if (*it - address < length)
+        it = addresses.erase(it);
+      else
+        ++it;
+    }
+    return;
+  }
+
+  for (u32 i = address; i < address + length; i += 4)
+    addresses.erase(i);
+}
+
 bool JitBlock::OverlapsPhysicalRange(u32 address, u32 length) const
 {
-  return physical_addresses.lower_bound(address) !=
-         physical_addresses.lower_bound(address + length);
+  const auto begin = physical_addresses.begin();
+  const auto end = physical_addresses.end();
+  return std::lower_bound(begin, end, address) != std::lower_bound(begin, end, address + length);
 }
 
 JitBaseBlockCache::JitBaseBlockCache(JitBase& jit) : m_jit{jit}
@@ -65,13 +86,17 @@ void JitBaseBlockCache::Clear()
 #endif
   m_jit.js.fifoWriteAddresses.clear();
   m_jit.js.pairedQuantizeAddresses.clear();
-  for (auto& e : block_map)
-  {
-    DestroyBlock(e.second);
-  }
-  block_map.clear();
-  links_to.clear();
-  block_range_map.clear();
+  block_map.ForEach([this](u32, JitBlock* block) {
+    for (; block; block = block->next_in_block_map)
+      DestroyBlock(*block);
+  });
+  block_map.Clear();
+  links_to.Clear();
+  block_range_map.Clear();
+
+  free_blocks.clear();
+  for (JitBlock& block : block_storage)
+    free_blocks.push_back(&block);
 
   valid_block.ClearAll();
 
@@ -91,19 +116,49 @@ JitBlock** JitBaseBlockCache::GetFastBlockMap()
 
 void JitBaseBlockCache::RunOnBlocks(std::function<void(const JitBlock&)> f)
 {
-  for (const auto& e : block_map)
-    f(e.second);
+  block_map.ForEach([&f](u32, const JitBlock* block) {
+    for (; block; block = block->next_in_block_map)
+      f(*block);
+  });
 }
 
 JitBlock* JitBaseBlockCache::AllocateBlock(u32 em_address)
 {
   u32 physicalAddress = PowerPC::JitCache_TranslateAddress(em_address).address;
-  JitBlock& b = block_map.emplace(physicalAddress, JitBlock())->second;
+
+  JitBlock* block;
+  if (free_blocks.empty())
+  {
+    block = &block_storage.emplace_back();
+  }
+  else
+  {
+    block = free_blocks.back();
+    free_blocks.pop_back();
+
+    // Keep the capacity of the vectors of the old block around.
+    std::vector<JitBlock::LinkData> link_data = std::move(block->linkData);
+    std::vector<u32> physical_addresses = std::move(block->physical_addresses);
+    *block = JitBlock();
+    block->linkData = std::move(link_data);
+    block->physical_addresses = std::move(physical_addresses);
+  }
+
+  JitBlock& b = *block;
   b.effectiveAddress = em_address;
   b.physicalAddress = physicalAddress;
   b.msrBits = MSR.Hex & JIT_CACHE_MSR_MASK;
+  b.next_in_block_map = nullptr;
   b.linkData.clear();
+  b.physical_addresses.clear();
   b.fast_block_map_index = 0;
+
+  // Append the block, so that older blocks with the same address are found first.
+  JitBlock** next = &block_map[physicalAddress];
+  while (*next)
+    next = &(*next)->next_in_block_map;
+  *next = &b;
+
   return &b;
 }
 
@@ -114,22 +169,15 @@ void JitBaseBlockCache::FinalizeBlock(JitBlock& block, bool block_link,
   fast_block_map[index] = &block;
   block.fast_block_map_index = index;
 
-  block.physical_addresses = physical_addresses;
+  block.physical_addresses.assign(physical_addresses.begin(), physical_addresses.end());
 
-  u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
   for (u32 addr : physical_addresses)
-  {
     valid_block.Set(addr / 32);
-    block_range_map[addr & range_mask].insert(&block);
-  }
+  AddToRangeIndex(block);
 
   if (block_link)
   {
-    for (const auto& e : block.linkData)
-    {
-      links_to.emplace(e.exitAddress, &block);
-    }
-
+    AddLinks(block);
     LinkBlock(block);
   }
 
@@ -160,12 +208,11 @@ JitBlock* JitBaseBlockCache::GetBlockFromStartAddress(u32 addr, u32 msr)
     translated_addr = translated.address;
   }
 
-  auto iter = block_map.equal_range(translated_addr);
-  for (; iter.first != iter.second; iter.first++)
+  JitBlock* const* first = block_map.Find(translated_addr);
+  for (JitBlock* b = first ? *first : nullptr; b; b = b->next_in_block_map)
   {
-    JitBlock& b = iter.first->second;
-    if (b.effectiveAddress == addr && b.msrBits == (msr & JIT_CACHE_MSR_MASK))
-      return &b;
+    if (b->effectiveAddress == addr && b->msrBits == (msr & JIT_CACHE_MSR_MASK))
+      return b;
   }
 
   return nullptr;
@@ -212,62 +259,69 @@ void JitBaseBlockCache::InvalidateICache(u32 address, u32 length, bool forced)
     // being in the right place between instructions).
     if (!forced)
     {
-      for (u32 i = address; i < address + length; i += 4)
-      {
-        m_jit.js.fifoWriteAddresses.erase(i);
-        m_jit.js.pairedQuantizeAddresses.erase(i);
-      }
+      EraseAddressRange(m_jit.js.fifoWriteAddresses, address, length);
+      EraseAddressRange(m_jit.js.pairedQuantizeAddresses, address, length);
     }
   }
 }
 
 void JitBaseBlockCache::ErasePhysicalRange(u32 address, u32 length)
 {
-  // Iterate over all macro blocks which overlap the given range.
-  u32 range_mask = ~(BLOCK_RANGE_MAP_ELEMENTS - 1);
-  auto start = block_range_map.lower_bound(address & range_mask);
-  auto end = block_range_map.lower_bound(address + length);
-  while (start != end)
-  {
-    // Iterate over all blocks in the macro block.
-    auto iter = start->second.begin();
-    while (iter != start->second.end())
+  if (length == 0)
+    return;
+
+  const u32 end_address = address + length;
+  const u32 first_page = address >> BLOCK_RANGE_MAP_PAGE_SHIFT;
+  const u32 last_page = static_cast<u32>((u64{address} + length - 1) >> BLOCK_RANGE_MAP_PAGE_SHIFT);
+
+  // Collect the blocks first, since erasing them modifies the range index.
+  blocks_to_erase.clear();
+  const auto collect = [&](const std::vector<RangeEntry>& entries) {
+    for (const RangeEntry& entry : entries)
     {
-      JitBlock* block = *iter;
-      if (block->OverlapsPhysicalRange(address, length))
+      if (entry.first_address < end_address && entry.last_address >= address &&
+          entry.block->OverlapsPhysicalRange(address, length))
       {
-        // If the block overlaps, also remove all other occupied slots in the other macro blocks.
-        // This will leak empty macro blocks, but they may be reused or cleared later on.
-        for (u32 addr : block->physical_addresses)
-          if ((addr & range_mask) != start->first)
-            block_range_map[addr & range_mask].erase(block);
-
-        // And remove the block.
-        DestroyBlock(*block);
-        auto block_map_iter = block_map.equal_range(block->physicalAddress);
-        while (block_map_iter.first != block_map_iter.second)
-        {
-          if (&block_map_iter.first->second == block)
-          {
-            block_map.erase(block_map_iter.first);
-            break;
-          }
-          block_map_iter.first++;
-        }
-        iter = start->second.erase(iter);
-      }
-      else
-      {
-        iter++;
+        blocks_to_erase.push_back(entry.block);
       }
     }
+  };
 
-    // If the macro block is empty, drop it.
-    if (start->second.empty())
-      start = block_range_map.erase(start);
-    else
-      start++;
+  // Large ranges (like a whole DMA transfer) can cover far more pages than contain code.
+  if (last_page - first_page >= block_range_map.size())
+  {
+    block_range_map.ForEach([&](u32 page, const std::vector<RangeEntry>& entries) {
+      if (page >= first_page && page <= last_page)
+        collect(entries);
+    });
+  }
+  else
+  {
+    for (u32 page = first_page; page <= last_page; ++page)
+    {
+      if (const std::vector<RangeEntry>* entries = block_range_map.Find(page))
+        collect(*entries);
+    }
   }
+
+  if (blocks_to_erase.empty())
+    return;
+
+  // A block that spans several pages was found once per page.
+  std::sort(blocks_to_erase.begin(), blocks_to_erase.end());
+  blocks_to_erase.erase(std::unique(blocks_to_erase.begin(), blocks_to_erase.end()),
+                        blocks_to_erase.end());
+
+  for (JitBlock* block : blocks_to_erase)
+    EraseBlock(*block);
+}
+
+void JitBaseBlockCache::EraseBlock(JitBlock& block)
+{
+  RemoveFromRangeIndex(block);
+  RemoveFromBlockMap(block);
+  DestroyBlock(block);
+  FreeBlock(block);
 }
 
 u32* JitBaseBlockCache::GetBlockBitSet() const
@@ -304,13 +358,16 @@ void JitBaseBlockCache::LinkBlockExits(JitBlock& block)
 void JitBaseBlockCache::LinkBlock(JitBlock& block)
 {
   LinkBlockExits(block);
-  auto ppp = links_to.equal_range(block.effectiveAddress);
 
-  for (auto iter = ppp.first; iter != ppp.second; ++iter)
+  // Link the exits of other blocks which point to this block
+  JitBlock::LinkData* const* first = links_to.Find(block.effectiveAddress);
+  for (JitBlock::LinkData* e = first ? *first : nullptr; e; e = e->next_link)
   {
-    JitBlock& b2 = *iter->second;
-    if (block.msrBits == b2.msrBits)
-      LinkBlockExits(b2);
+    if (!e->linkStatus && e->source_block->msrBits == block.msrBits)
+    {
+      WriteLinkBlock(*e, &block);
+      e->linkStatus = true;
+    }
   }
 }
 
@@ -322,22 +379,15 @@ void JitBaseBlockCache::UnlinkBlock(const JitBlock& block)
     WriteLinkBlock(e, nullptr);
   }
 
-  // Unlink all exits of other blocks which points to this block
-  auto ppp = links_to.equal_range(block.effectiveAddress);
-  for (auto iter = ppp.first; iter != ppp.second; ++iter)
+  // Unlink all exits of other blocks which point to this block
+  JitBlock::LinkData* const* first = links_to.Find(block.effectiveAddress);
+  for (JitBlock::LinkData* e = first ? *first : nullptr; e; e = e->next_link)
   {
-    JitBlock& sourceBlock = *iter->second;
-    if (sourceBlock.msrBits != block.msrBits)
+    if (e->source_block->msrBits != block.msrBits)
       continue;
 
-    for (auto& e : sourceBlock.linkData)
-    {
-      if (e.exitAddress == block.effectiveAddress)
-      {
-        WriteLinkBlock(e, nullptr);
-        e.linkStatus = false;
-      }
-    }
+    WriteLinkBlock(*e, nullptr);
+    e->linkStatus = false;
   }
 }
 
@@ -349,22 +399,118 @@ void JitBaseBlockCache::DestroyBlock(JitBlock& block)
   UnlinkBlock(block);
 
   // Delete linking addresses
-  for (const auto& e : block.linkData)
-  {
-    auto it = links_to.equal_range(e.exitAddress);
-    while (it.first != it.second)
-    {
-      if (it.first->second == &block)
-        it.first = links_to.erase(it.first);
-      else
-        it.first++;
-    }
-  }
+  RemoveLinks(block);
 
   // Raise an signal if we are going to call this block again
   WriteDestroyBlock(block);
 }
 
+void JitBaseBlockCache::AddLinks(JitBlock& block)
+{
+  for (auto& e : block.linkData)
+  {
+    JitBlock::LinkData*& first = links_to[e.exitAddress];
+    e.source_block = &block;
+    e.prev_link = nullptr;
+    e.next_link = first;
+    if (first)
+      first->prev_link = &e;
+    first = &e;
+  }
+}
+
+void JitBaseBlockCache::RemoveLinks(JitBlock& block)
+{
+  for (auto& e : block.linkData)
+  {
+    if (e.source_block != &block)
+      continue;
+
+    if (e.next_link)
+      e.next_link->prev_link = e.prev_link;
+
+    if (e.prev_link)
+      e.prev_link->next_link = e.next_link;
+    else if (e.next_link)
+      links_to[e.exitAddress] = e.next_link;
+    else
+      links_to.Erase(e.exitAddress);
+
+    e.source_block = nullptr;
+    e.prev_link = nullptr;
+    e.next_link = nullptr;
+  }
+}
+
+void JitBaseBlockCache::AddToRangeIndex(JitBlock& block)
+{
+  if (block.physical_addresses.empty())
+    return;
+
+  const RangeEntry entry{&block, block.physical_addresses.front(),
+                         block.physical_addresses.back()};
+  u32 previous_page = 0;
+  bool first = true;
+  for (u32 addr : block.physical_addresses)
+  {
+    const u32 page = addr >> BLOCK_RANGE_MAP_PAGE_SHIFT;
+    if (!first && page == previous_page)
+      continue;
+
+    block_range_map[page].push_back(entry);
+    previous_page = page;
+    first = false;
+  }
+}
+
+void JitBaseBlockCache::RemoveFromRangeIndex(JitBlock& block)
+{
+  u32 previous_page = 0;
+  bool first = true;
+  for (u32 addr : block.physical_addresses)
+  {
+    const u32 page = addr >> BLOCK_RANGE_MAP_PAGE_SHIFT;
+    if (!first && page == previous_page)
+      continue;
+    previous_page = page;
+    first = false;
+
+    // Empty pages are kept, since code is usually loaded to the same place again.
+    std::vector<RangeEntry>* entries = block_range_map.Find(page);
+    if (!entries)
+      continue;
+    auto it = std::find_if(entries->begin(), entries->end(),
+                           [&block](const RangeEntry& entry) { return entry.block == &block; });
+    if (it == entries->end())
+      continue;
+    *it = entries->back();
+    entries->pop_back();
+  }
+}
+
+void JitBaseBlockCache::RemoveFromBlockMap(JitBlock& block)
+{
+  JitBlock** first = block_map.Find(block.physicalAddress);
+  if (!first)
+    return;
+
+  JitBlock** next = first;
+  while (*next && *next != &block)
+    next = &(*next)->next_in_block_map;
+  if (!*next)
+    return;
+
+  *next = block.next_in_block_map;
+  block.next_in_block_map = nullptr;
+  if (!*first)
+    block_map.Erase(block.physicalAddress);
+}
+
+void JitBaseBlockCache::FreeBlock(JitBlock& block)
+{
+  free_blocks.push_back(&block);
+}
+
 JitBlock* JitBaseBlockCache::MoveBlockIntoFastCache(u32 addr, u32 msr)
 {
   JitBlock* block = GetBlockFromStartAddress(addr, msr);
@@ -7,13 +7,14 @@
 #include <array>
 #include <bitset>
 #include <cstring>
+#include <deque>
 #include <functional>
-#include <map>
 #include <memory>
 #include <set>
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/FlatHashMap.h"
 
 class JitBase;
 
@@ -43,6 +44,8 @@ struct JitBlock
   // and valid_block in particular). This is useful because of
   // of the way the instruction cache works on PowerPC.
   u32 physicalAddress;
+  // The next block in block_map with the same physical address.
+  JitBlock* next_in_block_map;
   // The number of bytes of JIT'ed code contained in this block. Mostly
   // useful for logging.
   u32 codeSize;
@@ -58,11 +61,17 @@ struct JitBlock
     u32 exitAddress;
     bool linkStatus;  // is it already linked?
     bool call;
+
+    // The exits to the same address form an intrusive list, whose head is in links_to.
+    // These are only set for blocks that were finalized with block linking enabled.
+    JitBlock* source_block = nullptr;
+    LinkData* prev_link = nullptr;
+    LinkData* next_link = nullptr;
   };
   std::vector<LinkData> linkData;
 
-  // This set stores all physical addresses of all occupied instructions.
-  std::set<u32> physical_addresses;
+  // The sorted physical addresses of all occupied instructions.
+  std::vector<u32> physical_addresses;
 
   // Block profiling data, structure is inlined in Jit.cpp
   struct ProfileData
@@ -74,6 +83,9 @@ struct JitBlock
     u64 ticStop;
   } profile_data = {};
 
+  // The number of times the block was entered. Only counted by JITs that recompile hot blocks.
+  u32 run_count = 0;
+
   // This tracks the position if this block within the fast block cache.
   // We allow each block to have only one map entry.
   size_t fast_block_map_index;
@@ -149,6 +161,8 @@ public:
 
   void InvalidateICache(u32 address, u32 length, bool forced);
   void ErasePhysicalRange(u32 address, u32 length);
+  // Erases a single block, so that it gets compiled again the next time it's reached.
+  void EraseBlock(JitBlock& block);
 
   u32* GetBlockBitSet() const;
 
@@ -169,19 +183,44 @@ private:
   // Fast but risky block lookup based on fast_block_map.
   size_t FastLookupIndexForAddress(u32 address);
 
-  // links_to hold all exit points of all valid blocks in a reverse way.
-  // It is used to query all blocks which links to an address.
-  std::multimap<u32, JitBlock*> links_to;  // destination_PC -> number
+  void AddLinks(JitBlock& block);
+  void RemoveLinks(JitBlock& block);
+  void AddToRangeIndex(JitBlock& block);
+  void RemoveFromRangeIndex(JitBlock& block);
+  void RemoveFromBlockMap(JitBlock& block);
+  void FreeBlock(JitBlock& block);
+
+  // An entry of block_range_map. The bounds of the block are kept next to the pointer,
+  // so that most blocks in a page can be skipped without touching them.
+  struct RangeEntry
+  {
+    JitBlock* block;
+    u32 first_address;
+    u32 last_address;
+  };
+
+  // links_to holds all exit points of all valid blocks in a reverse way.
+  // It is used to query all blocks which link to an address. Each value is
+  // the head of an intrusive list of JitBlock::LinkData.
+  Common::FlatHashMap<u32, JitBlock::LinkData*> links_to;  // destination_PC -> exits
 
   // Map indexed by the physical address of the entry point.
   // This is used to query the block based on the current PC in a slow way.
-  std::multimap<u32, JitBlock> block_map;  // start_addr -> block
+  // Blocks with the same physical address are chained with next_in_block_map.
+  Common::FlatHashMap<u32, JitBlock*> block_map;  // start_addr -> first block
+
+  // Storage of all blocks. Destroyed blocks are put on free_blocks and reused,
+  // so that blocks don't move and compiling a block usually doesn't allocate.
+  std::deque<JitBlock> block_storage;
+  std::vector<JitBlock*> free_blocks;
+
+  // Blocks indexed by the pages of physical memory that they occupy.
+  // This is used for invalidation of memory regions.
+  static constexpr u32 BLOCK_RANGE_MAP_PAGE_SHIFT = 12;
+  Common::FlatHashMap<u32, std::vector<RangeEntry>> block_range_map;  // page -> blocks
 
-  // Range of overlapping code indexed by a masked physical address.
-  // This is used for invalidation of memory regions. The range is grouped
-  // in macro blocks of each 0x100 bytes.
-  static constexpr u32 BLOCK_RANGE_MAP_ELEMENTS = 0x100;
-  std::map<u32, std::set<JitBlock*>> block_range_map;
+  // Reused by ErasePhysicalRange to collect the blocks to erase.
+  std::vector<JitBlock*> blocks_to_erase;
 
   // This bitsets shows which cachelines overlap with any blocks.
   // It is used to provide a fast way to query if no icache invalidation is needed.
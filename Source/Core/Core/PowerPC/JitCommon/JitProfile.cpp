@@ -0,0 +1,256 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/PowerPC/JitCommon/JitProfile.h"
+
+#include <algorithm>
+#include <set>
+#include <tuple>
+
+#include "Common/CommonPaths.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+#include "Core/PowerPC/MMU.h"
+
+constexpr u32 PROFILE_MAGIC = 0x4650424A;  // "JBPF"
+constexpr u32 PROFILE_VERSION = 2;          // Last changed when removing run counts
+
+// The profile keeps the most recently recorded blocks if there are more than this.
+constexpr size_t MAX_ENTRIES = 0x20000;
+
+struct ProfileHeader
+{
+  u32 magic;
+  u32 version;
+  u32 num_entries;
+  u32 num_recordings;
+};
+
+static bool IsSameBlock(const JitBlockProfile::Entry& a, const JitBlockProfile::Entry& b)
+{
+  return a.address == b.address && a.msr_bits == b.msr_bits;
+}
+
+static bool IsBefore(const JitBlockProfile::Entry& a, const JitBlockProfile::Entry& b)
+{
+  return std::tie(a.address, a.msr_bits) < std::tie(b.address, b.msr_bits);
+}
+
+static bool IsMoreRecent(const JitBlockProfile::Entry& a, const JitBlockProfile::Entry& b)
+{
+  return a.last_recording > b.last_recording;
+}
+
+// Unlike Memory::Read_U32, this doesn't complain about addresses outside of RAM,
+// such as the locked L1 cache.
+static bool ReadPhysicalInstruction(u32 address, u32* instruction)
+{
+  const bool in_ram = address < Memory::REALRAM_SIZE ||
+                      (Memory::m_pEXRAM && (address >> 28) == 0x1 &&
+                       (address & 0x0FFFFFFF) < Memory::EXRAM_SIZE);
+  if (!in_ram)
+    return false;
+
+  *instruction = Memory::Read_U32(address);
+  return true;
+}
+
+void JitBlockProfile::SetGame(const std::string& game_id)
+{
+  if (game_id == m_game_id)
+    return;
+
+  Save();
+
+  m_game_id = game_id;
+  m_path.clear();
+  m_num_recordings = 0;
+  m_entries.clear();
+  m_pending.clear();
+  if (!game_id.empty())
+  {
+    m_path = File::GetUserPath(D_CACHE_IDX) + game_id + ".jitprofile";
+    Load();
+  }
+}
+
+void JitBlockProfile::Load()
+{
+  File::IOFile file(m_path, "rb");
+  ProfileHeader header;
+  if (!file || !file.ReadArray(&header, 1))
+    return;
+
+  if (header.magic != PROFILE_MAGIC || header.version != PROFILE_VERSION ||
+      header.num_entries > MAX_ENTRIES)
+  {
+    WARN_LOG(DYNA_REC, "Ignoring invalid JIT profile %s", m_path.c_str());
+    return;
+  }
+
+  m_entries.resize(header.num_entries);
+  if (!file.ReadArray(m_entries.data(), m_entries.size()) ||
+      !std::is_sorted(m_entries.begin(), m_entries.end(), IsBefore))
+  {
+    WARN_LOG(DYNA_REC, "Ignoring invalid JIT profile %s", m_path.c_str());
+    m_entries.clear();
+    return;
+  }
+  m_num_recordings = header.num_recordings;
+
+  for (const Entry& entry : m_entries)
+    m_pending.emplace_hint(m_pending.end(), std::make_pair(entry.address, entry.msr_bits), entry);
+
+  INFO_LOG(DYNA_REC, "Loaded %zu blocks from JIT profile %s", m_entries.size(), m_path.c_str());
+}
+
+void JitBlockProfile::Save() const
+{
+  if (m_path.empty() || m_entries.empty())
+    return;
+
+  File::CreateFullPath(m_path);
+  File::IOFile file(m_path, "wb");
+  const ProfileHeader header{PROFILE_MAGIC, PROFILE_VERSION, static_cast<u32>(m_entries.size()),
+                            m_num_recordings};
+  if (!file.WriteArray(&header, 1) || !file.WriteArray(m_entries.data(), m_entries.size()))
+    ERROR_LOG(DYNA_REC, "Failed to write JIT profile %s", m_path.c_str());
+}
+
+void JitBlockProfile::Record(JitBaseBlockCache& block_cache)
+{
+  if (m_path.empty())
+    return;
+
+  // Blocks only count how often they run while tiering or profiling is on, which costs time
+  // on every block entry. Instead, the profile keeps track of when blocks were last seen.
+  ++m_num_recordings;
+  std::vector<Entry> recorded;
+  block_cache.RunOnBlocks([this, &recorded](const JitBlock& block) {
+    Entry entry{};
+    entry.address = block.effectiveAddress;
+    entry.msr_bits = block.msrBits;
+    if (!ReadPhysicalInstruction(block.physicalAddress, &entry.first_instruction))
+      return;
+    entry.hash = HashInstructions(block.physical_addresses);
+    entry.last_recording = m_num_recordings;
+    recorded.push_back(entry);
+  });
+  std::sort(recorded.begin(), recorded.end(), IsBefore);
+
+  // Merge with what was there. The code at an address may have changed since, so recorded
+  // entries replace old ones.
+  std::vector<Entry> merged;
+  merged.reserve(m_entries.size() + recorded.size());
+  auto old_it = m_entries.begin();
+  for (const Entry& entry : recorded)
+  {
+    while (old_it != m_entries.end() && IsBefore(*old_it, entry))
+      merged.push_back(*old_it++);
+    if (old_it != m_entries.end() && IsSameBlock(*old_it, entry))
+      ++old_it;
+
+    // The same block may have been compiled more than once.
+    if (!merged.empty() && IsSameBlock(merged.back(), entry))
+      merged.back() = entry;
+    else
+      merged.push_back(entry);
+  }
+  merged.insert(merged.end(), old_it, m_entries.end());
+
+  if (merged.size() > MAX_ENTRIES)
+  {
+    std::nth_element(merged.begin(), merged.begin() + MAX_ENTRIES, merged.end(), IsMoreRecent);
+    merged.resize(MAX_ENTRIES);
+    std::sort(merged.begin(), merged.end(), IsBefore);
+  }
+
+  m_entries = std::move(merged);
+}
+
+bool JitBlockProfile::IsPending(u32 address) const
+{
+  const auto it = m_pending.lower_bound({address, 0});
+  return it != m_pending.end() && it->first.first == address;
+}
+
+static bool IsLoaded(const JitBlockProfile::Entry& entry)
+{
+  const PowerPC::TranslateResult translated = PowerPC::JitCache_TranslateAddress(entry.address);
+  u32 instruction;
+  return translated.valid && ReadPhysicalInstruction(translated.address, &instruction) &&
+         instruction == entry.first_instruction;
+}
+
+std::vector<JitBlockProfile::Entry> JitBlockProfile::TakeLoadedBlocks(u32 address, u32 msr_bits,
+                                                                      size_t max_count)
+{
+  // Code gets loaded in contiguous pieces, so rather than checking every pending block, this
+  // looks at up to max_count blocks on either side of the address, and stops at the first one
+  // whose code isn't there.
+  std::vector<PendingMap::iterator> loaded;
+  const auto start = m_pending.lower_bound({address, 0});
+  size_t count = 0;
+  for (auto it = start; it != m_pending.end() && count < max_count; ++it)
+  {
+    if (it->second.msr_bits != msr_bits)
+      continue;
+    if (!IsLoaded(it->second))
+      break;
+    loaded.push_back(it);
+    count++;
+  }
+  count = 0;
+  for (auto it = start; it != m_pending.begin() && count < max_count;)
+  {
+    --it;
+    if (it->second.msr_bits != msr_bits)
+      continue;
+    if (!IsLoaded(it->second))
+      break;
+    loaded.push_back(it);
+    count++;
+  }
+
+  // Nearby code is the most likely to run next.
+  const auto distance = [address](PendingMap::iterator it) {
+    return it->second.address >= address ? it->second.address - address :
+                                            address - it->second.address;
+  };
+  std::stable_sort(loaded.begin(), loaded.end(),
+                   [&distance](PendingMap::iterator a, PendingMap::iterator b) {
+                     return distance(a) < distance(b);
+                   });
+  if (loaded.size() > max_count)
+    loaded.resize(max_count);
+
+  std::vector<Entry> entries;
+  entries.reserve(loaded.size());
+  for (PendingMap::iterator it : loaded)
+  {
+    entries.push_back(it->second);
+    m_pending.erase(it);
+  }
+  return entries;
+}
+
+template <typename Container>
+u64 JitBlockProfile::HashInstructions(const Container& physical_addresses)
+{
+  // FNV-1a over the instruction words.
+  u64 hash = 0xCBF29CE484222325;
+  for (u32 address : physical_addresses)
+  {
+    u32 instruction = 0;
+    ReadPhysicalInstruction(address, &instruction);
+    hash = (hash ^ instruction) * 0x100000001B3;
+  }
+  return hash;
+}
+
+template u64 JitBlockProfile::HashInstructions(const std::vector<u32>&);
+template u64 JitBlockProfile::HashInstructions(const std::set<u32>&);
@@ -0,0 +1,69 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+class JitBaseBlockCache;
+
+// A record of the blocks that a game has run, which is kept in the cache directory across
+// sessions. The next time the game runs, the blocks can be compiled before they are reached
+// instead of one at a time as the game gets to them.
+class JitBlockProfile
+{
+public:
+  struct Entry
+  {
+    u32 address;
+    u32 msr_bits;
+    // The first instruction, to tell cheaply whether the code is in memory yet.
+    u32 first_instruction;
+    u32 padding;
+    // A hash of all instructions of the block.
+    u64 hash;
+    // The number of the recording that last found the block in the cache.
+    u64 last_recording;
+  };
+
+  // Saves the profile of the current game, and loads the profile of the given one.
+  // An empty game ID disables the profile.
+  void SetGame(const std::string& game_id);
+  const std::string& GetGame() const { return m_game_id; }
+
+  void Save() const;
+
+  // Adds the blocks that are currently in the cache.
+  void Record(JitBaseBlockCache& block_cache);
+
+  // Whether the address was in the profile when it was loaded, and hasn't been taken yet.
+  bool IsPending(u32 address) const;
+
+  // Takes up to max_count of the pending blocks around the given address whose code is in
+  // memory, nearest first.
+  std::vector<Entry> TakeLoadedBlocks(u32 address, u32 msr_bits, size_t max_count);
+
+  // Hashes the instructions at the given physical addresses.
+  template <typename Container>
+  static u64 HashInstructions(const Container& physical_addresses);
+
+private:
+  void Load();
+
+  std::string m_game_id;
+  std::string m_path;
+  u32 m_num_recordings = 0;
+
+  // Everything that will be saved, sorted by address and MSR bits.
+  std::vector<Entry> m_entries;
+
+  // The blocks of the loaded profile that haven't been compiled yet, by address and MSR bits.
+  using PendingMap = std::map<std::pair<u32, u32>, Entry>;
+  PendingMap m_pending;
+};
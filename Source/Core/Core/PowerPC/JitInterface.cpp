@@ -212,13 +212,19 @@ void ClearCache()
 void ClearSafe()
 {
   if (g_jit)
-    g_jit->GetBlockCache()->Clear();
+    g_jit->ClearSafe();
 }
 
 void InvalidateICache(u32 address, u32 size, bool forced)
 {
   if (g_jit)
-    g_jit->GetBlockCache()->InvalidateICache(address, size, forced);
+    g_jit->InvalidateICache(address, size, forced);
+}
+
+void FinishPendingCompiles()
+{
+  if (g_jit)
+    g_jit->FinishPendingCompiles();
 }
 
 void CompileExceptionCheck(ExceptionType type)
@@ -250,11 +256,11 @@ void CompileExceptionCheck(ExceptionType type)
       if (optype != OpType::Store && optype != OpType::StoreFP && optype != OpType::StorePS)
         return;
     }
-    exception_addresses->insert(PC);
-
     // Invalidate the JIT block so that it gets recompiled with the external exception check
-    // included.
-    g_jit->GetBlockCache()->InvalidateICache(PC, 4, true);
+    // included. This also waits for the blocks that are being compiled in the background,
+    // which read the exception addresses, so that they can be changed safely afterwards.
+    g_jit->InvalidateICache(PC, 4, true);
+    exception_addresses->insert(PC);
   }
 }
 
@@ -63,6 +63,9 @@ void ClearSafe();
 // If "forced" is true, a recompile is being requested on code that hasn't been modified.
 void InvalidateICache(u32 address, u32 size, bool forced);
 
+// Waits for blocks that are being compiled in the background to be done.
+void FinishPendingCompiles();
+
 void CompileExceptionCheck(ExceptionType type);
 
 void Shutdown();
@@ -4,9 +4,12 @@
 
 #include "Core/PowerPC/MMU.h"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstring>
 #include <string>
+#include <vector>
 
 #include "Common/BitUtils.h"
 #include "Common/CommonTypes.h"
@@ -644,9 +647,6 @@ bool IsOptimizableRAMAddress(const u32 address)
   if (PowerPC::memchecks.HasAny())
     return false;
 
-  if (!MSR.DR)
-    return false;
-
   // TODO: This API needs to take an access size
   //
   // We store whether an access can be optimized to an unchecked access
@@ -794,9 +794,6 @@ u32 IsOptimizableMMIOAccess(u32 address, u32 access_size)
   if (PowerPC::memchecks.HasAny())
     return 0;
 
-  if (!MSR.DR)
-    return 0;
-
   // Translate address
   // If we also optimize for TLB mappings, we'd have to clear the
   // JitCache on each TLB invalidation.
@@ -816,9 +813,6 @@ bool IsOptimizableGatherPipeWrite(u32 address)
   if (PowerPC::memchecks.HasAny())
     return false;
 
-  if (!MSR.DR)
-    return false;
-
   // Translate address, only check BAT mapping.
   // If we also optimize for TLB mappings, we'd have to clear the
   // JitCache on each TLB invalidation.
@@ -966,8 +960,28 @@ static void GenerateISIException(u32 effective_address)
   WARN_LOG(POWERPC, "ISI exception at 0x%08x", PC);
 }
 
+// The pages that have been mapped into the logical address space for the page table, by TLB
+// set. They stay mapped until the TLB entries that could be caching their translation are
+// invalidated, which software has to do whenever it changes the page table.
+static std::array<std::vector<u32>, HW_PAGE_INDEX_MASK + 1> s_page_table_mappings;
+
+static void UnmapPageTableSet(std::vector<u32>& pages)
+{
+  for (u32 page : pages)
+    Memory::UnmapPageTablePage(page);
+  pages.clear();
+}
+
+static void UnmapPageTable()
+{
+  for (std::vector<u32>& pages : s_page_table_mappings)
+    UnmapPageTableSet(pages);
+}
+
 void SDRUpdated()
 {
+  UnmapPageTable();
+
   u32 htabmask = SDR1_HTABMASK(PowerPC::ppcState.spr[SPR_SDR]);
   if (!Common::IsValidLowMask(htabmask))
   {
@@ -1066,6 +1080,8 @@ void InvalidateTLBEntry(u32 address)
   TLBEntry& tlbe_i = ppcState.tlb[1][entry_index];
   tlbe_i.tag[0] = TLBEntry::INVALID_TAG;
   tlbe_i.tag[1] = TLBEntry::INVALID_TAG;
+
+  UnmapPageTableSet(s_page_table_mappings[entry_index]);
 }
 
 // Page Address Translation
@@ -1161,6 +1177,39 @@ static TranslateAddressResult TranslatePageAddress(const u32 address, const XChe
   return TranslateAddressResult{TranslateAddressResult::PAGE_FAULT, 0};
 }
 
+bool MapPageTableAddress(u32 address, bool write)
+{
+  if (!MSR.DR)
+    return false;
+
+  u32 bat_address = address;
+  if (TranslateBatAddess(dbat_table, &bat_address))
+    return false;
+
+  // Fastmem doesn't support memchecks.
+  const u32 page = address & ~static_cast<u32>(HW_PAGE_SIZE - 1);
+  if (PowerPC::memchecks.OverlapsMemcheck(page, HW_PAGE_SIZE))
+    return false;
+
+  // This does what the slow path would have, including setting the R and C bits. Mapping
+  // pages read-only until they are written to keeps the C bit correct.
+  const TranslateAddressResult translated =
+      write ? TranslatePageAddress(address, XCheckTLBFlag::Write) :
+              TranslatePageAddress(address, XCheckTLBFlag::Read);
+  if (translated.result != TranslateAddressResult::PAGE_TABLE_TRANSLATED)
+    return false;
+
+  const u32 translated_page = translated.address & ~static_cast<u32>(HW_PAGE_SIZE - 1);
+  if (!Memory::MapPageTablePage(page, translated_page, write))
+    return false;
+
+  const u32 entry_index = (page >> HW_PAGE_INDEX_SHIFT) & HW_PAGE_INDEX_MASK;
+  std::vector<u32>& pages = s_page_table_mappings[entry_index];
+  if (std::find(pages.begin(), pages.end(), page) == pages.end())
+    pages.push_back(page);
+  return true;
+}
+
 static void UpdateBATs(BatTable& bat_table, u32 base_spr)
 {
   // TODO: Separate BATs for MSR.PR==0 and MSR.PR==1
@@ -1253,6 +1302,9 @@ static void UpdateFakeMMUBat(BatTable& bat_table, u32 start_addr)
 
 void DBATUpdated()
 {
+  // Blocks that are still being compiled look up addresses in the old table.
+  JitInterface::FinishPendingCompiles();
+
   dbat_table = {};
   UpdateBATs(dbat_table, SPR_DBAT0U);
   bool extended_bats = SConfig::GetInstance().bWii && HID4.SBE;
@@ -1266,6 +1318,9 @@ void DBATUpdated()
   }
 
 #ifndef _ARCH_32
+  // This drops the page table mappings as well.
+  for (std::vector<u32>& pages : s_page_table_mappings)
+    pages.clear();
   Memory::UpdateLogicalMemory(dbat_table);
 #endif
 
@@ -87,9 +87,14 @@ void InvalidateTLBEntry(u32 address);
 void DBATUpdated();
 void IBATUpdated();
 
-// Result changes based on the BAT registers and MSR.DR.  Returns whether
-// it's safe to optimize a read or write to this address to an unguarded
-// memory access.  Does not consider page tables.
+// Called by the JITs when a fastmem access to the logical address space faults. If the address
+// is translated by the page table, maps its page so that the access can be retried.
+bool MapPageTableAddress(u32 address, bool write);
+
+// Result changes based on the BAT registers.  Returns whether it's safe to
+// optimize a read or write to this address to an unguarded memory access.
+// Does not consider page tables.  Only meaningful when the code being compiled
+// runs with MSR.DR set, which callers have to check themselves.
 bool IsOptimizableRAMAddress(u32 address);
 u32 IsOptimizableMMIOAccess(u32 address, u32 access_size);
 bool IsOptimizableGatherPipeWrite(u32 address);
@@ -39,9 +39,14 @@ namespace PPCAnalyst
 {
 // 0 does not perform block merging
 constexpr u32 BRANCH_FOLLOWING_THRESHOLD = 2;
+// Traces are only formed for hot code, so they are allowed to get much longer.
+constexpr u32 TRACE_FOLLOWING_THRESHOLD = 8;
 
 constexpr u32 INVALID_BRANCH_TARGET = 0xFFFFFFFF;
 
+// Longer loops are unlikely to be polling loops.
+constexpr u32 MAX_IDLE_LOOP_LENGTH = 16;
+
 static u32 EvaluateBranchTarget(UGeckoInstruction instr, u32 pc)
 {
   switch (instr.OPCD)
@@ -642,6 +647,81 @@ void PPCAnalyzer::SetInstructionStats(CodeBlock* block, CodeOp* code, const Gekk
   }
 }
 
+// Whether the instruction can be part of an idle loop: it must not change anything but
+// registers, and the registers that it changes must not affect the next iteration.
+static bool CanBeInIdleLoop(const CodeOp& op)
+{
+  const UGeckoInstruction inst = op.inst;
+  if (op.opinfo->flags & (FL_EVIL | FL_SET_OE | FL_READ_CA))
+    return false;
+
+  // Branches out of the loop, but not ones that would change CTR or LR.
+  if (inst.OPCD == 16)
+    return !inst.LK && (inst.BO & BO_DONT_DECREMENT_FLAG);
+
+  switch (op.opinfo->type)
+  {
+  case OpType::Integer:
+  case OpType::Load:
+    return true;
+  case OpType::System:
+    // mftb, sync and eieio
+    return inst.OPCD == 31 &&
+           (inst.SUBOP10 == 371 || inst.SUBOP10 == 598 || inst.SUBOP10 == 854);
+  default:
+    return false;
+  }
+}
+
+// Checks whether the instruction at the given index closes a loop back to the start of the
+// block that spins until memory or MMIO is changed by other hardware, or until enough time
+// has passed. Running such a loop until the next scheduled event changes nothing that the
+// loop doesn't overwrite on each iteration, so the CPU can skip ahead to that event instead.
+static bool IsIdleLoop(const CodeOp* code, u32 index)
+{
+  const CodeOp& branch = code[index];
+  const UGeckoInstruction inst = branch.inst;
+  if (index >= MAX_IDLE_LOOP_LENGTH ||
+      EvaluateBranchTarget(inst, branch.address) != code[0].address)
+  {
+    return false;
+  }
+  if (inst.OPCD == 16 && !CanBeInIdleLoop(branch))
+    return false;
+  if (inst.OPCD != 16 && (inst.OPCD != 18 || inst.LK))
+    return false;
+
+  BitSet32 gprs_defined, gprs_read_first;
+  BitSet8 crs_defined;
+  for (u32 i = 0; i <= index; ++i)
+  {
+    const CodeOp& op = code[i];
+
+    // Followed branches are not part of the loop.
+    if (op.address != code[0].address + i * 4 || op.skip)
+      return false;
+    if (i != index && !CanBeInIdleLoop(op))
+      return false;
+
+    // A conditional branch has to test a CR field that was set in this iteration.
+    if (op.inst.OPCD == 16 && (op.inst.BO & BO_DONT_CHECK_CONDITION) == 0 &&
+        !crs_defined[op.inst.BI >> 2])
+    {
+      return false;
+    }
+
+    gprs_read_first |= op.regsIn & ~gprs_defined;
+    gprs_defined |= op.regsOut;
+    if (op.outputCR0)
+      crs_defined[0] = true;
+    if (op.opinfo->flags & FL_SET_CRn)
+      crs_defined[op.inst.CRFD] = true;
+  }
+
+  // Registers that carry a value into the next iteration make it a counting loop.
+  return !(gprs_read_first & gprs_defined);
+}
+
 u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, std::size_t block_size)
 {
   // Clear block stats
@@ -673,6 +753,8 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, std:
   u32 num_inst = 0;
 
   const bool enable_follow = SConfig::GetInstance().bJITFollowBranch;
+  const bool form_trace = HasOption(OPTION_TRACE) && m_branch_predictor;
+  const u32 follow_threshold = form_trace ? TRACE_FOLLOWING_THRESHOLD : BRANCH_FOLLOWING_THRESHOLD;
 
   for (std::size_t i = 0; i < block_size; ++i)
   {
@@ -700,6 +782,10 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, std:
 
     SetInstructionStats(block, &code[i], opinfo, static_cast<u32>(i));
 
+    code[i].isIdleLoop = IsIdleLoop(code, static_cast<u32>(i));
+    if (code[i].isIdleLoop)
+      DEBUG_LOG(POWERPC, "Idle loop at %08x", code[0].address);
+
     bool follow = false;
     u32 destination = 0;
 
@@ -709,7 +795,9 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, std:
     //       If it is small, the performance will be down.
     //       If it is big, the size of generated code will be big and
     //       cache clearning will happen many times.
-    if (enable_follow && HasOption(OPTION_BRANCH_FOLLOW) && numFollows < BRANCH_FOLLOWING_THRESHOLD)
+    // Idle loops are left as they are, so the JIT can see the branch back to the start.
+    if (enable_follow && HasOption(OPTION_BRANCH_FOLLOW) && numFollows < follow_threshold &&
+        !code[i].isIdleLoop)
     {
       if (inst.OPCD == 18 && block_size > 1)
       {
@@ -734,6 +822,15 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, std:
           caller = i;
         }
       }
+      else if (form_trace && inst.OPCD == 16 && !inst.LK && block_size > 1 &&
+               m_branch_predictor(address, SignExt16(inst.BD << 2) + (inst.AA ? 0 : address)))
+      {
+        // Follow a conditional branch in the direction the trace usually takes. The JIT leaves
+        // the block through a side exit when the branch isn't taken.
+        follow = true;
+        destination = SignExt16(inst.BD << 2) + (inst.AA ? 0 : address);
+        code[i].traceFollowsBranch = true;
+      }
       else if (inst.OPCD == 19 && inst.SUBOP10 == 16 && !inst.LK && found_call &&
                (inst.BO & BO_DONT_DECREMENT_FLAG) && (inst.BO & BO_DONT_CHECK_CONDITION))
       {
@@ -816,6 +913,15 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, std:
     }
   }
 
+  // A conditional branch that a trace follows needs the next instruction for the side exit. If
+  // the block ends at the branch, because it is full or the destination can't be read, the
+  // branch exits both ways like any other, and the block continues after it.
+  if (num_inst > 0 && code[num_inst - 1].traceFollowsBranch)
+  {
+    code[num_inst - 1].traceFollowsBranch = false;
+    address = code[num_inst - 1].address + 4;
+  }
+
   block->m_num_instructions = num_inst;
 
   if (block->m_num_instructions > 1)
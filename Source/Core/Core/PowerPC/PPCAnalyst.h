@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <set>
 #include <vector>
 
@@ -46,6 +47,11 @@ struct CodeOp  // 16B
   bool canEndBlock;
   bool skipLRStack;
   bool skip;  // followed BL-s for example
+  // A trace continues at the destination of this conditional branch.
+  bool traceFollowsBranch;
+  // This branch goes back to the start of a loop that can only be left once other hardware
+  // or the time base changes something, so time can skip ahead to the next event.
+  bool isIdleLoop;
   // which registers are still needed after this instruction in this block
   BitSet32 fprInUse;
   BitSet32 gprInUse;
@@ -194,12 +200,22 @@ public:
 
     // Reorder cror instructions next to their associated fcmp.
     OPTION_CROR_MERGE = (1 << 6),
+
+    // Form a trace along a hot path: follow more unconditional branches, and follow
+    // conditional branches in the direction given by the branch predictor.
+    // Requires JIT support to leave the block when a followed conditional branch isn't taken.
+    OPTION_TRACE = (1 << 7),
   };
 
+  // Returns whether the conditional branch at the given address is likely to go to its
+  // destination. Used for OPTION_TRACE.
+  using BranchPredictor = std::function<bool(u32 address, u32 destination)>;
+
   // Option setting/getting
   void SetOption(AnalystOption option) { m_options |= option; }
   void ClearOption(AnalystOption option) { m_options &= ~(option); }
   bool HasOption(AnalystOption option) const { return !!(m_options & option); }
+  void SetBranchPredictor(BranchPredictor predictor) { m_branch_predictor = std::move(predictor); }
   u32 Analyze(u32 address, CodeBlock* block, CodeBuffer* buffer, std::size_t block_size);
 
 private:
@@ -216,6 +232,7 @@ private:
 
   // Options
   u32 m_options = 0;
+  BranchPredictor m_branch_predictor;
 };
 
 void LogFunctionCall(u32 addr);
@@ -0,0 +1,295 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/PowerPC/SamplingProfiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/File.h"
+#include "Common/Logging/Log.h"
+#include "Common/StringUtil.h"
+#include "Common/Swap.h"
+#include "Common/Thread.h"
+#include "Core/HW/Memmap.h"
+#include "Core/MachineContext.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+#include "Core/PowerPC/PowerPC.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+namespace Profiler
+{
+namespace
+{
+// A bit over four minutes at the default interval.
+constexpr size_t MAX_SAMPLES = 1 << 18;
+constexpr size_t MAX_STACK_DEPTH = 12;
+
+struct Sample
+{
+  uintptr_t host_pc;
+  u32 pc;
+  u32 lr;
+  u32 stack_depth;
+  std::array<u32, MAX_STACK_DEPTH> stack;
+};
+}  // namespace
+
+static std::mutex s_lock;
+static bool s_cpu_thread_registered = false;
+static std::vector<Sample> s_samples;
+static std::atomic<size_t> s_num_samples{0};
+static std::thread s_sampler_thread;
+static Common::Event s_stop_sampler;
+
+// Reads from the emulated stack without going through the MMU, which isn't safe to use from
+// a signal handler. The stack is assumed to be in MEM1 or MEM2 as the OS maps them.
+static bool ReadStackWord(u32 address, u32* value)
+{
+  const u32 segment = address >> 28;
+  if ((address & 3) || (segment != 0x8 && segment != 0x9 && segment != 0xC && segment != 0xD))
+    return false;
+
+  const u32 physical = address & 0x3FFFFFFF;
+  const u8* memory;
+  if (physical < Memory::REALRAM_SIZE)
+    memory = Memory::m_pRAM + physical;
+  else if (Memory::m_pEXRAM && (physical >> 28) == 0x1 &&
+           (physical & 0x0FFFFFFF) < Memory::EXRAM_SIZE)
+    memory = Memory::m_pEXRAM + (physical & Memory::EXRAM_MASK);
+  else
+    return false;
+
+  *value = Common::swap32(memory);
+  return true;
+}
+
+// Records where the CPU thread is. This runs in a signal handler on the CPU thread, so it only
+// reads memory and never blocks. Like the debugger's call stack, this follows the back chain
+// of stack frames, and takes the return address from the word after each back chain pointer.
+static void TakeSample(uintptr_t host_pc)
+{
+  const size_t index = s_num_samples.load(std::memory_order_relaxed);
+  if (index >= s_samples.size())
+    return;
+
+  Sample& sample = s_samples[index];
+  sample.host_pc = host_pc;
+  sample.pc = PowerPC::ppcState.pc;
+  sample.lr = PowerPC::ppcState.spr[SPR_LR];
+  sample.stack_depth = 0;
+
+  u32 frame;
+  if (ReadStackWord(PowerPC::ppcState.gpr[1], &frame))
+  {
+    u32 return_address;
+    while (frame != 0 && sample.stack_depth < MAX_STACK_DEPTH &&
+           ReadStackWord(frame + 4, &return_address))
+    {
+      sample.stack[sample.stack_depth++] = return_address;
+      if (!ReadStackWord(frame, &frame))
+        break;
+    }
+  }
+
+  s_num_samples.store(index + 1, std::memory_order_release);
+}
+
+#ifdef __linux__
+static pthread_t s_cpu_thread;
+static struct sigaction s_old_sigprof_action;
+
+static void SigprofHandler(int, siginfo_t*, void* raw_context)
+{
+  const ucontext_t* context = static_cast<const ucontext_t*>(raw_context);
+  TakeSample(static_cast<uintptr_t>(context->uc_mcontext.CTX_PC));
+}
+
+static bool StartSampler(u32 interval_us)
+{
+  struct sigaction sa = {};
+  sa.sa_sigaction = &SigprofHandler;
+  // The CPU thread might be running on the JIT's own stack, which has a guard page.
+  sa.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+  sigemptyset(&sa.sa_mask);
+  if (sigaction(SIGPROF, &sa, &s_old_sigprof_action) != 0)
+  {
+    ERROR_LOG(POWERPC, "Failed to install the SIGPROF handler");
+    return false;
+  }
+
+  s_stop_sampler.Reset();
+  s_sampler_thread = std::thread([interval_us] {
+    Common::SetCurrentThreadName("Sampling profiler");
+    while (!s_stop_sampler.WaitFor(std::chrono::microseconds(interval_us)))
+      pthread_kill(s_cpu_thread, SIGPROF);
+  });
+  return true;
+}
+
+static void StopSampler()
+{
+  s_stop_sampler.Set();
+  s_sampler_thread.join();
+  sigaction(SIGPROF, &s_old_sigprof_action, nullptr);
+}
+#else
+static bool StartSampler(u32 interval_us)
+{
+  ERROR_LOG(POWERPC, "The sampling profiler isn't supported on this platform");
+  return false;
+}
+
+static void StopSampler()
+{
+}
+#endif
+
+void RegisterCPUThread()
+{
+  std::lock_guard<std::mutex> lk(s_lock);
+#ifdef __linux__
+  s_cpu_thread = pthread_self();
+#endif
+  s_cpu_thread_registered = true;
+}
+
+void UnregisterCPUThread()
+{
+  std::lock_guard<std::mutex> lk(s_lock);
+  if (s_sampler_thread.joinable())
+    StopSampler();
+  s_cpu_thread_registered = false;
+}
+
+bool StartSampling(u32 interval_us)
+{
+  std::lock_guard<std::mutex> lk(s_lock);
+  if (s_sampler_thread.joinable())
+    return true;
+  if (!s_cpu_thread_registered)
+    return false;
+
+  s_samples.resize(MAX_SAMPLES);
+  s_num_samples.store(0, std::memory_order_relaxed);
+  return StartSampler(interval_us);
+}
+
+void StopSampling()
+{
+  std::lock_guard<std::mutex> lk(s_lock);
+  if (s_sampler_thread.joinable())
+    StopSampler();
+}
+
+bool IsSampling()
+{
+  std::lock_guard<std::mutex> lk(s_lock);
+  return s_sampler_thread.joinable();
+}
+
+static std::string GetFrameName(u32 address)
+{
+  const Common::Symbol* symbol = g_symbolDB.GetSymbolFromAddr(address);
+  std::string name = symbol ? symbol->name : StringFromFormat("0x%08x", address);
+
+  // Semicolons separate the frames.
+  std::replace(name.begin(), name.end(), ';', ':');
+  return name;
+}
+
+bool WriteCollapsedStacks(const std::string& filename)
+{
+  struct HostRange
+  {
+    uintptr_t begin;
+    uintptr_t end;
+    u32 address;
+  };
+
+  // The JITs don't keep the emulated PC up to date within a block, so samples are attributed
+  // to the block that the host PC is in instead. Blocks that have been dropped since can't be
+  // found anymore, and neither can far code, so those fall back to the emulated PC.
+  std::vector<HostRange> ranges;
+  const bool is_jit = g_jit && g_jit->GetAsmRoutines();
+  if (is_jit)
+  {
+    g_jit->GetBlockCache()->RunOnBlocks([&ranges](const JitBlock& block) {
+      if (!block.checkedEntry)
+        return;
+      const uintptr_t begin = reinterpret_cast<uintptr_t>(block.checkedEntry);
+      ranges.push_back({begin, begin + block.codeSize, block.effectiveAddress});
+    });
+    std::sort(ranges.begin(), ranges.end(),
+              [](const HostRange& a, const HostRange& b) { return a.begin < b.begin; });
+  }
+
+  std::map<std::string, u64> stacks;
+  std::vector<std::string> frames;
+  const size_t num_samples = s_num_samples.load(std::memory_order_acquire);
+  for (size_t i = 0; i < num_samples; ++i)
+  {
+    const Sample& sample = s_samples[i];
+
+    u32 pc = sample.pc;
+    bool in_block = false;
+    auto range = std::upper_bound(
+        ranges.begin(), ranges.end(), sample.host_pc,
+        [](uintptr_t host_pc, const HostRange& r) { return host_pc < r.begin; });
+    if (range != ranges.begin() && sample.host_pc < (--range)->end)
+    {
+      pc = range->address;
+      in_block = true;
+    }
+
+    // Innermost first. Time spent in the emulator itself, such as in MMIO handlers, is
+    // attributed to the block that called into it.
+    frames.clear();
+    if (is_jit && !in_block)
+      frames.push_back("[host]");
+    frames.push_back(GetFrameName(pc));
+
+    // LR points into the caller of a leaf function, and into the function itself otherwise.
+    frames.push_back(GetFrameName(sample.lr));
+    for (u32 j = 0; j < sample.stack_depth; ++j)
+      frames.push_back(GetFrameName(sample.stack[j]));
+    frames.erase(std::unique(frames.begin(), frames.end()), frames.end());
+
+    std::string key;
+    for (auto it = frames.rbegin(); it != frames.rend(); ++it)
+    {
+      if (!key.empty())
+        key += ';';
+      key += *it;
+    }
+    ++stacks[key];
+  }
+
+  File::IOFile file(filename, "w");
+  if (!file)
+  {
+    ERROR_LOG(POWERPC, "Failed to open %s", filename.c_str());
+    return false;
+  }
+  for (const auto& stack : stacks)
+    fprintf(file.GetHandle(), "%s %" PRIu64 "\n", stack.first.c_str(), stack.second);
+
+  INFO_LOG(POWERPC, "Wrote %zu samples to %s", num_samples, filename.c_str());
+  return true;
+}
+}  // namespace Profiler
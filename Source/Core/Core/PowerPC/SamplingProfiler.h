@@ -0,0 +1,28 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+// A sampling profiler for the emulated CPU. Unlike block profiling, it doesn't change the
+// generated code: the CPU thread is interrupted at a regular interval, and where it was is
+// recorded. That is the host PC, and the emulated PC and LR along with the return addresses
+// on the emulated stack. Only supported on Linux for now.
+namespace Profiler
+{
+// Called by the CPU thread when it starts and stops running emulated code.
+void RegisterCPUThread();
+void UnregisterCPUThread();
+
+bool StartSampling(u32 interval_us = 1000);
+void StopSampling();
+bool IsSampling();
+
+// Writes the samples since sampling was last started as collapsed stacks, one line per
+// distinct call stack of emulated functions, which flamegraph.pl and similar tools take.
+bool WriteCollapsedStacks(const std::string& filename);
+}  // namespace Profiler
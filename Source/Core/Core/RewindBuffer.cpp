@@ -0,0 +1,193 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/RewindBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "Common/ChunkFile.h"
+#include "Common/Logging/Log.h"
+
+namespace State
+{
+// A new base is made once the pages that differ from the current base take up more than
+// 1/REBASE_DIVISOR of it. Smaller values mean fewer full copies but bigger snapshots.
+static constexpr size_t REBASE_DIVISOR = 4;
+
+RewindBuffer::RewindBuffer(size_t budget) : m_budget(budget)
+{
+}
+
+void RewindBuffer::SetBudget(size_t budget)
+{
+  m_budget = budget;
+  EvictToBudget();
+}
+
+std::shared_ptr<const RewindBuffer::Base> RewindBuffer::GetCurrentBase() const
+{
+  if (m_snapshots.empty())
+    return nullptr;
+
+  const Snapshot& newest = m_snapshots.back();
+  if (newest.dirty_size > newest.base->size / REBASE_DIVISOR)
+    return nullptr;
+
+  return newest.base;
+}
+
+bool RewindBuffer::CaptureSnapshot(const DoStateFunction& do_state,
+                                   std::shared_ptr<const Base> base, Snapshot* snapshot)
+{
+  std::shared_ptr<Base> new_base;
+  if (!base)
+    new_base = std::make_shared<Base>();
+
+  size_t region_index = 0;
+  u8* ptr = nullptr;
+  m_state_buffer.Clear();
+  PointerWrap p(&ptr, &m_state_buffer);
+  p.SetMemoryRegionHandler([&](u8* data, u32 size) {
+    if (new_base)
+    {
+      new_base->regions.emplace_back(data, data + size);
+      new_base->size += size;
+      snapshot->regions.emplace_back();
+      ++region_index;
+      return;
+    }
+
+    if (region_index >= base->regions.size() || base->regions[region_index].size() != size)
+    {
+      // The layout of the memory regions has changed since the base was made.
+      p.SetMode(PointerWrap::MODE_MEASURE);
+      return;
+    }
+
+    const u8* base_data = base->regions[region_index].data();
+    DirtyPages& dirty = snapshot->regions.emplace_back();
+    for (u32 offset = 0; offset < size; offset += PAGE_SIZE)
+    {
+      const u32 page_size = std::min(PAGE_SIZE, size - offset);
+      if (std::memcmp(data + offset, base_data + offset, page_size) == 0)
+        continue;
+
+      dirty.indices.push_back(offset / PAGE_SIZE);
+      dirty.data.insert(dirty.data.end(), data + offset, data + offset + page_size);
+    }
+    snapshot->dirty_size += dirty.data.size() + dirty.indices.size() * sizeof(u32);
+    ++region_index;
+  });
+  do_state(p);
+
+  if (p.GetMode() != PointerWrap::MODE_WRITE || (base && region_index != base->regions.size()))
+    return false;
+
+  snapshot->state.resize(m_state_buffer.GetSize());
+  m_state_buffer.CopyTo(snapshot->state.data());
+  if (new_base)
+    snapshot->base = std::move(new_base);
+  else
+    snapshot->base = std::move(base);
+  return true;
+}
+
+void RewindBuffer::Capture(const DoStateFunction& do_state)
+{
+  // The state is serialized in a single pass, so a mismatch between the current memory regions and
+  // the base is only noticed while capturing. Retrying with a new base handles that rare case.
+  Snapshot snapshot;
+  std::shared_ptr<const Base> base = GetCurrentBase();
+  if (!CaptureSnapshot(do_state, base, &snapshot))
+  {
+    snapshot = {};
+    if (!base || !CaptureSnapshot(do_state, nullptr, &snapshot))
+    {
+      ERROR_LOG(CORE, "Failed to capture a rewind snapshot");
+      return;
+    }
+  }
+
+  if (m_snapshots.empty() || m_snapshots.back().base != snapshot.base)
+    m_memory_usage += snapshot.base->size;
+  m_memory_usage += snapshot.GetSize();
+  m_snapshots.push_back(std::move(snapshot));
+
+  EvictToBudget();
+}
+
+bool RewindBuffer::Rewind(const DoStateFunction& do_state)
+{
+  if (m_snapshots.empty())
+    return false;
+
+  Snapshot& snapshot = m_snapshots.back();
+  const Base& base = *snapshot.base;
+
+  size_t region_index = 0;
+  u8* ptr = snapshot.state.data();
+  PointerWrap p(&ptr, PointerWrap::MODE_READ);
+  p.SetMemoryRegionHandler([&](u8* data, u32 size) {
+    if (region_index >= base.regions.size() || base.regions[region_index].size() != size)
+    {
+      p.SetMode(PointerWrap::MODE_MEASURE);
+      return;
+    }
+
+    std::memcpy(data, base.regions[region_index].data(), size);
+
+    const DirtyPages& dirty = snapshot.regions[region_index];
+    const u8* page_data = dirty.data.data();
+    for (u32 page_index : dirty.indices)
+    {
+      const u32 offset = page_index * PAGE_SIZE;
+      const u32 page_size = std::min(PAGE_SIZE, size - offset);
+      std::memcpy(data + offset, page_data, page_size);
+      page_data += page_size;
+    }
+    ++region_index;
+  });
+  do_state(p);
+
+  const bool success = p.GetMode() == PointerWrap::MODE_READ;
+  if (!success)
+    ERROR_LOG(CORE, "Failed to load a rewind snapshot");
+
+  PopBack();
+  return success;
+}
+
+void RewindBuffer::Clear()
+{
+  m_snapshots.clear();
+  m_memory_usage = 0;
+}
+
+void RewindBuffer::PopFront()
+{
+  Snapshot& snapshot = m_snapshots.front();
+  m_memory_usage -= snapshot.GetSize();
+  // The snapshots of a base are contiguous, so the base is unused once no neighbour shares it.
+  if (m_snapshots.size() == 1 || m_snapshots[1].base != snapshot.base)
+    m_memory_usage -= snapshot.base->size;
+  m_snapshots.pop_front();
+}
+
+void RewindBuffer::PopBack()
+{
+  Snapshot& snapshot = m_snapshots.back();
+  m_memory_usage -= snapshot.GetSize();
+  if (m_snapshots.size() == 1 || m_snapshots[m_snapshots.size() - 2].base != snapshot.base)
+    m_memory_usage -= snapshot.base->size;
+  m_snapshots.pop_back();
+}
+
+void RewindBuffer::EvictToBudget()
+{
+  while (m_memory_usage > m_budget && m_snapshots.size() > 1)
+    PopFront();
+}
+}  // namespace State
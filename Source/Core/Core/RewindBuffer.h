@@ -0,0 +1,88 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+
+namespace State
+{
+// A history of snapshots of the emulated system, used for rewinding.
+//
+// Snapshots are incremental. The memory regions that the state passes to
+// PointerWrap::DoMemoryRegion are copied in full only into a base snapshot. Every
+// snapshot after it stores the pages of those regions that differ from the base,
+// plus the (comparatively small) rest of the state. Once the changed pages grow
+// to a large part of the base, the next snapshot becomes a new base.
+//
+// When the buffer goes over its budget, the oldest snapshots are dropped, and
+// so is their base once no snapshot uses it anymore. The newest snapshot is
+// always kept, even if it doesn't fit in the budget by itself.
+class RewindBuffer final
+{
+public:
+  using DoStateFunction = std::function<void(PointerWrap&)>;
+
+  static constexpr u32 PAGE_SIZE = 0x1000;
+
+  explicit RewindBuffer(size_t budget);
+
+  void SetBudget(size_t budget);
+  size_t GetBudget() const { return m_budget; }
+  // The number of bytes used by all snapshots, including their bases.
+  size_t GetMemoryUsage() const { return m_memory_usage; }
+  size_t GetSnapshotCount() const { return m_snapshots.size(); }
+  bool IsEmpty() const { return m_snapshots.empty(); }
+
+  void Capture(const DoStateFunction& do_state);
+  // Loads the newest snapshot and removes it, so that calling this repeatedly goes
+  // further back in time. Returns false if there was no snapshot or it failed to load.
+  bool Rewind(const DoStateFunction& do_state);
+  void Clear();
+
+private:
+  struct Base
+  {
+    std::vector<std::vector<u8>> regions;
+    size_t size = 0;
+  };
+
+  struct DirtyPages
+  {
+    std::vector<u32> indices;
+    std::vector<u8> data;
+  };
+
+  struct Snapshot
+  {
+    std::shared_ptr<const Base> base;
+    std::vector<u8> state;
+    std::vector<DirtyPages> regions;
+    size_t dirty_size = 0;
+
+    size_t GetSize() const { return state.size() + dirty_size; }
+  };
+
+  // Returns nullptr if the next snapshot should start a new base.
+  std::shared_ptr<const Base> GetCurrentBase() const;
+  bool CaptureSnapshot(const DoStateFunction& do_state, std::shared_ptr<const Base> base,
+                       Snapshot* snapshot);
+  void PopFront();
+  void PopBack();
+  void EvictToBudget();
+
+  std::deque<Snapshot> m_snapshots;
+  // Reused between captures, so that serializing doesn't need to allocate every time
+  ChunkedWriteBuffer m_state_buffer;
+  size_t m_budget;
+  size_t m_memory_usage = 0;
+};
+}  // namespace State
@@ -4,26 +4,40 @@
 
 #include "Core/State.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstring>
 #include <lzo/lzo1x.h>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
 #include "Common/Event.h"
 #include "Common/File.h"
 #include "Common/FileUtil.h"
+#include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/ScopeGuard.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
+#include "Common/ThreadPool.h"
 #include "Common/Timer.h"
 #include "Common/Version.h"
 
+#include "Core/Config/MainSettings.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -34,6 +48,7 @@
 #include "Core/Movie.h"
 #include "Core/NetPlayClient.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/RewindBuffer.h"
 
 #include "VideoCommon/AVIDump.h"
 #include "VideoCommon/OnScreenDisplay.h"
@@ -51,12 +66,35 @@ static const u32 IN_LEN = 128 * 1024u;
 
 static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
 
-static unsigned char __LZO_MMODEL out[OUT_LEN];
+// Compressed savestates are split into independently compressed frames, so that they can be
+// compressed and decompressed on several threads. The frames are preceded by a
+// FramedStateHeader and a table of the compressed size of each frame.
+// Older compressed states directly contain LZO blocks of at most IN_LEN bytes instead,
+// and start with the compressed size of the first block, which is always smaller than the magic.
+static constexpr u32 FRAMED_STATE_MAGIC = 0x5A465344;  // "DSFZ"
+static constexpr u32 FRAME_SIZE = 1024 * 1024;
+static constexpr u32 MAX_FRAME_SIZE = 64 * 1024 * 1024;
+static constexpr int ZSTD_COMPRESSION_LEVEL = 1;
+
+enum class FrameCompression : u32
+{
+  LZO = 1,
+  Zstd = 2,
+};
 
-#define HEAP_ALLOC(var, size)                                                                      \
-  lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
+struct FramedStateHeader
+{
+  u32 magic;
+  FrameCompression compression;
+  u32 frame_size;  // Uncompressed size of every frame but the last one
+  u32 num_frames;
+};
 
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+#ifdef HAVE_ZSTD
+static constexpr FrameCompression DEFAULT_FRAME_COMPRESSION = FrameCompression::Zstd;
+#else
+static constexpr FrameCompression DEFAULT_FRAME_COMPRESSION = FrameCompression::LZO;
+#endif
 
 static std::string g_last_filename;
 
@@ -64,7 +102,7 @@ static AfterLoadCallbackFunc s_on_after_load_callback;
 
 // Temporary undo state buffer
 static std::vector<u8> g_undo_load_buffer;
-static std::vector<u8> g_current_buffer;
+static ChunkedWriteBuffer g_current_buffer(FRAME_SIZE);
 static int g_loadDepth = 0;
 
 static std::mutex g_cs_undo_load_buffer;
@@ -73,6 +111,45 @@ static Common::Event g_compressAndDumpStateSyncEvent;
 
 static std::thread g_save_thread;
 
+static std::unique_ptr<RewindBuffer> s_rewind_buffer;
+static std::mutex s_rewind_buffer_mutex;
+static int s_fields_since_rewind_snapshot = 0;
+static std::atomic<bool> s_rewind_snapshot_queued{false};
+
+// Copies of the rewind settings, which are checked at the end of every field.
+static std::atomic<bool> s_rewind_enabled{false};
+static std::atomic<int> s_rewind_interval{1};
+static bool s_has_registered_rewind_callback = false;
+
+// Savestate files can be read and decompressed ahead of time on a worker thread (for instance
+// when a slot is highlighted in the UI), so that loading them only has to apply the state.
+struct PreloadedState
+{
+  std::string filename;
+  std::string game_id;
+  u64 file_size = 0;
+  u64 modification_time = 0;
+  std::vector<u8> data;
+  bool ready = false;
+};
+
+static std::thread s_preload_thread;
+static std::mutex s_preload_mutex;
+static std::condition_variable s_preload_cv;
+static bool s_preload_thread_running = false;
+static std::string s_preload_request;
+static std::string s_preload_request_game_id;
+static PreloadedState s_preloaded_state;
+
+// Used by the save thread for compressing and by the CPU thread for decompressing.
+// Both of them take part in the work, so one thread fewer than the host has is enough.
+static Common::ThreadPool& GetCompressionThreadPool()
+{
+  static Common::ThreadPool s_thread_pool(
+      std::max(std::thread::hardware_concurrency(), 1u) - 1, "Savestate Compression");
+  return s_thread_pool;
+}
+
 // Don't forget to increase this after doing changes on the savestate system
 static const u32 STATE_VERSION = 98;  // Last changed in PR 6895
 
@@ -217,16 +294,13 @@ void LoadFromBuffer(std::vector<u8>& buffer)
 void SaveToBuffer(std::vector<u8>& buffer)
 {
   Core::RunAsCPUThread([&] {
+    ChunkedWriteBuffer state;
     u8* ptr = nullptr;
-    PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
-
+    PointerWrap p(&ptr, &state);
     DoState(p);
-    const size_t buffer_size = reinterpret_cast<size_t>(ptr);
-    buffer.resize(buffer_size);
 
-    ptr = &buffer[0];
-    p.SetMode(PointerWrap::MODE_WRITE);
-    DoState(p);
+    buffer.resize(state.GetSize());
+    state.CopyTo(buffer.data());
   });
 }
 
@@ -251,6 +325,7 @@ static int GetEmptySlot(std::map<double, int> m)
 }
 
 static std::string MakeStateFilename(int number);
+static void DiscardPreloadedStates();
 
 // read state timestamps
 static std::map<double, int> GetSavedStates()
@@ -277,9 +352,207 @@ static std::map<double, int> GetSavedStates()
   return m;
 }
 
+static size_t GetFrameBound(FrameCompression compression, size_t size)
+{
+#ifdef HAVE_ZSTD
+  if (compression == FrameCompression::Zstd)
+    return ZSTD_compressBound(size);
+#endif
+  return size + (size / 16) + 64 + 3;
+}
+
+// Returns the compressed size, or 0 on failure.
+static size_t CompressFrame(FrameCompression compression, const u8* in, size_t in_size, u8* out,
+                            size_t out_capacity)
+{
+  switch (compression)
+  {
+  case FrameCompression::LZO:
+  {
+    std::vector<lzo_align_t> work_memory((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) /
+                                         sizeof(lzo_align_t));
+    lzo_uint out_size = 0;
+    if (lzo1x_1_compress(in, static_cast<lzo_uint>(in_size), out, &out_size,
+                         work_memory.data()) != LZO_E_OK)
+    {
+      return 0;
+    }
+    return out_size;
+  }
+#ifdef HAVE_ZSTD
+  case FrameCompression::Zstd:
+  {
+    const size_t out_size = ZSTD_compress(out, out_capacity, in, in_size, ZSTD_COMPRESSION_LEVEL);
+    return ZSTD_isError(out_size) ? 0 : out_size;
+  }
+#endif
+  default:
+    return 0;
+  }
+}
+
+static bool DecompressFrame(FrameCompression compression, const u8* in, size_t in_size, u8* out,
+                            size_t out_size)
+{
+  switch (compression)
+  {
+  case FrameCompression::LZO:
+  {
+    lzo_uint new_size = static_cast<lzo_uint>(out_size);
+    return lzo1x_decompress_safe(in, static_cast<lzo_uint>(in_size), out, &new_size, nullptr) ==
+               LZO_E_OK &&
+           new_size == out_size;
+  }
+#ifdef HAVE_ZSTD
+  case FrameCompression::Zstd:
+    return ZSTD_decompress(out, out_size, in, in_size) == out_size;
+#endif
+  default:
+    return false;
+  }
+}
+
+static bool CompressAndWriteFrames(const ChunkedWriteBuffer& data, File::IOFile& f)
+{
+  const u64 start_time = Common::Timer::GetTimeUs();
+
+  // The chunks of the buffer are multiples of the frame size, so the frames can be compressed
+  // right where they are.
+  std::vector<std::pair<const u8*, size_t>> frames;
+  for (size_t i = 0; i < data.GetChunkCount(); ++i)
+  {
+    const u8* chunk = data.GetChunk(i);
+    const size_t chunk_size = data.GetChunkDataSize(i);
+    for (size_t offset = 0; offset < chunk_size; offset += FRAME_SIZE)
+      frames.emplace_back(chunk + offset, std::min<size_t>(FRAME_SIZE, chunk_size - offset));
+  }
+
+  const FrameCompression compression = DEFAULT_FRAME_COMPRESSION;
+  const FramedStateHeader header{FRAMED_STATE_MAGIC, compression, FRAME_SIZE,
+                                 static_cast<u32>(frames.size())};
+
+  const size_t frame_bound = GetFrameBound(compression, FRAME_SIZE);
+  // Not a vector, since zero-initializing the whole thing would take a noticeable amount of time
+  std::unique_ptr<u8[]> compressed(new u8[frame_bound * header.num_frames]);
+  std::vector<u32> compressed_sizes(header.num_frames);
+
+  GetCompressionThreadPool().ParallelFor(header.num_frames, [&](size_t i) {
+    compressed_sizes[i] = static_cast<u32>(CompressFrame(
+        compression, frames[i].first, frames[i].second, &compressed[i * frame_bound], frame_bound));
+  });
+
+  if (std::find(compressed_sizes.begin(), compressed_sizes.end(), 0u) != compressed_sizes.end())
+  {
+    PanicAlertT("Internal compression error - savestate compression failed");
+    return false;
+  }
+
+  bool success = f.WriteArray(&header, 1) &&
+                 f.WriteArray(compressed_sizes.data(), compressed_sizes.size());
+  for (u32 i = 0; i < header.num_frames && success; ++i)
+    success = f.WriteBytes(&compressed[i * frame_bound], compressed_sizes[i]);
+
+  INFO_LOG(CORE, "Compressed a %zu byte savestate into %u frames in %" PRIu64 " us", data.GetSize(),
+           header.num_frames, Common::Timer::GetTimeUs() - start_time);
+  return success;
+}
+
+// Reads the frames that follow a FramedStateHeader. buffer must already have the
+// uncompressed size of the state.
+static bool ReadAndDecompressFrames(File::IOFile& f, std::vector<u8>& buffer)
+{
+  const u64 start_time = Common::Timer::GetTimeUs();
+
+  FramedStateHeader header;
+  if (!f.ReadArray(&header, 1) || header.magic != FRAMED_STATE_MAGIC || header.frame_size == 0 ||
+      header.frame_size > MAX_FRAME_SIZE ||
+      header.num_frames != (buffer.size() + header.frame_size - 1) / header.frame_size)
+  {
+    PanicAlertT("The savestate is corrupted.");
+    return false;
+  }
+
+#ifndef HAVE_ZSTD
+  if (header.compression == FrameCompression::Zstd)
+  {
+    PanicAlertT("This savestate is compressed with Zstandard, "
+                "which this build of Dolphin does not support.");
+    return false;
+  }
+#endif
+
+  std::vector<u32> compressed_sizes(header.num_frames);
+  if (!f.ReadArray(compressed_sizes.data(), compressed_sizes.size()))
+    return false;
+
+  std::vector<size_t> compressed_offsets(header.num_frames);
+  size_t compressed_size = 0;
+  for (u32 i = 0; i < header.num_frames; ++i)
+  {
+    compressed_offsets[i] = compressed_size;
+    compressed_size += compressed_sizes[i];
+  }
+
+  std::vector<u8> compressed(compressed_size);
+  if (!f.ReadBytes(compressed.data(), compressed.size()))
+    return false;
+
+  std::vector<u8> frame_ok(header.num_frames);
+  GetCompressionThreadPool().ParallelFor(header.num_frames, [&](size_t i) {
+    const size_t offset = i * header.frame_size;
+    frame_ok[i] = DecompressFrame(header.compression, &compressed[compressed_offsets[i]],
+                                  compressed_sizes[i], &buffer[offset],
+                                  std::min<size_t>(header.frame_size, buffer.size() - offset));
+  });
+
+  if (std::find(frame_ok.begin(), frame_ok.end(), 0) != frame_ok.end())
+  {
+    PanicAlertT("Internal decompression error - the savestate could not be decompressed");
+    return false;
+  }
+
+  INFO_LOG(CORE, "Decompressed a %zu byte savestate from %u frames in %" PRIu64 " us",
+           buffer.size(), header.num_frames, Common::Timer::GetTimeUs() - start_time);
+  return true;
+}
+
+// Decompresses a state made before states were split into frames
+static bool ReadAndDecompressLZOBlocks(File::IOFile& f, std::vector<u8>& buffer)
+{
+  std::vector<u8> in(OUT_LEN);
+
+  lzo_uint i = 0;
+  while (true)
+  {
+    lzo_uint32 cur_len = 0;  // number of bytes to read
+    lzo_uint new_len = 0;    // number of bytes to write
+
+    if (!f.ReadArray(&cur_len, 1))
+      break;
+
+    if (cur_len > in.size() || i > buffer.size() || !f.ReadBytes(in.data(), cur_len))
+      return false;
+
+    new_len = static_cast<lzo_uint>(std::min<size_t>(IN_LEN, buffer.size() - i));
+    const int res = lzo1x_decompress_safe(in.data(), cur_len, &buffer[i], &new_len, nullptr);
+    if (res != LZO_E_OK)
+    {
+      // This doesn't seem to happen anymore.
+      PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
+                  "Try loading the state again",
+                  res, i, new_len);
+      return false;
+    }
+
+    i += new_len;
+  }
+
+  return true;
+}
+
 struct CompressAndDumpState_args
 {
-  std::vector<u8>* buffer_vector;
+  ChunkedWriteBuffer* buffer;
   std::mutex* buffer_mutex;
   std::string filename;
   bool wait;
@@ -302,8 +575,7 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
   if (!save_args.wait)
     on_exit.Exit();
 
-  const u8* const buffer_data = &(*(save_args.buffer_vector))[0];
-  const size_t buffer_size = (save_args.buffer_vector)->size();
+  const ChunkedWriteBuffer& buffer = *save_args.buffer;
   std::string& filename = save_args.filename;
 
   // For easy debugging
@@ -338,44 +610,28 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
   // Setting up the header
   StateHeader header;
   strncpy(header.gameID, SConfig::GetInstance().GetGameID().c_str(), 6);
-  header.size = g_use_compression ? (u32)buffer_size : 0;
+  header.size = g_use_compression ? (u32)buffer.GetSize() : 0;
   header.time = Common::Timer::GetDoubleTime();
 
-  f.WriteArray(&header, 1);
+  bool success = f.WriteArray(&header, 1);
 
   if (header.size != 0)  // non-zero header size means the state is compressed
   {
-    lzo_uint i = 0;
-    while (true)
-    {
-      lzo_uint32 cur_len = 0;
-      lzo_uint out_len = 0;
-
-      if ((i + IN_LEN) >= buffer_size)
-      {
-        cur_len = (lzo_uint32)(buffer_size - i);
-      }
-      else
-      {
-        cur_len = IN_LEN;
-      }
-
-      if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-        PanicAlertT("Internal LZO Error - compression failed");
-
-      // The size of the data to write is 'out_len'
-      f.WriteArray((lzo_uint32*)&out_len, 1);
-      f.WriteBytes(out, out_len);
-
-      if (cur_len != IN_LEN)
-        break;
-
-      i += cur_len;
-    }
+    success = success && CompressAndWriteFrames(buffer, f);
   }
   else  // uncompressed
   {
-    f.WriteBytes(buffer_data, buffer_size);
+    for (size_t i = 0; i < buffer.GetChunkCount() && success; ++i)
+      success = f.WriteBytes(buffer.GetChunk(i), buffer.GetChunkDataSize(i));
+  }
+
+  if (!success)
+  {
+    // Don't leave a state behind that only has a header
+    f.Close();
+    File::Delete(filename);
+    Core::DisplayMessage("Could not save state", 2000);
+    return;
   }
 
   Core::DisplayMessage(StringFromFormat("Saved State to %s", filename.c_str()), 2000);
@@ -385,18 +641,11 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
 void SaveAs(const std::string& filename, bool wait)
 {
   Core::RunAsCPUThread([&] {
-    // Measure the size of the buffer.
     u8* ptr = nullptr;
-    PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
-    DoState(p);
-    const size_t buffer_size = reinterpret_cast<size_t>(ptr);
-
-    // Then actually do the write.
+    PointerWrap p(&ptr, &g_current_buffer);
     {
       std::lock_guard<std::mutex> lk(g_cs_current_buffer);
-      g_current_buffer.resize(buffer_size);
-      ptr = &g_current_buffer[0];
-      p.SetMode(PointerWrap::MODE_WRITE);
+      g_current_buffer.Clear();
       DoState(p);
     }
 
@@ -405,12 +654,14 @@ void SaveAs(const std::string& filename, bool wait)
       Core::DisplayMessage("Saving State...", 1000);
 
       CompressAndDumpState_args save_args;
-      save_args.buffer_vector = &g_current_buffer;
+      save_args.buffer = &g_current_buffer;
       save_args.buffer_mutex = &g_cs_current_buffer;
       save_args.filename = filename;
       save_args.wait = wait;
 
       Flush();
+      // The file (and lastState.sav) is about to change
+      DiscardPreloadedStates();
       g_save_thread = std::thread(CompressAndDumpState, save_args);
       g_compressAndDumpStateSyncEvent.Wait();
 
@@ -451,56 +702,53 @@ std::string GetInfoStringOfSlot(int slot, bool translate)
   return Common::Timer::GetDateTimeFormatted(header.time);
 }
 
-static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
+// Reads and decompresses a savestate file. This doesn't touch the emulated system, so it can run
+// on any thread.
+static bool ReadStateFile(const std::string& filename, const std::string& game_id,
+                          bool show_messages, std::vector<u8>& ret_data)
 {
-  Flush();
   File::IOFile f(filename, "rb");
   if (!f)
   {
-    Core::DisplayMessage("State not found", 2000);
-    return;
+    if (show_messages)
+      Core::DisplayMessage("State not found", 2000);
+    return false;
   }
 
   StateHeader header;
-  f.ReadArray(&header, 1);
+  if (!f.ReadArray(&header, 1))
+    return false;
 
-  if (strncmp(SConfig::GetInstance().GetGameID().c_str(), header.gameID, 6))
+  if (strncmp(game_id.c_str(), header.gameID, 6))
   {
-    Core::DisplayMessage(
-        StringFromFormat("State belongs to a different game (ID %.*s)", 6, header.gameID), 2000);
-    return;
+    if (show_messages)
+    {
+      Core::DisplayMessage(
+          StringFromFormat("State belongs to a different game (ID %.*s)", 6, header.gameID),
+          2000);
+    }
+    return false;
   }
 
   std::vector<u8> buffer;
 
   if (header.size != 0)  // non-zero size means the state is compressed
   {
-    Core::DisplayMessage("Decompressing State...", 500);
+    if (show_messages)
+      Core::DisplayMessage("Decompressing State...", 500);
 
     buffer.resize(header.size);
 
-    lzo_uint i = 0;
-    while (true)
-    {
-      lzo_uint32 cur_len = 0;  // number of bytes to read
-      lzo_uint new_len = 0;    // number of bytes to write
-
-      if (!f.ReadArray(&cur_len, 1))
-        break;
-
-      f.ReadBytes(out, cur_len);
-      const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
-      if (res != LZO_E_OK)
-      {
-        // This doesn't seem to happen anymore.
-        PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
-                    "Try loading the state again",
-                    res, i, new_len);
-        return;
-      }
+    u32 first_word = 0;
+    const u64 data_start = f.Tell();
+    if (!f.ReadArray(&first_word, 1) || !f.Seek(data_start, SEEK_SET))
+      return false;
 
-      i += new_len;
-    }
+    const bool success = first_word == FRAMED_STATE_MAGIC ?
+                             ReadAndDecompressFrames(f, buffer) :
+                             ReadAndDecompressLZOBlocks(f, buffer);
+    if (!success)
+      return false;
   }
   else  // uncompressed
   {
@@ -509,13 +757,144 @@ static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_
 
     if (!f.ReadBytes(&buffer[0], size))
     {
-      PanicAlert("wtf? reading bytes: %zu", size);
-      return;
+      if (show_messages)
+        PanicAlert("wtf? reading bytes: %zu", size);
+      return false;
     }
   }
 
   // all good
   ret_data.swap(buffer);
+  return true;
+}
+
+static void PreloadThread()
+{
+  Common::SetCurrentThreadName("Savestate preload thread");
+
+  std::unique_lock<std::mutex> lk(s_preload_mutex);
+  while (true)
+  {
+    s_preload_cv.wait(lk, [] { return !s_preload_thread_running || !s_preload_request.empty(); });
+    if (!s_preload_thread_running)
+      return;
+
+    const std::string filename = std::move(s_preload_request);
+    const std::string game_id = std::move(s_preload_request_game_id);
+    s_preload_request.clear();
+    s_preloaded_state = {};
+    s_preloaded_state.filename = filename;
+    lk.unlock();
+
+    // Taken before reading, so that a later write to the file can't go unnoticed
+    const File::FileInfo info(filename);
+    std::vector<u8> data;
+    const bool success = ReadStateFile(filename, game_id, false, data);
+
+    lk.lock();
+    // Unless the preload was discarded in the meantime
+    if (s_preloaded_state.filename == filename && !s_preloaded_state.ready)
+    {
+      if (success)
+      {
+        s_preloaded_state.game_id = game_id;
+        s_preloaded_state.file_size = info.GetSize();
+        s_preloaded_state.modification_time = info.GetModificationTime();
+        s_preloaded_state.data = std::move(data);
+        s_preloaded_state.ready = true;
+      }
+      else
+      {
+        s_preloaded_state = {};
+      }
+    }
+    s_preload_cv.notify_all();
+  }
+}
+
+// Returns the preloaded data of the given file, waiting for the preload if it is still running.
+static bool TakePreloadedState(const std::string& filename, const std::string& game_id,
+                               std::vector<u8>& ret_data)
+{
+  PreloadedState state;
+  {
+    std::unique_lock<std::mutex> lk(s_preload_mutex);
+    // Not started yet, so there's nothing to gain from waiting for the worker
+    if (s_preload_request == filename)
+      s_preload_request.clear();
+
+    s_preload_cv.wait(lk, [&] {
+      return s_preloaded_state.filename != filename || s_preloaded_state.ready;
+    });
+    if (s_preloaded_state.filename != filename)
+      return false;
+
+    state = std::move(s_preloaded_state);
+    s_preloaded_state = {};
+  }
+
+  const File::FileInfo info(filename);
+  if (state.game_id != game_id || info.GetSize() != state.file_size ||
+      info.GetModificationTime() != state.modification_time)
+  {
+    return false;
+  }
+
+  ret_data.swap(state.data);
+  return true;
+}
+
+static void DiscardPreloadedStates()
+{
+  std::lock_guard<std::mutex> lk(s_preload_mutex);
+  s_preload_request.clear();
+  s_preloaded_state = {};
+  s_preload_cv.notify_all();
+}
+
+static void StopPreloadThread()
+{
+  {
+    std::lock_guard<std::mutex> lk(s_preload_mutex);
+    s_preload_thread_running = false;
+    s_preload_request.clear();
+    s_preloaded_state = {};
+    s_preload_cv.notify_all();
+  }
+
+  if (s_preload_thread.joinable())
+    s_preload_thread.join();
+}
+
+void PreloadAs(const std::string& filename)
+{
+  if (!Core::IsRunning() || NetPlay::IsNetPlayRunning() || !File::Exists(filename))
+    return;
+
+  std::lock_guard<std::mutex> lk(s_preload_mutex);
+  if (s_preloaded_state.filename == filename || s_preload_request == filename)
+    return;
+
+  s_preload_request = filename;
+  s_preload_request_game_id = SConfig::GetInstance().GetGameID();
+  if (!s_preload_thread_running)
+  {
+    s_preload_thread_running = true;
+    s_preload_thread = std::thread(PreloadThread);
+  }
+  s_preload_cv.notify_all();
+}
+
+static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
+{
+  // Wait for a save to the same file to finish
+  Flush();
+
+  const std::string game_id = SConfig::GetInstance().GetGameID();
+  if (TakePreloadedState(filename, game_id, ret_data))
+    return;
+
+  ReadStateFile(filename, game_id, true, ret_data);
 }
 
 void LoadAs(const std::string& filename)
@@ -530,6 +909,11 @@ void LoadAs(const std::string& filename)
     return;
   }
 
+  // Reading and decompressing the file doesn't need the emulated system, so it happens before
+  // the core is paused. Only applying the state has to run on the CPU thread.
+  std::vector<u8> buffer;
+  LoadFileStateData(filename, buffer);
+
   Core::RunAsCPUThread([&] {
     g_loadDepth++;
 
@@ -547,19 +931,16 @@ void LoadAs(const std::string& filename)
     bool loaded = false;
     bool loadedSuccessfully = false;
 
-    // brackets here are so buffer gets freed ASAP
+    if (!buffer.empty())
     {
-      std::vector<u8> buffer;
-      LoadFileStateData(filename, buffer);
+      u8* ptr = &buffer[0];
+      PointerWrap p(&ptr, PointerWrap::MODE_READ);
+      DoState(p);
+      loaded = true;
+      loadedSuccessfully = (p.GetMode() == PointerWrap::MODE_READ);
 
-      if (!buffer.empty())
-      {
-        u8* ptr = &buffer[0];
-        PointerWrap p(&ptr, PointerWrap::MODE_READ);
-        DoState(p);
-        loaded = true;
-        loadedSuccessfully = (p.GetMode() == PointerWrap::MODE_READ);
-      }
+      // Free the buffer ASAP
+      std::vector<u8>().swap(buffer);
     }
 
     if (loaded)
@@ -595,28 +976,54 @@ void SetOnAfterLoadCallback(AfterLoadCallbackFunc callback)
   s_on_after_load_callback = std::move(callback);
 }
 
+static void RefreshRewindConfig()
+{
+  s_rewind_enabled = Config::Get(Config::MAIN_ENABLE_REWIND);
+  s_rewind_interval = Config::Get(Config::MAIN_REWIND_INTERVAL);
+
+  if (!s_rewind_enabled)
+  {
+    std::lock_guard<std::mutex> lk(s_rewind_buffer_mutex);
+    s_rewind_buffer.reset();
+  }
+}
+
 void Init()
 {
   if (lzo_init() != LZO_E_OK)
     PanicAlertT("Internal LZO Error - lzo_init() failed");
+
+  if (!s_has_registered_rewind_callback)
+  {
+    Config::AddConfigChangedCallback(RefreshRewindConfig);
+    s_has_registered_rewind_callback = true;
+  }
+  RefreshRewindConfig();
 }
 
 void Shutdown()
 {
   Flush();
+  StopPreloadThread();
 
   // swapping with an empty vector, rather than clear()ing
   // this gives a better guarantee to free the allocated memory right NOW (as opposed to, actually,
   // never)
   {
     std::lock_guard<std::mutex> lk(g_cs_current_buffer);
-    std::vector<u8>().swap(g_current_buffer);
+    g_current_buffer = ChunkedWriteBuffer(FRAME_SIZE);
   }
 
   {
     std::lock_guard<std::mutex> lk(g_cs_undo_load_buffer);
     std::vector<u8>().swap(g_undo_load_buffer);
   }
+
+  {
+    std::lock_guard<std::mutex> lk(s_rewind_buffer_mutex);
+    s_rewind_buffer.reset();
+    s_fields_since_rewind_snapshot = 0;
+  }
 }
 
 static std::string MakeStateFilename(int number)
@@ -635,6 +1042,11 @@ void Load(int slot)
   LoadAs(MakeStateFilename(slot));
 }
 
+void Preload(int slot)
+{
+  PreloadAs(MakeStateFilename(slot));
+}
+
 void LoadLastSaved(int i)
 {
   std::map<double, int> savedStates = GetSavedStates();
@@ -702,4 +1114,74 @@ void UndoSaveState()
   LoadAs(File::GetUserPath(D_STATESAVES_IDX) + "lastState.sav");
 }
 
+static bool IsRewindAllowed()
+{
+  // Netplay can't load states, and movies would desync since rewinding doesn't rewind the input.
+  return s_rewind_enabled && !NetPlay::IsNetPlayRunning() && !Movie::IsMovieActive();
+}
+
+static void CaptureRewindSnapshot()
+{
+  s_rewind_snapshot_queued = false;
+
+  if (!IsRewindAllowed())
+  {
+    std::lock_guard<std::mutex> lk(s_rewind_buffer_mutex);
+    s_rewind_buffer.reset();
+    return;
+  }
+
+  const size_t budget =
+      static_cast<size_t>(std::max(Config::Get(Config::MAIN_REWIND_BUFFER_SIZE), 0)) * 1024 * 1024;
+
+  // Like a savestate, this pauses the CPU and GPU threads first.
+  Core::RunAsCPUThread([&] {
+    std::lock_guard<std::mutex> lk(s_rewind_buffer_mutex);
+    if (s_rewind_buffer)
+      s_rewind_buffer->SetBudget(budget);
+    else
+      s_rewind_buffer = std::make_unique<RewindBuffer>(budget);
+
+    s_rewind_buffer->Capture(DoState);
+  });
+}
+
+void UpdateRewindBuffer()
+{
+  if (!s_rewind_enabled)
+    return;
+
+  if (++s_fields_since_rewind_snapshot < s_rewind_interval)
+    return;
+  s_fields_since_rewind_snapshot = 0;
+
+  // The end of a field is reached from a CoreTiming event, which has been taken off the event
+  // queue and not put back yet, so the state can't be saved here. The snapshot is taken from
+  // the host thread instead, which waits for the CPU thread to get to a safe point.
+  if (!s_rewind_snapshot_queued.exchange(true))
+    Core::QueueHostJob(CaptureRewindSnapshot);
+}
+
+bool Rewind()
+{
+  if (!Core::IsRunning() || !IsRewindAllowed())
+    return false;
+
+  bool rewound = false;
+  Core::RunAsCPUThread([&] {
+    std::lock_guard<std::mutex> lk(s_rewind_buffer_mutex);
+    if (s_rewind_buffer)
+      rewound = s_rewind_buffer->Rewind(DoState);
+    s_fields_since_rewind_snapshot = 0;
+  });
+
+  if (!rewound)
+    return false;
+
+  if (s_on_after_load_callback)
+    s_on_after_load_callback();
+
+  return true;
+}
+
 }  // namespace State
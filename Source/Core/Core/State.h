@@ -47,6 +47,11 @@ void Load(int slot);
 void SaveAs(const std::string& filename, bool wait = false);
 void LoadAs(const std::string& filename);
 
+// Reads and decompresses a state on a worker thread ahead of time, so that a later Load/LoadAs of
+// the same file only has to apply it. Meant for when it is likely that the user will load it soon.
+void Preload(int slot);
+void PreloadAs(const std::string& filename);
+
 void SaveToBuffer(std::vector<u8>& buffer);
 void LoadFromBuffer(std::vector<u8>& buffer);
 
@@ -55,6 +60,13 @@ void SaveFirstSaved();
 void UndoSaveState();
 void UndoLoadState();
 
+// Rewinding. While enabled in the config, a snapshot is taken every few video fields, and
+// Rewind() goes back to the newest one (and then the one before it, and so on).
+// UpdateRewindBuffer must be called on the CPU thread at the end of each field. The snapshots
+// themselves are taken from the host thread.
+void UpdateRewindBuffer();
+bool Rewind();
+
 // wait until previously scheduled savestate event (if any) is done
 void Flush();
 
@@ -3,19 +3,26 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
+#include <cinttypes>
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include "Common/CDUtils.h"
 #include "Common/CommonTypes.h"
 #include "Common/File.h"
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
 
 #include "DiscIO/Blob.h"
 #include "DiscIO/CISOBlob.h"
 #include "DiscIO/CompressedBlob.h"
+#include "DiscIO/DCZBlob.h"
 #include "DiscIO/DirectoryBlob.h"
 #include "DiscIO/DriveBlob.h"
 #include "DiscIO/FileBlob.h"
@@ -24,36 +31,100 @@
 
 namespace DiscIO
 {
+static std::atomic<size_t> s_cache_memory_budget{SectorReader::DEFAULT_CACHE_MEMORY_BUDGET};
+static std::atomic<bool> s_memory_mapping_enabled{false};
+
+void SetMemoryMappingEnabled(bool enabled)
+{
+  s_memory_mapping_enabled.store(enabled);
+}
+
+bool IsMemoryMappingEnabled()
+{
+  return s_memory_mapping_enabled.load();
+}
+
+void SectorReader::SetCacheMemoryBudget(size_t bytes)
+{
+  s_cache_memory_budget.store(bytes);
+}
+
 void SectorReader::SetSectorSize(int blocksize)
 {
   m_block_size = std::max(blocksize, 0);
-  for (auto& cache_entry : m_cache)
-  {
-    cache_entry.Reset();
-    cache_entry.data.resize(m_chunk_blocks * m_block_size);
-  }
+  ResizeCache();
 }
 
 void SectorReader::SetChunkSize(int block_cnt)
 {
   m_chunk_blocks = std::max(block_cnt, 1);
   // Clear cache and resize the data arrays
-  SetSectorSize(m_block_size);
+  ResizeCache();
+}
+
+void SectorReader::ResizeCache()
+{
+  m_cache_memory_budget = s_cache_memory_budget.load();
+
+  const size_t line_size = static_cast<size_t>(m_chunk_blocks) * m_block_size;
+  const size_t num_lines =
+      std::max<size_t>(MIN_CACHE_LINES, line_size ? m_cache_memory_budget / line_size : 0);
+
+  m_cache_index.clear();
+  m_cache.clear();
+  m_cache.resize(num_lines);
+  for (auto& cache_entry : m_cache)
+    cache_entry.data.resize(line_size);
+
+  // Read at most a quarter of the cache ahead, so that prefetching can't evict the chunks
+  // that are actually being used
+  const size_t prefetch_bytes = std::min(MAX_PREFETCH_BYTES, m_cache_memory_budget / 4);
+  const size_t max_prefetch_chunks = std::min<size_t>(MAX_PREFETCH_CHUNKS, num_lines / 4);
+  m_prefetch_chunks = static_cast<u32>(
+      std::clamp<size_t>(line_size ? prefetch_bytes / line_size : 1, 1, max_prefetch_chunks));
+  m_prefetch_queue.clear();
 }
 
 SectorReader::~SectorReader()
 {
+  StopPrefetching();
+
+  if (m_stats.hits || m_stats.misses)
+  {
+    INFO_LOG(DISCIO,
+             "Sector cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64
+             " prefetch hits, %" PRIu64 " chunks prefetched",
+             m_stats.hits, m_stats.misses, m_stats.prefetch_hits, m_stats.prefetched_chunks);
+  }
+}
+
+SectorReader::CacheStats SectorReader::GetCacheStats() const
+{
+  std::lock_guard<std::mutex> lk(m_cache_mutex);
+  return m_stats;
 }
 
-const SectorReader::Cache* SectorReader::FindCacheLine(u64 block_num)
+void SectorReader::StopPrefetching()
 {
-  auto itr = std::find_if(m_cache.begin(), m_cache.end(),
-                          [&](const Cache& entry) { return entry.Contains(block_num); });
-  if (itr == m_cache.end())
+  {
+    std::lock_guard<std::mutex> lk(m_cache_mutex);
+    m_stop_prefetching = true;
+    m_prefetch_queue.clear();
+  }
+  m_prefetch_wakeup.notify_all();
+
+  if (m_prefetch_thread.joinable())
+    m_prefetch_thread.join();
+}
+
+SectorReader::Cache* SectorReader::FindCacheLine(u64 chunk_num)
+{
+  auto itr = m_cache_index.find(chunk_num);
+  if (itr == m_cache_index.end())
     return nullptr;
 
-  itr->MarkUsed();
-  return &*itr;
+  itr->second->MarkUsed();
+  return itr->second;
 }
 
 SectorReader::Cache* SectorReader::GetEmptyCacheLine()
@@ -69,23 +140,51 @@ SectorReader::Cache* SectorReader::GetEmptyCacheLine()
     }
     line.ShiftLRU();
   });
+
+  if (oldest->num_blocks)
+    m_cache_index.erase(oldest->block_idx / m_chunk_blocks);
   oldest->Reset();
   return oldest;
 }
 
-const SectorReader::Cache* SectorReader::GetCacheLine(u64 block_num)
+void SectorReader::FillCacheLine(Cache* cache, u64 chunk_num, u32 blocks_read)
 {
-  if (auto entry = FindCacheLine(block_num))
-    return entry;
+  cache->Fill(chunk_num * m_chunk_blocks, blocks_read);
+  m_cache_index[chunk_num] = cache;
+}
+
+const SectorReader::Cache* SectorReader::GetCacheLine(u64 block_num,
+                                                      std::unique_lock<std::mutex>& lock)
+{
+  // We only read aligned chunks, this avoids duplicate overlapping entries.
+  const u64 chunk_idx = block_num / m_chunk_blocks;
+
+  // If the prefetch thread is busy reading the chunk we want, wait for it
+  // instead of reading the same chunk twice.
+  m_prefetch_done.wait(lock, [&] { return m_prefetching_chunk != chunk_idx; });
+
+  if (Cache* entry = FindCacheLine(chunk_idx))
+  {
+    ++m_stats.hits;
+    if (entry->prefetched)
+    {
+      ++m_stats.prefetch_hits;
+      entry->prefetched = false;
+    }
+    return entry->Contains(block_num) ? entry : nullptr;
+  }
 
   // Cache miss. Fault in the missing entry.
+  ++m_stats.misses;
   Cache* cache = GetEmptyCacheLine();
-  // We only read aligned chunks, this avoids duplicate overlapping entries.
-  u64 chunk_idx = block_num / m_chunk_blocks;
-  u32 blocks_read = ReadChunk(cache->data.data(), chunk_idx);
+  u32 blocks_read;
+  {
+    std::lock_guard<std::mutex> read_lock(m_read_mutex);
+    blocks_read = ReadChunk(cache->data.data(), chunk_idx);
+  }
   if (!blocks_read)
     return nullptr;
-  cache->Fill(chunk_idx * m_chunk_blocks, blocks_read);
+  FillCacheLine(cache, chunk_idx, blocks_read);
 
   // Secondary check for out-of-bounds read.
   // If we got less than m_chunk_blocks, we may still have missed.
@@ -96,6 +195,12 @@ const SectorReader::Cache* SectorReader::GetCacheLine(u64 block_num)
 
 bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
 {
+  std::unique_lock<std::mutex> lk(m_cache_mutex);
+  if (m_cache_memory_budget != s_cache_memory_budget.load())
+    ResizeCache();
+
+  UpdateAccessPattern(offset, size);
+
   u64 remain = size;
   u64 block = 0;
   u32 position_in_block = static_cast<u32>(offset % m_block_size);
@@ -104,7 +209,7 @@ bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
   {
     block = offset / m_block_size;
 
-    const Cache* cache = GetCacheLine(block);
+    const Cache* cache = GetCacheLine(block, lk);
     if (!cache)
       return false;
 
@@ -124,6 +229,87 @@ bool SectorReader::Read(u64 offset, u64 size, u8* out_ptr)
   return true;
 }
 
+void SectorReader::UpdateAccessPattern(u64 offset, u64 size)
+{
+  const u64 line_size = static_cast<u64>(m_block_size) * m_chunk_blocks;
+  if (line_size == 0 || size == 0)
+    return;
+
+  // Small forward skips still count as sequential, since games often skip over
+  // headers or padding while streaming
+  if (offset >= m_next_sequential_offset && offset - m_next_sequential_offset <= line_size)
+    ++m_sequential_reads;
+  else
+    m_sequential_reads = 0;
+
+  m_next_sequential_offset = offset + size;
+
+  if (m_sequential_reads < SEQUENTIAL_READS_BEFORE_PREFETCH || m_stop_prefetching)
+    return;
+
+  const u64 data_size = GetDataSize();
+  const u64 end_chunk = data_size ? (data_size + line_size - 1) / line_size : NO_CHUNK;
+  const u64 first_chunk = (offset + size - 1) / line_size + 1;
+
+  m_prefetch_queue.clear();
+  for (u64 chunk = first_chunk; chunk < first_chunk + m_prefetch_chunks && chunk < end_chunk;
+       ++chunk)
+  {
+    if (m_cache_index.find(chunk) == m_cache_index.end())
+      m_prefetch_queue.push_back(chunk);
+  }
+
+  if (m_prefetch_queue.empty())
+    return;
+
+  if (!m_prefetch_thread.joinable())
+    m_prefetch_thread = std::thread([this] { PrefetchThreadLoop(); });
+
+  m_prefetch_wakeup.notify_one();
+}
+
+void SectorReader::PrefetchThreadLoop()
+{
+  Common::SetCurrentThreadName("Disc prefetch thread");
+
+  std::unique_lock<std::mutex> lk(m_cache_mutex);
+  while (true)
+  {
+    m_prefetch_wakeup.wait(lk, [&] { return m_stop_prefetching || !m_prefetch_queue.empty(); });
+    if (m_stop_prefetching)
+      return;
+
+    const u64 chunk_idx = m_prefetch_queue.front();
+    m_prefetch_queue.pop_front();
+    if (m_cache_index.find(chunk_idx) != m_cache_index.end())
+      continue;
+
+    const size_t line_size = static_cast<size_t>(m_chunk_blocks) * m_block_size;
+    m_prefetch_buffer.resize(line_size);
+    m_prefetching_chunk = chunk_idx;
+    lk.unlock();
+
+    u32 blocks_read;
+    {
+      std::lock_guard<std::mutex> read_lock(m_read_mutex);
+      blocks_read = ReadChunk(m_prefetch_buffer.data(), chunk_idx);
+    }
+
+    lk.lock();
+    // The cache may have been resized while we weren't holding the lock
+    if (blocks_read && m_prefetch_buffer.size() == m_cache[0].data.size())
+    {
+      Cache* cache = GetEmptyCacheLine();
+      std::swap(cache->data, m_prefetch_buffer);
+      FillCacheLine(cache, chunk_idx, blocks_read);
+      cache->prefetched = true;
+      ++m_stats.prefetched_chunks;
+    }
+    m_prefetching_chunk = NO_CHUNK;
+    m_prefetch_done.notify_all();
+  }
+}
+
 // Crap default implementation if not overridden.
 bool SectorReader::ReadMultipleAlignedBlocks(u64 block_num, u64 cnt_blocks, u8* out_ptr)
 {
@@ -196,6 +382,8 @@ std::unique_ptr<BlobReader> CreateBlobReader(const std::string& filename)
   {
   case CISO_MAGIC:
     return CISOFileReader::Create(std::move(file));
+  case DCZ_MAGIC:
+    return DCZFileReader::Create(std::move(file), filename);
   case GCZ_MAGIC:
     return CompressedBlobReader::Create(std::move(file), filename);
   case TGC_MAGIC:
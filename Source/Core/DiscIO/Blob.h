@@ -15,9 +15,15 @@
 // automatically do the right thing.
 
 #include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -34,7 +40,8 @@ enum class BlobType
   GCZ,
   CISO,
   WBFS,
-  TGC
+  TGC,
+  DCZ
 };
 
 class BlobReader
@@ -69,13 +76,33 @@ protected:
 // Provides caching and byte-operation-to-block-operations facilities.
 // Used for compressed blob and direct drive reading.
 // NOTE: GetDataSize() is expected to be evenly divisible by the sector size.
+//
+// When Read is called for consecutive ranges, the chunks that follow are read on a
+// background thread ahead of time, so that sequential streaming doesn't have to wait
+// for decompression or cold disk reads.
 class SectorReader : public BlobReader
 {
 public:
+  struct CacheStats
+  {
+    u64 hits = 0;
+    u64 misses = 0;
+    // Hits on chunks that were read by the prefetch thread before anything asked for them
+    u64 prefetch_hits = 0;
+    u64 prefetched_chunks = 0;
+  };
+
   virtual ~SectorReader() = 0;
 
   bool Read(u64 offset, u64 size, u8* out_ptr) override;
 
+  CacheStats GetCacheStats() const;
+
+  // Sets how much memory each SectorReader may use for cached chunks.
+  // Existing readers pick up the new value (and drop their cache) on their next Read.
+  static void SetCacheMemoryBudget(size_t bytes);
+  static constexpr size_t DEFAULT_CACHE_MEMORY_BUDGET = 16 * 1024 * 1024;
+
 protected:
   void SetSectorSize(int blocksize);
   int GetSectorSize() const { return m_block_size; }
@@ -94,12 +121,18 @@ protected:
   // overridden in derived classes where possible.
   virtual bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8* out_ptr);
 
+  // GetBlock and ReadMultipleAlignedBlocks get called on the prefetch thread,
+  // so derived classes must call this at the start of their destructor.
+  // The calls never overlap, so derived classes don't need any locking of their own.
+  void StopPrefetching();
+
 private:
   struct Cache
   {
     std::vector<u8> data;
     u64 block_idx = 0;
     u32 num_blocks = 0;
+    bool prefetched = false;
 
     // [Pseudo-] Least Recently Used Shift Register
     // When an empty cache line is needed, the line with the lowest value
@@ -112,6 +145,7 @@ private:
     {
       block_idx = 0;
       num_blocks = 0;
+      prefetched = false;
       lru_sreg = 0;
     }
     void Fill(u64 block, u32 count)
@@ -130,17 +164,24 @@ private:
     bool IsLessRecentlyUsedThan(const Cache& other) const { return lru_sreg < other.lru_sreg; }
   };
 
-  // Gets the cache line that contains the given block, or nullptr.
+  // Reallocates the cache lines to fit the chunk size and the memory budget.
+  void ResizeCache();
+
+  // Gets the cache line that holds the given chunk, or nullptr.
   // NOTE: The cache record only lasts until it expires (next GetEmptyCacheLine)
-  const Cache* FindCacheLine(u64 block_num);
+  Cache* FindCacheLine(u64 chunk_num);
 
   // Finds the least recently used cache line, resets and returns it.
   Cache* GetEmptyCacheLine();
 
+  // Marks a cache line returned by GetEmptyCacheLine as holding the given chunk.
+  void FillCacheLine(Cache* cache, u64 chunk_num, u32 blocks_read);
+
   // Combines FindCacheLine with GetEmptyCacheLine and ReadChunk.
   // Always returns a valid cache line (loading the data if needed).
   // May return nullptr only if the cache missed and the read failed.
-  const Cache* GetCacheLine(u64 block_num);
+  // Must be called with m_cache_mutex locked through the given lock.
+  const Cache* GetCacheLine(u64 block_num, std::unique_lock<std::mutex>& lock);
 
   // Read all bytes from a chunk of blocks into a buffer.
   // Returns the number of blocks read (may be less than m_chunk_blocks
@@ -148,20 +189,57 @@ private:
   // evenly divisible into chunks). Returns zero if it fails.
   u32 ReadChunk(u8* buffer, u64 chunk_num);
 
-  static constexpr int CACHE_LINES = 32;
+  // Tracks whether reads are sequential and queues prefetches if they are.
+  void UpdateAccessPattern(u64 offset, u64 size);
+  void PrefetchThreadLoop();
+
+  static constexpr u32 MIN_CACHE_LINES = 8;
+  static constexpr u32 MAX_PREFETCH_CHUNKS = 64;
+  static constexpr size_t MAX_PREFETCH_BYTES = 4 * 1024 * 1024;
+  static constexpr u32 SEQUENTIAL_READS_BEFORE_PREFETCH = 2;
+  static constexpr u64 NO_CHUNK = UINT64_MAX;
+
   u32 m_block_size = 0;    // Bytes in a sector/block
   u32 m_chunk_blocks = 1;  // Number of sectors/blocks in a chunk
-  std::array<Cache, CACHE_LINES> m_cache;
+  size_t m_cache_memory_budget = 0;
+  std::vector<Cache> m_cache;
+  std::unordered_map<u64, Cache*> m_cache_index;  // Chunk number -> cache line
+  CacheStats m_stats;
+
+  // Guards everything above and the prefetch state below
+  mutable std::mutex m_cache_mutex;
+  // Held while GetBlock or ReadMultipleAlignedBlocks are running
+  std::mutex m_read_mutex;
+
+  u64 m_next_sequential_offset = 0;
+  u32 m_sequential_reads = 0;
+  u32 m_prefetch_chunks = 1;
+
+  std::thread m_prefetch_thread;
+  std::condition_variable m_prefetch_wakeup;
+  std::condition_variable m_prefetch_done;
+  std::deque<u64> m_prefetch_queue;
+  u64 m_prefetching_chunk = NO_CHUNK;
+  bool m_stop_prefetching = false;
+  // Only accessed by the prefetch thread
+  std::vector<u8> m_prefetch_buffer;
 };
 
 // Factory function - examines the path to choose the right type of BlobReader, and returns one.
 std::unique_ptr<BlobReader> CreateBlobReader(const std::string& filename);
 
+// When enabled, plain and WBFS disc images are read through memory mappings of their files
+// instead of seeking and reading. Only affects blob readers that are created afterwards.
+void SetMemoryMappingEnabled(bool enabled);
+bool IsMemoryMappingEnabled();
+
 typedef bool (*CompressCB)(const std::string& text, float percent, void* arg);
 
+// Blocks are compressed on num_threads worker threads (0 means one per hardware thread).
+// The callback is only ever called on the calling thread.
 bool CompressFileToBlob(const std::string& infile_path, const std::string& outfile_path,
                         u32 sub_type = 0, int sector_size = 16384, CompressCB callback = nullptr,
-                        void* arg = nullptr);
+                        void* arg = nullptr, int num_threads = 0);
 bool DecompressBlobToFile(const std::string& infile_path, const std::string& outfile_path,
                           CompressCB callback = nullptr, void* arg = nullptr);
 
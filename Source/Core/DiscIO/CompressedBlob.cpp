@@ -9,10 +9,14 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
 #include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <zlib.h>
@@ -24,6 +28,7 @@
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
 #include "DiscIO/Blob.h"
 #include "DiscIO/CompressedBlob.h"
 #include "DiscIO/DiscScrubber.h"
@@ -70,6 +75,7 @@ std::unique_ptr<CompressedBlobReader> CompressedBlobReader::Create(File::IOFile
 
 CompressedBlobReader::~CompressedBlobReader()
 {
+  StopPrefetching();
 }
 
 // IMPORTANT: Calling this function invalidates all earlier pointers gotten from this function.
@@ -152,8 +158,64 @@ bool CompressedBlobReader::GetBlock(u64 block_num, u8* out_ptr)
   return true;
 }
 
+namespace
+{
+struct CompressionSlot
+{
+  enum class State
+  {
+    Free,
+    Pending,
+    Done,
+    Failed,
+  };
+
+  std::vector<u8> in_buf;
+  std::vector<u8> out_buf;
+  bool stored = false;
+  u32 write_size = 0;
+  u32 hash = 0;
+  State state = State::Free;
+
+  const u8* GetWriteBuffer() const { return stored ? in_buf.data() : out_buf.data(); }
+};
+}  // Anonymous namespace
+
+// Compresses a single block. Every block is compressed from a freshly reset stream,
+// so the output only depends on the input block and not on which thread compressed it.
+static bool CompressBlock(z_stream* z, u32 block_size, CompressionSlot* slot)
+{
+  if (deflateReset(z) != Z_OK)
+    return false;
+
+  z->next_in = slot->in_buf.data();
+  z->avail_in = block_size;
+  z->next_out = slot->out_buf.data();
+  z->avail_out = block_size;
+
+  const int status = deflate(z, Z_FINISH);
+  const u32 comp_size = block_size - z->avail_out;
+
+  if ((status != Z_STREAM_END) || (z->avail_out < 10))
+  {
+    // let's store uncompressed
+    slot->stored = true;
+    slot->write_size = block_size;
+  }
+  else
+  {
+    // let's store compressed
+    slot->stored = false;
+    slot->write_size = comp_size;
+  }
+
+  slot->hash = Common::HashAdler32(slot->GetWriteBuffer(), slot->write_size);
+  return true;
+}
+
 bool CompressFileToBlob(const std::string& infile_path, const std::string& outfile_path,
-                        u32 sub_type, int block_size, CompressCB callback, void* arg)
+                        u32 sub_type, int block_size, CompressCB callback, void* arg,
+                        int num_threads)
 {
   bool scrubbing = false;
 
@@ -193,9 +255,21 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
     scrubbing = true;
   }
 
-  z_stream z = {};
-  if (deflateInit(&z, 9) != Z_OK)
-    return false;
+  if (num_threads <= 0)
+    num_threads = std::max<int>(1, std::thread::hardware_concurrency());
+
+  // Every worker thread owns a deflate stream.
+  std::vector<z_stream> streams(num_threads);
+  for (size_t i = 0; i < streams.size(); ++i)
+  {
+    streams[i] = {};
+    if (deflateInit(&streams[i], 9) != Z_OK)
+    {
+      for (size_t j = 0; j < i; ++j)
+        deflateEnd(&streams[j]);
+      return false;
+    }
+  }
 
   callback(GetStringT("Files opened, ready to compress."), 0, arg);
 
@@ -210,8 +284,50 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
 
   std::vector<u64> offsets(header.num_blocks);
   std::vector<u32> hashes(header.num_blocks);
-  std::vector<u8> out_buf(block_size);
-  std::vector<u8> in_buf(block_size);
+
+  // Block i is always handled by slot i % num_slots. Having more slots than workers lets
+  // the calling thread read ahead while it waits for the oldest block to be compressed.
+  std::vector<CompressionSlot> slots(num_threads * 2);
+  for (CompressionSlot& slot : slots)
+  {
+    slot.in_buf.resize(block_size);
+    slot.out_buf.resize(block_size);
+  }
+
+  std::mutex slots_mutex;
+  std::condition_variable work_available;
+  std::condition_variable work_done;
+  std::queue<CompressionSlot*> pending_slots;
+  bool stop_workers = false;
+
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads);
+  for (z_stream& z : streams)
+  {
+    workers.emplace_back([&, z_ptr = &z] {
+      Common::SetCurrentThreadName("GCZ Compression");
+      while (true)
+      {
+        CompressionSlot* slot;
+        {
+          std::unique_lock<std::mutex> lk(slots_mutex);
+          work_available.wait(lk, [&] { return stop_workers || !pending_slots.empty(); });
+          if (stop_workers)
+            return;
+          slot = pending_slots.front();
+          pending_slots.pop();
+        }
+
+        const bool compressed = CompressBlock(z_ptr, header.block_size, slot);
+
+        {
+          std::lock_guard<std::mutex> lk(slots_mutex);
+          slot->state = compressed ? CompressionSlot::State::Done : CompressionSlot::State::Failed;
+        }
+        work_done.notify_all();
+      }
+    });
+  }
 
   // seek past the header (we will write it at the end)
   outfile.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
@@ -222,6 +338,7 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
 
   // Now we are ready to write compressed data!
   u64 position = 0;
+  u32 next_block_to_read = 0;
   int num_compressed = 0;
   int num_stored = 0;
   int progress_monitor = std::max<int>(1, header.num_blocks / 1000);
@@ -231,7 +348,7 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   {
     if (i % progress_monitor == 0)
     {
-      const u64 inpos = infile.Tell();
+      const u64 inpos = static_cast<u64>(i) * block_size;
       int ratio = 0;
       if (inpos != 0)
         ratio = (int)(100 * position / inpos);
@@ -247,53 +364,58 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
       }
     }
 
-    offsets[i] = position;
+    // Reading has to stay on this thread, since the scrubber walks the input sequentially.
+    while (next_block_to_read < header.num_blocks && next_block_to_read - i < slots.size())
+    {
+      CompressionSlot& slot = slots[next_block_to_read % slots.size()];
 
-    size_t read_bytes;
-    if (scrubbing)
-      read_bytes = disc_scrubber.GetNextBlock(infile, in_buf.data());
-    else
-      infile.ReadArray(in_buf.data(), header.block_size, &read_bytes);
-    if (read_bytes < header.block_size)
-      std::fill(in_buf.begin() + read_bytes, in_buf.begin() + header.block_size, 0);
+      size_t read_bytes;
+      if (scrubbing)
+        read_bytes = disc_scrubber.GetNextBlock(infile, slot.in_buf.data());
+      else
+        infile.ReadArray(slot.in_buf.data(), header.block_size, &read_bytes);
+      if (read_bytes < header.block_size)
+        std::fill(slot.in_buf.begin() + read_bytes, slot.in_buf.begin() + header.block_size, 0);
 
-    int retval = deflateReset(&z);
-    z.next_in = in_buf.data();
-    z.avail_in = header.block_size;
-    z.next_out = out_buf.data();
-    z.avail_out = block_size;
+      {
+        std::lock_guard<std::mutex> lk(slots_mutex);
+        slot.state = CompressionSlot::State::Pending;
+        pending_slots.push(&slot);
+      }
+      work_available.notify_one();
+      ++next_block_to_read;
+    }
+
+    // Blocks are written strictly in order, so the output is identical to compressing
+    // on a single thread.
+    CompressionSlot& slot = slots[i % slots.size()];
+    {
+      std::unique_lock<std::mutex> lk(slots_mutex);
+      work_done.wait(lk, [&] {
+        return slot.state == CompressionSlot::State::Done ||
+               slot.state == CompressionSlot::State::Failed;
+      });
+    }
 
-    if (retval != Z_OK)
+    if (slot.state == CompressionSlot::State::Failed)
     {
       ERROR_LOG(DISCIO, "Deflate failed");
       success = false;
       break;
     }
 
-    int status = deflate(&z, Z_FINISH);
-    int comp_size = block_size - z.avail_out;
-
-    u8* write_buf;
-    int write_size;
-    if ((status != Z_STREAM_END) || (z.avail_out < 10))
+    offsets[i] = position;
+    if (slot.stored)
     {
-      // PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
-      // let's store uncompressed
-      write_buf = in_buf.data();
       offsets[i] |= 0x8000000000000000ULL;
-      write_size = block_size;
       num_stored++;
     }
     else
     {
-      // let's store compressed
-      // PanicAlert("Comp %i to %i", block_size, comp_size);
-      write_buf = out_buf.data();
-      write_size = comp_size;
       num_compressed++;
     }
 
-    if (!outfile.WriteBytes(write_buf, write_size))
+    if (!outfile.WriteBytes(slot.GetWriteBuffer(), slot.write_size))
     {
       PanicAlertT("Failed to write the output file \"%s\".\n"
                   "Check that you have enough space available on the target drive.",
@@ -302,10 +424,19 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
       break;
     }
 
-    position += write_size;
+    position += slot.write_size;
 
-    hashes[i] = Common::HashAdler32(write_buf, write_size);
+    hashes[i] = slot.hash;
+    slot.state = CompressionSlot::State::Free;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(slots_mutex);
+    stop_workers = true;
   }
+  work_available.notify_all();
+  for (std::thread& worker : workers)
+    worker.join();
 
   header.compressed_data_size = position;
 
@@ -325,7 +456,8 @@ bool CompressFileToBlob(const std::string& infile_path, const std::string& outfi
   }
 
   // Cleanup
-  deflateEnd(&z);
+  for (z_stream& z : streams)
+    deflateEnd(&z);
 
   if (success)
   {
@@ -0,0 +1,896 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "DiscIO/DCZBlob.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "Common/Align.h"
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/Logging/Log.h"
+#include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
+#include "Core/IOS/ES/Formats.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/Enums.h"
+#include "DiscIO/LaggedFibonacciGenerator.h"
+#include "DiscIO/Volume.h"
+#include "DiscIO/VolumeWii.h"
+
+namespace DiscIO
+{
+// Guards against allocating absurd amounts of memory for corrupt files
+static constexpr u32 MAX_CHUNK_SIZE = 0x4000000;
+
+bool IsDCZCompressionSupported(DCZCompression compression)
+{
+  switch (compression)
+  {
+  case DCZCompression::None:
+  case DCZCompression::Deflate:
+    return true;
+#ifdef HAVE_LZMA
+  case DCZCompression::LZMA:
+    return true;
+#endif
+#ifdef HAVE_ZSTD
+  case DCZCompression::Zstd:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+static bool CompressBuffer(DCZCompression compression, int level, const u8* in, size_t in_size,
+                           std::vector<u8>* out)
+{
+  switch (compression)
+  {
+  case DCZCompression::Deflate:
+  {
+    z_stream z = {};
+    if (deflateInit(&z, level) != Z_OK)
+      return false;
+
+    out->resize(deflateBound(&z, static_cast<uLong>(in_size)));
+    z.next_in = const_cast<u8*>(in);
+    z.avail_in = static_cast<uInt>(in_size);
+    z.next_out = out->data();
+    z.avail_out = static_cast<uInt>(out->size());
+
+    const int status = deflate(&z, Z_FINISH);
+    out->resize(z.total_out);
+    deflateEnd(&z);
+    return status == Z_STREAM_END;
+  }
+#ifdef HAVE_LZMA
+  case DCZCompression::LZMA:
+  {
+    out->resize(lzma_stream_buffer_bound(in_size));
+    size_t out_pos = 0;
+    const u32 preset = static_cast<u32>(std::clamp(level, 0, 9));
+    if (lzma_easy_buffer_encode(preset, LZMA_CHECK_NONE, nullptr, in, in_size, out->data(),
+                                &out_pos, out->size()) != LZMA_OK)
+    {
+      return false;
+    }
+    out->resize(out_pos);
+    return true;
+  }
+#endif
+#ifdef HAVE_ZSTD
+  case DCZCompression::Zstd:
+  {
+    out->resize(ZSTD_compressBound(in_size));
+    const size_t result = ZSTD_compress(out->data(), out->size(), in, in_size, level);
+    if (ZSTD_isError(result))
+      return false;
+    out->resize(result);
+    return true;
+  }
+#endif
+  default:
+    return false;
+  }
+}
+
+static bool DecompressBuffer(DCZCompression compression, const u8* in, size_t in_size, u8* out,
+                             size_t out_size)
+{
+  switch (compression)
+  {
+  case DCZCompression::Deflate:
+  {
+    z_stream z = {};
+    if (inflateInit(&z) != Z_OK)
+      return false;
+
+    z.next_in = const_cast<u8*>(in);
+    z.avail_in = static_cast<uInt>(in_size);
+    z.next_out = out;
+    z.avail_out = static_cast<uInt>(out_size);
+
+    const int status = inflate(&z, Z_FINISH);
+    const bool success = status == Z_STREAM_END && z.avail_out == 0;
+    inflateEnd(&z);
+    return success;
+  }
+#ifdef HAVE_LZMA
+  case DCZCompression::LZMA:
+  {
+    u64 memory_limit = UINT64_MAX;
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+    return lzma_stream_buffer_decode(&memory_limit, 0, nullptr, in, &in_pos, in_size, out,
+                                     &out_pos, out_size) == LZMA_OK &&
+           out_pos == out_size;
+  }
+#endif
+#ifdef HAVE_ZSTD
+  case DCZCompression::Zstd:
+    return ZSTD_decompress(out, out_size, in, in_size) == out_size;
+#endif
+  default:
+    return false;
+  }
+}
+
+static size_t GetPayloadSize(const DCZChunkEntry& chunk)
+{
+  if (chunk.type == DCZChunkType::WiiDecrypted)
+    return chunk.disc_size / VolumeWii::BLOCK_TOTAL_SIZE * VolumeWii::BLOCK_DATA_SIZE;
+  return chunk.disc_size;
+}
+
+// Junk is reseeded at every multiple of this many bytes of the disc (or of a partition).
+static constexpr u64 JUNK_SEED_INTERVAL = 0x8000;
+
+static bool UnpackJunk(const u8* in, size_t in_size, u8* out, size_t out_size)
+{
+  LaggedFibonacciGenerator lfg;
+
+  while (in_size > 0)
+  {
+    u32 size;
+    if (in_size < sizeof(size))
+      return false;
+    std::memcpy(&size, in, sizeof(size));
+
+    if (size & DCZ_JUNK_RUN_FLAG)
+    {
+      DCZJunkRun run;
+      if (in_size < sizeof(run))
+        return false;
+      std::memcpy(&run, in, sizeof(run));
+      in += sizeof(run);
+      in_size -= sizeof(run);
+
+      // A run never crosses a reseed, so anything else is a corrupt file
+      size &= ~DCZ_JUNK_RUN_FLAG;
+      if (size > out_size || run.lfg_offset >= JUNK_SEED_INTERVAL ||
+          size > JUNK_SEED_INTERVAL - run.lfg_offset)
+      {
+        return false;
+      }
+
+      lfg.SetSeed(run.seed.data());
+      lfg.Forward(run.lfg_offset);
+      lfg.GetBytes(size, out);
+    }
+    else
+    {
+      in += sizeof(size);
+      in_size -= sizeof(size);
+      if (size > in_size || size > out_size)
+        return false;
+
+      std::copy_n(in, size, out);
+      in += size;
+      in_size -= size;
+    }
+
+    out += size;
+    out_size -= size;
+  }
+
+  return out_size == 0;
+}
+
+DCZFileReader::DCZFileReader(File::IOFile file, const std::string& filename)
+    : m_file(std::move(file)), m_file_name(filename)
+{
+  m_file_size = m_file.GetSize();
+  m_file.Seek(0, SEEK_SET);
+  if (!m_file.ReadArray(&m_header, 1) || m_header.magic != DCZ_MAGIC ||
+      m_header.version != DCZ_VERSION || !IsDCZCompressionSupported(m_header.compression))
+  {
+    return;
+  }
+
+  std::vector<DCZPartitionEntry> partition_entries(m_header.num_partitions);
+  m_chunks.resize(m_header.num_chunks);
+  if (!m_file.ReadArray(partition_entries.data(), partition_entries.size()) ||
+      !m_file.ReadArray(m_chunks.data(), m_chunks.size()))
+  {
+    return;
+  }
+
+  for (const DCZPartitionEntry& entry : partition_entries)
+  {
+    m_partitions.push_back({entry, Common::AES::CreateContextEncrypt(entry.title_key.data()),
+                            Common::AES::CreateContextDecrypt(entry.title_key.data())});
+  }
+
+  // The chunks must cover the whole disc without gaps or overlaps
+  u64 position = 0;
+  for (const DCZChunkEntry& chunk : m_chunks)
+  {
+    if (chunk.disc_offset != position || chunk.disc_size == 0 ||
+        chunk.disc_size > MAX_CHUNK_SIZE || chunk.stored_size > MAX_CHUNK_SIZE)
+    {
+      return;
+    }
+
+    if (chunk.type == DCZChunkType::WiiDecrypted &&
+        (chunk.partition_index >= m_partitions.size() ||
+         chunk.disc_size % VolumeWii::BLOCK_TOTAL_SIZE != 0 ||
+         chunk.disc_size > VolumeWii::GROUP_TOTAL_SIZE))
+    {
+      return;
+    }
+
+    position += chunk.disc_size;
+  }
+
+  m_is_valid = position == m_header.data_size;
+}
+
+std::unique_ptr<DCZFileReader> DCZFileReader::Create(File::IOFile file, const std::string& filename)
+{
+  auto reader = std::unique_ptr<DCZFileReader>(new DCZFileReader(std::move(file), filename));
+  if (!reader->IsValid())
+    return nullptr;
+
+  return reader;
+}
+
+DCZFileReader::~DCZFileReader()
+{
+}
+
+size_t DCZFileReader::FindChunk(u64 disc_offset) const
+{
+  auto it = std::upper_bound(
+      m_chunks.begin(), m_chunks.end(), disc_offset,
+      [](u64 offset, const DCZChunkEntry& chunk) { return offset < chunk.disc_offset; });
+  if (it == m_chunks.begin())
+    return m_chunks.size();
+
+  --it;
+  if (disc_offset - it->disc_offset >= it->disc_size)
+    return m_chunks.size();
+
+  return static_cast<size_t>(it - m_chunks.begin());
+}
+
+const u8* DCZFileReader::GetChunkPayload(size_t chunk_index)
+{
+  if (m_payload_chunk == chunk_index)
+    return m_payload_buffer.data();
+
+  m_payload_chunk = SIZE_MAX;
+
+  const DCZChunkEntry& chunk = m_chunks[chunk_index];
+  const size_t payload_size = GetPayloadSize(chunk);
+  if (m_payload_buffer.size() < payload_size)
+    m_payload_buffer.resize(payload_size);
+
+  const bool is_compressed = (chunk.flags & DCZ_CHUNK_COMPRESSED) != 0;
+  const bool is_packed = (chunk.flags & DCZ_CHUNK_PACKED) != 0;
+  if (!is_compressed && !is_packed && chunk.stored_size != payload_size)
+  {
+    ERROR_LOG(DISCIO, "DCZ chunk %zu has the wrong size", chunk_index);
+    return nullptr;
+  }
+
+  std::vector<u8>& read_buffer = is_compressed || is_packed ? m_stored_buffer : m_payload_buffer;
+  if (read_buffer.size() < chunk.stored_size)
+    read_buffer.resize(chunk.stored_size);
+
+  m_file.Seek(chunk.file_offset, SEEK_SET);
+  if (!m_file.ReadBytes(read_buffer.data(), chunk.stored_size))
+  {
+    PanicAlertT("The disc image \"%s\" is truncated, some of the data is missing.",
+                m_file_name.c_str());
+    m_file.Clear();
+    return nullptr;
+  }
+
+  const u32 hash = Common::HashAdler32(read_buffer.data(), chunk.stored_size);
+  if (hash != chunk.hash)
+  {
+    PanicAlertT("The disc image \"%s\" is corrupt.\n"
+                "Hash of block %" PRIu64 " is %08x instead of %08x.",
+                m_file_name.c_str(), static_cast<u64>(chunk_index), hash, chunk.hash);
+    return nullptr;
+  }
+
+  const u8* stored = m_stored_buffer.data();
+  size_t stored_size = chunk.stored_size;
+  u32 packed_size = static_cast<u32>(payload_size);
+  if (is_packed)
+  {
+    if (stored_size < sizeof(packed_size))
+    {
+      ERROR_LOG(DISCIO, "DCZ chunk %zu has the wrong size", chunk_index);
+      return nullptr;
+    }
+    std::memcpy(&packed_size, stored, sizeof(packed_size));
+    stored += sizeof(packed_size);
+    stored_size -= sizeof(packed_size);
+
+    if (packed_size > MAX_CHUNK_SIZE || (!is_compressed && stored_size != packed_size))
+    {
+      ERROR_LOG(DISCIO, "DCZ chunk %zu has the wrong size", chunk_index);
+      return nullptr;
+    }
+  }
+
+  const u8* packed = stored;
+  if (is_compressed)
+  {
+    std::vector<u8>& decompressed_buffer = is_packed ? m_packed_buffer : m_payload_buffer;
+    if (decompressed_buffer.size() < packed_size)
+      decompressed_buffer.resize(packed_size);
+
+    if (!DecompressBuffer(m_header.compression, stored, stored_size, decompressed_buffer.data(),
+                          packed_size))
+    {
+      ERROR_LOG(DISCIO, "Failed to decompress DCZ chunk %zu", chunk_index);
+      return nullptr;
+    }
+    packed = decompressed_buffer.data();
+  }
+
+  if (is_packed && !UnpackJunk(packed, packed_size, m_payload_buffer.data(), payload_size))
+  {
+    ERROR_LOG(DISCIO, "Failed to unpack DCZ chunk %zu", chunk_index);
+    return nullptr;
+  }
+
+  m_payload_chunk = chunk_index;
+  return m_payload_buffer.data();
+}
+
+const u8* DCZFileReader::GetEncryptedChunk(size_t chunk_index)
+{
+  if (m_encrypted_chunk == chunk_index)
+    return m_encrypted_buffer.data();
+
+  m_encrypted_chunk = SIZE_MAX;
+
+  const u8* payload = GetChunkPayload(chunk_index);
+  if (!payload)
+    return nullptr;
+
+  const DCZChunkEntry& chunk = m_chunks[chunk_index];
+  const u32 num_blocks = chunk.disc_size / VolumeWii::BLOCK_TOTAL_SIZE;
+
+  std::vector<VolumeWii::HashBlock> hash_blocks(num_blocks);
+  VolumeWii::HashGroup(payload, num_blocks, hash_blocks.data());
+
+  m_encrypted_buffer.resize(chunk.disc_size);
+  VolumeWii::EncryptGroup(m_partitions[chunk.partition_index].encryption_context.get(),
+                          hash_blocks.data(), payload, num_blocks, m_encrypted_buffer.data());
+
+  m_encrypted_chunk = chunk_index;
+  return m_encrypted_buffer.data();
+}
+
+bool DCZFileReader::Read(u64 offset, u64 size, u8* out_ptr)
+{
+  if (offset > m_header.data_size || size > m_header.data_size - offset)
+    return false;
+
+  while (size > 0)
+  {
+    const size_t chunk_index = FindChunk(offset);
+    if (chunk_index == m_chunks.size())
+      return false;
+
+    const DCZChunkEntry& chunk = m_chunks[chunk_index];
+    const u64 offset_in_chunk = offset - chunk.disc_offset;
+    const u64 bytes_to_copy = std::min(size, chunk.disc_size - offset_in_chunk);
+
+    switch (chunk.type)
+    {
+    case DCZChunkType::Fill:
+      std::fill_n(out_ptr, bytes_to_copy, chunk.fill_byte);
+      break;
+
+    case DCZChunkType::Raw:
+    {
+      const u8* payload = GetChunkPayload(chunk_index);
+      if (!payload)
+        return false;
+      std::copy_n(payload + offset_in_chunk, bytes_to_copy, out_ptr);
+      break;
+    }
+
+    case DCZChunkType::WiiDecrypted:
+    {
+      const u8* encrypted = GetEncryptedChunk(chunk_index);
+      if (!encrypted)
+        return false;
+      std::copy_n(encrypted + offset_in_chunk, bytes_to_copy, out_ptr);
+      break;
+    }
+
+    default:
+      return false;
+    }
+
+    offset += bytes_to_copy;
+    out_ptr += bytes_to_copy;
+    size -= bytes_to_copy;
+  }
+
+  return true;
+}
+
+bool DCZFileReader::ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_offset)
+{
+  auto partition_it =
+      std::find_if(m_partitions.begin(), m_partitions.end(), [&](const PartitionInfo& partition) {
+        return partition.entry.partition_offset == partition_offset;
+      });
+  if (partition_it == m_partitions.end())
+    return false;
+
+  const PartitionInfo& partition = *partition_it;
+  const size_t partition_index = partition_it - m_partitions.begin();
+
+  std::vector<u8> encrypted_block;
+  std::vector<u8> decrypted_block;
+
+  while (size > 0)
+  {
+    const u64 block_index = offset / VolumeWii::BLOCK_DATA_SIZE;
+    const u64 offset_in_block = offset % VolumeWii::BLOCK_DATA_SIZE;
+    const u64 bytes_to_copy = std::min(size, VolumeWii::BLOCK_DATA_SIZE - offset_in_block);
+    const u64 block_disc_offset =
+        partition.entry.data_offset + block_index * VolumeWii::BLOCK_TOTAL_SIZE;
+
+    const size_t chunk_index = FindChunk(block_disc_offset);
+    if (chunk_index == m_chunks.size())
+      return false;
+
+    const DCZChunkEntry& chunk = m_chunks[chunk_index];
+    if (chunk.type == DCZChunkType::WiiDecrypted && chunk.partition_index == partition_index)
+    {
+      // The fast path: no hashing or decryption needed
+      const u8* payload = GetChunkPayload(chunk_index);
+      if (!payload)
+        return false;
+
+      const u64 block_in_chunk =
+          (block_disc_offset - chunk.disc_offset) / VolumeWii::BLOCK_TOTAL_SIZE;
+      std::copy_n(payload + block_in_chunk * VolumeWii::BLOCK_DATA_SIZE + offset_in_block,
+                  bytes_to_copy, out_ptr);
+    }
+    else
+    {
+      // This block couldn't be stored decrypted, so decrypt it like VolumeWii would
+      encrypted_block.resize(VolumeWii::BLOCK_TOTAL_SIZE);
+      decrypted_block.resize(VolumeWii::BLOCK_DATA_SIZE);
+      if (!Read(block_disc_offset, VolumeWii::BLOCK_TOTAL_SIZE, encrypted_block.data()))
+        return false;
+
+      VolumeWii::DecryptBlock(partition.decryption_context.get(), encrypted_block.data(), nullptr,
+                              decrypted_block.data());
+      std::copy_n(decrypted_block.data() + offset_in_block, bytes_to_copy, out_ptr);
+    }
+
+    offset += bytes_to_copy;
+    out_ptr += bytes_to_copy;
+    size -= bytes_to_copy;
+  }
+
+  return true;
+}
+
+static std::vector<DCZPartitionEntry> GetPartitionEntries(const Volume& volume, u64 data_size)
+{
+  std::vector<DCZPartitionEntry> entries;
+  if (volume.GetVolumeType() != Platform::WiiDisc || !volume.IsEncryptedAndHashed())
+    return entries;
+
+  for (const Partition& partition : volume.GetPartitions())
+  {
+    const IOS::ES::TicketReader& ticket = volume.GetTicket(partition);
+    const std::optional<u64> data_offset =
+        volume.ReadSwappedAndShifted(partition.offset + 0x2b8, PARTITION_NONE);
+    const std::optional<u64> partition_data_size =
+        volume.ReadSwappedAndShifted(partition.offset + 0x2bc, PARTITION_NONE);
+    if (!ticket.IsValid() || !data_offset || !partition_data_size)
+      continue;
+
+    entries.push_back(DCZPartitionEntry{partition.offset, partition.offset + *data_offset,
+                                        *partition_data_size, ticket.GetTitleKey()});
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const DCZPartitionEntry& a, const DCZPartitionEntry& b) {
+              return a.data_offset < b.data_offset;
+            });
+
+  // Drop partitions that overlap each other or don't fit on the disc
+  std::vector<DCZPartitionEntry> valid_entries;
+  u64 end_of_previous = 0;
+  for (const DCZPartitionEntry& entry : entries)
+  {
+    if (entry.data_offset < end_of_previous || entry.data_offset >= data_size ||
+        valid_entries.size() == UINT8_MAX)
+    {
+      continue;
+    }
+
+    valid_entries.push_back(entry);
+    valid_entries.back().data_size = std::min(entry.data_size, data_size - entry.data_offset);
+    end_of_previous = entry.data_offset + valid_entries.back().data_size;
+  }
+
+  return valid_entries;
+}
+
+static std::vector<DCZChunkEntry> PlanChunks(const std::vector<DCZPartitionEntry>& partitions,
+                                             u64 data_size, u32 chunk_size)
+{
+  std::vector<DCZChunkEntry> chunks;
+
+  const auto add_chunks = [&](u64 start, u64 end, u32 size, DCZChunkType type,
+                              u8 partition_index) {
+    while (start < end)
+    {
+      DCZChunkEntry chunk = {};
+      chunk.disc_offset = start;
+      chunk.disc_size = static_cast<u32>(std::min<u64>(size, end - start));
+      chunk.type = type;
+      chunk.partition_index = partition_index;
+
+      // Only whole blocks can be stored decrypted
+      if (type == DCZChunkType::WiiDecrypted &&
+          chunk.disc_size % VolumeWii::BLOCK_TOTAL_SIZE != 0)
+      {
+        chunk.type = DCZChunkType::Raw;
+        chunk.partition_index = 0;
+      }
+
+      chunks.push_back(chunk);
+      start += chunk.disc_size;
+    }
+  };
+
+  u64 position = 0;
+  for (size_t i = 0; i < partitions.size(); ++i)
+  {
+    const DCZPartitionEntry& partition = partitions[i];
+    add_chunks(position, partition.data_offset, chunk_size, DCZChunkType::Raw, 0);
+
+    // Partition data is split into groups, since that is the unit the hashes cover
+    const u64 end = partition.data_offset + partition.data_size;
+    add_chunks(partition.data_offset, end, VolumeWii::GROUP_TOTAL_SIZE,
+               DCZChunkType::WiiDecrypted, static_cast<u8>(i));
+    position = end;
+  }
+  add_chunks(position, data_size, chunk_size, DCZChunkType::Raw, 0);
+
+  return chunks;
+}
+
+// Decrypts a group and checks that re-hashing and re-encrypting the decrypted data
+// would give back exactly the same bytes.
+static bool DecryptAndVerifyGroup(const Common::AES::Context* aes_context, const u8* in,
+                                  u32 num_blocks, std::vector<VolumeWii::HashBlock>* hash_blocks,
+                                  std::vector<VolumeWii::HashBlock>* regenerated_hash_blocks,
+                                  u8* data_out)
+{
+  hash_blocks->resize(num_blocks);
+  regenerated_hash_blocks->resize(num_blocks);
+
+  for (u32 i = 0; i < num_blocks; ++i)
+  {
+    VolumeWii::DecryptBlock(aes_context, in + static_cast<size_t>(i) * VolumeWii::BLOCK_TOTAL_SIZE,
+                            &(*hash_blocks)[i], data_out + i * VolumeWii::BLOCK_DATA_SIZE);
+  }
+
+  VolumeWii::HashGroup(data_out, num_blocks, regenerated_hash_blocks->data());
+
+  // CBC encryption is deterministic and the IV of the data is taken from the encrypted
+  // hash block, so identical hash blocks mean that the encryption will match too.
+  return std::memcmp(hash_blocks->data(), regenerated_hash_blocks->data(),
+                     sizeof(VolumeWii::HashBlock) * num_blocks) == 0;
+}
+
+// Replaces the runs of junk in a payload with the seeds they were generated with.
+// Returns false if there was no junk to replace.
+static bool PackJunk(const u8* in, size_t size, u64 offset, std::vector<u8>* out)
+{
+  out->clear();
+
+  const auto append = [out](const void* data, size_t data_size) {
+    const u8* bytes = static_cast<const u8*>(data);
+    out->insert(out->end(), bytes, bytes + data_size);
+  };
+  const auto append_raw_run = [&](size_t start, size_t end) {
+    const u32 run_size = static_cast<u32>(end - start);
+    if (run_size == 0)
+      return;
+    append(&run_size, sizeof(run_size));
+    append(in + start, run_size);
+  };
+
+  size_t raw_start = 0;
+  size_t position = Common::AlignUp(offset, sizeof(u32)) - offset;
+  while (position < size)
+  {
+    const u64 lfg_offset = (offset + position) % JUNK_SEED_INTERVAL;
+    const size_t max_junk_size =
+        static_cast<size_t>(std::min<u64>(size - position, JUNK_SEED_INTERVAL - lfg_offset));
+
+    DCZJunkRun run;
+    const size_t junk_size = LaggedFibonacciGenerator::GetSeed(in + position, max_junk_size,
+                                                               lfg_offset, run.seed.data());
+    // GetSeed returns 0 for almost everything that isn't junk. Runs shorter than the seed
+    // could be found too (like zeroes right before the end), but aren't worth storing as junk.
+    if (junk_size < sizeof(run))
+    {
+      position += sizeof(u32);
+      continue;
+    }
+
+    append_raw_run(raw_start, position);
+    run.size = static_cast<u32>(junk_size) | DCZ_JUNK_RUN_FLAG;
+    run.lfg_offset = static_cast<u32>(lfg_offset);
+    append(&run, sizeof(run));
+
+    raw_start = position + junk_size;
+    position = Common::AlignUp(offset + raw_start, sizeof(u32)) - offset;
+  }
+
+  if (raw_start == 0)
+    return false;
+
+  append_raw_run(raw_start, size);
+  return true;
+}
+
+bool ConvertToDCZ(const std::string& infile_path, const std::string& outfile_path,
+                  DCZCompression compression, int compression_level, u32 chunk_size,
+                  CompressCB callback, void* arg)
+{
+  if (!IsDCZCompressionSupported(compression))
+  {
+    PanicAlertT("The selected compression method is not supported by this build of Dolphin.");
+    return false;
+  }
+
+  std::unique_ptr<BlobReader> reader = CreateBlobReader(infile_path);
+  if (!reader)
+  {
+    PanicAlertT("Failed to open the input file \"%s\".", infile_path.c_str());
+    return false;
+  }
+
+  if (reader->GetBlobType() == BlobType::DCZ)
+  {
+    PanicAlertT("\"%s\" is already compressed! Cannot compress it further.", infile_path.c_str());
+    return false;
+  }
+
+  File::IOFile outfile(outfile_path, "wb");
+  if (!outfile)
+  {
+    PanicAlertT("Failed to open the output file \"%s\".\n"
+                "Check that you have permissions to write the target folder and that the media can "
+                "be written.",
+                outfile_path.c_str());
+    return false;
+  }
+
+  chunk_size = std::clamp<u32>(chunk_size, VolumeWii::BLOCK_TOTAL_SIZE, MAX_CHUNK_SIZE);
+
+  const u64 data_size = reader->GetDataSize();
+
+  std::vector<DCZPartitionEntry> partitions;
+  if (std::unique_ptr<Volume> volume = CreateVolumeFromFilename(infile_path))
+    partitions = GetPartitionEntries(*volume, data_size);
+
+  std::vector<std::unique_ptr<Common::AES::Context>> aes_contexts;
+  for (const DCZPartitionEntry& partition : partitions)
+    aes_contexts.push_back(Common::AES::CreateContextDecrypt(partition.title_key.data()));
+
+  std::vector<DCZChunkEntry> chunks = PlanChunks(partitions, data_size, chunk_size);
+
+  if (callback)
+    callback(GetStringT("Files opened, ready to compress."), 0, arg);
+
+  DCZHeader header = {};
+  header.magic = DCZ_MAGIC;
+  header.version = DCZ_VERSION;
+  header.data_size = data_size;
+  header.chunk_size = chunk_size;
+  header.num_chunks = static_cast<u32>(chunks.size());
+  header.num_partitions = static_cast<u32>(partitions.size());
+  header.compression = compression;
+
+  u64 position = sizeof(DCZHeader) + sizeof(DCZPartitionEntry) * partitions.size() +
+                 sizeof(DCZChunkEntry) * chunks.size();
+
+  // seek past the header and tables (we will write them at the end)
+  outfile.Seek(position, SEEK_SET);
+
+  std::vector<u8> in_buf(std::max(chunk_size, VolumeWii::GROUP_TOTAL_SIZE));
+  std::vector<u8> decrypted_buf(VolumeWii::GROUP_DATA_SIZE);
+  std::vector<u8> packed_buf;
+  std::vector<u8> compressed_buf;
+  std::vector<u8> stored_buf;
+  std::vector<VolumeWii::HashBlock> hash_blocks;
+  std::vector<VolumeWii::HashBlock> regenerated_hash_blocks;
+
+  const size_t progress_monitor = std::max<size_t>(1, chunks.size() / 1000);
+  bool success = true;
+
+  for (size_t i = 0; i < chunks.size(); ++i)
+  {
+    DCZChunkEntry& chunk = chunks[i];
+
+    if (callback && i % progress_monitor == 0)
+    {
+      const int ratio =
+          chunk.disc_offset == 0 ? 0 : static_cast<int>(100 * position / chunk.disc_offset);
+      const std::string text =
+          StringFromFormat(GetStringT("%i of %i blocks. Compression ratio %i%%").c_str(),
+                           static_cast<int>(i), static_cast<int>(chunks.size()), ratio);
+      if (!callback(text, static_cast<float>(i) / chunks.size(), arg))
+      {
+        success = false;
+        break;
+      }
+    }
+
+    if (!reader->Read(chunk.disc_offset, chunk.disc_size, in_buf.data()))
+    {
+      PanicAlertT("Failed to read from the input file \"%s\".", infile_path.c_str());
+      success = false;
+      break;
+    }
+
+    const auto in_end = in_buf.begin() + chunk.disc_size;
+    if (std::all_of(in_buf.begin(), in_end, [&](u8 x) { return x == in_buf[0]; }))
+    {
+      chunk.type = DCZChunkType::Fill;
+      chunk.fill_byte = in_buf[0];
+      chunk.partition_index = 0;
+      chunk.file_offset = position;
+      continue;
+    }
+
+    const u8* payload = in_buf.data();
+    if (chunk.type == DCZChunkType::WiiDecrypted)
+    {
+      const u32 num_blocks = chunk.disc_size / VolumeWii::BLOCK_TOTAL_SIZE;
+      if (DecryptAndVerifyGroup(aes_contexts[chunk.partition_index].get(), in_buf.data(),
+                                num_blocks, &hash_blocks, &regenerated_hash_blocks,
+                                decrypted_buf.data()))
+      {
+        payload = decrypted_buf.data();
+      }
+      else
+      {
+        // Probably scrubbed or modified, so the hashes can't be regenerated
+        chunk.type = DCZChunkType::Raw;
+        chunk.partition_index = 0;
+      }
+    }
+
+    // Junk is looked for where it would be on the disc or in the decrypted partition
+    u64 junk_offset = chunk.disc_offset;
+    if (chunk.type == DCZChunkType::WiiDecrypted)
+    {
+      junk_offset = (chunk.disc_offset - partitions[chunk.partition_index].data_offset) /
+                    VolumeWii::BLOCK_TOTAL_SIZE * VolumeWii::BLOCK_DATA_SIZE;
+    }
+
+    const size_t payload_size = GetPayloadSize(chunk);
+    const u8* write_buf = payload;
+    size_t write_size = payload_size;
+    chunk.flags = 0;
+
+    if (PackJunk(payload, payload_size, junk_offset, &packed_buf))
+    {
+      write_buf = packed_buf.data();
+      write_size = packed_buf.size();
+      chunk.flags |= DCZ_CHUNK_PACKED;
+    }
+
+    if (compression != DCZCompression::None &&
+        CompressBuffer(compression, compression_level, write_buf, write_size, &compressed_buf) &&
+        compressed_buf.size() < write_size)
+    {
+      write_buf = compressed_buf.data();
+      write_size = compressed_buf.size();
+      chunk.flags |= DCZ_CHUNK_COMPRESSED;
+    }
+
+    if (chunk.flags & DCZ_CHUNK_PACKED)
+    {
+      // The reader needs to know how big the packed payload is before decompressing it
+      const u32 packed_size = static_cast<u32>(packed_buf.size());
+      stored_buf.resize(sizeof(packed_size) + write_size);
+      std::memcpy(stored_buf.data(), &packed_size, sizeof(packed_size));
+      std::copy_n(write_buf, write_size, stored_buf.data() + sizeof(packed_size));
+      write_buf = stored_buf.data();
+      write_size = stored_buf.size();
+    }
+
+    chunk.file_offset = position;
+    chunk.stored_size = static_cast<u32>(write_size);
+    chunk.hash = Common::HashAdler32(write_buf, write_size);
+
+    if (!outfile.WriteBytes(write_buf, write_size))
+    {
+      PanicAlertT("Failed to write the output file \"%s\".\n"
+                  "Check that you have enough space available on the target drive.",
+                  outfile_path.c_str());
+      success = false;
+      break;
+    }
+
+    position += write_size;
+  }
+
+  if (!success)
+  {
+    // Remove the incomplete output file.
+    outfile.Close();
+    File::Delete(outfile_path);
+    return false;
+  }
+
+  // Okay, go back and fill in headers
+  outfile.Seek(0, SEEK_SET);
+  outfile.WriteArray(&header, 1);
+  outfile.WriteArray(partitions.data(), partitions.size());
+  outfile.WriteArray(chunks.data(), chunks.size());
+
+  if (callback)
+    callback(GetStringT("Done compressing disc image."), 1.0f, arg);
+
+  return true;
+}
+
+}  // namespace DiscIO
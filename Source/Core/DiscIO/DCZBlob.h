@@ -0,0 +1,176 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// WARNING Code not big-endian safe.
+
+// To create new DCZ files, use ConvertToDCZ.
+
+// DCZ is a seekable compressed disc format. Unlike GCZ, it has variable-size chunks
+// that can be compressed with several algorithms, chunks that only consist of
+// a repeated byte take no space, and the groups of encrypted Wii partitions are
+// stored decrypted and without hashes when the hashes and the encryption can be
+// regenerated exactly. Reading the decrypted partition data back therefore needs
+// neither AES nor SHA-1, and decrypted data compresses much better.
+// The junk padding that discs are mastered with can't be compressed, so runs of it
+// are stored as the seeds of the LaggedFibonacciGenerator that produced them.
+
+// File format
+// * DCZHeader
+// * DCZPartitionEntry[num_partitions]
+// * DCZChunkEntry[num_chunks], sorted by disc offset, covering the whole disc
+// * [Chunk data]
+
+// The stored data of a packed chunk is the u32 size of the packed payload followed by
+// the (possibly compressed) packed payload. The packed payload is a sequence of runs
+// that each start with a u32 size. Runs with DCZ_JUNK_RUN_FLAG set in the size are
+// the rest of a DCZJunkRun, other runs are followed by that many bytes of payload.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+#include "Common/File.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/LaggedFibonacciGenerator.h"
+
+namespace DiscIO
+{
+static constexpr u32 DCZ_MAGIC = 0x015A4344;  // "DCZ\x01" (byteswapped to little endian)
+static constexpr u32 DCZ_VERSION = 1;
+
+enum class DCZCompression : u8
+{
+  None = 0,
+  Deflate = 1,
+  LZMA = 2,
+  Zstd = 3,
+};
+
+// Not every compression method is available in every build.
+bool IsDCZCompressionSupported(DCZCompression compression);
+
+enum class DCZChunkType : u8
+{
+  // The (possibly compressed) bytes of the disc.
+  Raw = 0,
+  // Every byte of the chunk is fill_byte. Nothing is stored.
+  Fill = 1,
+  // Decrypted data of Wii partition blocks without their hash blocks.
+  // The hashes and the encryption are regenerated when reading.
+  WiiDecrypted = 2,
+};
+
+enum DCZChunkFlags : u8
+{
+  DCZ_CHUNK_COMPRESSED = 1 << 0,
+  // Junk runs have been taken out of the payload. See the file format above.
+  DCZ_CHUNK_PACKED = 1 << 1,
+};
+
+static constexpr u32 DCZ_JUNK_RUN_FLAG = 0x80000000;
+
+struct DCZHeader  // 32 bytes
+{
+  u32 magic;
+  u32 version;
+  u64 data_size;
+  u32 chunk_size;
+  u32 num_chunks;
+  u32 num_partitions;
+  DCZCompression compression;
+  u8 padding[3];
+};
+static_assert(sizeof(DCZHeader) == 32, "Wrong size for DCZHeader");
+
+struct DCZPartitionEntry  // 40 bytes
+{
+  u64 partition_offset;
+  u64 data_offset;  // Absolute, not relative to partition_offset
+  u64 data_size;
+  std::array<u8, 16> title_key;
+};
+static_assert(sizeof(DCZPartitionEntry) == 40, "Wrong size for DCZPartitionEntry");
+
+struct DCZChunkEntry  // 32 bytes
+{
+  u64 disc_offset;
+  u64 file_offset;
+  u32 disc_size;
+  u32 stored_size;
+  u32 hash;  // Adler-32 of the stored bytes
+  DCZChunkType type;
+  u8 flags;  // DCZChunkFlags
+  u8 fill_byte;
+  u8 partition_index;
+};
+static_assert(sizeof(DCZChunkEntry) == 32, "Wrong size for DCZChunkEntry");
+
+struct DCZJunkRun  // 76 bytes
+{
+  u32 size;  // Has DCZ_JUNK_RUN_FLAG set
+  u32 lfg_offset;  // How far into the output of the generator the run starts
+  std::array<u32, LaggedFibonacciGenerator::SEED_SIZE> seed;
+};
+static_assert(sizeof(DCZJunkRun) == 76, "Wrong size for DCZJunkRun");
+
+class DCZFileReader final : public BlobReader
+{
+public:
+  static std::unique_ptr<DCZFileReader> Create(File::IOFile file, const std::string& filename);
+  ~DCZFileReader();
+
+  BlobType GetBlobType() const override { return BlobType::DCZ; }
+  u64 GetDataSize() const override { return m_header.data_size; }
+  u64 GetRawSize() const override { return m_file_size; }
+  bool Read(u64 offset, u64 size, u8* out_ptr) override;
+
+  bool SupportsReadWiiDecrypted() const override { return !m_partitions.empty(); }
+  bool ReadWiiDecrypted(u64 offset, u64 size, u8* out_ptr, u64 partition_offset) override;
+
+private:
+  struct PartitionInfo
+  {
+    DCZPartitionEntry entry;
+    std::unique_ptr<Common::AES::Context> encryption_context;
+    std::unique_ptr<Common::AES::Context> decryption_context;
+  };
+
+  DCZFileReader(File::IOFile file, const std::string& filename);
+
+  bool IsValid() const { return m_is_valid; }
+  // Returns the index of the chunk that contains the given disc offset, or num_chunks.
+  size_t FindChunk(u64 disc_offset) const;
+  // Returns the decompressed payload of a chunk, or nullptr if it couldn't be read.
+  const u8* GetChunkPayload(size_t chunk_index);
+  // Returns the chunk as it is laid out on the disc, or nullptr if it couldn't be read.
+  const u8* GetEncryptedChunk(size_t chunk_index);
+
+  File::IOFile m_file;
+  std::string m_file_name;
+  u64 m_file_size;
+  bool m_is_valid = false;
+
+  DCZHeader m_header = {};
+  std::vector<PartitionInfo> m_partitions;
+  std::vector<DCZChunkEntry> m_chunks;
+
+  std::vector<u8> m_stored_buffer;
+  std::vector<u8> m_packed_buffer;
+  std::vector<u8> m_payload_buffer;
+  size_t m_payload_chunk = SIZE_MAX;
+  std::vector<u8> m_encrypted_buffer;
+  size_t m_encrypted_chunk = SIZE_MAX;
+};
+
+bool ConvertToDCZ(const std::string& infile_path, const std::string& outfile_path,
+                  DCZCompression compression, int compression_level, u32 chunk_size = 0x200000,
+                  CompressCB callback = nullptr, void* arg = nullptr);
+
+}  // namespace DiscIO
@@ -101,6 +101,8 @@ DriveReader::DriveReader(const std::string& drive)
 
 DriveReader::~DriveReader()
 {
+  StopPrefetching();
+
 #ifdef _WIN32
 #ifdef _LOCKDRIVE  // Do we want to lock the drive?
   // Unlock the disc in the CD-ROM drive.
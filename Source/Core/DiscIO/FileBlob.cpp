@@ -2,6 +2,8 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
@@ -13,6 +15,9 @@ namespace DiscIO
 PlainFileReader::PlainFileReader(File::IOFile file) : m_file(std::move(file))
 {
   m_size = m_file.GetSize();
+
+  if (IsMemoryMappingEnabled())
+    m_mapping.Map(m_file);
 }
 
 std::unique_ptr<PlainFileReader> PlainFileReader::Create(File::IOFile file)
@@ -25,6 +30,21 @@ std::unique_ptr<PlainFileReader> PlainFileReader::Create(File::IOFile file)
 
 bool PlainFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 {
+  if (m_mapping.IsMapped())
+  {
+    if (offset > m_mapping.GetSize() || nbytes > m_mapping.GetSize() - offset)
+      return false;
+
+    // Page faults only make the OS read in a little around the faulting page,
+    // so ask for the data that sequential reads will need next ahead of time
+    if (offset == m_next_sequential_offset)
+      m_mapping.Advise(offset + nbytes, READAHEAD_SIZE, File::MappedFile::AccessPattern::WillNeed);
+    m_next_sequential_offset = offset + nbytes;
+
+    std::memcpy(out_ptr, m_mapping.GetData() + offset, static_cast<size_t>(nbytes));
+    return true;
+  }
+
   if (m_file.Seek(offset, SEEK_SET) && m_file.ReadBytes(out_ptr, nbytes))
   {
     return true;
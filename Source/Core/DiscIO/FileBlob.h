@@ -10,6 +10,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/File.h"
+#include "Common/MappedFile.h"
 #include "DiscIO/Blob.h"
 
 namespace DiscIO
@@ -24,11 +25,18 @@ public:
   u64 GetRawSize() const override { return m_size; }
   bool Read(u64 offset, u64 nbytes, u8* out_ptr) override;
 
+  bool IsMemoryMapped() const { return m_mapping.IsMapped(); }
+
 private:
   PlainFileReader(File::IOFile file);
 
+  // How far ahead of sequential reads the OS is asked to read into the page cache
+  static constexpr u64 READAHEAD_SIZE = 2 * 1024 * 1024;
+
   File::IOFile m_file;
+  File::MappedFile m_mapping;
   s64 m_size;
+  u64 m_next_sequential_offset = 0;
 };
 
 }  // namespace
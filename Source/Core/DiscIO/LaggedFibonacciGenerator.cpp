@@ -0,0 +1,193 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "DiscIO/LaggedFibonacciGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+#include "Common/CommonTypes.h"
+#include "Common/Swap.h"
+
+namespace DiscIO
+{
+void LaggedFibonacciGenerator::SetSeed(const u32 seed[SEED_SIZE])
+{
+  m_position_bytes = 0;
+  for (size_t i = 0; i < SEED_SIZE; ++i)
+    m_buffer[i] = Common::swap32(seed[i]);
+
+  Initialize(false);
+}
+
+bool LaggedFibonacciGenerator::Initialize(bool check_existing_data)
+{
+  for (size_t i = SEED_SIZE; i < LFG_K; ++i)
+  {
+    const u32 calculated = (m_buffer[i - 17] << 23) ^ (m_buffer[i - 16] >> 9) ^ m_buffer[i - 1];
+
+    if (check_existing_data)
+    {
+      // Bits 16 and 17 never make it to the output (see below), so they can't be compared
+      const u32 actual = (m_buffer[i] & 0xFF00FFFF) | (m_buffer[i] << 2 & 0x00FC0000);
+      if ((calculated & 0xFFFCFFFF) != actual)
+        return false;
+    }
+
+    m_buffer[i] = calculated;
+  }
+
+  // The second byte of every word is output shifted right by 18 instead of 16. Doing the shift
+  // and the byteswap here once means that the output is simply the contents of m_buffer.
+  // Both are linear, so Forward gives the same results before or after them.
+  for (u32& x : m_buffer)
+    x = Common::swap32((x & 0xFF00FFFF) | ((x >> 2) & 0x00FF0000));
+
+  for (size_t i = 0; i < 4; ++i)
+    Forward();
+
+  return true;
+}
+
+bool LaggedFibonacciGenerator::Reinitialize(u32 seed_out[SEED_SIZE])
+{
+  for (size_t i = 0; i < 4; ++i)
+    Backward();
+
+  for (u32& x : m_buffer)
+    x = Common::swap32(x);
+
+  // Recover the bits that the output shift dropped. Bits 16 and 17 of the first word can't be
+  // recovered, but they don't affect the output either.
+  for (size_t i = 0; i < SEED_SIZE; ++i)
+  {
+    m_buffer[i] = (m_buffer[i] & 0xFF00FFFF) | (m_buffer[i] << 2 & 0x00FC0000) |
+                  ((m_buffer[i + 16] ^ m_buffer[i + 15]) << 9 & 0x00030000);
+  }
+
+  for (size_t i = 0; i < SEED_SIZE; ++i)
+    seed_out[i] = Common::swap32(m_buffer[i]);
+
+  return Initialize(true);
+}
+
+void LaggedFibonacciGenerator::Forward()
+{
+  for (size_t i = 0; i < LFG_J; ++i)
+    m_buffer[i] ^= m_buffer[i + LFG_K - LFG_J];
+  for (size_t i = LFG_J; i < LFG_K; ++i)
+    m_buffer[i] ^= m_buffer[i - LFG_J];
+}
+
+void LaggedFibonacciGenerator::Backward(size_t start_word, size_t end_word)
+{
+  const size_t loop_end = std::max(LFG_J, start_word);
+  for (size_t i = std::min(end_word, LFG_K); i > loop_end; --i)
+    m_buffer[i - 1] ^= m_buffer[i - 1 - LFG_J];
+  for (size_t i = std::min(end_word, LFG_J); i > start_word; --i)
+    m_buffer[i - 1] ^= m_buffer[i - 1 + LFG_K - LFG_J];
+}
+
+void LaggedFibonacciGenerator::Forward(size_t count)
+{
+  m_position_bytes += count;
+  while (m_position_bytes >= LFG_K * sizeof(u32))
+  {
+    Forward();
+    m_position_bytes -= LFG_K * sizeof(u32);
+  }
+}
+
+void LaggedFibonacciGenerator::GetBytes(size_t count, u8* out)
+{
+  while (count > 0)
+  {
+    const size_t length = std::min(count, LFG_K * sizeof(u32) - m_position_bytes);
+    std::memcpy(out, reinterpret_cast<const u8*>(m_buffer.data()) + m_position_bytes, length);
+    m_position_bytes += length;
+    count -= length;
+    out += length;
+
+    if (m_position_bytes == LFG_K * sizeof(u32))
+    {
+      Forward();
+      m_position_bytes = 0;
+    }
+  }
+}
+
+u8 LaggedFibonacciGenerator::GetByte()
+{
+  const u8 result = reinterpret_cast<const u8*>(m_buffer.data())[m_position_bytes];
+
+  if (++m_position_bytes == LFG_K * sizeof(u32))
+  {
+    Forward();
+    m_position_bytes = 0;
+  }
+
+  return result;
+}
+
+size_t LaggedFibonacciGenerator::GetSeed(const u8* data, size_t size, size_t data_offset,
+                                         u32 seed_out[SEED_SIZE])
+{
+  if (data_offset % sizeof(u32) != 0 || size < (LFG_K + LFG_J) * sizeof(u32))
+    return 0;
+
+  const auto read_word = [data](size_t i) {
+    u32 word;
+    std::memcpy(&word, data + i * sizeof(u32), sizeof(word));
+    return word;
+  };
+
+  // Every output word is the XOR of the words LFG_K and LFG_J before it, and the two copies of
+  // bits 24 and 25 must match. This rejects almost all other data without rewinding anything,
+  // which matters because callers search for junk by trying every offset.
+  for (size_t i = LFG_K; i < LFG_K + LFG_J; ++i)
+  {
+    if (read_word(i) != (read_word(i - LFG_K) ^ read_word(i - LFG_J)))
+      return 0;
+  }
+
+  std::array<u32, LFG_K> words;
+  std::memcpy(words.data(), data, sizeof(words));
+  for (u32 word : words)
+  {
+    const u32 x = Common::swap32(word);
+    if ((x & 0x00C00000) != (x >> 2 & 0x00C00000))
+      return 0;
+  }
+
+  // Put the words where they would be in m_buffer, then rewind to the first round
+  const size_t word_offset = data_offset / sizeof(u32);
+  const size_t offset_mod_k = word_offset % LFG_K;
+  const size_t offset_div_k = word_offset / LFG_K;
+
+  LaggedFibonacciGenerator lfg;
+  std::copy(words.begin(), words.begin() + (LFG_K - offset_mod_k),
+            lfg.m_buffer.begin() + offset_mod_k);
+  std::copy(words.begin() + (LFG_K - offset_mod_k), words.end(), lfg.m_buffer.begin());
+
+  lfg.Backward(0, offset_mod_k);
+  for (size_t i = 0; i < offset_div_k; ++i)
+    lfg.Backward();
+
+  if (!lfg.Reinitialize(seed_out))
+    return 0;
+
+  for (size_t i = 0; i < offset_div_k; ++i)
+    lfg.Forward();
+  lfg.m_position_bytes = offset_mod_k * sizeof(u32);
+
+  size_t reproduced_bytes = 0;
+  while (reproduced_bytes < size && lfg.GetByte() == data[reproduced_bytes])
+    ++reproduced_bytes;
+
+  return reproduced_bytes;
+}
+
+}  // namespace DiscIO
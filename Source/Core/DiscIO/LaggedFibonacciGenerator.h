@@ -0,0 +1,52 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+namespace DiscIO
+{
+// The generator that the padding ("junk") between the files of GameCube and Wii discs
+// was made with. It is reseeded for every 0x8000 bytes of padding.
+class LaggedFibonacciGenerator
+{
+public:
+  static constexpr size_t SEED_SIZE = 17;
+
+  // Reconstructs the seed that data was generated with, assuming that data starts data_offset
+  // bytes into the output of the generator, and returns how many bytes of data the seed
+  // reproduces. Returns 0 if data doesn't start with enough generated bytes to tell.
+  // data_offset must be a multiple of 4. The seed words are stored big endian.
+  static size_t GetSeed(const u8* data, size_t size, size_t data_offset,
+                        u32 seed_out[SEED_SIZE]);
+
+  // SetSeed must be called before using the functions below.
+  void SetSeed(const u32 seed[SEED_SIZE]);
+
+  // Outputs count bytes and advances the output by the same amount.
+  void GetBytes(size_t count, u8* out);
+  // Advances the output like GetBytes without outputting anything.
+  void Forward(size_t count);
+
+private:
+  static constexpr size_t LFG_K = 521;
+  static constexpr size_t LFG_J = 32;
+
+  u8 GetByte();
+  void Forward();
+  // Undoes Forward for the words in [start_word, end_word).
+  void Backward(size_t start_word = 0, size_t end_word = LFG_K);
+  bool Initialize(bool check_existing_data);
+  bool Reinitialize(u32 seed_out[SEED_SIZE]);
+
+  // Holds the output bytes of the current round, which is why the words are big endian.
+  std::array<u32, LFG_K> m_buffer;
+  size_t m_position_bytes = 0;
+};
+
+}  // namespace DiscIO
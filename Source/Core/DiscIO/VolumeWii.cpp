@@ -9,7 +9,6 @@
 #include <cstddef>
 #include <cstring>
 #include <map>
-#include <mbedtls/aes.h>
 #include <mbedtls/sha1.h>
 #include <memory>
 #include <optional>
@@ -18,10 +17,13 @@
 #include <vector>
 
 #include "Common/Assert.h"
+#include "Common/CPUDetect.h"
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
 #include "Common/Logging/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/Swap.h"
+#include "Common/ThreadPool.h"
 
 #include "DiscIO/Blob.h"
 #include "DiscIO/DiscExtractor.h"
@@ -33,9 +35,16 @@
 
 namespace DiscIO
 {
+// Shared by all volumes, since many of them can be open at once (e.g. in the game list)
+static Common::ThreadPool& GetDecryptionThreadPool()
+{
+  static Common::ThreadPool s_thread_pool(
+      static_cast<size_t>(std::clamp(cpu_info.num_cores - 1, 0, 3)), "Wii Decryption");
+  return s_thread_pool;
+}
+
 VolumeWii::VolumeWii(std::unique_ptr<BlobReader> reader)
-    : m_reader(std::move(reader)), m_game_partition(PARTITION_NONE),
-      m_last_decrypted_block(UINT64_MAX)
+    : m_reader(std::move(reader)), m_game_partition(PARTITION_NONE)
 {
   ASSERT(m_reader);
 
@@ -97,14 +106,12 @@ VolumeWii::VolumeWii(std::unique_ptr<BlobReader> reader)
         return IOS::ES::TMDReader{std::move(tmd_buffer)};
       };
 
-      auto get_key = [this, partition]() -> std::unique_ptr<mbedtls_aes_context> {
+      auto get_key = [this, partition]() -> std::unique_ptr<Common::AES::Context> {
         const IOS::ES::TicketReader& ticket = *m_partitions[partition].ticket;
         if (!ticket.IsValid())
           return nullptr;
         const std::array<u8, 16> key = ticket.GetTitleKey();
-        std::unique_ptr<mbedtls_aes_context> aes_context = std::make_unique<mbedtls_aes_context>();
-        mbedtls_aes_setkey_dec(aes_context.get(), key.data(), 128);
-        return aes_context;
+        return Common::AES::CreateContextDecrypt(key.data());
       };
 
       auto get_file_system = [this, partition]() -> std::unique_ptr<FileSystem> {
@@ -117,7 +124,7 @@ VolumeWii::VolumeWii(std::unique_ptr<BlobReader> reader)
       };
 
       m_partitions.emplace(
-          partition, PartitionDetails{Common::Lazy<std::unique_ptr<mbedtls_aes_context>>(get_key),
+          partition, PartitionDetails{Common::Lazy<std::unique_ptr<Common::AES::Context>>(get_key),
                                       Common::Lazy<IOS::ES::TicketReader>(get_ticket),
                                       Common::Lazy<IOS::ES::TMDReader>(get_tmd),
                                       Common::Lazy<std::unique_ptr<FileSystem>>(get_file_system),
@@ -149,42 +156,57 @@ bool VolumeWii::Read(u64 offset, u64 length, u8* buffer, const Partition& partit
   if (m_reader->SupportsReadWiiDecrypted())
     return m_reader->ReadWiiDecrypted(offset, length, buffer, partition.offset);
 
-  mbedtls_aes_context* aes_context = partition_details.key->get();
+  const Common::AES::Context* aes_context = partition_details.key->get();
   if (!aes_context)
     return false;
 
-  std::vector<u8> read_buffer(BLOCK_TOTAL_SIZE);
+  const u64 partition_data_offset = partition.offset + *partition_details.data_offset;
   while (length > 0)
   {
     // Calculate offsets
-    u64 block_offset_on_disc = partition.offset + *partition_details.data_offset +
-                               offset / BLOCK_DATA_SIZE * BLOCK_TOTAL_SIZE;
-    u64 data_offset_in_block = offset % BLOCK_DATA_SIZE;
+    const u64 block_index = offset / BLOCK_DATA_SIZE;
+    const u64 data_offset_in_block = offset % BLOCK_DATA_SIZE;
 
-    if (m_last_decrypted_block != block_offset_on_disc)
+    u64 copy_size;
+    if (const u8* cached_data = FindCachedBlock(partition.offset, block_index))
+    {
+      copy_size = std::min(length, BLOCK_DATA_SIZE - data_offset_in_block);
+      std::memcpy(buffer, cached_data + data_offset_in_block, static_cast<size_t>(copy_size));
+    }
+    else
     {
-      // Read the current block
-      if (!m_reader->Read(block_offset_on_disc, BLOCK_TOTAL_SIZE, read_buffer.data()))
+      // Decrypt all the blocks of this read up to the next cached one in one go,
+      // so that the reader sees one large read and the blocks can be decrypted in parallel
+      const u64 last_block_index = (offset + length - 1) / BLOCK_DATA_SIZE;
+      u32 num_blocks = 1;
+      while (num_blocks < MAX_BLOCKS_PER_BATCH && block_index + num_blocks <= last_block_index &&
+             !FindCachedBlock(partition.offset, block_index + num_blocks))
+      {
+        ++num_blocks;
+      }
+
+      if (!ReadAndDecryptBlocks(aes_context,
+                                partition_data_offset + block_index * BLOCK_TOTAL_SIZE,
+                                num_blocks))
+      {
         return false;
+      }
 
-      // Decrypt the block's data.
-      // 0x3D0 - 0x3DF in read_buffer will be overwritten,
-      // but that won't affect anything, because we won't
-      // use the content of read_buffer anymore after this
-      mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, BLOCK_DATA_SIZE, &read_buffer[0x3D0],
-                            &read_buffer[BLOCK_HEADER_SIZE], m_last_decrypted_block_data);
-      m_last_decrypted_block = block_offset_on_disc;
-
-      // The only thing we currently use from the 0x000 - 0x3FF part
-      // of the block is the IV (at 0x3D0), but it also contains SHA-1
-      // hashes that IOS uses to check that discs aren't tampered with.
-      // http://wiibrew.org/wiki/Wii_Disc#Encrypted
-    }
+      copy_size = std::min<u64>(length, num_blocks * BLOCK_DATA_SIZE - data_offset_in_block);
+      std::memcpy(buffer, &m_decrypted_buffer[data_offset_in_block],
+                  static_cast<size_t>(copy_size));
 
-    // Copy the decrypted data
-    u64 copy_size = std::min(length, BLOCK_DATA_SIZE - data_offset_in_block);
-    memcpy(buffer, &m_last_decrypted_block_data[data_offset_in_block],
-           static_cast<size_t>(copy_size));
+      // Blocks that are only partially read are likely to be needed again by the next read.
+      // Fully read blocks are not cached so that long sequential reads don't evict everything.
+      if (data_offset_in_block != 0 || copy_size < BLOCK_DATA_SIZE)
+        CacheBlock(partition.offset, block_index, m_decrypted_buffer.data());
+      const u64 end_offset_in_batch = data_offset_in_block + copy_size;
+      if (num_blocks > 1 && end_offset_in_batch % BLOCK_DATA_SIZE != 0)
+      {
+        CacheBlock(partition.offset, block_index + num_blocks - 1,
+                   &m_decrypted_buffer[static_cast<size_t>(num_blocks - 1) * BLOCK_DATA_SIZE]);
+      }
+    }
 
     // Update offsets
     length -= copy_size;
@@ -195,6 +217,70 @@ bool VolumeWii::Read(u64 offset, u64 length, u8* buffer, const Partition& partit
   return true;
 }
 
+bool VolumeWii::ReadAndDecryptBlocks(const Common::AES::Context* aes_context, u64 offset_on_disc,
+                                     u32 num_blocks) const
+{
+  m_read_buffer.resize(static_cast<size_t>(num_blocks) * BLOCK_TOTAL_SIZE);
+  m_decrypted_buffer.resize(static_cast<size_t>(num_blocks) * BLOCK_DATA_SIZE);
+
+  if (!m_reader->Read(offset_on_disc, m_read_buffer.size(), m_read_buffer.data()))
+    return false;
+
+  // The only thing we currently use from the 0x000 - 0x3FF part
+  // of each block is the IV (at 0x3D0), but it also contains SHA-1
+  // hashes that IOS uses to check that discs aren't tampered with.
+  // http://wiibrew.org/wiki/Wii_Disc#Encrypted
+  const auto decrypt = [&](size_t i) {
+    DecryptBlock(aes_context, &m_read_buffer[i * BLOCK_TOTAL_SIZE], nullptr,
+                 &m_decrypted_buffer[i * BLOCK_DATA_SIZE]);
+  };
+
+  if (num_blocks < MIN_BLOCKS_FOR_THREADS)
+  {
+    for (u32 i = 0; i < num_blocks; ++i)
+      decrypt(i);
+  }
+  else
+  {
+    GetDecryptionThreadPool().ParallelFor(num_blocks, decrypt);
+  }
+
+  return true;
+}
+
+const u8* VolumeWii::FindCachedBlock(u64 partition_offset, u64 block_index) const
+{
+  for (CachedBlock& block : m_block_cache)
+  {
+    if (block.block_index == block_index && block.partition_offset == partition_offset)
+    {
+      block.last_used = ++m_block_cache_tick;
+      return block.data.data();
+    }
+  }
+  return nullptr;
+}
+
+void VolumeWii::CacheBlock(u64 partition_offset, u64 block_index, const u8* data) const
+{
+  CachedBlock* block;
+  if (m_block_cache.size() < BLOCK_CACHE_SIZE)
+  {
+    block = &m_block_cache.emplace_back();
+  }
+  else
+  {
+    block = &*std::min_element(
+        m_block_cache.begin(), m_block_cache.end(),
+        [](const CachedBlock& a, const CachedBlock& b) { return a.last_used < b.last_used; });
+  }
+
+  block->partition_offset = partition_offset;
+  block->block_index = block_index;
+  block->last_used = ++m_block_cache_tick;
+  std::memcpy(block->data.data(), data, BLOCK_DATA_SIZE);
+}
+
 bool VolumeWii::IsEncryptedAndHashed() const
 {
   return m_encrypted;
@@ -255,6 +341,76 @@ u64 VolumeWii::EncryptedPartitionOffsetToRawOffset(u64 offset, const Partition&
          (offset % BLOCK_DATA_SIZE);
 }
 
+void VolumeWii::HashGroup(const u8* data, u32 num_blocks, HashBlock* out)
+{
+  num_blocks = std::min(num_blocks, BLOCKS_PER_GROUP);
+  std::memset(out, 0, sizeof(HashBlock) * num_blocks);
+
+  // H0: one hash per 0x400 bytes of data
+  for (u32 i = 0; i < num_blocks; ++i)
+  {
+    const u8* block_data = data + static_cast<size_t>(i) * BLOCK_DATA_SIZE;
+    for (u32 j = 0; j < 31; ++j)
+      mbedtls_sha1(block_data + j * 0x400, 0x400, out[i].h0[j]);
+  }
+
+  // H1: one hash of the H0 table of each block in the subgroup
+  const u32 num_subgroups = (num_blocks + BLOCKS_PER_SUBGROUP - 1) / BLOCKS_PER_SUBGROUP;
+  for (u32 subgroup = 0; subgroup < num_subgroups; ++subgroup)
+  {
+    const u32 first = subgroup * BLOCKS_PER_SUBGROUP;
+    const u32 last = std::min(first + BLOCKS_PER_SUBGROUP, num_blocks);
+
+    u8 h1[8][20] = {};
+    for (u32 i = first; i < last; ++i)
+      mbedtls_sha1(out[i].h0[0], sizeof(out[i].h0), h1[i - first]);
+
+    for (u32 i = first; i < last; ++i)
+      std::memcpy(out[i].h1, h1, sizeof(h1));
+  }
+
+  // H2: one hash of the H1 table of each subgroup in the group
+  u8 h2[8][20] = {};
+  for (u32 subgroup = 0; subgroup < num_subgroups; ++subgroup)
+  {
+    const HashBlock& first_in_subgroup = out[subgroup * BLOCKS_PER_SUBGROUP];
+    mbedtls_sha1(first_in_subgroup.h1[0], sizeof(first_in_subgroup.h1), h2[subgroup]);
+  }
+
+  for (u32 i = 0; i < num_blocks; ++i)
+    std::memcpy(out[i].h2, h2, sizeof(h2));
+}
+
+void VolumeWii::DecryptBlock(const Common::AES::Context* aes_context, const u8* in,
+                             HashBlock* hash_out, u8* data_out)
+{
+  if (hash_out)
+  {
+    const u8 iv[16] = {};
+    aes_context->CryptCBC(iv, in, reinterpret_cast<u8*>(hash_out), BLOCK_HEADER_SIZE);
+  }
+
+  // The data is encrypted using the last 16 bytes of the encrypted H2 table as the IV
+  if (data_out)
+    aes_context->CryptCBC(&in[0x3D0], &in[BLOCK_HEADER_SIZE], data_out, BLOCK_DATA_SIZE);
+}
+
+void VolumeWii::EncryptGroup(const Common::AES::Context* aes_context,
+                             const HashBlock* hash_blocks, const u8* data, u32 num_blocks, u8* out)
+{
+  for (u32 i = 0; i < num_blocks; ++i)
+  {
+    u8* block_out = out + static_cast<size_t>(i) * BLOCK_TOTAL_SIZE;
+
+    const u8 iv[16] = {};
+    aes_context->CryptCBC(iv, reinterpret_cast<const u8*>(&hash_blocks[i]), block_out,
+                          BLOCK_HEADER_SIZE);
+
+    aes_context->CryptCBC(&block_out[0x3D0], data + static_cast<size_t>(i) * BLOCK_DATA_SIZE,
+                          &block_out[BLOCK_HEADER_SIZE], BLOCK_DATA_SIZE);
+  }
+}
+
 u64 VolumeWii::PartitionOffsetToRawOffset(u64 offset, const Partition& partition) const
 {
   auto it = m_partitions.find(partition);
@@ -389,7 +545,7 @@ bool VolumeWii::CheckIntegrity(const Partition& partition) const
   if (it == m_partitions.end())
     return false;
   const PartitionDetails& partition_details = it->second;
-  mbedtls_aes_context* aes_context = partition_details.key->get();
+  const Common::AES::Context* aes_context = partition_details.key->get();
   if (!aes_context)
     return false;
 
@@ -407,14 +563,14 @@ bool VolumeWii::CheckIntegrity(const Partition& partition) const
     // Read and decrypt the cluster metadata
     u8 cluster_metadata_crypted[0x400];
     u8 cluster_metadata[0x400];
-    u8 iv[16] = {0};
+    const u8 iv[16] = {0};
     if (!m_reader->Read(cluster_offset, sizeof(cluster_metadata_crypted), cluster_metadata_crypted))
     {
       WARN_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read metadata", cluster_id);
       return false;
     }
-    mbedtls_aes_crypt_cbc(aes_context, MBEDTLS_AES_DECRYPT, sizeof(cluster_metadata), iv,
-                          cluster_metadata_crypted, cluster_metadata);
+    aes_context->CryptCBC(iv, cluster_metadata_crypted, cluster_metadata,
+                          sizeof(cluster_metadata));
 
     // Some clusters have invalid data and metadata because they aren't
     // meant to be read by the game (for example, holes between files). To
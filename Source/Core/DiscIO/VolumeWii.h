@@ -4,14 +4,15 @@
 
 #pragma once
 
+#include <array>
 #include <map>
-#include <mbedtls/aes.h>
 #include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
 #include "Common/Lazy.h"
 #include "Core/IOS/ES/Formats.h"
 #include "DiscIO/Filesystem.h"
@@ -67,13 +68,43 @@ public:
   static constexpr unsigned int BLOCK_DATA_SIZE = 0x7C00;
   static constexpr unsigned int BLOCK_TOTAL_SIZE = BLOCK_HEADER_SIZE + BLOCK_DATA_SIZE;
 
+  static constexpr unsigned int BLOCKS_PER_SUBGROUP = 8;
+  static constexpr unsigned int BLOCKS_PER_GROUP = 64;
+  static constexpr unsigned int GROUP_TOTAL_SIZE = BLOCK_TOTAL_SIZE * BLOCKS_PER_GROUP;
+  static constexpr unsigned int GROUP_DATA_SIZE = BLOCK_DATA_SIZE * BLOCKS_PER_GROUP;
+
+  // The decrypted contents of the first BLOCK_HEADER_SIZE bytes of a block.
+  // http://wiibrew.org/wiki/Wii_Disc#Encrypted
+  struct HashBlock
+  {
+    u8 h0[31][20];
+    u8 padding_0[20];
+    u8 h1[8][20];
+    u8 padding_1[32];
+    u8 h2[8][20];
+    u8 padding_2[32];
+  };
+
+  // Generates the H0, H1 and H2 hashes for num_blocks (at most BLOCKS_PER_GROUP) blocks
+  // of decrypted data that make up the start of a group. The padding is zeroed.
+  static void HashGroup(const u8* data, u32 num_blocks, HashBlock* out);
+
+  // Decrypts one BLOCK_TOTAL_SIZE block. Either output pointer may be nullptr.
+  static void DecryptBlock(const Common::AES::Context* aes_context, const u8* in,
+                           HashBlock* hash_out, u8* data_out);
+
+  // Encrypts num_blocks blocks into the layout they have on a disc.
+  // The AES context must have been set up with an encryption key.
+  static void EncryptGroup(const Common::AES::Context* aes_context, const HashBlock* hash_blocks,
+                           const u8* data, u32 num_blocks, u8* out);
+
 protected:
   u32 GetOffsetShift() const override { return 2; }
 
 private:
   struct PartitionDetails
   {
-    Common::Lazy<std::unique_ptr<mbedtls_aes_context>> key;
+    Common::Lazy<std::unique_ptr<Common::AES::Context>> key;
     Common::Lazy<IOS::ES::TicketReader> ticket;
     Common::Lazy<IOS::ES::TMDReader> tmd;
     Common::Lazy<std::unique_ptr<FileSystem>> file_system;
@@ -81,13 +112,39 @@ private:
     u32 type;
   };
 
+  struct CachedBlock
+  {
+    u64 partition_offset;
+    u64 block_index;
+    u64 last_used;
+    std::array<u8, BLOCK_DATA_SIZE> data;
+  };
+
+  // Up to this many consecutive blocks are read and decrypted together
+  static constexpr u32 MAX_BLOCKS_PER_BATCH = 64;
+  // Batches smaller than this aren't worth waking up the decryption threads for
+  static constexpr u32 MIN_BLOCKS_FOR_THREADS = 4;
+  static constexpr size_t BLOCK_CACHE_SIZE = 16;
+
+  // Reads num_blocks blocks starting at the given raw offset and decrypts their data
+  // into m_decrypted_buffer.
+  bool ReadAndDecryptBlocks(const Common::AES::Context* aes_context, u64 offset_on_disc,
+                            u32 num_blocks) const;
+  const u8* FindCachedBlock(u64 partition_offset, u64 block_index) const;
+  void CacheBlock(u64 partition_offset, u64 block_index, const u8* data) const;
+
   std::unique_ptr<BlobReader> m_reader;
   std::map<Partition, PartitionDetails> m_partitions;
   Partition m_game_partition;
   bool m_encrypted;
 
-  mutable u64 m_last_decrypted_block;
-  mutable u8 m_last_decrypted_block_data[BLOCK_DATA_SIZE];
+  mutable std::vector<CachedBlock> m_block_cache;
+  mutable u64 m_block_cache_tick = 0;
+  mutable std::vector<u8> m_read_buffer;
+  mutable std::vector<u8> m_decrypted_buffer;
 };
 
+static_assert(sizeof(VolumeWii::HashBlock) == VolumeWii::BLOCK_HEADER_SIZE,
+              "HashBlock must be as large as a block header");
+
 }  // namespace
@@ -42,6 +42,12 @@ WbfsFileReader::WbfsFileReader(File::IOFile file, const std::string& path)
   m_files[0].file.ReadBytes(m_wlba_table.data(), m_blocks_per_disc * sizeof(u16));
   for (size_t i = 0; i < m_blocks_per_disc; i++)
     m_wlba_table[i] = Common::swap16(m_wlba_table[i]);
+
+  if (IsMemoryMappingEnabled())
+  {
+    for (FileEntry& file_entry : m_files)
+      file_entry.mapping.Map(file_entry.file);
+  }
 }
 
 WbfsFileReader::~WbfsFileReader()
@@ -117,27 +123,44 @@ bool WbfsFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 {
   while (nbytes)
   {
-    u64 read_size;
-    File::IOFile& data_file = SeekToCluster(offset, &read_size);
-    if (read_size == 0)
+    u64 offset_in_file;
+    u64 available;
+    FileEntry* file_entry = FindCluster(offset, &offset_in_file, &available);
+    if (!file_entry)
       return false;
-    read_size = std::min(read_size, nbytes);
+    const u64 read_size = std::min(available, nbytes);
 
-    if (!data_file.ReadBytes(out_ptr, read_size))
+    if (file_entry->mapping.IsMapped())
     {
-      data_file.Clear();
+      // Prefetch the rest of the cluster when the disc is being read sequentially.
+      // The next cluster can be anywhere in the files, so there's no point going further.
+      if (offset == m_next_sequential_offset && available > read_size)
+      {
+        file_entry->mapping.Advise(offset_in_file + read_size, available - read_size,
+                                   File::MappedFile::AccessPattern::WillNeed);
+      }
+
+      std::memcpy(out_ptr, file_entry->mapping.GetData() + offset_in_file,
+                  static_cast<size_t>(read_size));
+    }
+    else if (!file_entry->file.Seek(offset_in_file, SEEK_SET) ||
+             !file_entry->file.ReadBytes(out_ptr, read_size))
+    {
+      file_entry->file.Clear();
       return false;
     }
 
     out_ptr += read_size;
     nbytes -= read_size;
     offset += read_size;
+    m_next_sequential_offset = offset;
   }
 
   return true;
 }
 
-File::IOFile& WbfsFileReader::SeekToCluster(u64 offset, u64* available)
+WbfsFileReader::FileEntry* WbfsFileReader::FindCluster(u64 offset, u64* offset_in_file,
+                                                       u64* available)
 {
   u64 base_cluster = (offset >> m_header.wbfs_sector_shift);
   if (base_cluster < m_blocks_per_disc)
@@ -150,24 +173,20 @@ File::IOFile& WbfsFileReader::SeekToCluster(u64 offset, u64* available)
     {
       if (final_address < (file_entry.base_address + file_entry.size))
       {
-        file_entry.file.Seek(final_address - file_entry.base_address, SEEK_SET);
-        if (available)
-        {
-          u64 till_end_of_file = file_entry.size - (final_address - file_entry.base_address);
-          u64 till_end_of_sector = m_wbfs_sector_size - cluster_offset;
-          *available = std::min(till_end_of_file, till_end_of_sector);
-        }
-
-        return file_entry.file;
+        *offset_in_file = final_address - file_entry.base_address;
+        u64 till_end_of_file = file_entry.size - *offset_in_file;
+        u64 till_end_of_sector = m_wbfs_sector_size - cluster_offset;
+        *available = std::min(till_end_of_file, till_end_of_sector);
+
+        return &file_entry;
       }
     }
   }
 
   PanicAlert("Read beyond end of disc");
-  if (available)
-    *available = 0;
-  m_files[0].file.Seek(0, SEEK_SET);
-  return m_files[0].file;
+  *offset_in_file = 0;
+  *available = 0;
+  return nullptr;
 }
 
 std::unique_ptr<WbfsFileReader> WbfsFileReader::Create(File::IOFile file, const std::string& path)
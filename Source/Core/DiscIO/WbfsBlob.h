@@ -10,6 +10,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/File.h"
+#include "Common/MappedFile.h"
 #include "DiscIO/Blob.h"
 
 namespace DiscIO
@@ -39,7 +40,6 @@ private:
   bool AddFileToList(File::IOFile file);
   bool ReadHeader();
 
-  File::IOFile& SeekToCluster(u64 offset, u64* available);
   bool IsGood() { return m_good; }
   struct FileEntry
   {
@@ -49,10 +49,18 @@ private:
     }
 
     File::IOFile file;
+    // Each file of a split WBFS image is mapped on its own
+    File::MappedFile mapping;
     u64 base_address;
     u64 size;
   };
 
+  // Returns the file that contains the given disc offset and the position in that file,
+  // or nullptr if the offset is beyond the end of the disc.
+  // available is set to the number of bytes that can be read there before reaching
+  // the end of the cluster or of the file.
+  FileEntry* FindCluster(u64 offset, u64* offset_in_file, u64* available);
+
   std::vector<FileEntry> m_files;
 
   u64 m_size;
@@ -77,6 +85,8 @@ private:
   std::vector<u16> m_wlba_table;
   u64 m_blocks_per_disc;
 
+  u64 m_next_sequential_offset = 0;
+
   bool m_good;
 };
 
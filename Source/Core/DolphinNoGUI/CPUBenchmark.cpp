@@ -0,0 +1,563 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Runs small CPU-bound programs for a fixed number of emulated cycles on each CPU core, and
+// reports how long that took on the host. The programs are generated here rather than loaded
+// from files, so that every build measures exactly the same code. There is no video or audio
+// output, and emulation runs on a single thread, so the results only depend on the CPU core.
+
+#include <OptionParser.h>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "Common/Flag.h"
+#include "Common/Swap.h"
+#include "Common/Version.h"
+
+#include "Core/Boot/Boot.h"
+#include "Core/Boot/DolReader.h"
+#include "Core/BootManager.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/GCKeyboard.h"
+#include "Core/HW/GCPad.h"
+#include "Core/HW/SystemTimers.h"
+#include "Core/Host.h"
+#include "Core/PowerPC/PowerPC.h"
+
+#include "InputCommon/ControllerInterface/ControllerInterface.h"
+
+#include "UICommon/UICommon.h"
+
+#include "VideoCommon/VideoBackendBase.h"
+
+static Common::Event s_update_main_frame_event;
+
+void Host_NotifyMapLoaded()
+{
+}
+
+void Host_RefreshDSPDebuggerWindow()
+{
+}
+
+void Host_Message(HostMessageID id)
+{
+  if (id == HostMessageID::WMUserJobDispatch || id == HostMessageID::WMUserStop)
+    s_update_main_frame_event.Set();
+}
+
+void* Host_GetRenderHandle()
+{
+  return nullptr;
+}
+
+void Host_UpdateTitle(const std::string& title)
+{
+}
+
+void Host_UpdateDisasmDialog()
+{
+}
+
+void Host_UpdateMainFrame()
+{
+  s_update_main_frame_event.Set();
+}
+
+void Host_RequestRenderWindowSize(int width, int height)
+{
+}
+
+bool Host_UINeedsControllerState()
+{
+  return false;
+}
+
+bool Host_RendererHasFocus()
+{
+  return false;
+}
+
+bool Host_RendererIsFullscreen()
+{
+  return false;
+}
+
+void Host_ShowVideoConfig(void*, const std::string&)
+{
+}
+
+void Host_YieldToUI()
+{
+}
+
+void Host_UpdateProgressDialog(const char* caption, int position, int total)
+{
+}
+
+namespace
+{
+constexpr u32 ENTRY_POINT = 0x80003100;
+// Where the programs keep their data, well away from the code.
+constexpr u32 DATA_ADDRESS = 0x80100000;
+
+constexpr u32 DForm(u32 opcd, u32 d, u32 a, u32 imm)
+{
+  return opcd << 26 | d << 21 | a << 16 | (imm & 0xFFFF);
+}
+
+constexpr u32 XForm(u32 opcd, u32 d, u32 a, u32 b, u32 xo)
+{
+  return opcd << 26 | d << 21 | a << 16 | b << 11 | xo << 1;
+}
+
+constexpr u32 AForm(u32 opcd, u32 d, u32 a, u32 b, u32 c, u32 xo)
+{
+  return opcd << 26 | d << 21 | a << 16 | b << 11 | c << 6 | xo << 1;
+}
+
+constexpr u32 Rlwinm(u32 a, u32 s, u32 sh, u32 mb, u32 me)
+{
+  return 21 << 26 | s << 21 | a << 16 | sh << 11 | mb << 6 | me << 1;
+}
+
+constexpr u32 Mtspr(u32 spr, u32 s)
+{
+  return XForm(31, s, spr & 0x1F, spr >> 5, 467);
+}
+
+class ProgramWriter
+{
+public:
+  // Starts every program with external interrupts disabled, and r10 pointing to the data.
+  ProgramWriter()
+  {
+    Emit(XForm(31, 3, 0, 0, 83));  // mfmsr r3
+    Emit(Rlwinm(3, 3, 0, 17, 15));  // rlwinm r3, r3, 0, 17, 15 (clear EE)
+    Emit(XForm(31, 3, 0, 0, 146));  // mtmsr r3
+    Emit(XForm(19, 0, 0, 0, 150));  // isync
+    Emit(DForm(15, 10, 0, DATA_ADDRESS >> 16));  // lis r10, DATA_ADDRESS@h
+  }
+
+  size_t GetLabel() const { return m_code.size(); }
+  void Emit(u32 instruction) { m_code.push_back(instruction); }
+  void B(size_t label) { Emit(18 << 26 | (GetDisplacement(label) & 0x03FFFFFC)); }
+  void Bc(u32 bo, u32 bi, size_t label)
+  {
+    Emit(16 << 26 | bo << 21 | bi << 16 | (GetDisplacement(label) & 0xFFFC));
+  }
+
+  std::vector<u8> MakeDol() const
+  {
+    constexpr u32 TEXT_OFFSET = 0x100;
+
+    std::vector<u32> dol(TEXT_OFFSET / sizeof(u32) + m_code.size());
+    dol[0] = TEXT_OFFSET;         // Offset of the first text section
+    dol[18] = ENTRY_POINT;        // Address of the first text section
+    dol[36] = static_cast<u32>(m_code.size() * sizeof(u32));  // Size of the first text section
+    dol[56] = ENTRY_POINT;        // Entry point
+    std::copy(m_code.begin(), m_code.end(), dol.begin() + TEXT_OFFSET / sizeof(u32));
+
+    std::vector<u8> bytes(dol.size() * sizeof(u32));
+    for (size_t i = 0; i < dol.size(); ++i)
+    {
+      const u32 word = Common::swap32(dol[i]);
+      std::memcpy(&bytes[i * sizeof(u32)], &word, sizeof(u32));
+    }
+    return bytes;
+  }
+
+private:
+  u32 GetDisplacement(size_t label) const
+  {
+    return static_cast<u32>((label - m_code.size()) * sizeof(u32));
+  }
+
+  std::vector<u32> m_code;
+};
+
+std::vector<u8> GenerateIntegerProgram()
+{
+  ProgramWriter w;
+  w.Emit(DForm(14, 3, 0, 0));            // li r3, 0
+  w.Emit(DForm(14, 4, 0, 1));            // li r4, 1
+  w.Emit(DForm(15, 5, 0, 0x1234));       // lis r5, 0x1234
+  w.Emit(DForm(24, 5, 5, 0x5679));       // ori r5, r5, 0x5679
+  const size_t loop = w.GetLabel();
+  w.Emit(XForm(31, 3, 3, 4, 266));       // add r3, r3, r4
+  w.Emit(XForm(31, 6, 3, 5, 235));       // mullw r6, r3, r5
+  w.Emit(XForm(31, 4, 4, 6, 316));       // xor r4, r4, r6
+  w.Emit(Rlwinm(7, 4, 5, 0, 31));        // rotlwi r7, r4, 5
+  w.Emit(XForm(31, 8, 7, 3, 40));        // subf r8, r7, r3
+  w.Emit(XForm(31, 8, 9, 3, 824));       // srawi r9, r8, 3
+  w.Emit(XForm(31, 9, 4, 4, 444));       // or r4, r9, r4
+  w.Emit(XForm(31, 0, 3, 4, 0));         // cmpw r3, r4
+  const size_t skip_add = w.GetLabel() + 2;
+  w.Bc(12, 0, skip_add);                 // blt skip_add
+  w.Emit(DForm(14, 3, 3, 3));            // addi r3, r3, 3
+  w.B(loop);                             // skip_add: b loop
+  return w.MakeDol();
+}
+
+std::vector<u8> GenerateFloatingPointProgram()
+{
+  ProgramWriter w;
+  w.Emit(DForm(15, 3, 0, 0x3FF0));       // lis r3, 0x3FF0
+  w.Emit(DForm(36, 3, 10, 0));           // stw r3, 0(r10)
+  w.Emit(DForm(14, 3, 0, 0));            // li r3, 0
+  w.Emit(DForm(36, 3, 10, 4));           // stw r3, 4(r10)
+  w.Emit(DForm(50, 1, 10, 0));           // lfd f1, 0(r10)
+  w.Emit(DForm(50, 2, 10, 0));           // lfd f2, 0(r10)
+  w.Emit(AForm(63, 3, 1, 1, 0, 20));     // fsub f3, f1, f1
+  const size_t loop = w.GetLabel();
+  w.Emit(AForm(63, 3, 1, 3, 2, 29));     // fmadd f3, f1, f2, f3
+  w.Emit(AForm(63, 4, 3, 0, 2, 25));     // fmul f4, f3, f2
+  w.Emit(AForm(63, 5, 4, 1, 0, 21));     // fadd f5, f4, f1
+  w.Emit(AForm(63, 6, 5, 2, 0, 20));     // fsub f6, f5, f2
+  w.Emit(AForm(59, 7, 6, 0, 2, 25));     // fmuls f7, f6, f2
+  w.Emit(AForm(59, 8, 7, 1, 0, 21));     // fadds f8, f7, f1
+  w.Emit(AForm(59, 9, 8, 2, 0, 18));     // fdivs f9, f8, f2
+  w.Emit(DForm(54, 9, 10, 8));           // stfd f9, 8(r10)
+  w.B(loop);                             // b loop
+  return w.MakeDol();
+}
+
+std::vector<u8> GeneratePairedSingleProgram()
+{
+  ProgramWriter w;
+  w.Emit(DForm(15, 3, 0, 0xA000));       // lis r3, 0xA000
+  w.Emit(Mtspr(SPR_HID2, 3));            // mtspr HID2, r3 (PSE and LSQE)
+  w.Emit(DForm(14, 3, 0, 0));            // li r3, 0
+  w.Emit(Mtspr(SPR_GQR0, 3));            // mtspr GQR0, r3
+  w.Emit(XForm(19, 0, 0, 0, 150));       // isync
+  w.Emit(DForm(15, 3, 0, 0x3F80));       // lis r3, 0x3F80
+  w.Emit(DForm(36, 3, 10, 0));           // stw r3, 0(r10)
+  w.Emit(DForm(36, 3, 10, 4));           // stw r3, 4(r10)
+  w.Emit(DForm(56, 1, 10, 0));           // psq_l f1, 0(r10), 0, 0
+  w.Emit(DForm(56, 2, 10, 0));           // psq_l f2, 0(r10), 0, 0
+  w.Emit(AForm(4, 3, 1, 1, 0, 20));      // ps_sub f3, f1, f1
+  const size_t loop = w.GetLabel();
+  w.Emit(AForm(4, 3, 1, 3, 2, 29));      // ps_madd f3, f1, f2, f3
+  w.Emit(AForm(4, 4, 3, 0, 2, 25));      // ps_mul f4, f3, f2
+  w.Emit(AForm(4, 5, 4, 1, 0, 21));      // ps_add f5, f4, f1
+  w.Emit(XForm(4, 6, 5, 4, 592));        // ps_merge10 f6, f5, f4
+  w.Emit(AForm(4, 7, 6, 5, 4, 10));      // ps_sum0 f7, f6, f4, f5
+  w.Emit(DForm(60, 7, 10, 8));           // psq_st f7, 8(r10), 0, 0
+  w.Emit(DForm(56, 8, 10, 8));           // psq_l f8, 8(r10), 0, 0
+  w.B(loop);                             // b loop
+  return w.MakeDol();
+}
+
+std::vector<u8> GenerateLoadStoreProgram()
+{
+  // Walks through 64 KiB of memory with loads and stores of all sizes.
+  ProgramWriter w;
+  const size_t outer_loop = w.GetLabel();
+  w.Emit(DForm(14, 11, 0, 0));           // li r11, 0
+  w.Emit(DForm(14, 12, 0, 0x1000));      // li r12, 0x1000
+  w.Emit(Mtspr(SPR_CTR, 12));            // mtctr r12
+  const size_t inner_loop = w.GetLabel();
+  w.Emit(XForm(31, 9, 10, 11, 266));     // add r9, r10, r11
+  w.Emit(DForm(32, 4, 9, 0));            // lwz r4, 0(r9)
+  w.Emit(DForm(40, 5, 9, 4));            // lhz r5, 4(r9)
+  w.Emit(DForm(34, 6, 9, 7));            // lbz r6, 7(r9)
+  w.Emit(XForm(31, 4, 4, 5, 266));       // add r4, r4, r5
+  w.Emit(XForm(31, 4, 4, 6, 266));       // add r4, r4, r6
+  w.Emit(DForm(36, 4, 9, 0));            // stw r4, 0(r9)
+  w.Emit(DForm(44, 4, 9, 8));            // sth r4, 8(r9)
+  w.Emit(DForm(38, 4, 9, 11));           // stb r4, 11(r9)
+  w.Emit(DForm(14, 11, 11, 16));         // addi r11, r11, 16
+  w.Bc(16, 0, inner_loop);               // bdnz inner_loop
+  w.B(outer_loop);                       // b outer_loop
+  return w.MakeDol();
+}
+
+std::vector<u8> GenerateMMUProgram()
+{
+  // Touches a different page of an 8 MiB area with every access. Runs with MMU emulation, and
+  // reaches the area through the page table rather than a BAT: 0x40000000 is mapped page by page
+  // to the data, with a 64 KiB hash table at 0x01000000. With a VSID of zero and the smallest
+  // table, page n goes into PTEG n & 0x3FF, so the 2048 pages only need the first two slots.
+  ProgramWriter w;
+  w.Emit(DForm(14, 13, 0, 0));           // li r13, 0
+  w.Emit(DForm(15, 14, 0, 0x8100));      // lis r14, 0x8100 (the hash table)
+  w.Emit(DForm(15, 15, 0, 0x0010));      // lis r15, 0x0010 (physical address of the data)
+  w.Emit(DForm(24, 15, 15, 2));          // ori r15, r15, 2 (read/write)
+  w.Emit(DForm(14, 12, 0, 2048));        // li r12, 2048
+  w.Emit(Mtspr(SPR_CTR, 12));            // mtctr r12
+  const size_t fill_loop = w.GetLabel();
+  w.Emit(Rlwinm(16, 13, 6, 16, 25));     // rlwinm r16, r13, 6, 16, 25 (PTEG of the page)
+  w.Emit(Rlwinm(17, 13, 25, 28, 28));    // rlwinm r17, r13, 25, 28, 28 (slot in the PTEG)
+  w.Emit(XForm(31, 16, 16, 17, 266));    // add r16, r16, r17
+  w.Emit(XForm(31, 16, 16, 14, 266));    // add r16, r16, r14
+  w.Emit(Rlwinm(18, 13, 22, 26, 31));    // extrwi r18, r13, 6, 16 (API)
+  w.Emit(DForm(25, 18, 18, 0x8000));     // oris r18, r18, 0x8000 (valid)
+  w.Emit(DForm(36, 18, 16, 0));          // stw r18, 0(r16)
+  w.Emit(DForm(36, 15, 16, 4));          // stw r15, 4(r16)
+  w.Emit(DForm(14, 13, 13, 1));          // addi r13, r13, 1
+  w.Emit(DForm(14, 15, 15, 0x1000));     // addi r15, r15, 0x1000
+  w.Bc(16, 0, fill_loop);                // bdnz fill_loop
+  w.Emit(XForm(31, 0, 0, 0, 598));       // sync
+  w.Emit(DForm(15, 3, 0, 0x0100));       // lis r3, 0x0100
+  w.Emit(Mtspr(SPR_SDR, 3));             // mtspr SDR1, r3 (HTABMASK 0)
+  w.Emit(DForm(14, 3, 0, 0));            // li r3, 0
+  w.Emit(XForm(31, 3, 4, 0, 210));       // mtsr 4, r3 (VSID 0)
+  w.Emit(XForm(19, 0, 0, 0, 150));       // isync
+  w.Emit(DForm(15, 10, 0, 0x4000));      // lis r10, 0x4000
+
+  w.Emit(DForm(14, 11, 0, 0));           // li r11, 0
+  w.Emit(DForm(14, 12, 0, 0x1020));      // li r12, 0x1020
+  const size_t loop = w.GetLabel();
+  w.Emit(XForm(31, 11, 11, 12, 266));    // add r11, r11, r12
+  w.Emit(Rlwinm(11, 11, 0, 9, 31));      // clrlwi r11, r11, 9
+  w.Emit(XForm(31, 4, 10, 11, 23));      // lwzx r4, r10, r11
+  w.Emit(DForm(14, 4, 4, 1));            // addi r4, r4, 1
+  w.Emit(XForm(31, 4, 10, 11, 151));     // stwx r4, r10, r11
+  w.B(loop);                             // b loop
+  return w.MakeDol();
+}
+
+struct Program
+{
+  const char* name;
+  std::vector<u8> (*generate)();
+  bool mmu;
+};
+
+constexpr Program PROGRAMS[] = {
+    {"integer", GenerateIntegerProgram, false},
+    {"fp", GenerateFloatingPointProgram, false},
+    {"paired", GeneratePairedSingleProgram, false},
+    {"loadstore", GenerateLoadStoreProgram, false},
+    {"mmu", GenerateMMUProgram, true},
+};
+
+struct CPUCoreName
+{
+  const char* name;
+  PowerPC::CPUCore core;
+};
+
+constexpr CPUCoreName CPU_CORE_NAMES[] = {
+    {"interpreter", PowerPC::CPUCore::Interpreter},
+    {"cachedinterpreter", PowerPC::CPUCore::CachedInterpreter},
+    {"jit64", PowerPC::CPUCore::JIT64},
+    {"jitarm64", PowerPC::CPUCore::JITARM64},
+};
+
+const char* GetCPUCoreName(PowerPC::CPUCore core)
+{
+  for (const CPUCoreName& name : CPU_CORE_NAMES)
+  {
+    if (name.core == core)
+      return name.name;
+  }
+  return "unknown";
+}
+
+Common::Flag s_core_stopped;
+Common::Event s_run_finished;
+std::chrono::steady_clock::time_point s_run_start;
+std::chrono::steady_clock::time_point s_run_end;
+
+void RunFinished(u64, s64)
+{
+  s_run_end = std::chrono::steady_clock::now();
+  s_run_finished.Set();
+}
+
+void WaitForHost(const std::function<bool()>& done)
+{
+  while (!done())
+  {
+    Core::HostDispatchJobs();
+    s_update_main_frame_event.WaitFor(std::chrono::milliseconds(10));
+  }
+}
+
+struct RunResult
+{
+  u64 emulated_cycles;
+  double host_seconds;
+};
+
+std::optional<RunResult> RunProgram(const Program& program, PowerPC::CPUCore core,
+                                    double emulated_seconds)
+{
+  SConfig& config = SConfig::GetInstance();
+  config.cpu_core = core;
+  config.bMMU = program.mmu;
+  config.bCPUThread = false;
+  config.bDSPHLE = true;
+  config.m_EmulationSpeed = 0.0f;
+  config.m_OCEnable = false;
+  config.bEnableDebugging = false;
+  config.sBackend = BACKEND_NULLSOUND;
+  config.m_strVideoBackend = "Null";
+  VideoBackendBase::ActivateBackend(config.m_strVideoBackend);
+
+  s_core_stopped.Clear();
+  s_run_finished.Reset();
+
+  auto boot = std::make_unique<BootParameters>(BootParameters::Executable{
+      std::string(program.name) + ".dol", std::make_unique<DolReader>(program.generate())});
+  if (!BootManager::BootCore(std::move(boot)))
+    return {};
+
+  WaitForHost([] { return Core::GetState() == Core::State::Running || s_core_stopped.IsSet(); });
+  if (s_core_stopped.IsSet())
+    return {};
+
+  u64 cycles = 0;
+  Core::RunAsCPUThread([&cycles, emulated_seconds] {
+    cycles = static_cast<u64>(emulated_seconds * SystemTimers::GetTicksPerSecond());
+    CoreTiming::EventType* event = CoreTiming::RegisterEvent("BenchmarkFinished", RunFinished);
+    s_run_start = std::chrono::steady_clock::now();
+    CoreTiming::ScheduleEvent(static_cast<s64>(cycles), event);
+  });
+
+  WaitForHost([] { return s_run_finished.WaitFor(std::chrono::milliseconds(0)); });
+
+  Core::Stop();
+  WaitForHost([] { return s_core_stopped.IsSet(); });
+  Core::Shutdown();
+
+  return RunResult{cycles, std::chrono::duration<double>(s_run_end - s_run_start).count()};
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  optparse::OptionParser parser;
+  parser.usage("usage: %prog [options]...").version(Common::scm_rev_str);
+  parser.description("Measures how fast each CPU core emulates a set of built-in programs. "
+                     "The results are written as CSV.");
+  parser.add_option("-u", "--user").action("store").help("User folder path");
+  parser.add_option("-s", "--seconds")
+      .action("store")
+      .type("float")
+      .set_default(1.0)
+      .help("Emulated seconds to run each program for [default: %default]");
+  parser.add_option("-c", "--core")
+      .action("append")
+      .choices({"interpreter", "cachedinterpreter", "jit64", "jitarm64"})
+      .help("CPU core to measure, can be repeated [default: all available]");
+  parser.add_option("-p", "--program")
+      .action("append")
+      .choices({"integer", "fp", "paired", "loadstore", "mmu"})
+      .help("Program to run, can be repeated [default: all]");
+  parser.add_option("-o", "--output").action("store").help("Write the results to this file");
+
+  optparse::Values& options = parser.parse_args(argc, argv);
+
+  std::vector<PowerPC::CPUCore> cores;
+  if (options.is_set("core"))
+  {
+    for (const std::string& name : options.all("core"))
+    {
+      for (const CPUCoreName& core_name : CPU_CORE_NAMES)
+      {
+        if (name == core_name.name)
+          cores.push_back(core_name.core);
+      }
+    }
+  }
+  else
+  {
+    cores = PowerPC::AvailableCPUCores();
+  }
+
+  std::vector<const Program*> programs;
+  for (const Program& program : PROGRAMS)
+  {
+    if (!options.is_set("program"))
+    {
+      programs.push_back(&program);
+      continue;
+    }
+    const std::list<std::string>& names = options.all("program");
+    if (std::find(names.begin(), names.end(), program.name) != names.end())
+      programs.push_back(&program);
+  }
+
+  // Settings are never read from or saved to an existing user folder unless asked to, so that
+  // they can't affect the results.
+  std::string user_directory;
+  const bool temporary_user_directory = !options.is_set("user");
+  if (temporary_user_directory)
+    user_directory = File::CreateTempDir();
+  else
+    user_directory = static_cast<const char*>(options.get("user"));
+
+  File::IOFile output;
+  if (options.is_set("output"))
+  {
+    output.Open(static_cast<const char*>(options.get("output")), "w");
+    if (!output)
+    {
+      fprintf(stderr, "Could not open %s\n", static_cast<const char*>(options.get("output")));
+      return 1;
+    }
+  }
+  FILE* const out = output ? output.GetHandle() : stdout;
+
+  UICommon::SetUserDirectory(user_directory);
+  UICommon::Init();
+
+  // Like the GUIs, initialize the controllers once for the whole process rather than on every
+  // boot. Nothing reads them, but the emulation thread expects them to exist.
+  g_controller_interface.Initialize(nullptr);
+  Pad::Initialize();
+  Keyboard::Initialize();
+
+  Core::SetOnStateChangedCallback([](Core::State state) {
+    if (state == Core::State::Uninitialized)
+      s_core_stopped.Set();
+  });
+
+  const double seconds = options.get("seconds");
+  int result = 0;
+  fprintf(out, "program,core,emulated_cycles,host_seconds,host_seconds_per_emulated_second\n");
+  for (const Program* program : programs)
+  {
+    for (PowerPC::CPUCore core : cores)
+    {
+      const std::optional<RunResult> run = RunProgram(*program, core, seconds);
+      if (!run)
+      {
+        fprintf(stderr, "Could not run %s on %s\n", program->name, GetCPUCoreName(core));
+        result = 1;
+        continue;
+      }
+
+      fprintf(out, "%s,%s,%" PRIu64 ",%.6f,%.6f\n", program->name, GetCPUCoreName(core),
+              run->emulated_cycles, run->host_seconds, run->host_seconds / seconds);
+      fflush(out);
+    }
+  }
+
+  Keyboard::Shutdown();
+  Pad::Shutdown();
+  g_controller_interface.Shutdown();
+  UICommon::Shutdown();
+  if (temporary_user_directory)
+    File::DeleteDirRecursively(user_directory);
+
+  return result;
+}
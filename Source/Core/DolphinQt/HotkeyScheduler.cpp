@@ -15,6 +15,7 @@
 #include "Common/Thread.h"
 
 #include "Core/Config/GraphicsSettings.h"
+#include "Core/Config/MainSettings.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/HotkeyManager.h"
@@ -126,6 +127,24 @@ static void HandleFrameStepHotkeys()
   }
 }
 
+static void HandleRewindHotkey()
+{
+  static int rewind_delay_count = 0;
+
+  if (!IsHotkey(HK_REWIND, true))
+  {
+    rewind_delay_count = 0;
+    return;
+  }
+
+  // Holding the hotkey keeps going back. The hotkeys are checked about once per field, so
+  // stepping back once every snapshot interval rewinds at about the speed the game ran at.
+  if (rewind_delay_count == 0)
+    State::Rewind();
+  rewind_delay_count =
+      (rewind_delay_count + 1) % std::max(Config::Get(Config::MAIN_REWIND_INTERVAL), 1);
+}
+
 void HotkeyScheduler::Run()
 {
   while (!m_stop_requested.IsSet())
@@ -535,6 +554,8 @@ void HotkeyScheduler::Run()
 
     if (IsHotkey(HK_SAVE_STATE_FILE))
       emit StateSaveFile();
+
+    HandleRewindHotkey();
   }
 }
 
@@ -561,7 +561,7 @@ QString MainWindow::PromptFileName()
   QString path = QFileDialog::getOpenFileName(
       this, tr("Select a File"),
       settings.value(QStringLiteral("mainwindow/lastdir"), QStringLiteral("")).toString(),
-      tr("All GC/Wii files (*.elf *.dol *.gcm *.iso *.tgc *.wbfs *.ciso *.gcz *.wad *.dff);;"
+      tr("All GC/Wii files (*.elf *.dol *.gcm *.iso *.tgc *.wbfs *.ciso *.gcz *.dcz *.wad *.dff);;"
          "All Files (*)"));
 
   if (!path.isEmpty())
@@ -1040,6 +1040,9 @@ void MainWindow::SetStateSlot(int slot)
   Core::DisplayMessage(StringFromFormat("Selected slot %d - %s", m_state_slot,
                                         State::GetInfoStringOfSlot(m_state_slot, false).c_str()),
                        2500);
+
+  // The selected slot is likely to be loaded soon
+  State::Preload(m_state_slot);
 }
 
 void MainWindow::PerformOnlineUpdate(const std::string& region)
@@ -13,6 +13,7 @@
 #include <QInputDialog>
 #include <QMap>
 #include <QMessageBox>
+#include <QSignalBlocker>
 #include <QUrl>
 
 #include "Common/CommonPaths.h"
@@ -37,6 +38,7 @@
 #include "Core/PowerPC/PPCAnalyst.h"
 #include "Core/PowerPC/PPCSymbolDB.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/SamplingProfiler.h"
 #include "Core/PowerPC/SignatureDB/SignatureDB.h"
 #include "Core/State.h"
 #include "Core/TitleDatabase.h"
@@ -116,6 +118,7 @@ void MenuBar::OnEmulationStateChanged(Core::State state)
   m_jit_clear_cache->setEnabled(running);
   m_jit_log_coverage->setEnabled(!running);
   m_jit_search_instruction->setEnabled(running);
+  m_jit_sampling_profiler->setEnabled(running || m_jit_sampling_profiler->isChecked());
 
   for (QAction* action :
        {m_jit_off, m_jit_loadstore_off, m_jit_loadstore_lbzx_off, m_jit_loadstore_lxz_off,
@@ -301,15 +304,21 @@ void MenuBar::AddStateLoadMenu(QMenu* emu_menu)
 {
   m_state_load_menu = emu_menu->addMenu(tr("&Load State"));
   m_state_load_menu->addAction(tr("Load State from File"), this, &MenuBar::StateLoad);
-  m_state_load_menu->addAction(tr("Load State from Selected Slot"), this, &MenuBar::StateLoadSlot);
+  QAction* load_selected = m_state_load_menu->addAction(tr("Load State from Selected Slot"),
+                                                        this, &MenuBar::StateLoadSlot);
   m_state_load_slots_menu = m_state_load_menu->addMenu(tr("Load State from Slot"));
   m_state_load_menu->addAction(tr("Undo Load State"), this, &MenuBar::StateLoadUndo);
 
+  // Start decompressing a state as soon as it is highlighted, so that loading it is quicker
+  connect(load_selected, &QAction::hovered, this,
+          [] { State::Preload(Settings::Instance().GetStateSlot()); });
+
   for (int i = 1; i <= 10; i++)
   {
     QAction* action = m_state_load_slots_menu->addAction(QStringLiteral(""));
 
     connect(action, &QAction::triggered, this, [=]() { emit StateLoadSlotAt(i); });
+    connect(action, &QAction::hovered, this, [=] { State::Preload(i); });
   }
 }
 
@@ -759,6 +768,9 @@ void MenuBar::AddJITMenu()
       m_jit->addAction(tr("Log JIT Instruction Coverage"), this, &MenuBar::LogInstructions);
   m_jit_search_instruction =
       m_jit->addAction(tr("Search for an Instruction"), this, &MenuBar::SearchInstruction);
+  m_jit_sampling_profiler = m_jit->addAction(tr("Sampling Profiler"));
+  m_jit_sampling_profiler->setCheckable(true);
+  connect(m_jit_sampling_profiler, &QAction::toggled, this, &MenuBar::ToggleSamplingProfiler);
 
   m_jit->addSeparator();
 
@@ -1310,6 +1322,33 @@ void MenuBar::ClearCache()
   Core::RunAsCPUThread(JitInterface::ClearCache);
 }
 
+void MenuBar::ToggleSamplingProfiler(bool enabled)
+{
+  if (enabled)
+  {
+    if (!Profiler::StartSampling())
+    {
+      QMessageBox::warning(this, tr("Error"), tr("Failed to start the sampling profiler."));
+      QSignalBlocker blocker(m_jit_sampling_profiler);
+      m_jit_sampling_profiler->setChecked(false);
+    }
+    return;
+  }
+
+  Profiler::StopSampling();
+  m_jit_sampling_profiler->setEnabled(Core::IsRunning());
+
+  const QString file = QFileDialog::getSaveFileName(this, tr("Save Collapsed Stacks"), QString(),
+                                                    tr("Collapsed stacks (*.txt)"));
+  if (file.isEmpty())
+    return;
+
+  bool success = false;
+  Core::RunAsCPUThread([&] { success = Profiler::WriteCollapsedStacks(file.toStdString()); });
+  if (!success)
+    QMessageBox::warning(this, tr("Error"), tr("Failed to write '%1'").arg(file));
+}
+
 void MenuBar::LogInstructions()
 {
   PPCTables::LogCompiledInstructions();
@@ -155,6 +155,7 @@ private:
   void CreateSignatureFile();
   void PatchHLEFunctions();
   void ClearCache();
+  void ToggleSamplingProfiler(bool enabled);
   void LogInstructions();
   void SearchInstruction();
 
@@ -230,6 +231,7 @@ private:
   QAction* m_jit_clear_cache;
   QAction* m_jit_log_coverage;
   QAction* m_jit_search_instruction;
+  QAction* m_jit_sampling_profiler;
   QAction* m_jit_off;
   QAction* m_jit_loadstore_off;
   QAction* m_jit_loadstore_lbzx_off;
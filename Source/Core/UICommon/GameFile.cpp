@@ -113,6 +113,12 @@ GameFile::GameFile(const std::string& path)
     SplitPath(m_file_path, nullptr, &name, &extension);
     m_file_name = name + extension;
 
+    // Checked before reading the file, so that a file that is modified while it's being
+    // scanned is considered changed the next time the cache is updated
+    const File::FileInfo file_info(m_file_path);
+    m_file_size_on_disk = file_info.GetSize();
+    m_file_modification_time = file_info.GetModificationTime();
+
     std::unique_ptr<DiscIO::Volume> volume(DiscIO::CreateVolumeFromFilename(m_file_path));
     if (volume != nullptr)
     {
@@ -153,6 +159,13 @@ GameFile::GameFile(const std::string& path)
   }
 }
 
+bool GameFile::FileChangedOnDisk() const
+{
+  const File::FileInfo file_info(m_file_path);
+  return file_info.GetSize() != m_file_size_on_disk ||
+         file_info.GetModificationTime() != m_file_modification_time;
+}
+
 bool GameFile::IsValid() const
 {
   if (!m_valid)
@@ -320,6 +333,8 @@ void GameFile::DoState(PointerWrap& p)
 
   p.Do(m_file_size);
   p.Do(m_volume_size);
+  p.Do(m_file_size_on_disk);
+  p.Do(m_file_modification_time);
 
   p.Do(m_short_names);
   p.Do(m_long_names);
@@ -80,6 +80,9 @@ public:
   DiscIO::BlobType GetBlobType() const { return m_blob_type; }
   const std::string& GetApploaderDate() const { return m_apploader_date; }
   u64 GetFileSize() const { return m_file_size; }
+  // Whether the file on disk no longer has the size and modification time it had
+  // when this GameFile was created. Only checks the file system, so it is cheap.
+  bool FileChangedOnDisk() const;
   u64 GetVolumeSize() const { return m_volume_size; }
   const GameBanner& GetBannerImage() const;
   const GameCover& GetCoverImage() const;
@@ -112,6 +115,9 @@ private:
 
   u64 m_file_size{};
   u64 m_volume_size{};
+  // As reported by the file system, for noticing when the file has been replaced
+  u64 m_file_size_on_disk{};
+  u64 m_file_modification_time{};
 
   std::map<DiscIO::Language, std::string> m_short_names{};
   std::map<DiscIO::Language, std::string> m_long_names{};
@@ -11,6 +11,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -20,6 +21,7 @@
 #include "Common/File.h"
 #include "Common/FileSearch.h"
 #include "Common/FileUtil.h"
+#include "Common/ThreadPool.h"
 
 #include "DiscIO/DirectoryBlob.h"
 
@@ -27,13 +29,21 @@
 
 namespace UICommon
 {
-static constexpr u32 CACHE_REVISION = 12;  // Last changed in PR 7285
+static constexpr u32 CACHE_REVISION = 14;  // Last changed when adding file timestamps
+
+// Scanning mostly waits for I/O (possibly over a network), so use more threads than cores.
+// The calling thread takes part as well.
+static size_t GetScanWorkerCount()
+{
+  const size_t hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  return std::clamp<size_t>(hardware_threads * 2, 2, 32) - 1;
+}
 
 std::vector<std::string> FindAllGamePaths(const std::vector<std::string>& directories_to_scan,
                                           bool recursive_scan)
 {
   static const std::vector<std::string> search_extensions = {
-      ".gcm", ".tgc", ".iso", ".ciso", ".gcz", ".wbfs", ".wad", ".dol", ".elf"};
+      ".gcm", ".tgc", ".iso", ".ciso", ".gcz", ".dcz", ".wbfs", ".wad", ".dol", ".elf"};
 
   // TODO: We could process paths iteratively as they are found
   return Common::DoFileSearch(directories_to_scan, search_extensions, recursive_scan);
@@ -78,6 +88,7 @@ std::shared_ptr<const GameFile> GameFileCache::AddOrGet(const std::string& path,
     m_cached_files.emplace_back(std::move(game));
   }
   std::shared_ptr<GameFile>& result = found ? *it : m_cached_files.back();
+  result->DownloadDefaultCover();
   if (UpdateAdditionalMetadata(&result) || !found)
     *cache_changed = true;
 
@@ -101,46 +112,57 @@ bool GameFileCache::Update(
   }
 
   bool cache_changed = false;
+  Common::ThreadPool thread_pool(GetScanWorkerCount(), "Game List Scan");
+
+  // Files whose size or modification time differs from when they were cached get rescanned
+  std::vector<u8> file_changed(m_cached_files.size());
+  thread_pool.ParallelFor(m_cached_files.size(), [&](size_t i) {
+    file_changed[i] = m_cached_files[i]->FileChangedOnDisk();
+  });
 
-  // Delete paths that aren't in game_paths from m_cached_files,
-  // while simultaneously deleting paths that are in m_cached_files from game_paths.
+  // Delete paths that aren't in game_paths (or have changed) from m_cached_files,
+  // while simultaneously deleting the unchanged paths in m_cached_files from game_paths.
   // For the sake of speed, we don't care about maintaining the order of m_cached_files.
   {
-    auto it = m_cached_files.begin();
-    auto end = m_cached_files.end();
-    while (it != end)
+    size_t i = 0;
+    size_t end = m_cached_files.size();
+    while (i != end)
     {
-      if (game_paths.erase((*it)->GetFilePath()))
+      if (!file_changed[i] && game_paths.erase(m_cached_files[i]->GetFilePath()))
       {
-        ++it;
+        ++i;
       }
       else
       {
         if (game_removed_from_cache)
-          game_removed_from_cache((*it)->GetFilePath());
+          game_removed_from_cache(m_cached_files[i]->GetFilePath());
 
         cache_changed = true;
         --end;
-        *it = std::move(*end);
+        m_cached_files[i] = std::move(m_cached_files[end]);
+        file_changed[i] = file_changed[end];
       }
     }
-    m_cached_files.erase(it, m_cached_files.end());
+    m_cached_files.erase(m_cached_files.begin() + end, m_cached_files.end());
   }
 
   // Now that the previous loop has run, game_paths only contains paths that
   // aren't in m_cached_files, so we simply add all of them to m_cached_files.
-  for (const std::string& path : game_paths)
-  {
-    auto file = std::make_shared<GameFile>(path);
-    if (file->IsValid())
-    {
-      if (game_added_to_cache)
-        game_added_to_cache(file);
+  // Opening and parsing the files is what takes time, so that happens in parallel.
+  const std::vector<std::string> new_paths(game_paths.begin(), game_paths.end());
+  std::mutex mutex;
+  thread_pool.ParallelFor(new_paths.size(), [&](size_t i) {
+    auto file = std::make_shared<GameFile>(new_paths[i]);
+    if (!file->IsValid())
+      return;
 
-      cache_changed = true;
-      m_cached_files.push_back(std::move(file));
-    }
-  }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (game_added_to_cache)
+      game_added_to_cache(file);
+
+    cache_changed = true;
+    m_cached_files.push_back(std::move(file));
+  });
 
   return cache_changed;
 }
@@ -148,15 +170,26 @@ bool GameFileCache::Update(
 bool GameFileCache::UpdateAdditionalMetadata(
     std::function<void(const std::shared_ptr<const GameFile>&)> game_updated)
 {
+  // Covers are saved under the game ID, which several files can share, so they are
+  // downloaded one at a time.
+  for (const std::shared_ptr<GameFile>& file : m_cached_files)
+    file->DownloadDefaultCover();
+
   bool cache_changed = false;
+  Common::ThreadPool thread_pool(GetScanWorkerCount(), "Game List Scan");
 
-  for (std::shared_ptr<GameFile>& file : m_cached_files)
-  {
-    const bool updated = UpdateAdditionalMetadata(&file);
-    cache_changed |= updated;
-    if (game_updated && updated)
+  // Every call only replaces its own element of m_cached_files
+  std::mutex mutex;
+  thread_pool.ParallelFor(m_cached_files.size(), [&](size_t i) {
+    std::shared_ptr<GameFile>& file = m_cached_files[i];
+    if (!UpdateAdditionalMetadata(&file))
+      return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    cache_changed = true;
+    if (game_updated)
       game_updated(file);
-  }
+  });
 
   return cache_changed;
 }
@@ -165,9 +198,6 @@ bool GameFileCache::UpdateAdditionalMetadata(std::shared_ptr<GameFile>* game_fil
 {
   const bool wii_banner_changed = (*game_file)->WiiBannerChanged();
   const bool custom_banner_changed = (*game_file)->CustomBannerChanged();
-
-  (*game_file)->DownloadDefaultCover();
-
   const bool default_cover_changed = (*game_file)->DefaultCoverChanged();
   const bool custom_cover_changed = (*game_file)->CustomCoverChanged();
 
@@ -36,6 +36,9 @@ public:
   std::shared_ptr<const GameFile> AddOrGet(const std::string& path, bool* cache_changed);
 
   // These functions return true if the call modified the cache.
+  // Files are scanned on several threads, so the callbacks can be called from any thread
+  // (but never from more than one at the same time).
+  // Update only reopens files that are new or whose size or modification time has changed.
   bool Update(const std::vector<std::string>& all_game_paths,
               std::function<void(const std::shared_ptr<const GameFile>&)> game_added_to_cache = {},
               std::function<void(const std::string&)> game_removed_from_cache = {});
@@ -46,6 +49,7 @@ public:
   bool Save();
 
 private:
+  // Expects the default cover to have been downloaded already.
   bool UpdateAdditionalMetadata(std::shared_ptr<GameFile>* game_file);
 
   bool SyncCacheFile(bool save);
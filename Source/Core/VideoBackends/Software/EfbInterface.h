@@ -59,5 +59,5 @@ void EncodeXFB(u8* xfb_in_ram, u32 memory_stride, const EFBRectangle& source_rec
 
 u32 GetPerfQueryResult(PerfQueryType type);
 void ResetPerfQuery();
-void IncPerfCounterQuadCount(PerfQueryType type);
+void AddPerfCounterPixels(PerfQueryType type, u32 count);
 }  // namespace EfbInterface
@@ -3,13 +3,23 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
 
+#include "Common/BitSet.h"
 #include "Common/CommonTypes.h"
+#include "Common/ThreadPool.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/NativeVertexFormat.h"
 #include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/Tev.h"
+#ifdef _M_X86_64
+#include "VideoBackends/Software/TevJit.h"
+#endif
+#include "VideoCommon/BoundingBox.h"
 #include "VideoCommon/PerfQueryBase.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoConfig.h"
@@ -19,28 +29,102 @@ namespace Rasterizer
 {
 static constexpr int BLOCK_SIZE = 2;
 
-static Slope ZSlope;
-static Slope WSlope;
-static Slope ColorSlopes[2][4];
-static Slope TexSlopes[8][3];
-
-static s32 vertex0X;
-static s32 vertex0Y;
-static float vertexOffsetX;
-static float vertexOffsetY;
+// Tiles are a whole number of blocks, so that no block is split between two tiles.
+static constexpr int TILE_WIDTH = 32;
+static constexpr int TILE_HEIGHT = 32;
+static constexpr int NUM_TILES_X = (EFB_WIDTH + TILE_WIDTH - 1) / TILE_WIDTH;
+static constexpr int NUM_TILES_Y = (EFB_HEIGHT + TILE_HEIGHT - 1) / TILE_HEIGHT;
+static_assert(TILE_WIDTH % BLOCK_SIZE == 0 && TILE_HEIGHT % BLOCK_SIZE == 0,
+              "Blocks must not cross tile boundaries");
+
+// Binned triangles are drawn early once there are this many, to bound the memory used.
+static constexpr size_t MAX_BINNED_TRIANGLES = 4096;
+// Below this many pixels in the bounding boxes of the binned triangles, waking up the worker
+// threads costs more than drawing everything on the calling thread.
+static constexpr u32 MIN_PARALLEL_PIXELS = 64 * 64;
+
+// Everything needed to rasterize a triangle after it's been set up.
+struct Triangle
+{
+  Slope ZSlope;
+  Slope WSlope;
+  Slope ColorSlopes[2][4];
+  Slope TexSlopes[8][3];
+
+  s32 vertex0X;
+  s32 vertex0Y;
+  float vertexOffsetX;
+  float vertexOffsetY;
+
+  // Half-edge constants and deltas
+  s32 C1, C2, C3;
+  s32 DX12, DX23, DX31;
+  s32 DY12, DY23, DY31;
+
+  // Bounding rectangle, aligned to blocks
+  s32 minx, maxx, miny, maxy;
+};
+
+struct Tile
+{
+  std::vector<u32> triangles;
+  Tev tev;
+  RasterBlock rasterBlock;
+  u32 rasterizedPixels;
+};
 
-static Tev tev;
-static RasterBlock rasterBlock;
+// The z slope has to outlive the triangle it was set up for, because of zfreeze.
+static Slope ZSlope;
 
-void Init()
+static std::vector<Triangle> s_triangles;
+// Tev keeps pointers into itself, so the tiles must never move.
+static std::array<Tile, NUM_TILES_X * NUM_TILES_Y> s_tiles;
+static std::vector<u32> s_binned_tiles;
+static u32 s_binned_pixels;
+static std::unique_ptr<Common::ThreadPool> s_thread_pool;
+#ifdef _M_X86_64
+static std::unique_ptr<TevJit> s_tev_jit;
+#endif
+
+void Init(u32 num_threads)
 {
-  tev.Init();
+  for (Tile& tile : s_tiles)
+  {
+    tile.tev.Init();
+    tile.rasterizedPixels = 0;
+  }
 
   // Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the
   // first primitive.
   // TODO: This is just a guess!
   ZSlope.dfdx = ZSlope.dfdy = 0.f;
   ZSlope.f0 = 1.f;
+
+  // The calling thread draws tiles too.
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  s_thread_pool = std::make_unique<Common::ThreadPool>(num_threads - 1, "Software rasterizer");
+
+#ifdef _M_X86_64
+  s_tev_jit = std::make_unique<TevJit>();
+#endif
+}
+
+void Shutdown()
+{
+  s_thread_pool.reset();
+#ifdef _M_X86_64
+  s_tev_jit.reset();
+#endif
+  s_triangles.clear();
+  s_triangles.shrink_to_fit();
+  for (Tile& tile : s_tiles)
+  {
+    tile.triangles.clear();
+    tile.triangles.shrink_to_fit();
+  }
+  s_binned_tiles.clear();
+  s_binned_pixels = 0;
 }
 
 // Returns approximation of log2(f) in s28.4
@@ -67,48 +151,51 @@ static inline int iround(float x)
 
 void SetTevReg(int reg, int comp, s16 color)
 {
-  tev.SetRegColor(reg, comp, color);
+  for (Tile& tile : s_tiles)
+    tile.tev.SetRegColor(reg, comp, color);
 }
 
-static void Draw(s32 x, s32 y, s32 xi, s32 yi)
+// Sets up one lane of the tile's TEV for a pixel. Returns false if it fails the early depth test.
+static bool SetupPixel(const Triangle& tri, Tile& tile, int lane, s32 x, s32 y, s32 xi, s32 yi)
 {
-  INCSTAT(stats.thisFrame.rasterizedPixels);
+  tile.rasterizedPixels++;
 
-  float dx = vertexOffsetX + (float)(x - vertex0X);
-  float dy = vertexOffsetY + (float)(y - vertex0Y);
+  float dx = tri.vertexOffsetX + (float)(x - tri.vertex0X);
+  float dy = tri.vertexOffsetY + (float)(y - tri.vertex0Y);
 
-  s32 z = (s32)MathUtil::Clamp<float>(ZSlope.GetValue(dx, dy), 0.0f, 16777215.0f);
+  s32 z = (s32)MathUtil::Clamp<float>(tri.ZSlope.GetValue(dx, dy), 0.0f, 16777215.0f);
 
+  Tev& tev = tile.tev;
   if (bpmem.UseEarlyDepthTest() && g_ActiveConfig.bZComploc)
   {
     // TODO: Test if perf regs are incremented even if test is disabled
-    EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT_ZCOMPLOC);
+    tev.PerfQueryPixels[PQ_ZCOMP_INPUT_ZCOMPLOC]++;
     if (bpmem.zmode.testenable)
     {
       // early z
       if (!EfbInterface::ZCompare(x, y, z))
-        return;
+        return false;
     }
-    EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT_ZCOMPLOC);
+    tev.PerfQueryPixels[PQ_ZCOMP_OUTPUT_ZCOMPLOC]++;
   }
 
-  RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
+  const RasterBlockPixel& pixel = tile.rasterBlock.Pixel[xi][yi];
 
-  tev.Position[0] = x;
-  tev.Position[1] = y;
-  tev.Position[2] = z;
+  tev.Position[lane][0] = x;
+  tev.Position[lane][1] = y;
+  tev.Position[lane][2] = z;
 
   //  colors
   for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
   {
     for (int comp = 0; comp < 4; comp++)
     {
-      u16 color = (u16)ColorSlopes[i][comp].GetValue(dx, dy);
+      u16 color = (u16)tri.ColorSlopes[i][comp].GetValue(dx, dy);
 
       // clamp color value to 0
       u16 mask = ~(color >> 8);
 
-      tev.Color[i][comp] = color & mask;
+      tev.Color[lane][i][comp] = color & mask;
     }
   }
 
@@ -116,10 +203,33 @@ static void Draw(s32 x, s32 y, s32 xi, s32 yi)
   for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
   {
     // multiply by 128 because TEV stores UVs as s17.7
-    tev.Uv[i].s = (s32)(pixel.Uv[i][0] * 128);
-    tev.Uv[i].t = (s32)(pixel.Uv[i][1] * 128);
+    tev.Uv[lane][i].s = (s32)(pixel.Uv[i][0] * 128);
+    tev.Uv[lane][i].t = (s32)(pixel.Uv[i][1] * 128);
   }
 
+  return true;
+}
+
+// Draws the pixels of a block whose bit is set in coverage, where bit (yi * BLOCK_SIZE + xi)
+// is the pixel at (x + xi, y + yi). They go through the TEV together, one pixel per lane.
+static void DrawBlock(const Triangle& tri, Tile& tile, s32 x, s32 y, u32 coverage)
+{
+  static_assert(BLOCK_SIZE * BLOCK_SIZE == Tev::NUM_LANES, "A block must fill the TEV lanes");
+
+  u32 mask = 0;
+  for (int lane : BitSet32(coverage))
+  {
+    const s32 xi = lane % BLOCK_SIZE;
+    const s32 yi = lane / BLOCK_SIZE;
+    if (SetupPixel(tri, tile, lane, x + xi, y + yi, xi, yi))
+      mask |= 1u << lane;
+  }
+
+  if (mask == 0)
+    return;
+
+  Tev& tev = tile.tev;
+  const RasterBlock& rasterBlock = tile.rasterBlock;
   for (unsigned int i = 0; i < bpmem.genMode.numindstages; i++)
   {
     tev.IndirectLod[i] = rasterBlock.IndirectLod[i];
@@ -132,19 +242,28 @@ static void Draw(s32 x, s32 y, s32 xi, s32 yi)
     tev.TextureLinear[i] = rasterBlock.TextureLinear[i];
   }
 
-  tev.Draw();
+  // The TEV dumps go through a single temporary pixel, so draw one pixel at a time for them.
+  if (g_ActiveConfig.bDumpTevStages || g_ActiveConfig.bDumpTevTextureFetches)
+  {
+    for (int lane : BitSet32(mask))
+      tev.Draw(1u << lane);
+  }
+  else
+  {
+    tev.Draw(mask);
+  }
 }
 
-static void InitTriangle(float X1, float Y1, s32 xi, s32 yi)
+static void InitTriangle(Triangle* tri, float X1, float Y1, s32 xi, s32 yi)
 {
-  vertex0X = xi;
-  vertex0Y = yi;
+  tri->vertex0X = xi;
+  tri->vertex0Y = yi;
 
   // adjust a little less than 0.5
   const float adjust = 0.495f;
 
-  vertexOffsetX = ((float)xi - X1) + adjust;
-  vertexOffsetY = ((float)yi - Y1) + adjust;
+  tri->vertexOffsetX = ((float)xi - X1) + adjust;
+  tri->vertexOffsetY = ((float)yi - Y1) + adjust;
 }
 
 static void InitSlope(Slope* slope, float f1, float f2, float f3, float DX31, float DX12,
@@ -160,7 +279,8 @@ static void InitSlope(Slope* slope, float f1, float f2, float f3, float DX31, fl
   slope->f0 = f1;
 }
 
-static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoord)
+static inline void CalculateLOD(const RasterBlock& rasterBlock, s32* lodp, bool* linear,
+                                u32 texmap, u32 texcoord)
 {
   const FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
   const u8 subTexmap = texmap & 3;
@@ -173,17 +293,17 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
   float sDelta, tDelta;
   if (tm0.diag_lod)
   {
-    float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-    float* uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
+    const float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+    const float* uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
 
     sDelta = fabsf(uv0[0] - uv1[0]);
     tDelta = fabsf(uv0[1] - uv1[1]);
   }
   else
   {
-    float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-    float* uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
-    float* uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
+    const float* uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+    const float* uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
+    const float* uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
 
     sDelta = std::max(fabsf(uv0[0] - uv1[0]), fabsf(uv0[0] - uv2[0]));
     tDelta = std::max(fabsf(uv0[1] - uv1[1]), fabsf(uv0[1] - uv2[1]));
@@ -208,7 +328,7 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
   *lodp = lod;
 }
 
-static void BuildBlock(s32 blockX, s32 blockY)
+static void BuildBlock(const Triangle& tri, RasterBlock& rasterBlock, s32 blockX, s32 blockY)
 {
   for (s32 yi = 0; yi < BLOCK_SIZE; yi++)
   {
@@ -216,10 +336,10 @@ static void BuildBlock(s32 blockX, s32 blockY)
     {
       RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
-      float dx = vertexOffsetX + (float)(xi + blockX - vertex0X);
-      float dy = vertexOffsetY + (float)(yi + blockY - vertex0Y);
+      float dx = tri.vertexOffsetX + (float)(xi + blockX - tri.vertex0X);
+      float dy = tri.vertexOffsetY + (float)(yi + blockY - tri.vertex0Y);
 
-      float invW = 1.0f / WSlope.GetValue(dx, dy);
+      float invW = 1.0f / tri.WSlope.GetValue(dx, dy);
       pixel.InvW = invW;
 
       // tex coords
@@ -228,13 +348,13 @@ static void BuildBlock(s32 blockX, s32 blockY)
         float projection = invW;
         if (xfmem.texMtxInfo[i].projection)
         {
-          float q = TexSlopes[i][2].GetValue(dx, dy) * invW;
+          float q = tri.TexSlopes[i][2].GetValue(dx, dy) * invW;
           if (q != 0.0f)
             projection = invW / q;
         }
 
-        pixel.Uv[i][0] = TexSlopes[i][0].GetValue(dx, dy) * projection;
-        pixel.Uv[i][1] = TexSlopes[i][1].GetValue(dx, dy) * projection;
+        pixel.Uv[i][0] = tri.TexSlopes[i][0].GetValue(dx, dy) * projection;
+        pixel.Uv[i][1] = tri.TexSlopes[i][1].GetValue(dx, dy) * projection;
       }
     }
   }
@@ -247,7 +367,8 @@ static void BuildBlock(s32 blockX, s32 blockY)
     u32 texcoord = indref & 3;
     indref >>= 3;
 
-    CalculateLOD(&rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap, texcoord);
+    CalculateLOD(rasterBlock, &rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap,
+                 texcoord);
   }
 
   for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
@@ -259,11 +380,190 @@ static void BuildBlock(s32 blockX, s32 blockY)
       u32 texmap = order.getTexMap(stageOdd);
       u32 texcoord = order.getTexCoord(stageOdd);
 
-      CalculateLOD(&rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap, texcoord);
+      CalculateLOD(rasterBlock, &rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap,
+                   texcoord);
     }
   }
 }
 
+static void DrawTriangleInTile(const Triangle& tri, Tile& tile, s32 tileX, s32 tileY)
+{
+  const s32 C1 = tri.C1;
+  const s32 C2 = tri.C2;
+  const s32 C3 = tri.C3;
+  const s32 DX12 = tri.DX12;
+  const s32 DX23 = tri.DX23;
+  const s32 DX31 = tri.DX31;
+  const s32 DY12 = tri.DY12;
+  const s32 DY23 = tri.DY23;
+  const s32 DY31 = tri.DY31;
+
+  // Fixed-pos32 deltas
+  const s32 FDX12 = DX12 * 16;
+  const s32 FDX23 = DX23 * 16;
+  const s32 FDX31 = DX31 * 16;
+
+  const s32 FDY12 = DY12 * 16;
+  const s32 FDY23 = DY23 * 16;
+  const s32 FDY31 = DY31 * 16;
+
+  // Both the bounding rectangle and the tile start on a block boundary
+  const s32 minx = std::max(tri.minx, tileX);
+  const s32 maxx = std::min(tri.maxx, tileX + TILE_WIDTH);
+  const s32 miny = std::max(tri.miny, tileY);
+  const s32 maxy = std::min(tri.maxy, tileY + TILE_HEIGHT);
+
+  // Loop through blocks
+  for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
+  {
+    for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
+    {
+      // Corners of block
+      s32 x0 = x << 4;
+      s32 x1 = (x + BLOCK_SIZE - 1) << 4;
+      s32 y0 = y << 4;
+      s32 y1 = (y + BLOCK_SIZE - 1) << 4;
+
+      // Evaluate half-space functions
+      bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
+      bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
+      bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
+      bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
+      int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
+
+      bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
+      bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
+      bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
+      bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
+      int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
+
+      bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
+      bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
+      bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
+      bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
+      int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
+
+      // Skip block when outside an edge
+      if (a == 0x0 || b == 0x0 || c == 0x0)
+        continue;
+
+      BuildBlock(tri, tile.rasterBlock, x, y);
+
+      // Accept whole block when totally covered
+      if (a == 0xF && b == 0xF && c == 0xF)
+      {
+        DrawBlock(tri, tile, x, y, 0xF);
+      }
+      else  // Partially covered block
+      {
+        s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
+        s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
+        s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
+
+        u32 coverage = 0;
+        for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
+        {
+          s32 CX1 = CY1;
+          s32 CX2 = CY2;
+          s32 CX3 = CY3;
+
+          for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
+          {
+            if (CX1 > 0 && CX2 > 0 && CX3 > 0)
+            {
+              coverage |= 1u << (iy * BLOCK_SIZE + ix);
+            }
+
+            CX1 -= FDY12;
+            CX2 -= FDY23;
+            CX3 -= FDY31;
+          }
+
+          CY1 += FDX12;
+          CY2 += FDX23;
+          CY3 += FDX31;
+        }
+
+        DrawBlock(tri, tile, x, y, coverage);
+      }
+    }
+  }
+}
+
+static void DrawTile(u32 index)
+{
+  Tile& tile = s_tiles[index];
+  const s32 tileX = static_cast<s32>(index % NUM_TILES_X) * TILE_WIDTH;
+  const s32 tileY = static_cast<s32>(index / NUM_TILES_X) * TILE_HEIGHT;
+
+  for (u32 triangle : tile.triangles)
+    DrawTriangleInTile(s_triangles[triangle], tile, tileX, tileY);
+  tile.triangles.clear();
+}
+
+void DrawBinnedTriangles()
+{
+  if (s_triangles.empty())
+    return;
+
+  // All triangles since the last call were drawn with the same BP state.
+  Tev::CombinerFunction combiners = nullptr;
+#ifdef _M_X86_64
+  if (s_tev_jit)
+    combiners = s_tev_jit->GetCombiners(s_tiles[0].tev);
+#endif
+  for (u32 index : s_binned_tiles)
+    s_tiles[index].tev.SetCombiners(combiners);
+
+  // The debug buffers for the TEV stages are shared by all tiles.
+  const bool parallel = s_thread_pool && s_binned_pixels >= MIN_PARALLEL_PIXELS &&
+                        !g_ActiveConfig.bDumpTevStages && !g_ActiveConfig.bDumpTevTextureFetches;
+  if (parallel)
+  {
+    s_thread_pool->ParallelFor(s_binned_tiles.size(),
+                               [](size_t i) { DrawTile(s_binned_tiles[i]); });
+  }
+  else
+  {
+    for (u32 index : s_binned_tiles)
+      DrawTile(index);
+  }
+
+  // Everything that's added up is independent of the order the pixels were drawn in.
+  for (u32 index : s_binned_tiles)
+  {
+    Tile& tile = s_tiles[index];
+    Tev& tev = tile.tev;
+
+    ADDSTAT(stats.thisFrame.rasterizedPixels, tile.rasterizedPixels);
+    ADDSTAT(stats.thisFrame.tevPixelsIn, tev.PixelsIn);
+    ADDSTAT(stats.thisFrame.tevPixelsOut, tev.PixelsOut);
+    tile.rasterizedPixels = 0;
+
+    for (int type = 0; type < PQ_NUM_MEMBERS; type++)
+    {
+      if (tev.PerfQueryPixels[type] != 0)
+        EfbInterface::AddPerfCounterPixels(static_cast<PerfQueryType>(type),
+                                           tev.PerfQueryPixels[type]);
+    }
+
+    BoundingBox::coords[BoundingBox::LEFT] =
+        std::min(tev.BoundingBoxCoords[BoundingBox::LEFT], BoundingBox::coords[BoundingBox::LEFT]);
+    BoundingBox::coords[BoundingBox::RIGHT] = std::max(tev.BoundingBoxCoords[BoundingBox::RIGHT],
+                                                       BoundingBox::coords[BoundingBox::RIGHT]);
+    BoundingBox::coords[BoundingBox::TOP] =
+        std::min(tev.BoundingBoxCoords[BoundingBox::TOP], BoundingBox::coords[BoundingBox::TOP]);
+    BoundingBox::coords[BoundingBox::BOTTOM] = std::max(
+        tev.BoundingBoxCoords[BoundingBox::BOTTOM], BoundingBox::coords[BoundingBox::BOTTOM]);
+
+    tev.ResetCounters();
+  }
+
+  s_triangles.clear();
+  s_binned_tiles.clear();
+  s_binned_pixels = 0;
+}
+
 void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v1,
                            const OutputVertexData* v2)
 {
@@ -290,15 +590,6 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   const s32 DY23 = Y2 - Y3;
   const s32 DY31 = Y3 - Y1;
 
-  // Fixed-pos32 deltas
-  const s32 FDX12 = DX12 * 16;
-  const s32 FDX23 = DX23 * 16;
-  const s32 FDX31 = DX31 * 16;
-
-  const s32 FDY12 = DY12 * 16;
-  const s32 FDY23 = DY23 * 16;
-  const s32 FDY31 = DY31 * 16;
-
   // Bounding rectangle
   s32 minx = (std::min(std::min(X1, X2), X3) + 0xF) >> 4;
   s32 maxx = (std::max(std::max(X1, X2), X3) + 0xF) >> 4;
@@ -341,11 +632,16 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   float fltdy12 = flty1 - v1->screenPosition.y;
   float fltdy31 = v2->screenPosition.y - flty1;
 
-  InitTriangle(fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
+  if (s_triangles.size() >= MAX_BINNED_TRIANGLES)
+    DrawBinnedTriangles();
+  s_triangles.emplace_back();
+  Triangle& tri = s_triangles.back();
+
+  InitTriangle(&tri, fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
 
   float w[3] = {1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w,
                 1.0f / v2->projectedPosition.w};
-  InitSlope(&WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+  InitSlope(&tri.WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 
   // TODO: The zfreeze emulation is not quite correct, yet!
   // Many things might prevent us from reaching this line (culling, clipping, scissoring).
@@ -356,19 +652,21 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   if (!bpmem.genMode.zfreeze || !g_ActiveConfig.bZFreeze)
     InitSlope(&ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31,
               fltdx12, fltdy12, fltdy31);
+  tri.ZSlope = ZSlope;
 
   for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
   {
     for (int comp = 0; comp < 4; comp++)
-      InitSlope(&ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp],
-                fltdx31, fltdx12, fltdy12, fltdy31);
+      InitSlope(&tri.ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp],
+                v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
   }
 
   for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
   {
     for (int comp = 0; comp < 3; comp++)
-      InitSlope(&TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1],
-                v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+      InitSlope(&tri.TexSlopes[i][comp], v0->texCoords[i][comp] * w[0],
+                v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12,
+                fltdy12, fltdy31);
   }
 
   // Half-edge constants
@@ -384,87 +682,35 @@ void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v
   if (DY31 < 0 || (DY31 == 0 && DX31 > 0))
     C3++;
 
-  // Start in corner of 8x8 block
-  minx &= ~(BLOCK_SIZE - 1);
-  miny &= ~(BLOCK_SIZE - 1);
+  tri.C1 = C1;
+  tri.C2 = C2;
+  tri.C3 = C3;
+  tri.DX12 = DX12;
+  tri.DX23 = DX23;
+  tri.DX31 = DX31;
+  tri.DY12 = DY12;
+  tri.DY23 = DY23;
+  tri.DY31 = DY31;
 
-  // Loop through blocks
-  for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
+  // Start in corner of 8x8 block
+  tri.minx = minx & ~(BLOCK_SIZE - 1);
+  tri.miny = miny & ~(BLOCK_SIZE - 1);
+  tri.maxx = maxx;
+  tri.maxy = maxy;
+
+  // A block that starts before maxx can end after it, but it still ends in the same tile.
+  const u32 triangle = static_cast<u32>(s_triangles.size() - 1);
+  for (s32 ty = tri.miny / TILE_HEIGHT; ty <= (maxy - 1) / TILE_HEIGHT; ty++)
   {
-    for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
+    for (s32 tx = tri.minx / TILE_WIDTH; tx <= (maxx - 1) / TILE_WIDTH; tx++)
     {
-      // Corners of block
-      s32 x0 = x << 4;
-      s32 x1 = (x + BLOCK_SIZE - 1) << 4;
-      s32 y0 = y << 4;
-      s32 y1 = (y + BLOCK_SIZE - 1) << 4;
-
-      // Evaluate half-space functions
-      bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
-      bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
-      bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
-      bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
-      int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
-
-      bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
-      bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
-      bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
-      bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
-      int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
-
-      bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
-      bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
-      bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
-      bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
-      int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
-
-      // Skip block when outside an edge
-      if (a == 0x0 || b == 0x0 || c == 0x0)
-        continue;
-
-      BuildBlock(x, y);
-
-      // Accept whole block when totally covered
-      if (a == 0xF && b == 0xF && c == 0xF)
-      {
-        for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-        {
-          for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-          {
-            Draw(x + ix, y + iy, ix, iy);
-          }
-        }
-      }
-      else  // Partially covered block
-      {
-        s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
-        s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
-        s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
-
-        for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-        {
-          s32 CX1 = CY1;
-          s32 CX2 = CY2;
-          s32 CX3 = CY3;
-
-          for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-          {
-            if (CX1 > 0 && CX2 > 0 && CX3 > 0)
-            {
-              Draw(x + ix, y + iy, ix, iy);
-            }
-
-            CX1 -= FDY12;
-            CX2 -= FDY23;
-            CX3 -= FDY31;
-          }
-
-          CY1 += FDX12;
-          CY2 += FDX23;
-          CY3 += FDX31;
-        }
-      }
+      const u32 index = static_cast<u32>(ty * NUM_TILES_X + tx);
+      std::vector<u32>& triangles = s_tiles[index].triangles;
+      if (triangles.empty())
+        s_binned_tiles.push_back(index);
+      triangles.push_back(triangle);
     }
   }
+  s_binned_pixels += static_cast<u32>((maxx - tri.minx) * (maxy - tri.miny));
 }
 }
@@ -10,11 +10,21 @@ struct OutputVertexData;
 
 namespace Rasterizer
 {
-void Init();
+// Draws on num_threads threads, counting the calling thread, or on one thread per hardware
+// thread if it is 0.
+void Init(u32 num_threads = 0);
+void Shutdown();
 
+// Sets up the triangle and sorts it into the screen tiles it covers. Nothing is drawn until
+// DrawBinnedTriangles is called.
 void DrawTriangleFrontFace(const OutputVertexData* v0, const OutputVertexData* v1,
                            const OutputVertexData* v2);
 
+// Draws the tiles on several threads. Each tile draws its triangles in the order they were
+// submitted, so the result is the same as drawing them one after another. This has to be
+// called before the EFB is accessed or the state used for drawing changes.
+void DrawBinnedTriangles();
+
 void SetTevReg(int reg, int comp, s16 color);
 
 struct Slope
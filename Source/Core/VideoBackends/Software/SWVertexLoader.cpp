@@ -4,6 +4,8 @@
 
 #include "VideoBackends/Software/SWVertexLoader.h"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <limits>
 
@@ -15,6 +17,7 @@
 #include "VideoBackends/Software/NativeVertexFormat.h"
 #include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/Tev.h"
+#include "VideoBackends/Software/TextureSampler.h"
 #include "VideoBackends/Software/TransformUnit.h"
 
 #include "VideoCommon/DataReader.h"
@@ -57,6 +60,7 @@ void SWVertexLoader::ResetBuffer(u32 stride)
 
 void SWVertexLoader::vFlush()
 {
+  TextureSampler::InvalidateBindings();
   DebugUtil::OnObjectBegin();
 
   u8 primitiveType = 0;
@@ -87,29 +91,39 @@ void SWVertexLoader::vFlush()
     Rasterizer::SetTevReg(i, Tev::ALP_C, PixelShaderManager::constants.kcolors[i][3]);
   }
 
-  for (u32 i = 0; i < IndexGenerator::GetIndexLen(); i++)
-  {
-    const u16 index = m_local_index_buffer[i];
-    memset(&m_vertex, 0, sizeof(m_vertex));
+  memset(&m_vertex, 0, sizeof(m_vertex));
 
-    // Super Mario Sunshine requires those to be zero for those debug boxes.
-    m_vertex.color = {};
+  // Super Mario Sunshine requires those to be zero for those debug boxes.
+  m_vertex.color = {};
 
-    // parse the videocommon format to our own struct format (m_vertex)
-    SetFormat(g_main_cp_state.last_id, primitiveType);
-    ParseVertex(VertexLoaderManager::GetCurrentVertexFormat()->GetVertexDeclaration(), index);
+  SetFormat(g_main_cp_state.last_id, primitiveType);
+  const PortableVertexDeclaration& vdec =
+      VertexLoaderManager::GetCurrentVertexFormat()->GetVertexDeclaration();
+  const bool has_normal = (VertexLoaderManager::g_current_components & VB_HAS_NRM0) != 0;
+  const bool nbt = (VertexLoaderManager::g_current_components & VB_HAS_NRM2) != 0;
 
-    // transform this vertex so that it can be used for rasterization (outVertex)
-    OutputVertexData* outVertex = m_setup_unit.GetVertex();
-    TransformUnit::TransformPosition(&m_vertex, outVertex);
-    outVertex->normal = {};
-    if (VertexLoaderManager::g_current_components & VB_HAS_NRM0)
+  // Transform each vertex once, in batches, however many primitives it's used by.
+  const u32 num_vertices = IndexGenerator::GetNumVerts();
+  m_transformed_vertices.resize(num_vertices);
+  for (u32 first = 0; first < num_vertices; first += TransformUnit::BATCH_SIZE)
+  {
+    const u32 count = std::min(TransformUnit::BATCH_SIZE, num_vertices - first);
+    std::array<InputVertexData, TransformUnit::BATCH_SIZE> batch;
+    for (u32 i = 0; i < count; i++)
     {
-      TransformUnit::TransformNormal(
-          &m_vertex, (VertexLoaderManager::g_current_components & VB_HAS_NRM2) != 0, outVertex);
+      // parse the videocommon format to our own struct format
+      batch[i] = m_vertex;
+      ParseVertex(vdec, first + i, &batch[i]);
     }
-    TransformUnit::TransformColor(&m_vertex, outVertex);
-    TransformUnit::TransformTexCoord(&m_vertex, outVertex, m_tex_gen_special_case);
+
+    TransformUnit::TransformVertices(batch.data(), &m_transformed_vertices[first], count,
+                                     has_normal, nbt, m_tex_gen_special_case);
+  }
+
+  for (u32 i = 0; i < IndexGenerator::GetIndexLen(); i++)
+  {
+    const u16 index = m_local_index_buffer[i];
+    *m_setup_unit.GetVertex() = m_transformed_vertices[index];
 
     // assemble and rasterize the primitive
     m_setup_unit.SetupVertex();
@@ -117,6 +131,8 @@ void SWVertexLoader::vFlush()
     INCSTAT(stats.thisFrame.numVerticesLoaded)
   }
 
+  Rasterizer::DrawBinnedTriangles();
+
   DebugUtil::OnObjectEnd();
 }
 
@@ -207,34 +223,35 @@ static void ReadVertexAttribute(T* dst, DataReader src, const AttributeFormat& f
   }
 }
 
-void SWVertexLoader::ParseVertex(const PortableVertexDeclaration& vdec, int index)
+void SWVertexLoader::ParseVertex(const PortableVertexDeclaration& vdec, int index,
+                                 InputVertexData* vertex)
 {
   DataReader src(m_local_vertex_buffer.data(),
                  m_local_vertex_buffer.data() + m_local_vertex_buffer.size());
   src.Skip(index * vdec.stride);
 
-  ReadVertexAttribute<float>(&m_vertex.position[0], src, vdec.position, 0, 3, false);
+  ReadVertexAttribute<float>(&vertex->position[0], src, vdec.position, 0, 3, false);
 
-  for (std::size_t i = 0; i < m_vertex.normal.size(); i++)
+  for (std::size_t i = 0; i < vertex->normal.size(); i++)
   {
-    ReadVertexAttribute<float>(&m_vertex.normal[i][0], src, vdec.normals[i], 0, 3, false);
+    ReadVertexAttribute<float>(&vertex->normal[i][0], src, vdec.normals[i], 0, 3, false);
   }
 
-  for (std::size_t i = 0; i < m_vertex.color.size(); i++)
+  for (std::size_t i = 0; i < vertex->color.size(); i++)
   {
-    ReadVertexAttribute<u8>(m_vertex.color[i].data(), src, vdec.colors[i], 0, 4, true);
+    ReadVertexAttribute<u8>(vertex->color[i].data(), src, vdec.colors[i], 0, 4, true);
   }
 
-  for (std::size_t i = 0; i < m_vertex.texCoords.size(); i++)
+  for (std::size_t i = 0; i < vertex->texCoords.size(); i++)
   {
-    ReadVertexAttribute<float>(m_vertex.texCoords[i].data(), src, vdec.texcoords[i], 0, 2, false);
+    ReadVertexAttribute<float>(vertex->texCoords[i].data(), src, vdec.texcoords[i], 0, 2, false);
 
     // the texmtr is stored as third component of the texCoord
     if (vdec.texcoords[i].components >= 3)
     {
-      ReadVertexAttribute<u8>(&m_vertex.texMtx[i], src, vdec.texcoords[i], 2, 1, false);
+      ReadVertexAttribute<u8>(&vertex->texMtx[i], src, vdec.texcoords[i], 2, 1, false);
     }
   }
 
-  ReadVertexAttribute<u8>(&m_vertex.posMtx, src, vdec.posmtx, 0, 1, false);
+  ReadVertexAttribute<u8>(&vertex->posMtx, src, vdec.posmtx, 0, 1, false);
 }
@@ -20,6 +20,7 @@
 #include "VideoBackends/Software/SWTexture.h"
 #include "VideoBackends/Software/SWVertexLoader.h"
 #include "VideoBackends/Software/TextureCache.h"
+#include "VideoBackends/Software/TextureSampler.h"
 #include "VideoBackends/Software/VideoBackend.h"
 
 #include "VideoCommon/FramebufferManagerBase.h"
@@ -109,6 +110,8 @@ void VideoSoftware::Shutdown()
     g_renderer->Shutdown();
 
   DebugUtil::Shutdown();
+  Rasterizer::Shutdown();
+  TextureSampler::Shutdown();
   SWOGLWindow::Shutdown();
   g_framebuffer_manager.reset();
   g_texture_cache.reset();
@@ -2,10 +2,15 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <iterator>
 
+#include "Common/BitSet.h"
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "VideoBackends/Software/DebugUtil.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/Tev.h"
@@ -14,7 +19,6 @@
 #include "VideoCommon/BoundingBox.h"
 #include "VideoCommon/PerfQueryBase.h"
 #include "VideoCommon/PixelShaderManager.h"
-#include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoConfig.h"
 #include "VideoCommon/XFMemory.h"
 
@@ -36,68 +40,70 @@ void Tev::Init()
   FixedConstants[7] = 223;
   FixedConstants[8] = 255;
 
-  for (s16& comp : Zero16)
-  {
-    comp = 0;
-  }
-
-  m_ColorInputLUT[0][RED_INP] = &Reg[0][RED_C];
-  m_ColorInputLUT[0][GRN_INP] = &Reg[0][GRN_C];
-  m_ColorInputLUT[0][BLU_INP] = &Reg[0][BLU_C];  // prev.rgb
-  m_ColorInputLUT[1][RED_INP] = &Reg[0][ALP_C];
-  m_ColorInputLUT[1][GRN_INP] = &Reg[0][ALP_C];
-  m_ColorInputLUT[1][BLU_INP] = &Reg[0][ALP_C];  // prev.aaa
-  m_ColorInputLUT[2][RED_INP] = &Reg[1][RED_C];
-  m_ColorInputLUT[2][GRN_INP] = &Reg[1][GRN_C];
-  m_ColorInputLUT[2][BLU_INP] = &Reg[1][BLU_C];  // c0.rgb
-  m_ColorInputLUT[3][RED_INP] = &Reg[1][ALP_C];
-  m_ColorInputLUT[3][GRN_INP] = &Reg[1][ALP_C];
-  m_ColorInputLUT[3][BLU_INP] = &Reg[1][ALP_C];  // c0.aaa
-  m_ColorInputLUT[4][RED_INP] = &Reg[2][RED_C];
-  m_ColorInputLUT[4][GRN_INP] = &Reg[2][GRN_C];
-  m_ColorInputLUT[4][BLU_INP] = &Reg[2][BLU_C];  // c1.rgb
-  m_ColorInputLUT[5][RED_INP] = &Reg[2][ALP_C];
-  m_ColorInputLUT[5][GRN_INP] = &Reg[2][ALP_C];
-  m_ColorInputLUT[5][BLU_INP] = &Reg[2][ALP_C];  // c1.aaa
-  m_ColorInputLUT[6][RED_INP] = &Reg[3][RED_C];
-  m_ColorInputLUT[6][GRN_INP] = &Reg[3][GRN_C];
-  m_ColorInputLUT[6][BLU_INP] = &Reg[3][BLU_C];  // c2.rgb
-  m_ColorInputLUT[7][RED_INP] = &Reg[3][ALP_C];
-  m_ColorInputLUT[7][GRN_INP] = &Reg[3][ALP_C];
-  m_ColorInputLUT[7][BLU_INP] = &Reg[3][ALP_C];  // c2.aaa
-  m_ColorInputLUT[8][RED_INP] = &TexColor[RED_C];
-  m_ColorInputLUT[8][GRN_INP] = &TexColor[GRN_C];
-  m_ColorInputLUT[8][BLU_INP] = &TexColor[BLU_C];  // tex.rgb
-  m_ColorInputLUT[9][RED_INP] = &TexColor[ALP_C];
-  m_ColorInputLUT[9][GRN_INP] = &TexColor[ALP_C];
-  m_ColorInputLUT[9][BLU_INP] = &TexColor[ALP_C];  // tex.aaa
-  m_ColorInputLUT[10][RED_INP] = &RasColor[RED_C];
-  m_ColorInputLUT[10][GRN_INP] = &RasColor[GRN_C];
-  m_ColorInputLUT[10][BLU_INP] = &RasColor[BLU_C];  // ras.rgb
-  m_ColorInputLUT[11][RED_INP] = &RasColor[ALP_C];
-  m_ColorInputLUT[11][GRN_INP] = &RasColor[ALP_C];
-  m_ColorInputLUT[11][BLU_INP] = &RasColor[ALP_C];  // ras.rgb
-  m_ColorInputLUT[12][RED_INP] = &FixedConstants[8];
-  m_ColorInputLUT[12][GRN_INP] = &FixedConstants[8];
-  m_ColorInputLUT[12][BLU_INP] = &FixedConstants[8];  // one
-  m_ColorInputLUT[13][RED_INP] = &FixedConstants[4];
-  m_ColorInputLUT[13][GRN_INP] = &FixedConstants[4];
-  m_ColorInputLUT[13][BLU_INP] = &FixedConstants[4];  // half
-  m_ColorInputLUT[14][RED_INP] = &StageKonst[RED_C];
-  m_ColorInputLUT[14][GRN_INP] = &StageKonst[GRN_C];
-  m_ColorInputLUT[14][BLU_INP] = &StageKonst[BLU_C];  // konst
-  m_ColorInputLUT[15][RED_INP] = &FixedConstants[0];
-  m_ColorInputLUT[15][GRN_INP] = &FixedConstants[0];
-  m_ColorInputLUT[15][BLU_INP] = &FixedConstants[0];  // zero
-
-  m_AlphaInputLUT[0] = &Reg[0][ALP_C];      // prev
-  m_AlphaInputLUT[1] = &Reg[1][ALP_C];      // c0
-  m_AlphaInputLUT[2] = &Reg[2][ALP_C];      // c1
-  m_AlphaInputLUT[3] = &Reg[3][ALP_C];      // c2
-  m_AlphaInputLUT[4] = &TexColor[ALP_C];    // tex
-  m_AlphaInputLUT[5] = &RasColor[ALP_C];    // ras
-  m_AlphaInputLUT[6] = &StageKonst[ALP_C];  // konst
-  m_AlphaInputLUT[7] = &Zero16[ALP_C];      // zero
+  for (int lane = 0; lane < NUM_LANES; lane++)
+  {
+    FixedInputs[0][lane] = FixedConstants[8];
+    FixedInputs[1][lane] = FixedConstants[4];
+    FixedInputs[2][lane] = FixedConstants[0];
+  }
+
+  m_ColorInputLUT[0][RED_INP] = Reg[0][RED_C];
+  m_ColorInputLUT[0][GRN_INP] = Reg[0][GRN_C];
+  m_ColorInputLUT[0][BLU_INP] = Reg[0][BLU_C];  // prev.rgb
+  m_ColorInputLUT[1][RED_INP] = Reg[0][ALP_C];
+  m_ColorInputLUT[1][GRN_INP] = Reg[0][ALP_C];
+  m_ColorInputLUT[1][BLU_INP] = Reg[0][ALP_C];  // prev.aaa
+  m_ColorInputLUT[2][RED_INP] = Reg[1][RED_C];
+  m_ColorInputLUT[2][GRN_INP] = Reg[1][GRN_C];
+  m_ColorInputLUT[2][BLU_INP] = Reg[1][BLU_C];  // c0.rgb
+  m_ColorInputLUT[3][RED_INP] = Reg[1][ALP_C];
+  m_ColorInputLUT[3][GRN_INP] = Reg[1][ALP_C];
+  m_ColorInputLUT[3][BLU_INP] = Reg[1][ALP_C];  // c0.aaa
+  m_ColorInputLUT[4][RED_INP] = Reg[2][RED_C];
+  m_ColorInputLUT[4][GRN_INP] = Reg[2][GRN_C];
+  m_ColorInputLUT[4][BLU_INP] = Reg[2][BLU_C];  // c1.rgb
+  m_ColorInputLUT[5][RED_INP] = Reg[2][ALP_C];
+  m_ColorInputLUT[5][GRN_INP] = Reg[2][ALP_C];
+  m_ColorInputLUT[5][BLU_INP] = Reg[2][ALP_C];  // c1.aaa
+  m_ColorInputLUT[6][RED_INP] = Reg[3][RED_C];
+  m_ColorInputLUT[6][GRN_INP] = Reg[3][GRN_C];
+  m_ColorInputLUT[6][BLU_INP] = Reg[3][BLU_C];  // c2.rgb
+  m_ColorInputLUT[7][RED_INP] = Reg[3][ALP_C];
+  m_ColorInputLUT[7][GRN_INP] = Reg[3][ALP_C];
+  m_ColorInputLUT[7][BLU_INP] = Reg[3][ALP_C];  // c2.aaa
+  m_ColorInputLUT[8][RED_INP] = TexColor[RED_C];
+  m_ColorInputLUT[8][GRN_INP] = TexColor[GRN_C];
+  m_ColorInputLUT[8][BLU_INP] = TexColor[BLU_C];  // tex.rgb
+  m_ColorInputLUT[9][RED_INP] = TexColor[ALP_C];
+  m_ColorInputLUT[9][GRN_INP] = TexColor[ALP_C];
+  m_ColorInputLUT[9][BLU_INP] = TexColor[ALP_C];  // tex.aaa
+  m_ColorInputLUT[10][RED_INP] = RasColor[RED_C];
+  m_ColorInputLUT[10][GRN_INP] = RasColor[GRN_C];
+  m_ColorInputLUT[10][BLU_INP] = RasColor[BLU_C];  // ras.rgb
+  m_ColorInputLUT[11][RED_INP] = RasColor[ALP_C];
+  m_ColorInputLUT[11][GRN_INP] = RasColor[ALP_C];
+  m_ColorInputLUT[11][BLU_INP] = RasColor[ALP_C];  // ras.rgb
+  m_ColorInputLUT[12][RED_INP] = FixedInputs[0];
+  m_ColorInputLUT[12][GRN_INP] = FixedInputs[0];
+  m_ColorInputLUT[12][BLU_INP] = FixedInputs[0];  // one
+  m_ColorInputLUT[13][RED_INP] = FixedInputs[1];
+  m_ColorInputLUT[13][GRN_INP] = FixedInputs[1];
+  m_ColorInputLUT[13][BLU_INP] = FixedInputs[1];  // half
+  m_ColorInputLUT[14][RED_INP] = StageKonst[RED_C];
+  m_ColorInputLUT[14][GRN_INP] = StageKonst[GRN_C];
+  m_ColorInputLUT[14][BLU_INP] = StageKonst[BLU_C];  // konst
+  m_ColorInputLUT[15][RED_INP] = FixedInputs[2];
+  m_ColorInputLUT[15][GRN_INP] = FixedInputs[2];
+  m_ColorInputLUT[15][BLU_INP] = FixedInputs[2];  // zero
+
+  m_AlphaInputLUT[0] = Reg[0][ALP_C];      // prev
+  m_AlphaInputLUT[1] = Reg[1][ALP_C];      // c0
+  m_AlphaInputLUT[2] = Reg[2][ALP_C];      // c1
+  m_AlphaInputLUT[3] = Reg[3][ALP_C];      // c2
+  m_AlphaInputLUT[4] = TexColor[ALP_C];    // tex
+  m_AlphaInputLUT[5] = RasColor[ALP_C];    // ras
+  m_AlphaInputLUT[6] = StageKonst[ALP_C];  // konst
+  m_AlphaInputLUT[7] = FixedInputs[2];     // zero
 
   for (int comp = 0; comp < 4; comp++)
   {
@@ -157,6 +163,8 @@ void Tev::Init()
   m_ScaleRShiftLUT[1] = 0;
   m_ScaleRShiftLUT[2] = 0;
   m_ScaleRShiftLUT[3] = 1;
+
+  ResetCounters();
 }
 
 static inline s16 Clamp255(s16 in)
@@ -169,98 +177,201 @@ static inline s16 Clamp1024(s16 in)
   return in > 1023 ? 1023 : (in < -1024 ? -1024 : in);
 }
 
-void Tev::SetRasColor(int colorChan, int swaptable)
+// The registers are 16 bits wide, so results are truncated to that before being clamped.
+#ifdef _M_X86
+static inline __m128i ClampLanes(__m128i value, __m128i min, __m128i max)
+{
+  value = _mm_srai_epi32(_mm_slli_epi32(value, 16), 16);
+  const __m128i above = _mm_cmpgt_epi32(value, max);
+  value = _mm_or_si128(_mm_and_si128(above, max), _mm_andnot_si128(above, value));
+  const __m128i below = _mm_cmpgt_epi32(min, value);
+  return _mm_or_si128(_mm_and_si128(below, min), _mm_andnot_si128(below, value));
+}
+
+static void ClampLanes(s32* value, bool clamp)
+{
+  const __m128i min = _mm_set1_epi32(clamp ? 0 : -1024);
+  const __m128i max = _mm_set1_epi32(clamp ? 255 : 1023);
+  __m128i* lanes = reinterpret_cast<__m128i*>(value);
+  _mm_store_si128(lanes, ClampLanes(_mm_load_si128(lanes), min, max));
+}
+
+// Evaluates a regular combiner for one component of all lanes:
+// ((d + bias) << lshift) + ((lerp(a, b, c) << lshift) + round) / 256, then >> rshift.
+// The color and alpha combiners differ in whether the lerp is negated before or after dividing.
+static void CombineLanes(s32* dest, const s32* a_in, const s32* b_in, const s32* c_in,
+                         const s32* d_in, s32 bias, u32 lshift, u32 rshift, s32 round, bool negate,
+                         bool negate_before_divide)
+{
+  // a, b and c are 8 bits, d is 11 bits signed.
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  const __m128i a = _mm_and_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(a_in)), mask);
+  const __m128i b = _mm_and_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(b_in)), mask);
+  __m128i c = _mm_and_si128(_mm_load_si128(reinterpret_cast<const __m128i*>(c_in)), mask);
+  __m128i d = _mm_load_si128(reinterpret_cast<const __m128i*>(d_in));
+  d = _mm_srai_epi32(_mm_slli_epi32(d, 21), 21);
+
+  c = _mm_add_epi32(c, _mm_srli_epi32(c, 7));
+
+  // a * (256 - c) + b * c in one multiply-add of 16 bit pairs, none of which exceed 256.
+  const __m128i ab = _mm_or_si128(a, _mm_slli_epi32(b, 16));
+  const __m128i weights =
+      _mm_or_si128(_mm_sub_epi32(_mm_set1_epi32(256), c), _mm_slli_epi32(c, 16));
+  const __m128i lshift_count = _mm_cvtsi32_si128(lshift);
+  __m128i temp = _mm_sll_epi32(_mm_madd_epi16(ab, weights), lshift_count);
+  temp = _mm_add_epi32(temp, _mm_set1_epi32(round));
+
+  if (negate && negate_before_divide)
+    temp = _mm_sub_epi32(_mm_setzero_si128(), temp);
+  temp = _mm_srai_epi32(temp, 8);
+  if (negate && !negate_before_divide)
+    temp = _mm_sub_epi32(_mm_setzero_si128(), temp);
+
+  __m128i result = _mm_sll_epi32(_mm_add_epi32(d, _mm_set1_epi32(bias)), lshift_count);
+  result = _mm_sra_epi32(_mm_add_epi32(result, temp), _mm_cvtsi32_si128(rshift));
+  _mm_store_si128(reinterpret_cast<__m128i*>(dest), result);
+}
+#else
+static void ClampLanes(s32* value, bool clamp)
+{
+  for (int lane = 0; lane < Tev::NUM_LANES; lane++)
+  {
+    const s16 truncated = static_cast<s16>(value[lane]);
+    value[lane] = clamp ? Clamp255(truncated) : Clamp1024(truncated);
+  }
+}
+
+static void CombineLanes(s32* dest, const s32* a_in, const s32* b_in, const s32* c_in,
+                         const s32* d_in, s32 bias, u32 lshift, u32 rshift, s32 round, bool negate,
+                         bool negate_before_divide)
+{
+  for (int lane = 0; lane < Tev::NUM_LANES; lane++)
+  {
+    const s32 a = a_in[lane] & 0xFF;
+    const s32 b = b_in[lane] & 0xFF;
+    s32 c = c_in[lane] & 0xFF;
+    const s32 d = static_cast<s32>(static_cast<u32>(d_in[lane]) << 21) >> 21;
+
+    c += c >> 7;
+
+    s32 temp = a * (256 - c) + (b * c);
+    temp <<= lshift;
+    temp += round;
+    if (negate_before_divide)
+      temp = negate ? (-temp >> 8) : (temp >> 8);
+    else
+      temp = negate ? -(temp >> 8) : (temp >> 8);
+
+    s32 result = ((d + bias) << lshift) + temp;
+    dest[lane] = result >> rshift;
+  }
+}
+#endif
+
+void Tev::SetRasColor(int stage, int lane, int colorChan, int swaptable)
 {
+  s32(&RasColor)[4][NUM_LANES] = StageRasColor[stage];
+
   switch (colorChan)
   {
   case 0:  // Color0
   {
-    const u8* color = Color[0];
-    RasColor[RED_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[GRN_C] = color[bpmem.tevksel[swaptable].swap2];
+    const u8* color = Color[lane][0];
+    RasColor[RED_C][lane] = color[bpmem.tevksel[swaptable].swap1];
+    RasColor[GRN_C][lane] = color[bpmem.tevksel[swaptable].swap2];
     swaptable++;
-    RasColor[BLU_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[ALP_C] = color[bpmem.tevksel[swaptable].swap2];
+    RasColor[BLU_C][lane] = color[bpmem.tevksel[swaptable].swap1];
+    RasColor[ALP_C][lane] = color[bpmem.tevksel[swaptable].swap2];
   }
   break;
   case 1:  // Color1
   {
-    const u8* color = Color[1];
-    RasColor[RED_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[GRN_C] = color[bpmem.tevksel[swaptable].swap2];
+    const u8* color = Color[lane][1];
+    RasColor[RED_C][lane] = color[bpmem.tevksel[swaptable].swap1];
+    RasColor[GRN_C][lane] = color[bpmem.tevksel[swaptable].swap2];
     swaptable++;
-    RasColor[BLU_C] = color[bpmem.tevksel[swaptable].swap1];
-    RasColor[ALP_C] = color[bpmem.tevksel[swaptable].swap2];
+    RasColor[BLU_C][lane] = color[bpmem.tevksel[swaptable].swap1];
+    RasColor[ALP_C][lane] = color[bpmem.tevksel[swaptable].swap2];
   }
   break;
   case 5:  // alpha bump
   {
-    for (s16& comp : RasColor)
+    for (auto& comp : RasColor)
     {
-      comp = AlphaBump;
+      comp[lane] = AlphaBump[lane];
     }
   }
   break;
   case 6:  // alpha bump normalized
   {
-    const u8 normalized = AlphaBump | AlphaBump >> 5;
-    for (s16& comp : RasColor)
+    const u8 normalized = AlphaBump[lane] | AlphaBump[lane] >> 5;
+    for (auto& comp : RasColor)
     {
-      comp = normalized;
+      comp[lane] = normalized;
     }
   }
   break;
   default:  // zero
   {
-    for (s16& comp : RasColor)
+    for (auto& comp : RasColor)
     {
-      comp = 0;
+      comp[lane] = 0;
     }
   }
   break;
   }
 }
 
-void Tev::DrawColorRegular(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4])
+void Tev::GetInputs(const TevStageCombiner::ColorCombiner& cc,
+                    const TevStageCombiner::AlphaCombiner& ac, int lane, InputRegType inputs[4])
 {
   for (int i = 0; i < 3; i++)
   {
-    const InputRegType& InputReg = inputs[BLU_C + i];
-
-    const u16 c = InputReg.c + (InputReg.c >> 7);
-
-    s32 temp = InputReg.a * (256 - c) + (InputReg.b * c);
-    temp <<= m_ScaleLShiftLUT[cc.shift];
-    temp += (cc.shift == 3) ? 0 : (cc.op == 1) ? 127 : 128;
-    temp >>= 8;
-    temp = cc.op ? -temp : temp;
-
-    s32 result = ((InputReg.d + m_BiasLUT[cc.bias]) << m_ScaleLShiftLUT[cc.shift]) + temp;
-    result = result >> m_ScaleRShiftLUT[cc.shift];
+    inputs[BLU_C + i].a = m_ColorInputLUT[cc.a][i][lane];
+    inputs[BLU_C + i].b = m_ColorInputLUT[cc.b][i][lane];
+    inputs[BLU_C + i].c = m_ColorInputLUT[cc.c][i][lane];
+    inputs[BLU_C + i].d = m_ColorInputLUT[cc.d][i][lane];
+  }
+  inputs[ALP_C].a = m_AlphaInputLUT[ac.a][lane];
+  inputs[ALP_C].b = m_AlphaInputLUT[ac.b][lane];
+  inputs[ALP_C].c = m_AlphaInputLUT[ac.c][lane];
+  inputs[ALP_C].d = m_AlphaInputLUT[ac.d][lane];
+}
 
-    Reg[cc.dest][BLU_C + i] = result;
+void Tev::DrawColorRegular(const TevStageCombiner::ColorCombiner& cc)
+{
+  const s32 round = (cc.shift == 3) ? 0 : (cc.op == 1) ? 127 : 128;
+  for (int i = 0; i < 3; i++)
+  {
+    CombineLanes(Reg[cc.dest][BLU_C + i], m_ColorInputLUT[cc.a][i], m_ColorInputLUT[cc.b][i],
+                 m_ColorInputLUT[cc.c][i], m_ColorInputLUT[cc.d][i], m_BiasLUT[cc.bias],
+                 m_ScaleLShiftLUT[cc.shift], m_ScaleRShiftLUT[cc.shift], round, cc.op != 0,
+                 false);
   }
 }
 
-void Tev::DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4])
+void Tev::DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, int lane,
+                           const InputRegType inputs[4])
 {
   for (int i = BLU_C; i <= RED_C; i++)
   {
     switch ((cc.shift << 1) | cc.op | 8)  // encoded compare mode
     {
     case TEVCMP_R8_GT:
-      Reg[cc.dest][i] = inputs[i].d + ((inputs[RED_C].a > inputs[RED_C].b) ? inputs[i].c : 0);
+      Reg[cc.dest][i][lane] =
+          inputs[i].d + ((inputs[RED_C].a > inputs[RED_C].b) ? inputs[i].c : 0);
       break;
 
     case TEVCMP_R8_EQ:
-      Reg[cc.dest][i] = inputs[i].d + ((inputs[RED_C].a == inputs[RED_C].b) ? inputs[i].c : 0);
+      Reg[cc.dest][i][lane] =
+          inputs[i].d + ((inputs[RED_C].a == inputs[RED_C].b) ? inputs[i].c : 0);
       break;
 
     case TEVCMP_GR16_GT:
     {
       const u32 a = (inputs[GRN_C].a << 8) | inputs[RED_C].a;
       const u32 b = (inputs[GRN_C].b << 8) | inputs[RED_C].b;
-      Reg[cc.dest][i] = inputs[i].d + ((a > b) ? inputs[i].c : 0);
+      Reg[cc.dest][i][lane] = inputs[i].d + ((a > b) ? inputs[i].c : 0);
     }
     break;
 
@@ -268,7 +379,7 @@ void Tev::DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, const Inpu
     {
       const u32 a = (inputs[GRN_C].a << 8) | inputs[RED_C].a;
       const u32 b = (inputs[GRN_C].b << 8) | inputs[RED_C].b;
-      Reg[cc.dest][i] = inputs[i].d + ((a == b) ? inputs[i].c : 0);
+      Reg[cc.dest][i][lane] = inputs[i].d + ((a == b) ? inputs[i].c : 0);
     }
     break;
 
@@ -276,7 +387,7 @@ void Tev::DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, const Inpu
     {
       const u32 a = (inputs[BLU_C].a << 16) | (inputs[GRN_C].a << 8) | inputs[RED_C].a;
       const u32 b = (inputs[BLU_C].b << 16) | (inputs[GRN_C].b << 8) | inputs[RED_C].b;
-      Reg[cc.dest][i] = inputs[i].d + ((a > b) ? inputs[i].c : 0);
+      Reg[cc.dest][i][lane] = inputs[i].d + ((a > b) ? inputs[i].c : 0);
     }
     break;
 
@@ -284,49 +395,41 @@ void Tev::DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, const Inpu
     {
       const u32 a = (inputs[BLU_C].a << 16) | (inputs[GRN_C].a << 8) | inputs[RED_C].a;
       const u32 b = (inputs[BLU_C].b << 16) | (inputs[GRN_C].b << 8) | inputs[RED_C].b;
-      Reg[cc.dest][i] = inputs[i].d + ((a == b) ? inputs[i].c : 0);
+      Reg[cc.dest][i][lane] = inputs[i].d + ((a == b) ? inputs[i].c : 0);
     }
     break;
 
     case TEVCMP_RGB8_GT:
-      Reg[cc.dest][i] = inputs[i].d + ((inputs[i].a > inputs[i].b) ? inputs[i].c : 0);
+      Reg[cc.dest][i][lane] = inputs[i].d + ((inputs[i].a > inputs[i].b) ? inputs[i].c : 0);
       break;
 
     case TEVCMP_RGB8_EQ:
-      Reg[cc.dest][i] = inputs[i].d + ((inputs[i].a == inputs[i].b) ? inputs[i].c : 0);
+      Reg[cc.dest][i][lane] = inputs[i].d + ((inputs[i].a == inputs[i].b) ? inputs[i].c : 0);
       break;
     }
   }
 }
 
-void Tev::DrawAlphaRegular(const TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4])
+void Tev::DrawAlphaRegular(const TevStageCombiner::AlphaCombiner& ac)
 {
-  const InputRegType& InputReg = inputs[ALP_C];
-
-  const u16 c = InputReg.c + (InputReg.c >> 7);
-
-  s32 temp = InputReg.a * (256 - c) + (InputReg.b * c);
-  temp <<= m_ScaleLShiftLUT[ac.shift];
-  temp += (ac.shift != 3) ? 0 : (ac.op == 1) ? 127 : 128;
-  temp = ac.op ? (-temp >> 8) : (temp >> 8);
-
-  s32 result = ((InputReg.d + m_BiasLUT[ac.bias]) << m_ScaleLShiftLUT[ac.shift]) + temp;
-  result = result >> m_ScaleRShiftLUT[ac.shift];
-
-  Reg[ac.dest][ALP_C] = result;
+  const s32 round = (ac.shift != 3) ? 0 : (ac.op == 1) ? 127 : 128;
+  CombineLanes(Reg[ac.dest][ALP_C], m_AlphaInputLUT[ac.a], m_AlphaInputLUT[ac.b],
+               m_AlphaInputLUT[ac.c], m_AlphaInputLUT[ac.d], m_BiasLUT[ac.bias],
+               m_ScaleLShiftLUT[ac.shift], m_ScaleRShiftLUT[ac.shift], round, ac.op != 0, true);
 }
 
-void Tev::DrawAlphaCompare(const TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4])
+void Tev::DrawAlphaCompare(const TevStageCombiner::AlphaCombiner& ac, int lane,
+                           const InputRegType inputs[4])
 {
   switch ((ac.shift << 1) | ac.op | 8)  // encoded compare mode
   {
   case TEVCMP_R8_GT:
-    Reg[ac.dest][ALP_C] =
+    Reg[ac.dest][ALP_C][lane] =
         inputs[ALP_C].d + ((inputs[RED_C].a > inputs[RED_C].b) ? inputs[ALP_C].c : 0);
     break;
 
   case TEVCMP_R8_EQ:
-    Reg[ac.dest][ALP_C] =
+    Reg[ac.dest][ALP_C][lane] =
         inputs[ALP_C].d + ((inputs[RED_C].a == inputs[RED_C].b) ? inputs[ALP_C].c : 0);
     break;
 
@@ -334,7 +437,7 @@ void Tev::DrawAlphaCompare(const TevStageCombiner::AlphaCombiner& ac, const Inpu
   {
     const u32 a = (inputs[GRN_C].a << 8) | inputs[RED_C].a;
     const u32 b = (inputs[GRN_C].b << 8) | inputs[RED_C].b;
-    Reg[ac.dest][ALP_C] = inputs[ALP_C].d + ((a > b) ? inputs[ALP_C].c : 0);
+    Reg[ac.dest][ALP_C][lane] = inputs[ALP_C].d + ((a > b) ? inputs[ALP_C].c : 0);
   }
   break;
 
@@ -342,7 +445,7 @@ void Tev::DrawAlphaCompare(const TevStageCombiner::AlphaCombiner& ac, const Inpu
   {
     const u32 a = (inputs[GRN_C].a << 8) | inputs[RED_C].a;
     const u32 b = (inputs[GRN_C].b << 8) | inputs[RED_C].b;
-    Reg[ac.dest][ALP_C] = inputs[ALP_C].d + ((a == b) ? inputs[ALP_C].c : 0);
+    Reg[ac.dest][ALP_C][lane] = inputs[ALP_C].d + ((a == b) ? inputs[ALP_C].c : 0);
   }
   break;
 
@@ -350,7 +453,7 @@ void Tev::DrawAlphaCompare(const TevStageCombiner::AlphaCombiner& ac, const Inpu
   {
     const u32 a = (inputs[BLU_C].a << 16) | (inputs[GRN_C].a << 8) | inputs[RED_C].a;
     const u32 b = (inputs[BLU_C].b << 16) | (inputs[GRN_C].b << 8) | inputs[RED_C].b;
-    Reg[ac.dest][ALP_C] = inputs[ALP_C].d + ((a > b) ? inputs[ALP_C].c : 0);
+    Reg[ac.dest][ALP_C][lane] = inputs[ALP_C].d + ((a > b) ? inputs[ALP_C].c : 0);
   }
   break;
 
@@ -358,17 +461,17 @@ void Tev::DrawAlphaCompare(const TevStageCombiner::AlphaCombiner& ac, const Inpu
   {
     const u32 a = (inputs[BLU_C].a << 16) | (inputs[GRN_C].a << 8) | inputs[RED_C].a;
     const u32 b = (inputs[BLU_C].b << 16) | (inputs[GRN_C].b << 8) | inputs[RED_C].b;
-    Reg[ac.dest][ALP_C] = inputs[ALP_C].d + ((a == b) ? inputs[ALP_C].c : 0);
+    Reg[ac.dest][ALP_C][lane] = inputs[ALP_C].d + ((a == b) ? inputs[ALP_C].c : 0);
   }
   break;
 
   case TEVCMP_A8_GT:
-    Reg[ac.dest][ALP_C] =
+    Reg[ac.dest][ALP_C][lane] =
         inputs[ALP_C].d + ((inputs[ALP_C].a > inputs[ALP_C].b) ? inputs[ALP_C].c : 0);
     break;
 
   case TEVCMP_A8_EQ:
-    Reg[ac.dest][ALP_C] =
+    Reg[ac.dest][ALP_C][lane] =
         inputs[ALP_C].d + ((inputs[ALP_C].a == inputs[ALP_C].b) ? inputs[ALP_C].c : 0);
     break;
   }
@@ -442,10 +545,12 @@ static inline s32 WrapIndirectCoord(s32 coord, int wrapMode)
   }
 }
 
-void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
+void Tev::Indirect(int lane, unsigned int stageNum, s32 s, s32 t)
 {
   const TevStageIndirect& indirect = bpmem.tevind[stageNum];
-  const u8* indmap = IndirectTex[indirect.bt];
+  const u8* indmap = IndirectTex[lane][indirect.bt];
+  u8& alpha_bump = AlphaBump[lane];
+  TextureCoordinateType& tex_coord = TexCoord[lane];
 
   s32 indcoord[3];
 
@@ -453,16 +558,16 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
   switch (indirect.bs)
   {
   case ITBA_OFF:
-    AlphaBump = 0;
+    alpha_bump = 0;
     break;
   case ITBA_S:
-    AlphaBump = indmap[TextureSampler::ALP_SMP];
+    alpha_bump = indmap[TextureSampler::ALP_SMP];
     break;
   case ITBA_T:
-    AlphaBump = indmap[TextureSampler::BLU_SMP];
+    alpha_bump = indmap[TextureSampler::BLU_SMP];
     break;
   case ITBA_U:
-    AlphaBump = indmap[TextureSampler::GRN_SMP];
+    alpha_bump = indmap[TextureSampler::GRN_SMP];
     break;
   }
 
@@ -480,25 +585,25 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
     indcoord[0] = indmap[TextureSampler::ALP_SMP] + bias[0];
     indcoord[1] = indmap[TextureSampler::BLU_SMP] + bias[1];
     indcoord[2] = indmap[TextureSampler::GRN_SMP] + bias[2];
-    AlphaBump = AlphaBump & 0xf8;
+    alpha_bump = alpha_bump & 0xf8;
     break;
   case ITF_5:
     indcoord[0] = (indmap[TextureSampler::ALP_SMP] & 0x1f) + bias[0];
     indcoord[1] = (indmap[TextureSampler::BLU_SMP] & 0x1f) + bias[1];
     indcoord[2] = (indmap[TextureSampler::GRN_SMP] & 0x1f) + bias[2];
-    AlphaBump = AlphaBump & 0xe0;
+    alpha_bump = alpha_bump & 0xe0;
     break;
   case ITF_4:
     indcoord[0] = (indmap[TextureSampler::ALP_SMP] & 0x0f) + bias[0];
     indcoord[1] = (indmap[TextureSampler::BLU_SMP] & 0x0f) + bias[1];
     indcoord[2] = (indmap[TextureSampler::GRN_SMP] & 0x0f) + bias[2];
-    AlphaBump = AlphaBump & 0xf0;
+    alpha_bump = alpha_bump & 0xf0;
     break;
   case ITF_3:
     indcoord[0] = (indmap[TextureSampler::ALP_SMP] & 0x07) + bias[0];
     indcoord[1] = (indmap[TextureSampler::BLU_SMP] & 0x07) + bias[1];
     indcoord[2] = (indmap[TextureSampler::GRN_SMP] & 0x07) + bias[2];
-    AlphaBump = AlphaBump & 0xf8;
+    alpha_bump = alpha_bump & 0xf8;
     break;
   default:
     PanicAlert("Tev::Indirect");
@@ -552,32 +657,42 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
 
   if (indirect.fb_addprev)
   {
-    TexCoord.s += (int)(WrapIndirectCoord(s, indirect.sw) + indtevtrans[0]);
-    TexCoord.t += (int)(WrapIndirectCoord(t, indirect.tw) + indtevtrans[1]);
+    tex_coord.s += (int)(WrapIndirectCoord(s, indirect.sw) + indtevtrans[0]);
+    tex_coord.t += (int)(WrapIndirectCoord(t, indirect.tw) + indtevtrans[1]);
   }
   else
   {
-    TexCoord.s = (int)(WrapIndirectCoord(s, indirect.sw) + indtevtrans[0]);
-    TexCoord.t = (int)(WrapIndirectCoord(t, indirect.tw) + indtevtrans[1]);
+    tex_coord.s = (int)(WrapIndirectCoord(s, indirect.sw) + indtevtrans[0]);
+    tex_coord.t = (int)(WrapIndirectCoord(t, indirect.tw) + indtevtrans[1]);
   }
 }
 
-void Tev::Draw()
+void Tev::Draw(u32 mask)
 {
-  ASSERT(Position[0] >= 0 && Position[0] < EFB_WIDTH);
-  ASSERT(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
+  const BitSet32 lanes(mask);
+  for (int lane : lanes)
+  {
+    ASSERT(Position[lane][0] >= 0 && Position[lane][0] < EFB_WIDTH);
+    ASSERT(Position[lane][1] >= 0 && Position[lane][1] < EFB_HEIGHT);
+  }
 
-  INCSTAT(stats.thisFrame.tevPixelsIn);
+  PixelsIn += lanes.Count();
 
   // initial color values
   for (int i = 0; i < 4; i++)
   {
-    Reg[i][RED_C] = PixelShaderManager::constants.colors[i][0];
-    Reg[i][GRN_C] = PixelShaderManager::constants.colors[i][1];
-    Reg[i][BLU_C] = PixelShaderManager::constants.colors[i][2];
-    Reg[i][ALP_C] = PixelShaderManager::constants.colors[i][3];
+    std::fill_n(Reg[i][RED_C], NUM_LANES, PixelShaderManager::constants.colors[i][0]);
+    std::fill_n(Reg[i][GRN_C], NUM_LANES, PixelShaderManager::constants.colors[i][1]);
+    std::fill_n(Reg[i][BLU_C], NUM_LANES, PixelShaderManager::constants.colors[i][2]);
+    std::fill_n(Reg[i][ALP_C], NUM_LANES, PixelShaderManager::constants.colors[i][3]);
   }
 
+  // Stages can read these without having set them, so don't let them carry over from whatever
+  // pixel was drawn before.
+  std::memset(AlphaBump, 0, sizeof(AlphaBump));
+  std::memset(IndirectTex, 0, sizeof(IndirectTex));
+  std::memset(TexCoord, 0, sizeof(TexCoord));
+
   for (unsigned int stageNum = 0; stageNum < bpmem.genMode.numindstages; stageNum++)
   {
     const int stageNum2 = stageNum >> 1;
@@ -590,19 +705,22 @@ void Tev::Draw()
     const s32 scaleS = stageOdd ? texscale.ss1 : texscale.ss0;
     const s32 scaleT = stageOdd ? texscale.ts1 : texscale.ts0;
 
-    TextureSampler::Sample(Uv[texcoordSel].s >> scaleS, Uv[texcoordSel].t >> scaleT,
-                           IndirectLod[stageNum], IndirectLinear[stageNum], texmap,
-                           IndirectTex[stageNum]);
+    for (int lane : lanes)
+    {
+      TextureSampler::Sample(Uv[lane][texcoordSel].s >> scaleS, Uv[lane][texcoordSel].t >> scaleT,
+                             IndirectLod[stageNum], IndirectLinear[stageNum], texmap,
+                             IndirectTex[lane][stageNum]);
 
 #if ALLOW_TEV_DUMPS
-    if (g_ActiveConfig.bDumpTevStages)
-    {
-      u8 stage[4] = {IndirectTex[stageNum][TextureSampler::ALP_SMP],
-                     IndirectTex[stageNum][TextureSampler::BLU_SMP],
-                     IndirectTex[stageNum][TextureSampler::GRN_SMP], 255};
-      DebugUtil::DrawTempBuffer(stage, INDIRECT + stageNum);
-    }
+      if (g_ActiveConfig.bDumpTevStages)
+      {
+        u8 stage[4] = {IndirectTex[lane][stageNum][TextureSampler::ALP_SMP],
+                       IndirectTex[lane][stageNum][TextureSampler::BLU_SMP],
+                       IndirectTex[lane][stageNum][TextureSampler::GRN_SMP], 255};
+        DebugUtil::DrawTempBuffer(stage, INDIRECT + stageNum);
+      }
 #endif
+    }
   }
 
   for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
@@ -610,109 +728,145 @@ void Tev::Draw()
     const int stageNum2 = stageNum >> 1;
     const int stageOdd = stageNum & 1;
     const TwoTevStageOrders& order = bpmem.tevorders[stageNum2];
-    const TevKSel& kSel = bpmem.tevksel[stageNum2];
-
-    // stage combiners
-    const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
     const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
 
     const int texcoordSel = order.getTexCoord(stageOdd);
     const int texmap = order.getTexMap(stageOdd);
 
-    Indirect(stageNum, Uv[texcoordSel].s, Uv[texcoordSel].t);
-
-    // sample texture
-    if (order.getEnable(stageOdd))
+    s32(&TexColor)[4][NUM_LANES] = StageTexColor[stageNum];
+    for (int lane : lanes)
     {
-      // RGBA
-      u8 texel[4];
+      Indirect(lane, stageNum, Uv[lane][texcoordSel].s, Uv[lane][texcoordSel].t);
+
+      // sample texture
+      if (order.getEnable(stageOdd))
+      {
+        // RGBA
+        u8 texel[4];
 
-      TextureSampler::Sample(TexCoord.s, TexCoord.t, TextureLod[stageNum], TextureLinear[stageNum],
-                             texmap, texel);
+        TextureSampler::Sample(TexCoord[lane].s, TexCoord[lane].t, TextureLod[stageNum],
+                               TextureLinear[stageNum], texmap, texel);
 
 #if ALLOW_TEV_DUMPS
-      if (g_ActiveConfig.bDumpTevTextureFetches)
-        DebugUtil::DrawTempBuffer(texel, DIRECT_TFETCH + stageNum);
+        if (g_ActiveConfig.bDumpTevTextureFetches)
+          DebugUtil::DrawTempBuffer(texel, DIRECT_TFETCH + stageNum);
 #endif
 
-      int swaptable = ac.tswap * 2;
-
-      TexColor[RED_C] = texel[bpmem.tevksel[swaptable].swap1];
-      TexColor[GRN_C] = texel[bpmem.tevksel[swaptable].swap2];
-      swaptable++;
-      TexColor[BLU_C] = texel[bpmem.tevksel[swaptable].swap1];
-      TexColor[ALP_C] = texel[bpmem.tevksel[swaptable].swap2];
+        int swaptable = ac.tswap * 2;
+
+        TexColor[RED_C][lane] = texel[bpmem.tevksel[swaptable].swap1];
+        TexColor[GRN_C][lane] = texel[bpmem.tevksel[swaptable].swap2];
+        swaptable++;
+        TexColor[BLU_C][lane] = texel[bpmem.tevksel[swaptable].swap1];
+        TexColor[ALP_C][lane] = texel[bpmem.tevksel[swaptable].swap2];
+      }
+      else
+      {
+        // Stages without a texture see the one from the last stage that had one.
+        for (int comp = 0; comp < 4; comp++)
+          TexColor[comp][lane] = stageNum ? StageTexColor[stageNum - 1][comp][lane] : 0;
+      }
+
+      // set color
+      SetRasColor(stageNum, lane, order.getColorChan(stageOdd), ac.rswap * 2);
     }
+  }
+
+  // The compiled combiners don't dump the stages.
+  if (m_Combiners && !(ALLOW_TEV_DUMPS && g_ActiveConfig.bDumpTevStages))
+    m_Combiners(this);
+  else
+    DrawCombiners(mask);
+
+  for (int lane : lanes)
+    DrawOutput(lane);
+}
+
+void Tev::DrawCombiners(u32 mask)
+{
+  const BitSet32 lanes(mask);
+  for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+  {
+    const int stageOdd = stageNum & 1;
+    const TevKSel& kSel = bpmem.tevksel[stageNum >> 1];
+
+    // stage combiners
+    const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
+    const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
+
+    std::memcpy(TexColor, StageTexColor[stageNum], sizeof(TexColor));
+    std::memcpy(RasColor, StageRasColor[stageNum], sizeof(RasColor));
 
     // set konst for this stage
     const int kc = kSel.getKC(stageOdd);
     const int ka = kSel.getKA(stageOdd);
-    StageKonst[RED_C] = *(m_KonstLUT[kc][RED_C]);
-    StageKonst[GRN_C] = *(m_KonstLUT[kc][GRN_C]);
-    StageKonst[BLU_C] = *(m_KonstLUT[kc][BLU_C]);
-    StageKonst[ALP_C] = *(m_KonstLUT[ka][ALP_C]);
-
-    // set color
-    SetRasColor(order.getColorChan(stageOdd), ac.rswap * 2);
-
-    // combine inputs
-    InputRegType inputs[4];
-    for (int i = 0; i < 3; i++)
+    std::fill_n(StageKonst[RED_C], NUM_LANES, *(m_KonstLUT[kc][RED_C]));
+    std::fill_n(StageKonst[GRN_C], NUM_LANES, *(m_KonstLUT[kc][GRN_C]));
+    std::fill_n(StageKonst[BLU_C], NUM_LANES, *(m_KonstLUT[kc][BLU_C]));
+    std::fill_n(StageKonst[ALP_C], NUM_LANES, *(m_KonstLUT[ka][ALP_C]));
+
+    // The compare modes of the alpha combiner can read the color inputs, which have to be
+    // gathered before the color combiner overwrites them.
+    const bool color_compare = cc.bias == 3;
+    const bool alpha_compare = ac.bias == 3;
+    InputRegType inputs[NUM_LANES][4];
+    if (color_compare || alpha_compare)
     {
-      inputs[BLU_C + i].a = *m_ColorInputLUT[cc.a][i];
-      inputs[BLU_C + i].b = *m_ColorInputLUT[cc.b][i];
-      inputs[BLU_C + i].c = *m_ColorInputLUT[cc.c][i];
-      inputs[BLU_C + i].d = *m_ColorInputLUT[cc.d][i];
+      for (int lane : lanes)
+        GetInputs(cc, ac, lane, inputs[lane]);
     }
-    inputs[ALP_C].a = *m_AlphaInputLUT[ac.a];
-    inputs[ALP_C].b = *m_AlphaInputLUT[ac.b];
-    inputs[ALP_C].c = *m_AlphaInputLUT[ac.c];
-    inputs[ALP_C].d = *m_AlphaInputLUT[ac.d];
-
-    if (cc.bias != 3)
-      DrawColorRegular(cc, inputs);
-    else
-      DrawColorCompare(cc, inputs);
 
-    if (cc.clamp)
+    if (!color_compare)
     {
-      Reg[cc.dest][RED_C] = Clamp255(Reg[cc.dest][RED_C]);
-      Reg[cc.dest][GRN_C] = Clamp255(Reg[cc.dest][GRN_C]);
-      Reg[cc.dest][BLU_C] = Clamp255(Reg[cc.dest][BLU_C]);
+      DrawColorRegular(cc);
     }
     else
     {
-      Reg[cc.dest][RED_C] = Clamp1024(Reg[cc.dest][RED_C]);
-      Reg[cc.dest][GRN_C] = Clamp1024(Reg[cc.dest][GRN_C]);
-      Reg[cc.dest][BLU_C] = Clamp1024(Reg[cc.dest][BLU_C]);
+      for (int lane : lanes)
+        DrawColorCompare(cc, lane, inputs[lane]);
     }
 
-    if (ac.bias != 3)
-      DrawAlphaRegular(ac, inputs);
-    else
-      DrawAlphaCompare(ac, inputs);
+    ClampLanes(Reg[cc.dest][RED_C], cc.clamp);
+    ClampLanes(Reg[cc.dest][GRN_C], cc.clamp);
+    ClampLanes(Reg[cc.dest][BLU_C], cc.clamp);
 
-    if (ac.clamp)
-      Reg[ac.dest][ALP_C] = Clamp255(Reg[ac.dest][ALP_C]);
+    if (!alpha_compare)
+    {
+      DrawAlphaRegular(ac);
+    }
     else
-      Reg[ac.dest][ALP_C] = Clamp1024(Reg[ac.dest][ALP_C]);
+    {
+      for (int lane : lanes)
+        DrawAlphaCompare(ac, lane, inputs[lane]);
+    }
+
+    ClampLanes(Reg[ac.dest][ALP_C], ac.clamp);
 
 #if ALLOW_TEV_DUMPS
     if (g_ActiveConfig.bDumpTevStages)
     {
-      u8 stage[4] = {(u8)Reg[0][RED_C], (u8)Reg[0][GRN_C], (u8)Reg[0][BLU_C], (u8)Reg[0][ALP_C]};
-      DebugUtil::DrawTempBuffer(stage, DIRECT + stageNum);
+      for (int lane : lanes)
+      {
+        u8 stage[4] = {(u8)Reg[0][RED_C][lane], (u8)Reg[0][GRN_C][lane], (u8)Reg[0][BLU_C][lane],
+                       (u8)Reg[0][ALP_C][lane]};
+        DebugUtil::DrawTempBuffer(stage, DIRECT + stageNum);
+      }
     }
 #endif
   }
+}
+
+void Tev::DrawOutput(int lane)
+{
+  s32* position = Position[lane];
 
   // convert to 8 bits per component
   // the results of the last tev stage are put onto the screen,
   // regardless of the used destination register - TODO: Verify!
   const u32 color_index = bpmem.combiners[bpmem.genMode.numtevstages].colorC.dest;
   const u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
-  u8 output[4] = {(u8)Reg[alpha_index][ALP_C], (u8)Reg[color_index][BLU_C],
-                  (u8)Reg[color_index][GRN_C], (u8)Reg[color_index][RED_C]};
+  u8 output[4] = {(u8)Reg[alpha_index][ALP_C][lane], (u8)Reg[color_index][BLU_C][lane],
+                  (u8)Reg[color_index][GRN_C][lane], (u8)Reg[color_index][RED_C][lane]};
 
   if (!TevAlphaTest(output[ALP_C]))
     return;
@@ -720,24 +874,25 @@ void Tev::Draw()
   // z texture
   if (bpmem.ztex2.op)
   {
+    const s32(&TexColor)[4][NUM_LANES] = StageTexColor[bpmem.genMode.numtevstages];
     u32 ztex = bpmem.ztex1.bias;
     switch (bpmem.ztex2.type)
     {
     case 0:  // 8 bit
-      ztex += TexColor[ALP_C];
+      ztex += TexColor[ALP_C][lane];
       break;
     case 1:  // 16 bit
-      ztex += TexColor[ALP_C] << 8 | TexColor[RED_C];
+      ztex += TexColor[ALP_C][lane] << 8 | TexColor[RED_C][lane];
       break;
     case 2:  // 24 bit
-      ztex += TexColor[RED_C] << 16 | TexColor[GRN_C] << 8 | TexColor[BLU_C];
+      ztex += TexColor[RED_C][lane] << 16 | TexColor[GRN_C][lane] << 8 | TexColor[BLU_C][lane];
       break;
     }
 
     if (bpmem.ztex2.op == ZTEXTURE_ADD)
-      ztex += Position[2];
+      ztex += position[2];
 
-    Position[2] = ztex & 0x00ffffff;
+    position[2] = ztex & 0x00ffffff;
   }
 
   // fog
@@ -749,7 +904,7 @@ void Tev::Draw()
     {
       // perspective
       // ze = A/(B - (Zs >> B_SHF))
-      const s32 denom = bpmem.fog.b_magnitude - (Position[2] >> bpmem.fog.b_shift);
+      const s32 denom = bpmem.fog.b_magnitude - (position[2] >> bpmem.fog.b_shift);
       // in addition downscale magnitude and zs to 0.24 bits
       ze = (bpmem.fog.GetA() * 16777215.0f) / static_cast<float>(denom);
     }
@@ -758,7 +913,7 @@ void Tev::Draw()
       // orthographic
       // ze = a*Zs
       // in addition downscale zs to 0.24 bits
-      ze = bpmem.fog.GetA() * (static_cast<float>(Position[2]) / 16777215.0f);
+      ze = bpmem.fog.GetA() * (static_cast<float>(position[2]) / 16777215.0f);
     }
 
     if (bpmem.fogRange.Base.Enabled)
@@ -770,7 +925,7 @@ void Tev::Draw()
 
       // First, calculate the offset from the viewport center (normalized to 0..1)
       const float offset =
-          (Position[0] - (static_cast<s32>(bpmem.fogRange.Base.Center.Value()) - 342)) /
+          (position[0] - (static_cast<s32>(bpmem.fogRange.Base.Center.Value()) - 342)) /
           static_cast<float>(xfmem.viewport.wd);
 
       // Based on that, choose the index such that points which are far away from the z-axis use the
@@ -832,31 +987,31 @@ void Tev::Draw()
   if (late_ztest && bpmem.zmode.testenable)
   {
     // TODO: Check against hw if these values get incremented even if depth testing is disabled
-    EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT);
+    PerfQueryPixels[PQ_ZCOMP_INPUT]++;
 
-    if (!EfbInterface::ZCompare(Position[0], Position[1], Position[2]))
+    if (!EfbInterface::ZCompare(position[0], position[1], position[2]))
       return;
 
-    EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT);
+    PerfQueryPixels[PQ_ZCOMP_OUTPUT]++;
   }
 
   // branchless bounding box update
-  BoundingBox::coords[BoundingBox::LEFT] =
-      std::min((u16)Position[0], BoundingBox::coords[BoundingBox::LEFT]);
-  BoundingBox::coords[BoundingBox::RIGHT] =
-      std::max((u16)Position[0], BoundingBox::coords[BoundingBox::RIGHT]);
-  BoundingBox::coords[BoundingBox::TOP] =
-      std::min((u16)Position[1], BoundingBox::coords[BoundingBox::TOP]);
-  BoundingBox::coords[BoundingBox::BOTTOM] =
-      std::max((u16)Position[1], BoundingBox::coords[BoundingBox::BOTTOM]);
+  BoundingBoxCoords[BoundingBox::LEFT] =
+      std::min((u16)position[0], BoundingBoxCoords[BoundingBox::LEFT]);
+  BoundingBoxCoords[BoundingBox::RIGHT] =
+      std::max((u16)position[0], BoundingBoxCoords[BoundingBox::RIGHT]);
+  BoundingBoxCoords[BoundingBox::TOP] =
+      std::min((u16)position[1], BoundingBoxCoords[BoundingBox::TOP]);
+  BoundingBoxCoords[BoundingBox::BOTTOM] =
+      std::max((u16)position[1], BoundingBoxCoords[BoundingBox::BOTTOM]);
 
 #if ALLOW_TEV_DUMPS
   if (g_ActiveConfig.bDumpTevStages)
   {
     for (u32 i = 0; i < bpmem.genMode.numindstages; ++i)
-      DebugUtil::CopyTempBuffer(Position[0], Position[1], INDIRECT, i, "Indirect");
+      DebugUtil::CopyTempBuffer(position[0], position[1], INDIRECT, i, "Indirect");
     for (u32 i = 0; i <= bpmem.genMode.numtevstages; ++i)
-      DebugUtil::CopyTempBuffer(Position[0], Position[1], DIRECT, i, "Stage");
+      DebugUtil::CopyTempBuffer(position[0], position[1], DIRECT, i, "Stage");
   }
 
   if (g_ActiveConfig.bDumpTevTextureFetches)
@@ -865,15 +1020,33 @@ void Tev::Draw()
     {
       TwoTevStageOrders& order = bpmem.tevorders[i >> 1];
       if (order.getEnable(i & 1))
-        DebugUtil::CopyTempBuffer(Position[0], Position[1], DIRECT_TFETCH, i, "TFetch");
+        DebugUtil::CopyTempBuffer(position[0], position[1], DIRECT_TFETCH, i, "TFetch");
     }
   }
 #endif
 
-  INCSTAT(stats.thisFrame.tevPixelsOut);
-  EfbInterface::IncPerfCounterQuadCount(PQ_BLEND_INPUT);
+  PixelsOut++;
+  PerfQueryPixels[PQ_BLEND_INPUT]++;
+
+  EfbInterface::BlendTev(position[0], position[1], output);
+}
 
-  EfbInterface::BlendTev(Position[0], Position[1], output);
+void Tev::ResetCounters()
+{
+  PixelsIn = 0;
+  PixelsOut = 0;
+  std::fill(std::begin(PerfQueryPixels), std::end(PerfQueryPixels), 0);
+
+  // Empty, so that it doesn't change the global bounding box when merged into it.
+  BoundingBoxCoords[BoundingBox::LEFT] = 0xFFFF;
+  BoundingBoxCoords[BoundingBox::RIGHT] = 0;
+  BoundingBoxCoords[BoundingBox::TOP] = 0xFFFF;
+  BoundingBoxCoords[BoundingBox::BOTTOM] = 0;
+}
+
+void Tev::SetCombiners(CombinerFunction combiners)
+{
+  m_Combiners = combiners;
 }
 
 void Tev::SetRegColor(int reg, int comp, s16 color)
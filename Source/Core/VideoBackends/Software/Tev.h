@@ -4,10 +4,24 @@
 
 #pragma once
 
+#include "Common/CommonTypes.h"
 #include "VideoCommon/BPMemory.h"
+#include "VideoCommon/PerfQueryBase.h"
+
+class TevJit;
 
 class Tev
 {
+public:
+  // Pixels are drawn a 2x2 block at a time, one pixel per lane.
+  static constexpr int NUM_LANES = 4;
+
+  // Runs the combiners of all stages at once, see TevJit.
+  using CombinerFunction = void (*)(Tev* tev);
+
+private:
+  friend class TevJit;
+
   struct InputRegType
   {
     unsigned a : 8;
@@ -23,20 +37,26 @@ class Tev
   };
 
   // color order: ABGR
-  s16 Reg[4][4];
+  // The combiner inputs and outputs are kept as [component][lane], so that the combiners can
+  // work on one component of all pixels at once.
+  alignas(16) s32 Reg[4][4][NUM_LANES];
+  alignas(16) s32 TexColor[4][NUM_LANES];
+  alignas(16) s32 RasColor[4][NUM_LANES];
+  alignas(16) s32 StageKonst[4][NUM_LANES];
+  alignas(16) s32 FixedInputs[3][NUM_LANES];  // one, half, zero
+  // The texture and rasterized colors don't depend on the combiners, so they're looked up for
+  // all stages before combining. TexColor and RasColor are set from these for each stage.
+  alignas(16) s32 StageTexColor[16][4][NUM_LANES];
+  alignas(16) s32 StageRasColor[16][4][NUM_LANES];
   s16 KonstantColors[4][4];
-  s16 TexColor[4];
-  s16 RasColor[4];
-  s16 StageKonst[4];
-  s16 Zero16[4];
 
   s16 FixedConstants[9];
-  u8 AlphaBump;
-  u8 IndirectTex[4][4];
-  TextureCoordinateType TexCoord;
+  u8 AlphaBump[NUM_LANES];
+  u8 IndirectTex[NUM_LANES][4][4];
+  TextureCoordinateType TexCoord[NUM_LANES];
 
-  s16* m_ColorInputLUT[16][3];
-  s16* m_AlphaInputLUT[8];  // values must point to ABGR color
+  const s32* m_ColorInputLUT[16][3];
+  const s32* m_AlphaInputLUT[8];  // values must point to ABGR color
   s16* m_KonstLUT[32][4];
   s16 m_BiasLUT[4];
   u8 m_ScaleLShiftLUT[4];
@@ -57,24 +77,42 @@ class Tev
     INDIRECT = 32
   };
 
-  void SetRasColor(int colorChan, int swaptable);
+  void SetRasColor(int stage, int lane, int colorChan, int swaptable);
+
+  void GetInputs(const TevStageCombiner::ColorCombiner& cc,
+                 const TevStageCombiner::AlphaCombiner& ac, int lane, InputRegType inputs[4]);
+  void DrawColorRegular(const TevStageCombiner::ColorCombiner& cc);
+  void DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, int lane,
+                        const InputRegType inputs[4]);
+  void DrawAlphaRegular(const TevStageCombiner::AlphaCombiner& ac);
+  void DrawAlphaCompare(const TevStageCombiner::AlphaCombiner& ac, int lane,
+                        const InputRegType inputs[4]);
 
-  void DrawColorRegular(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
-  void DrawColorCompare(const TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
-  void DrawAlphaRegular(const TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4]);
-  void DrawAlphaCompare(const TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4]);
+  void Indirect(int lane, unsigned int stageNum, s32 s, s32 t);
 
-  void Indirect(unsigned int stageNum, s32 s, s32 t);
+  void DrawCombiners(u32 mask);
+  void DrawOutput(int lane);
+
+  CombinerFunction m_Combiners = nullptr;
 
 public:
-  s32 Position[3];
-  u8 Color[2][4];  // must be RGBA for correct swap table ordering
-  TextureCoordinateType Uv[8];
+  s32 Position[NUM_LANES][3];
+  u8 Color[NUM_LANES][2][4];  // must be RGBA for correct swap table ordering
+  TextureCoordinateType Uv[NUM_LANES][8];
+
+  // Shared by all pixels of the block
   s32 IndirectLod[4];
   bool IndirectLinear[4];
   s32 TextureLod[16];
   bool TextureLinear[16];
 
+  // The rasterizer draws with several instances at once, so these are gathered per instance
+  // and added to the statistics, the perf counters and the bounding box by the rasterizer.
+  u32 PixelsIn;
+  u32 PixelsOut;
+  u32 PerfQueryPixels[PQ_NUM_MEMBERS];
+  u16 BoundingBoxCoords[4];
+
   enum
   {
     ALP_C,
@@ -85,7 +123,13 @@ public:
 
   void Init();
 
-  void Draw();
+  // Draws the pixels whose lane bit is set in mask.
+  void Draw(u32 mask);
+
+  void ResetCounters();
+
+  // Compiled combiners for the current TEV configuration, or nullptr to interpret them.
+  void SetCombiners(CombinerFunction combiners);
 
   void SetRegColor(int reg, int comp, s16 color);
 };
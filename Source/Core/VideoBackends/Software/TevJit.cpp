@@ -0,0 +1,234 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoBackends/Software/TevJit.h"
+
+#include "Common/CommonTypes.h"
+#include "Common/JitRegister.h"
+#include "Common/x64ABI.h"
+#include "Common/x64Emitter.h"
+#include "VideoCommon/BPMemory.h"
+
+using namespace Gen;
+
+// The generated code only uses registers that are caller saved on all x64 ABIs.
+static const X64Reg tev_reg = ABI_PARAM1;
+static const X64Reg scratch_reg = RAX;
+
+// Each compiled configuration takes a few KiB at most.
+static constexpr size_t CODE_SIZE = 1024 * 1024;
+static constexpr size_t MAX_CACHED_CONFIGURATIONS = 256;
+
+static constexpr s32 CONSTANT_VALUES[] = {0xFF, 256, 127, 128, 128, -128, 255, 0, 1023, -1024};
+
+TevJit::TevJit()
+{
+  AllocCodeSpace(CODE_SIZE);
+  ClearCache();
+}
+
+void TevJit::ClearCache()
+{
+  m_cache.clear();
+  ClearCodeSpace();
+
+  // Kept in the code space, so that they are always in range of RIP relative addressing.
+  m_constants = AlignCode16();
+  for (s32 value : CONSTANT_VALUES)
+  {
+    for (int lane = 0; lane < Tev::NUM_LANES; lane++)
+      Write32(static_cast<u32>(value));
+  }
+}
+
+OpArg TevJit::MConst(Constant constant) const
+{
+  return M(m_constants + constant * Tev::NUM_LANES * sizeof(s32));
+}
+
+TevJit::Key TevJit::GetKey()
+{
+  Key key{};
+  key[0] = bpmem.genMode.numtevstages;
+  for (u32 stage = 0; stage <= bpmem.genMode.numtevstages; stage++)
+  {
+    const TevKSel& ksel = bpmem.tevksel[stage >> 1];
+    key[1 + stage * 3] = bpmem.combiners[stage].colorC.hex;
+    // Without the swap table selection
+    key[2 + stage * 3] = bpmem.combiners[stage].alphaC.hex & ~0xF;
+    key[3 + stage * 3] = ksel.getKC(stage & 1) | ksel.getKA(stage & 1) << 8;
+  }
+  return key;
+}
+
+bool TevJit::CanCompile()
+{
+  // The compare modes are rare enough to leave to the interpreter.
+  for (u32 stage = 0; stage <= bpmem.genMode.numtevstages; stage++)
+  {
+    if (bpmem.combiners[stage].colorC.bias == 3 || bpmem.combiners[stage].alphaC.bias == 3)
+      return false;
+  }
+  return true;
+}
+
+Tev::CombinerFunction TevJit::GetCombiners(const Tev& tev)
+{
+  const Key key = GetKey();
+  const auto iter = m_cache.find(key);
+  if (iter != m_cache.end())
+    return iter->second;
+
+  if (m_cache.size() >= MAX_CACHED_CONFIGURATIONS || IsAlmostFull())
+    ClearCache();
+
+  const Tev::CombinerFunction combiners = CanCompile() ? Compile(tev) : nullptr;
+  m_cache.emplace(key, combiners);
+  return combiners;
+}
+
+void TevJit::LoadLanes(X64Reg reg, const Tev& tev, const s32* lanes, int stage, int kc, int ka)
+{
+  // The input tables of the interpreter point to the colors of the current stage and to the
+  // konst color it copies for each stage. The colors of all stages are kept side by side.
+  if (lanes >= tev.StageKonst[0] && lanes < tev.StageKonst[4])
+  {
+    const int comp = static_cast<int>(lanes - tev.StageKonst[0]) / Tev::NUM_LANES;
+    const s16* konst = tev.m_KonstLUT[comp == Tev::ALP_C ? ka : kc][comp];
+    MOVSX(32, 16, scratch_reg, MDisp(tev_reg, PtrOffset(konst, &tev)));
+    MOVD_xmm(reg, R(scratch_reg));
+    PSHUFD(reg, R(reg), 0);
+    return;
+  }
+
+  if (lanes >= tev.TexColor[0] && lanes < tev.TexColor[4])
+    lanes = tev.StageTexColor[stage][0] + (lanes - tev.TexColor[0]);
+  else if (lanes >= tev.RasColor[0] && lanes < tev.RasColor[4])
+    lanes = tev.StageRasColor[stage][0] + (lanes - tev.RasColor[0]);
+
+  MOVDQA(reg, MDisp(tev_reg, PtrOffset(lanes, &tev)));
+}
+
+// Emits the same steps as CombineLanes in Tev.cpp, with everything that only depends on the
+// configuration resolved up front. The result is left in XMM1 and stored to dest.
+void TevJit::CombineComponent(const Tev& tev, int stage, int kc, int ka, const s32* dest,
+                              const s32* a, const s32* b, const s32* c, const s32* d, int bias,
+                              int shift, bool negate, bool negate_before_divide, s32 round,
+                              bool clamp)
+{
+  const u8 lshift = tev.m_ScaleLShiftLUT[shift];
+  const u8 rshift = tev.m_ScaleRShiftLUT[shift];
+  const s32* zero = tev.FixedInputs[2];
+
+  // With both a and b zero, only the rounding is left of the lerp.
+  const bool constant_lerp = a == zero && b == zero;
+  s32 lerp = 0;
+  if (constant_lerp)
+  {
+    lerp = negate_before_divide ? (negate ? -round : round) >> 8 :
+                                  (negate ? -(round >> 8) : round >> 8);
+  }
+  else
+  {
+    LoadLanes(XMM0, tev, a, stage, kc, ka);
+    PAND(XMM0, MConst(CONST_MASK_8BIT));
+    LoadLanes(XMM1, tev, b, stage, kc, ka);
+    PAND(XMM1, MConst(CONST_MASK_8BIT));
+    PSLLD(XMM1, 16);
+    POR(XMM0, R(XMM1));
+
+    LoadLanes(XMM1, tev, c, stage, kc, ka);
+    PAND(XMM1, MConst(CONST_MASK_8BIT));
+    MOVDQA(XMM2, R(XMM1));
+    PSRLD(XMM2, 7);
+    PADDD(XMM1, R(XMM2));
+    MOVDQA(XMM2, MConst(CONST_256));
+    PSUBD(XMM2, R(XMM1));
+    PSLLD(XMM1, 16);
+    POR(XMM1, R(XMM2));
+
+    PMADDWD(XMM0, R(XMM1));
+    if (lshift != 0)
+      PSLLD(XMM0, lshift);
+    if (round != 0)
+      PADDD(XMM0, MConst(round == 127 ? CONST_ROUND_127 : CONST_ROUND_128));
+
+    const auto negate_lerp = [this] {
+      PXOR(XMM2, R(XMM2));
+      PSUBD(XMM2, R(XMM0));
+      MOVDQA(XMM0, R(XMM2));
+    };
+    if (negate && negate_before_divide)
+      negate_lerp();
+    PSRAD(XMM0, 8);
+    if (negate && !negate_before_divide)
+      negate_lerp();
+  }
+
+  LoadLanes(XMM1, tev, d, stage, kc, ka);
+  PSLLD(XMM1, 21);
+  PSRAD(XMM1, 21);
+  if (tev.m_BiasLUT[bias] != 0)
+    PADDD(XMM1, MConst(tev.m_BiasLUT[bias] > 0 ? CONST_BIAS_128 : CONST_BIAS_NEG_128));
+  if (lshift != 0)
+    PSLLD(XMM1, lshift);
+  if (!constant_lerp)
+  {
+    PADDD(XMM1, R(XMM0));
+  }
+  else if (lerp != 0)
+  {
+    MOV(32, R(scratch_reg), Imm32(static_cast<u32>(lerp)));
+    MOVD_xmm(XMM0, R(scratch_reg));
+    PSHUFD(XMM0, R(XMM0), 0);
+    PADDD(XMM1, R(XMM0));
+  }
+  if (rshift != 0)
+    PSRAD(XMM1, rshift);
+
+  // Truncate to 16 bits and clamp. The values are sign extended to 32 bits here, so a signed
+  // 16 bit min and max with the sign extended bounds also gets the upper halves right.
+  PSLLD(XMM1, 16);
+  PSRAD(XMM1, 16);
+  PMINSW(XMM1, MConst(clamp ? CONST_MAX_255 : CONST_MAX_1023));
+  PMAXSW(XMM1, MConst(clamp ? CONST_MIN_0 : CONST_MIN_NEG_1024));
+
+  MOVDQA(MDisp(tev_reg, PtrOffset(dest, &tev)), XMM1);
+}
+
+Tev::CombinerFunction TevJit::Compile(const Tev& tev)
+{
+  AlignCode16();
+  const u8* start = GetCodePtr();
+
+  for (u32 stage = 0; stage <= bpmem.genMode.numtevstages; stage++)
+  {
+    const TevKSel& ksel = bpmem.tevksel[stage >> 1];
+    const int kc = ksel.getKC(stage & 1);
+    const int ka = ksel.getKA(stage & 1);
+
+    const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stage].colorC;
+    const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stage].alphaC;
+
+    const s32 color_round = (cc.shift == 3) ? 0 : (cc.op == 1) ? 127 : 128;
+    for (int i = 0; i < 3; i++)
+    {
+      CombineComponent(tev, stage, kc, ka, tev.Reg[cc.dest][Tev::BLU_C + i],
+                       tev.m_ColorInputLUT[cc.a][i], tev.m_ColorInputLUT[cc.b][i],
+                       tev.m_ColorInputLUT[cc.c][i], tev.m_ColorInputLUT[cc.d][i], cc.bias,
+                       cc.shift, cc.op != 0, false, color_round, cc.clamp != 0);
+    }
+
+    const s32 alpha_round = (ac.shift != 3) ? 0 : (ac.op == 1) ? 127 : 128;
+    CombineComponent(tev, stage, kc, ka, tev.Reg[ac.dest][Tev::ALP_C],
+                     tev.m_AlphaInputLUT[ac.a], tev.m_AlphaInputLUT[ac.b],
+                     tev.m_AlphaInputLUT[ac.c], tev.m_AlphaInputLUT[ac.d], ac.bias, ac.shift,
+                     ac.op != 0, true, alpha_round, ac.clamp != 0);
+  }
+
+  RET();
+
+  JitRegister::Register(start, GetCodePtr(), "VideoSW_TevCombiners_%zu", m_cache.size());
+  return reinterpret_cast<Tev::CombinerFunction>(start);
+}
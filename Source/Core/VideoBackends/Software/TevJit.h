@@ -0,0 +1,60 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <map>
+
+#include "Common/CommonTypes.h"
+#include "Common/x64Emitter.h"
+#include "VideoBackends/Software/Tev.h"
+
+// Compiles the color and alpha combiners of all TEV stages into one function per configuration,
+// with the inputs, scales and clamps of each stage built in. The texture and rasterized colors
+// are still gathered by Tev::Draw before the combiners run, and everything after them is
+// still interpreted.
+class TevJit : public Gen::X64CodeBlock
+{
+public:
+  TevJit();
+
+  // Returns the combiners for the current BP state, compiling them if they aren't cached yet.
+  // Returns nullptr for configurations that must be interpreted.
+  Tev::CombinerFunction GetCombiners(const Tev& tev);
+
+private:
+  // The number of stages, then for each stage the color and alpha combiner and the konst
+  // selection. The swap tables only affect the colors gathered before combining.
+  using Key = std::array<u32, 1 + 16 * 3>;
+
+  enum Constant
+  {
+    CONST_MASK_8BIT,
+    CONST_256,
+    CONST_ROUND_127,
+    CONST_ROUND_128,
+    CONST_BIAS_128,
+    CONST_BIAS_NEG_128,
+    CONST_MAX_255,
+    CONST_MIN_0,
+    CONST_MAX_1023,
+    CONST_MIN_NEG_1024,
+    NUM_CONSTANTS
+  };
+
+  static Key GetKey();
+  static bool CanCompile();
+
+  void ClearCache();
+  Tev::CombinerFunction Compile(const Tev& tev);
+  void LoadLanes(Gen::X64Reg reg, const Tev& tev, const s32* lanes, int stage, int kc, int ka);
+  void CombineComponent(const Tev& tev, int stage, int kc, int ka, const s32* dest,
+                        const s32* a, const s32* b, const s32* c, const s32* d, int bias,
+                        int shift, bool negate, bool negate_before_divide, s32 round, bool clamp);
+  Gen::OpArg MConst(Constant constant) const;
+
+  std::map<Key, Tev::CombinerFunction> m_cache;
+  const u8* m_constants = nullptr;
+};
@@ -5,19 +5,209 @@
 #include "VideoBackends/Software/TextureSampler.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+#include "Common/Intrinsics.h"
 #include "Core/HW/Memmap.h"
 
 #include "VideoCommon/BPMemory.h"
 #include "VideoCommon/SamplerCommon.h"
 #include "VideoCommon/TextureDecoder.h"
+#include "VideoCommon/VideoConfig.h"
 
 #define ALLOW_MIPMAP 1
 
 namespace TextureSampler
 {
+namespace
+{
+// Where one mip level of a texture map is, as set up by the BP registers.
+struct TextureLevel
+{
+  const u8* src;
+  const u8* src_odd;  // only for RGBA8 textures in TMEM
+  int width;          // largest coordinates, like in TexImage0
+  int height;
+  TextureFormat format;
+  const u8* tlut;
+  TLUTFormat tlut_format;
+};
+
+// A mip level decoded to RGBA8 in whole blocks, so the stride can be wider than the level.
+struct DecodedLevel
+{
+  std::vector<u8> texels;
+  int stride;
+  u64 last_used;
+};
+
+// The texture format overlay is drawn into the decoded levels, so its options are part of the key.
+using DecodedLevelKey =
+    std::tuple<const u8*, const u8*, int, int, TextureFormat, TLUTFormat, u64, bool, bool>;
+}  // namespace
+
+// Real textures are at most 1024x1024, which is 11 levels. Anything past those is decoded
+// texel by texel, as it reads past the end of the texture anyway.
+static constexpr int MAX_DECODED_LEVELS = 11;
+// Levels that weren't used by the last draw are dropped once the cache is this large.
+static constexpr size_t MAX_CACHE_SIZE = 64 * 1024 * 1024;
+
+static std::mutex s_cache_lock;
+static std::map<DecodedLevelKey, DecodedLevel> s_cache;
+static size_t s_cache_size = 0;
+static u64 s_draw_count = 0;
+// The levels looked up for the current draw, per texture map. The tiles are drawn on several
+// threads, so they're filled in as they are first sampled.
+static std::array<std::array<std::atomic<const DecodedLevel*>, MAX_DECODED_LEVELS>, 8>
+    s_bound_levels;
+
+void InvalidateBindings()
+{
+  std::lock_guard<std::mutex> lk(s_cache_lock);
+  for (auto& levels : s_bound_levels)
+  {
+    for (auto& level : levels)
+      level.store(nullptr, std::memory_order_relaxed);
+  }
+
+  s_draw_count++;
+  if (s_cache_size <= MAX_CACHE_SIZE)
+    return;
+
+  for (auto it = s_cache.begin(); it != s_cache.end();)
+  {
+    if (it->second.last_used + 1 < s_draw_count)
+    {
+      s_cache_size -= it->second.texels.size();
+      it = s_cache.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+void Shutdown()
+{
+  std::lock_guard<std::mutex> lk(s_cache_lock);
+  for (auto& levels : s_bound_levels)
+  {
+    for (auto& level : levels)
+      level.store(nullptr, std::memory_order_relaxed);
+  }
+  s_cache.clear();
+  s_cache_size = 0;
+}
+
+static bool IsDecodable(TextureFormat format)
+{
+  switch (format)
+  {
+  case TextureFormat::I4:
+  case TextureFormat::I8:
+  case TextureFormat::IA4:
+  case TextureFormat::IA8:
+  case TextureFormat::RGB565:
+  case TextureFormat::RGB5A3:
+  case TextureFormat::RGBA8:
+  case TextureFormat::C4:
+  case TextureFormat::C8:
+  case TextureFormat::C14X2:
+  case TextureFormat::CMPR:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Decodes a whole level, or finds it in the cache. The cache lock must be held. Like the texture
+// cache of the hardware backends, the texture data and the palette are hashed, since either can
+// change in memory without the BP registers changing.
+static const DecodedLevel* DecodeLevel(const TextureLevel& level)
+{
+  int width;
+  int height;
+  u64 hash;
+  if (level.src_odd)
+  {
+    // DecodeTexelRGBA8FromTmem takes the stride from the largest coordinate, so keep it as is.
+    width = level.width + 1;
+    height = level.height + 1;
+    const int blocks = ((level.width >> 2) + 1) * ((level.height >> 2) + 1);
+    hash = Common::GetHash64(level.src, blocks * 32, 0) ^
+           Common::GetHash64(level.src_odd, blocks * 32, 0);
+  }
+  else
+  {
+    const int block_width = TexDecoder_GetBlockWidthInTexels(level.format);
+    const int block_height = TexDecoder_GetBlockHeightInTexels(level.format);
+    width = (level.width / block_width + 1) * block_width;
+    height = (level.height / block_height + 1) * block_height;
+    hash = Common::GetHash64(level.src,
+                             TexDecoder_GetTextureSizeInBytes(width, height, level.format), 0);
+    if (IsColorIndexed(level.format))
+      hash ^= Common::GetHash64(level.tlut, TexDecoder_GetPaletteSize(level.format), 0);
+  }
+
+  const DecodedLevelKey key(level.src, level.src_odd, width, height, level.format,
+                            level.tlut_format, hash, g_ActiveConfig.bTexFmtOverlayEnable,
+                            g_ActiveConfig.bTexFmtOverlayCenter);
+  auto it = s_cache.find(key);
+  if (it == s_cache.end())
+  {
+    DecodedLevel decoded;
+    decoded.texels.resize(width * height * 4);
+    decoded.stride = width;
+    if (level.src_odd)
+    {
+      TexDecoder_DecodeRGBA8FromTmem(decoded.texels.data(), level.src, level.src_odd, width,
+                                     height);
+    }
+    else
+    {
+      TexDecoder_Decode(decoded.texels.data(), level.src, width, height, level.format, level.tlut,
+                        level.tlut_format);
+    }
+
+    s_cache_size += decoded.texels.size();
+    it = s_cache.emplace(key, std::move(decoded)).first;
+  }
+
+  it->second.last_used = s_draw_count;
+  return &it->second;
+}
+
+// Returns the decoded level, or nullptr if it has to be decoded texel by texel.
+static const DecodedLevel* GetDecodedLevel(u8 texmap, s32 mip, const TextureLevel& level)
+{
+  if (mip >= MAX_DECODED_LEVELS || !level.src || !IsDecodable(level.format))
+    return nullptr;
+
+  std::atomic<const DecodedLevel*>& bound = s_bound_levels[texmap][mip];
+  const DecodedLevel* decoded = bound.load(std::memory_order_acquire);
+  if (decoded)
+    return decoded;
+
+  std::lock_guard<std::mutex> lk(s_cache_lock);
+  decoded = bound.load(std::memory_order_relaxed);
+  if (!decoded)
+  {
+    decoded = DecodeLevel(level);
+    bound.store(decoded, std::memory_order_release);
+  }
+  return decoded;
+}
+
 static inline void WrapCoord(int* coordp, int wrapMode, int imageSize)
 {
   int coord = *coordp;
@@ -103,52 +293,49 @@ void Sample(s32 s, s32 t, s32 lod, bool linear, u8 texmap, u8* sample)
   }
 }
 
-void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8* sample)
+static void GetLevel(u8 texmap, s32 mip, TextureLevel* level)
 {
   const FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
   const u8 subTexmap = texmap & 3;
 
-  const TexMode0& tm0 = texUnit.texMode0[subTexmap];
   const TexImage0& ti0 = texUnit.texImage0[subTexmap];
   const TexTLUT& texTlut = texUnit.texTlut[subTexmap];
   const TextureFormat texfmt = static_cast<TextureFormat>(ti0.format);
-  const TLUTFormat tlutfmt = static_cast<TLUTFormat>(texTlut.tlut_format);
 
-  const u8* imageSrc;
-  const u8* imageSrcOdd = nullptr;
+  level->format = texfmt;
+  level->tlut_format = static_cast<TLUTFormat>(texTlut.tlut_format);
+  level->src_odd = nullptr;
   if (texUnit.texImage1[subTexmap].image_type)
   {
-    imageSrc = &texMem[texUnit.texImage1[subTexmap].tmem_even * TMEM_LINE_SIZE];
+    level->src = &texMem[texUnit.texImage1[subTexmap].tmem_even * TMEM_LINE_SIZE];
     if (texfmt == TextureFormat::RGBA8)
-      imageSrcOdd = &texMem[texUnit.texImage2[subTexmap].tmem_odd * TMEM_LINE_SIZE];
+      level->src_odd = &texMem[texUnit.texImage2[subTexmap].tmem_odd * TMEM_LINE_SIZE];
   }
   else
   {
     const u32 imageBase = texUnit.texImage3[subTexmap].image_base << 5;
-    imageSrc = Memory::GetPointer(imageBase);
+    level->src = Memory::GetPointer(imageBase);
   }
 
-  int imageWidth = ti0.width;
-  int imageHeight = ti0.height;
+  level->width = ti0.width;
+  level->height = ti0.height;
 
   const int tlutAddress = texTlut.tmem_offset << 9;
-  const u8* tlut = &texMem[tlutAddress];
+  level->tlut = &texMem[tlutAddress];
 
-  // reduce sample location and texture size to mip level
+  // reduce texture size to mip level
   // move texture pointer to mip location
   if (mip)
   {
-    int mipWidth = imageWidth + 1;
-    int mipHeight = imageHeight + 1;
+    int mipWidth = level->width + 1;
+    int mipHeight = level->height + 1;
 
     const int fmtWidth = TexDecoder_GetBlockWidthInTexels(texfmt);
     const int fmtHeight = TexDecoder_GetBlockHeightInTexels(texfmt);
     const int fmtDepth = TexDecoder_GetTexelSizeInNibbles(texfmt);
 
-    imageWidth >>= mip;
-    imageHeight >>= mip;
-    s >>= mip;
-    t >>= mip;
+    level->width >>= mip;
+    level->height >>= mip;
 
     while (mip)
     {
@@ -156,12 +343,72 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8* sample)
       mipHeight = std::max(mipHeight, fmtHeight);
       const u32 size = (mipWidth * mipHeight * fmtDepth) >> 1;
 
-      imageSrc += size;
+      level->src += size;
       mipWidth >>= 1;
       mipHeight >>= 1;
       mip--;
     }
   }
+}
+
+static inline void GetTexel(const TextureLevel& level, const DecodedLevel* decoded, int s, int t,
+                            u8* texel)
+{
+  if (decoded)
+    std::memcpy(texel, &decoded->texels[(t * decoded->stride + s) * 4], 4);
+  else if (level.src_odd)
+    TexDecoder_DecodeTexelRGBA8FromTmem(texel, level.src, level.src_odd, s, t, level.width);
+  else
+    TexDecoder_DecodeTexel(texel, level.src, s, t, level.width, level.format, level.tlut,
+                           level.tlut_format);
+}
+
+// Weights are in 0.14 fixed point and add up to 1.
+static inline void Bilinear(const u8* texel00, const u8* texel10, const u8* texel01,
+                            const u8* texel11, u32 weight00, u32 weight10, u32 weight01,
+                            u32 weight11, u8* sample)
+{
+#ifdef _M_X86
+  // Interleave the texels of each row, so that a multiply-add of 16 bit pairs gives the sum of
+  // both for each component.
+  const __m128i zero = _mm_setzero_si128();
+  u32 t00, t10, t01, t11;
+  std::memcpy(&t00, texel00, sizeof(u32));
+  std::memcpy(&t10, texel10, sizeof(u32));
+  std::memcpy(&t01, texel01, sizeof(u32));
+  std::memcpy(&t11, texel11, sizeof(u32));
+  const __m128i row0 = _mm_unpacklo_epi8(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(t00), _mm_cvtsi32_si128(t10)), zero);
+  const __m128i row1 = _mm_unpacklo_epi8(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(t01), _mm_cvtsi32_si128(t11)), zero);
+  __m128i sum = _mm_add_epi32(_mm_madd_epi16(row0, _mm_set1_epi32(weight00 | weight10 << 16)),
+                              _mm_madd_epi16(row1, _mm_set1_epi32(weight01 | weight11 << 16)));
+  sum = _mm_srli_epi32(sum, 14);
+  sum = _mm_packus_epi16(_mm_packs_epi32(sum, zero), zero);
+  const u32 result = _mm_cvtsi128_si32(sum);
+  std::memcpy(sample, &result, sizeof(u32));
+#else
+  for (int i = 0; i < 4; i++)
+  {
+    const u32 value = texel00[i] * weight00 + texel10[i] * weight10 + texel01[i] * weight01 +
+                      texel11[i] * weight11;
+    sample[i] = (u8)(value >> 14);
+  }
+#endif
+}
+
+void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8* sample)
+{
+  const FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
+  const TexMode0& tm0 = texUnit.texMode0[texmap & 3];
+
+  TextureLevel level;
+  GetLevel(texmap, mip, &level);
+  const DecodedLevel* decoded = GetDecodedLevel(texmap, mip, level);
+
+  // reduce sample location to mip level
+  s >>= mip;
+  t >>= mip;
 
   if (linear)
   {
@@ -175,60 +422,24 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8* sample)
 
     // linear sampling
     int imageSPlus1 = imageS + 1;
-    const int fractS = s & 0x7f;
+    const u32 fractS = s & 0x7f;
 
     int imageTPlus1 = imageT + 1;
-    const int fractT = t & 0x7f;
+    const u32 fractT = t & 0x7f;
 
-    u8 sampledTex[4];
-    u32 texel[4];
-
-    WrapCoord(&imageS, tm0.wrap_s, imageWidth);
-    WrapCoord(&imageT, tm0.wrap_t, imageHeight);
-    WrapCoord(&imageSPlus1, tm0.wrap_s, imageWidth);
-    WrapCoord(&imageTPlus1, tm0.wrap_t, imageHeight);
-
-    if (!(texfmt == TextureFormat::RGBA8 && texUnit.texImage1[subTexmap].image_type))
-    {
-      TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageT, imageWidth, texfmt, tlut,
-                             tlutfmt);
-      SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
+    WrapCoord(&imageS, tm0.wrap_s, level.width);
+    WrapCoord(&imageT, tm0.wrap_t, level.height);
+    WrapCoord(&imageSPlus1, tm0.wrap_s, level.width);
+    WrapCoord(&imageTPlus1, tm0.wrap_t, level.height);
 
-      TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageT, imageWidth, texfmt, tlut,
-                             tlutfmt);
-      AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
+    u8 texels[4][4];
+    GetTexel(level, decoded, imageS, imageT, texels[0]);
+    GetTexel(level, decoded, imageSPlus1, imageT, texels[1]);
+    GetTexel(level, decoded, imageS, imageTPlus1, texels[2]);
+    GetTexel(level, decoded, imageSPlus1, imageTPlus1, texels[3]);
 
-      TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageTPlus1, imageWidth, texfmt, tlut,
-                             tlutfmt);
-      AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
-
-      TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageTPlus1, imageWidth, texfmt,
-                             tlut, tlutfmt);
-      AddTexel(sampledTex, texel, (fractS) * (fractT));
-    }
-    else
-    {
-      TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageT,
-                                          imageWidth);
-      SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
-
-      TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1, imageT,
-                                          imageWidth);
-      AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
-
-      TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageTPlus1,
-                                          imageWidth);
-      AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
-
-      TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1,
-                                          imageTPlus1, imageWidth);
-      AddTexel(sampledTex, texel, (fractS) * (fractT));
-    }
-
-    sample[0] = (u8)(texel[0] >> 14);
-    sample[1] = (u8)(texel[1] >> 14);
-    sample[2] = (u8)(texel[2] >> 14);
-    sample[3] = (u8)(texel[3] >> 14);
+    Bilinear(texels[0], texels[1], texels[2], texels[3], (128 - fractS) * (128 - fractT),
+             fractS * (128 - fractT), (128 - fractS) * fractT, fractS * fractT, sample);
   }
   else
   {
@@ -237,14 +448,10 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8* sample)
     int imageT = t >> 7;
 
     // nearest neighbor sampling
-    WrapCoord(&imageS, tm0.wrap_s, imageWidth);
-    WrapCoord(&imageT, tm0.wrap_t, imageHeight);
+    WrapCoord(&imageS, tm0.wrap_s, level.width);
+    WrapCoord(&imageT, tm0.wrap_t, level.height);
 
-    if (!(texfmt == TextureFormat::RGBA8 && texUnit.texImage1[subTexmap].image_type))
-      TexDecoder_DecodeTexel(sample, imageSrc, imageS, imageT, imageWidth, texfmt, tlut, tlutfmt);
-    else
-      TexDecoder_DecodeTexelRGBA8FromTmem(sample, imageSrc, imageSrcOdd, imageS, imageT,
-                                          imageWidth);
+    GetTexel(level, decoded, imageS, imageT, sample);
   }
 }
 }
@@ -8,6 +8,12 @@
 
 namespace TextureSampler
 {
+// Texture levels are decoded as a whole the first time they are sampled in a draw, and kept
+// around for later draws that use the same data. Must be called whenever the texture state
+// might have changed, before sampling.
+void InvalidateBindings();
+void Shutdown();
+
 void Sample(s32 s, s32 t, s32 lod, bool linear, u8 texmap, u8* sample);
 
 void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8* sample);
@@ -11,6 +11,7 @@
 
 #include "Common/Assert.h"
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "Common/Logging/Log.h"
 #include "Common/MathUtil.h"
 #include "Common/MsgHandler.h"
@@ -319,24 +320,65 @@ static void LightAlpha(const Vec3& pos, const Vec3& normal, u8 lightNum, const L
   }
 }
 
+// Applies the lit color of a channel, if lighting is enabled for it, to the material color.
+static void ApplyLighting(const InputVertexData* src, u32 chan, const Vec3& lit_color,
+                          float lit_alpha, OutputVertexData* dst)
+{
+  // abgr
+  std::array<u8, 4> matcolor;
+  std::array<u8, 4> chancolor;
+
+  // color
+  const LitChannel& colorchan = xfmem.color[chan];
+  if (colorchan.matsource)
+    matcolor = src->color[chan];  // vertex
+  else
+    std::memcpy(matcolor.data(), &xfmem.matColor[chan], sizeof(u32));
+
+  if (colorchan.enablelighting)
+  {
+    int light_x = MathUtil::Clamp(static_cast<int>(lit_color.x), 0, 255);
+    int light_y = MathUtil::Clamp(static_cast<int>(lit_color.y), 0, 255);
+    int light_z = MathUtil::Clamp(static_cast<int>(lit_color.z), 0, 255);
+    chancolor[1] = (matcolor[1] * (light_x + (light_x >> 7))) >> 8;
+    chancolor[2] = (matcolor[2] * (light_y + (light_y >> 7))) >> 8;
+    chancolor[3] = (matcolor[3] * (light_z + (light_z >> 7))) >> 8;
+  }
+  else
+  {
+    chancolor = matcolor;
+  }
+
+  // alpha
+  const LitChannel& alphachan = xfmem.alpha[chan];
+  if (alphachan.matsource)
+    matcolor[0] = src->color[chan][0];  // vertex
+  else
+    matcolor[0] = xfmem.matColor[chan] & 0xff;
+
+  if (alphachan.enablelighting)
+  {
+    int light_a = MathUtil::Clamp(static_cast<int>(lit_alpha), 0, 255);
+    chancolor[0] = (matcolor[0] * (light_a + (light_a >> 7))) >> 8;
+  }
+  else
+  {
+    chancolor[0] = matcolor[0];
+  }
+
+  // abgr -> rgba
+  const u32 rgba_color = Common::swap32(chancolor.data());
+  std::memcpy(dst->color[chan].data(), &rgba_color, sizeof(u32));
+}
+
 void TransformColor(const InputVertexData* src, OutputVertexData* dst)
 {
   for (u32 chan = 0; chan < NUM_XF_COLOR_CHANNELS; chan++)
   {
-    // abgr
-    std::array<u8, 4> matcolor;
-    std::array<u8, 4> chancolor;
-
-    // color
+    Vec3 lightCol(0.0f);
     const LitChannel& colorchan = xfmem.color[chan];
-    if (colorchan.matsource)
-      matcolor = src->color[chan];  // vertex
-    else
-      std::memcpy(matcolor.data(), &xfmem.matColor[chan], sizeof(u32));
-
     if (colorchan.enablelighting)
     {
-      Vec3 lightCol;
       if (colorchan.ambsource)
       {
         // vertex
@@ -358,52 +400,26 @@ void TransformColor(const InputVertexData* src, OutputVertexData* dst)
         if (mask & (1 << i))
           LightColor(dst->mvPosition, dst->normal[0], i, colorchan, lightCol);
       }
-
-      int light_x = MathUtil::Clamp(static_cast<int>(lightCol.x), 0, 255);
-      int light_y = MathUtil::Clamp(static_cast<int>(lightCol.y), 0, 255);
-      int light_z = MathUtil::Clamp(static_cast<int>(lightCol.z), 0, 255);
-      chancolor[1] = (matcolor[1] * (light_x + (light_x >> 7))) >> 8;
-      chancolor[2] = (matcolor[2] * (light_y + (light_y >> 7))) >> 8;
-      chancolor[3] = (matcolor[3] * (light_z + (light_z >> 7))) >> 8;
-    }
-    else
-    {
-      chancolor = matcolor;
     }
 
-    // alpha
+    float lightAlpha = 0.0f;
     const LitChannel& alphachan = xfmem.alpha[chan];
-    if (alphachan.matsource)
-      matcolor[0] = src->color[chan][0];  // vertex
-    else
-      matcolor[0] = xfmem.matColor[chan] & 0xff;
-
-    if (xfmem.alpha[chan].enablelighting)
+    if (alphachan.enablelighting)
     {
-      float lightCol;
       if (alphachan.ambsource)
-        lightCol = src->color[chan][0];  // vertex
+        lightAlpha = src->color[chan][0];  // vertex
       else
-        lightCol = static_cast<float>(xfmem.ambColor[chan] & 0xff);
+        lightAlpha = static_cast<float>(xfmem.ambColor[chan] & 0xff);
 
       u8 mask = alphachan.GetFullLightMask();
       for (int i = 0; i < 8; ++i)
       {
         if (mask & (1 << i))
-          LightAlpha(dst->mvPosition, dst->normal[0], i, alphachan, lightCol);
+          LightAlpha(dst->mvPosition, dst->normal[0], i, alphachan, lightAlpha);
       }
-
-      int light_a = MathUtil::Clamp(static_cast<int>(lightCol), 0, 255);
-      chancolor[0] = (matcolor[0] * (light_a + (light_a >> 7))) >> 8;
-    }
-    else
-    {
-      chancolor[0] = matcolor[0];
     }
 
-    // abgr -> rgba
-    const u32 rgba_color = Common::swap32(chancolor.data());
-    std::memcpy(dst->color[chan].data(), &rgba_color, sizeof(u32));
+    ApplyLighting(src, chan, lightCol, lightAlpha, dst);
   }
 }
 
@@ -456,4 +472,527 @@ void TransformTexCoord(const InputVertexData* src, OutputVertexData* dst, bool s
     dst->texCoords[coordNum][1] *= (bpmem.texcoords[coordNum].t.scale_minus_1 + 1);
   }
 }
+
+// The batched transform keeps a component of every vertex of the batch side by side, one vertex
+// per lane. Each step is done in the same order as in the functions above, so that the results
+// are the same to the bit.
+#ifdef _M_X86
+static_assert(BATCH_SIZE == 4, "A batch should fill an SSE register");
+
+struct Lanes
+{
+  __m128 v;
+};
+
+struct LaneMask
+{
+  __m128 v;
+};
+
+static inline Lanes Load(const float* values)
+{
+  return {_mm_loadu_ps(values)};
+}
+
+static inline void Store(float* values, Lanes a)
+{
+  _mm_storeu_ps(values, a.v);
+}
+
+static inline Lanes Splat(float value)
+{
+  return {_mm_set1_ps(value)};
+}
+
+static inline Lanes operator+(Lanes a, Lanes b)
+{
+  return {_mm_add_ps(a.v, b.v)};
+}
+
+static inline Lanes operator-(Lanes a, Lanes b)
+{
+  return {_mm_sub_ps(a.v, b.v)};
+}
+
+static inline Lanes operator-(Lanes a)
+{
+  return {_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))};
+}
+
+static inline Lanes operator*(Lanes a, Lanes b)
+{
+  return {_mm_mul_ps(a.v, b.v)};
+}
+
+static inline Lanes operator/(Lanes a, Lanes b)
+{
+  return {_mm_div_ps(a.v, b.v)};
+}
+
+static inline Lanes Sqrt(Lanes a)
+{
+  return {_mm_sqrt_ps(a.v)};
+}
+
+// Same as std::max(0.0f, a), which gives 0 for NaN and negative zero.
+static inline Lanes MaxZero(Lanes a)
+{
+  return {_mm_max_ps(a.v, _mm_setzero_ps())};
+}
+
+static inline LaneMask operator==(Lanes a, Lanes b)
+{
+  return {_mm_cmpeq_ps(a.v, b.v)};
+}
+
+static inline LaneMask operator>(Lanes a, Lanes b)
+{
+  return {_mm_cmpgt_ps(a.v, b.v)};
+}
+
+static inline LaneMask operator>=(Lanes a, Lanes b)
+{
+  return {_mm_cmpge_ps(a.v, b.v)};
+}
+
+static inline LaneMask operator&(LaneMask a, LaneMask b)
+{
+  return {_mm_and_ps(a.v, b.v)};
+}
+
+static inline Lanes Select(LaneMask mask, Lanes if_true, Lanes if_false)
+{
+  return {_mm_or_ps(_mm_and_ps(mask.v, if_true.v), _mm_andnot_ps(mask.v, if_false.v))};
+}
+#else
+struct Lanes
+{
+  std::array<float, BATCH_SIZE> v;
+};
+
+struct LaneMask
+{
+  std::array<bool, BATCH_SIZE> v;
+};
+
+template <typename T, typename F>
+static inline T PerLane(F f)
+{
+  T result;
+  for (u32 lane = 0; lane < BATCH_SIZE; lane++)
+    result.v[lane] = f(lane);
+  return result;
+}
+
+static inline Lanes Load(const float* values)
+{
+  return PerLane<Lanes>([&](u32 i) { return values[i]; });
+}
+
+static inline void Store(float* values, Lanes a)
+{
+  std::copy(a.v.begin(), a.v.end(), values);
+}
+
+static inline Lanes Splat(float value)
+{
+  return PerLane<Lanes>([&](u32) { return value; });
+}
+
+static inline Lanes operator+(Lanes a, Lanes b)
+{
+  return PerLane<Lanes>([&](u32 i) { return a.v[i] + b.v[i]; });
+}
+
+static inline Lanes operator-(Lanes a, Lanes b)
+{
+  return PerLane<Lanes>([&](u32 i) { return a.v[i] - b.v[i]; });
+}
+
+static inline Lanes operator-(Lanes a)
+{
+  return PerLane<Lanes>([&](u32 i) { return -a.v[i]; });
+}
+
+static inline Lanes operator*(Lanes a, Lanes b)
+{
+  return PerLane<Lanes>([&](u32 i) { return a.v[i] * b.v[i]; });
+}
+
+static inline Lanes operator/(Lanes a, Lanes b)
+{
+  return PerLane<Lanes>([&](u32 i) { return a.v[i] / b.v[i]; });
+}
+
+static inline Lanes Sqrt(Lanes a)
+{
+  return PerLane<Lanes>([&](u32 i) { return sqrtf(a.v[i]); });
+}
+
+static inline Lanes MaxZero(Lanes a)
+{
+  return PerLane<Lanes>([&](u32 i) { return std::max(0.0f, a.v[i]); });
+}
+
+static inline LaneMask operator==(Lanes a, Lanes b)
+{
+  return PerLane<LaneMask>([&](u32 i) { return a.v[i] == b.v[i]; });
+}
+
+static inline LaneMask operator>(Lanes a, Lanes b)
+{
+  return PerLane<LaneMask>([&](u32 i) { return a.v[i] > b.v[i]; });
+}
+
+static inline LaneMask operator>=(Lanes a, Lanes b)
+{
+  return PerLane<LaneMask>([&](u32 i) { return a.v[i] >= b.v[i]; });
+}
+
+static inline LaneMask operator&(LaneMask a, LaneMask b)
+{
+  return PerLane<LaneMask>([&](u32 i) { return a.v[i] && b.v[i]; });
+}
+
+static inline Lanes Select(LaneMask mask, Lanes if_true, Lanes if_false)
+{
+  return PerLane<Lanes>([&](u32 i) { return mask.v[i] ? if_true.v[i] : if_false.v[i]; });
+}
+#endif
+
+struct Vec3Lanes
+{
+  Lanes x, y, z;
+};
+
+using BatchInput = std::array<const InputVertexData*, BATCH_SIZE>;
+
+template <typename F>
+static Lanes Gather(const BatchInput& in, F get)
+{
+  std::array<float, BATCH_SIZE> values;
+  for (u32 lane = 0; lane < BATCH_SIZE; lane++)
+    values[lane] = get(in[lane]);
+  return Load(values.data());
+}
+
+template <typename F>
+static Vec3Lanes GatherVec3(const BatchInput& in, F get)
+{
+  return {Gather(in, [&](const InputVertexData* v) { return get(v).x; }),
+          Gather(in, [&](const InputVertexData* v) { return get(v).y; }),
+          Gather(in, [&](const InputVertexData* v) { return get(v).z; })};
+}
+
+// Gathers the matrix of each lane, as one set of lanes per matrix element.
+template <size_t N, typename F>
+static std::array<Lanes, N> GatherMatrix(const BatchInput& in, F get_matrix)
+{
+  std::array<Lanes, N> mat;
+  for (size_t i = 0; i < N; i++)
+    mat[i] = Gather(in, [&](const InputVertexData* v) { return get_matrix(v)[i]; });
+  return mat;
+}
+
+static inline Vec3Lanes Splat(const Vec3& vec)
+{
+  return {Splat(vec.x), Splat(vec.y), Splat(vec.z)};
+}
+
+static inline Lanes Dot(const Vec3Lanes& a, const Vec3Lanes& b)
+{
+  return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
+}
+
+static inline Vec3Lanes Scale(const Vec3Lanes& vec, Lanes f)
+{
+  return {vec.x * f, vec.y * f, vec.z * f};
+}
+
+static inline Vec3Lanes Normalized(const Vec3Lanes& vec)
+{
+  return Scale(vec, Splat(1.0f) / Sqrt(Dot(vec, vec)));
+}
+
+static inline Vec3Lanes Select(LaneMask mask, const Vec3Lanes& if_true, const Vec3Lanes& if_false)
+{
+  return {Select(mask, if_true.x, if_false.x), Select(mask, if_true.y, if_false.y),
+          Select(mask, if_true.z, if_false.z)};
+}
+
+static Vec3Lanes MultiplyVec3Mat33(const Vec3Lanes& vec, const std::array<Lanes, 9>& mat)
+{
+  return {mat[0] * vec.x + mat[1] * vec.y + mat[2] * vec.z,
+          mat[3] * vec.x + mat[4] * vec.y + mat[5] * vec.z,
+          mat[6] * vec.x + mat[7] * vec.y + mat[8] * vec.z};
+}
+
+static Vec3Lanes MultiplyVec3Mat34(const Vec3Lanes& vec, const std::array<Lanes, 12>& mat)
+{
+  return {mat[0] * vec.x + mat[1] * vec.y + mat[2] * vec.z + mat[3],
+          mat[4] * vec.x + mat[5] * vec.y + mat[6] * vec.z + mat[7],
+          mat[8] * vec.x + mat[9] * vec.y + mat[10] * vec.z + mat[11]};
+}
+
+static inline Lanes SafeDivide(Lanes n, Lanes d)
+{
+  const Lanes zero = Splat(0.0f);
+  return Select(d == zero, Select(n > zero, Splat(1.0f), zero), n / d);
+}
+
+static Lanes CalculateLightAttn(const LightPointer* light, Vec3Lanes* _ldir,
+                                const Vec3Lanes& normal, const LitChannel& chan)
+{
+  const Lanes zero = Splat(0.0f);
+  Lanes attn = Splat(1.0f);
+  Vec3Lanes& ldir = *_ldir;
+
+  switch (chan.attnfunc)
+  {
+  case LIGHTATTN_NONE:
+  case LIGHTATTN_DIR:
+  {
+    ldir = Normalized(ldir);
+    ldir = Select((ldir.x == zero) & (ldir.y == zero) & (ldir.z == zero), normal, ldir);
+    break;
+  }
+  case LIGHTATTN_SPEC:
+  {
+    ldir = Normalized(ldir);
+    attn = Select(Dot(ldir, normal) >= zero, MaxZero(Dot(Splat(light->dir), normal)), zero);
+    const Vec3 cosAttn = light->cosatt;
+    Vec3 distAttn = light->distatt;
+    if (chan.diffusefunc != LIGHTDIF_NONE)
+      distAttn = distAttn.Normalized();
+
+    // attLen is (1, attn, attn * attn)
+    const Lanes attn2 = attn * attn;
+    const Lanes cos =
+        Splat(cosAttn.x) + (attn * Splat(cosAttn.y)) + (attn2 * Splat(cosAttn.z));
+    const Lanes dist =
+        Splat(distAttn.x) + (attn * Splat(distAttn.y)) + (attn2 * Splat(distAttn.z));
+    attn = SafeDivide(MaxZero(cos), dist);
+    break;
+  }
+  case LIGHTATTN_SPOT:
+  {
+    const Lanes dist2 = Dot(ldir, ldir);
+    const Lanes dist = Sqrt(dist2);
+    ldir = Scale(ldir, Splat(1.0f) / dist);
+    attn = MaxZero(Dot(ldir, Splat(light->dir)));
+
+    const Lanes cosAtt = Splat(light->cosatt.x) + (Splat(light->cosatt.y) * attn) +
+                         (Splat(light->cosatt.z) * attn * attn);
+    const Lanes distAtt = Splat(light->distatt.x) + (Splat(light->distatt.y) * dist) +
+                          (Splat(light->distatt.z) * dist2);
+    attn = SafeDivide(MaxZero(cosAtt), distAtt);
+    break;
+  }
+  default:
+    PanicAlert("LightColor");
+  }
+
+  return attn;
+}
+
+static void LightColor(const Vec3Lanes& pos, const Vec3Lanes& normal, u8 lightNum,
+                       const LitChannel& chan, Vec3Lanes& lightCol)
+{
+  const LightPointer* light = (const LightPointer*)&xfmem.lights[lightNum];
+
+  Vec3Lanes ldir = {Splat(light->pos.x) - pos.x, Splat(light->pos.y) - pos.y,
+                    Splat(light->pos.z) - pos.z};
+  const Lanes attn = CalculateLightAttn(light, &ldir, normal, chan);
+
+  Lanes scale;
+  switch (chan.diffusefunc)
+  {
+  case LIGHTDIF_NONE:
+    scale = attn;
+    break;
+  case LIGHTDIF_SIGN:
+    scale = attn * Dot(ldir, normal);
+    break;
+  case LIGHTDIF_CLAMP:
+    scale = attn * MaxZero(Dot(ldir, normal));
+    break;
+  default:
+    ASSERT(0);
+    return;
+  }
+
+  lightCol.x = lightCol.x + Splat(light->color[1]) * scale;
+  lightCol.y = lightCol.y + Splat(light->color[2]) * scale;
+  lightCol.z = lightCol.z + Splat(light->color[3]) * scale;
+}
+
+static void LightAlpha(const Vec3Lanes& pos, const Vec3Lanes& normal, u8 lightNum,
+                       const LitChannel& chan, Lanes& lightCol)
+{
+  const LightPointer* light = (const LightPointer*)&xfmem.lights[lightNum];
+
+  Vec3Lanes ldir = {Splat(light->pos.x) - pos.x, Splat(light->pos.y) - pos.y,
+                    Splat(light->pos.z) - pos.z};
+  const Lanes attn = CalculateLightAttn(light, &ldir, normal, chan);
+
+  switch (chan.diffusefunc)
+  {
+  case LIGHTDIF_NONE:
+    lightCol = lightCol + Splat(light->color[0]) * attn;
+    break;
+  case LIGHTDIF_SIGN:
+    lightCol = lightCol + Splat(light->color[0]) * attn * Dot(ldir, normal);
+    break;
+  case LIGHTDIF_CLAMP:
+    lightCol = lightCol + Splat(light->color[0]) * attn * MaxZero(Dot(ldir, normal));
+    break;
+  default:
+    ASSERT(0);
+  }
+}
+
+void TransformVertices(const InputVertexData* src, OutputVertexData* dst, u32 count,
+                       bool hasNormal, bool nbt, bool specialCase)
+{
+  ASSERT(count > 0 && count <= BATCH_SIZE);
+
+  // Lanes past the end of the batch repeat the last vertex, and their results are dropped.
+  BatchInput in;
+  for (u32 lane = 0; lane < BATCH_SIZE; lane++)
+    in[lane] = &src[std::min(lane, count - 1)];
+
+  // position
+  const auto pos_mat = GatherMatrix<12>(
+      in, [](const InputVertexData* v) { return &xfmem.posMatrices[v->posMtx * 4]; });
+  const Vec3Lanes position =
+      GatherVec3(in, [](const InputVertexData* v) -> const Vec3& { return v->position; });
+  const Vec3Lanes mvPosition = MultiplyVec3Mat34(position, pos_mat);
+
+  const float* proj = xfmem.projection.rawProjection;
+  Lanes projected[4];
+  if (xfmem.projection.type == GX_PERSPECTIVE)
+  {
+    projected[0] = Splat(proj[0]) * mvPosition.x + Splat(proj[1]) * mvPosition.z;
+    projected[1] = Splat(proj[2]) * mvPosition.y + Splat(proj[3]) * mvPosition.z;
+    projected[2] = (Splat(proj[4]) * mvPosition.z + Splat(proj[5])) * Splat(1.0f - (float)1e-7);
+    projected[3] = -mvPosition.z;
+  }
+  else
+  {
+    projected[0] = Splat(proj[0]) * mvPosition.x + Splat(proj[1]);
+    projected[1] = Splat(proj[2]) * mvPosition.y + Splat(proj[3]);
+    projected[2] = Splat(proj[4]) * mvPosition.z + Splat(proj[5]);
+    projected[3] = Splat(1.0f);
+  }
+
+  // normals
+  const Vec3Lanes zero = Splat(Vec3(0.0f));
+  std::array<Vec3Lanes, 3> normal = {zero, zero, zero};
+  if (hasNormal)
+  {
+    const auto normal_mat = GatherMatrix<9>(in, [](const InputVertexData* v) {
+      return &xfmem.normalMatrices[(v->posMtx & 31) * 3];
+    });
+    for (u32 i = 0; i < (nbt ? 3u : 1u); i++)
+    {
+      const Vec3Lanes src_normal =
+          GatherVec3(in, [i](const InputVertexData* v) -> const Vec3& { return v->normal[i]; });
+      normal[i] = MultiplyVec3Mat33(src_normal, normal_mat);
+    }
+    normal[0] = Normalized(normal[0]);
+  }
+
+  std::array<std::array<float, BATCH_SIZE>, 3 + 4 + 3 * 3> results;
+  Store(results[0].data(), mvPosition.x);
+  Store(results[1].data(), mvPosition.y);
+  Store(results[2].data(), mvPosition.z);
+  for (int i = 0; i < 4; i++)
+    Store(results[3 + i].data(), projected[i]);
+  for (int i = 0; i < 3; i++)
+  {
+    Store(results[7 + i * 3].data(), normal[i].x);
+    Store(results[8 + i * 3].data(), normal[i].y);
+    Store(results[9 + i * 3].data(), normal[i].z);
+  }
+
+  for (u32 lane = 0; lane < count; lane++)
+  {
+    OutputVertexData& vertex = dst[lane];
+    vertex = {};
+    vertex.mvPosition = Vec3(results[0][lane], results[1][lane], results[2][lane]);
+    vertex.projectedPosition = {results[3][lane], results[4][lane], results[5][lane],
+                                results[6][lane]};
+    for (int i = 0; i < 3; i++)
+    {
+      vertex.normal[i] =
+          Vec3(results[7 + i * 3][lane], results[8 + i * 3][lane], results[9 + i * 3][lane]);
+    }
+  }
+
+  // colors
+  for (u32 chan = 0; chan < NUM_XF_COLOR_CHANNELS; chan++)
+  {
+    Vec3Lanes lightCol = zero;
+    const LitChannel& colorchan = xfmem.color[chan];
+    if (colorchan.enablelighting)
+    {
+      if (colorchan.ambsource)
+      {
+        // vertex
+        lightCol.x = Gather(in, [chan](const InputVertexData* v) { return v->color[chan][1]; });
+        lightCol.y = Gather(in, [chan](const InputVertexData* v) { return v->color[chan][2]; });
+        lightCol.z = Gather(in, [chan](const InputVertexData* v) { return v->color[chan][3]; });
+      }
+      else
+      {
+        const u8* ambColor = reinterpret_cast<u8*>(&xfmem.ambColor[chan]);
+        lightCol = {Splat(ambColor[1]), Splat(ambColor[2]), Splat(ambColor[3])};
+      }
+
+      u8 mask = colorchan.GetFullLightMask();
+      for (int i = 0; i < 8; ++i)
+      {
+        if (mask & (1 << i))
+          LightColor(mvPosition, normal[0], i, colorchan, lightCol);
+      }
+    }
+
+    Lanes lightAlpha = zero.x;
+    const LitChannel& alphachan = xfmem.alpha[chan];
+    if (alphachan.enablelighting)
+    {
+      if (alphachan.ambsource)
+      {
+        // vertex
+        lightAlpha = Gather(in, [chan](const InputVertexData* v) { return v->color[chan][0]; });
+      }
+      else
+      {
+        lightAlpha = Splat(static_cast<float>(xfmem.ambColor[chan] & 0xff));
+      }
+
+      u8 mask = alphachan.GetFullLightMask();
+      for (int i = 0; i < 8; ++i)
+      {
+        if (mask & (1 << i))
+          LightAlpha(mvPosition, normal[0], i, alphachan, lightAlpha);
+      }
+    }
+
+    Store(results[0].data(), lightCol.x);
+    Store(results[1].data(), lightCol.y);
+    Store(results[2].data(), lightCol.z);
+    Store(results[3].data(), lightAlpha);
+    for (u32 lane = 0; lane < count; lane++)
+    {
+      ApplyLighting(&src[lane], chan, Vec3(results[0][lane], results[1][lane], results[2][lane]),
+                    results[3][lane], &dst[lane]);
+    }
+  }
+
+  // The texture coordinate generation depends too much on the configuration of each coordinate
+  // to be worth batching.
+  for (u32 lane = 0; lane < count; lane++)
+    TransformTexCoord(&src[lane], &dst[lane], specialCase);
+}
 }
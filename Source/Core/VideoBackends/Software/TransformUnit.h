@@ -4,13 +4,22 @@
 
 #pragma once
 
+#include "Common/CommonTypes.h"
+
 struct InputVertexData;
 struct OutputVertexData;
 
 namespace TransformUnit
 {
+// The number of vertices TransformVertices works on at once.
+constexpr u32 BATCH_SIZE = 4;
+
 void TransformPosition(const InputVertexData* src, OutputVertexData* dst);
 void TransformNormal(const InputVertexData* src, bool nbt, OutputVertexData* dst);
 void TransformColor(const InputVertexData* src, OutputVertexData* dst);
 void TransformTexCoord(const InputVertexData* src, OutputVertexData* dst, bool specialCase);
+
+// Transforms up to BATCH_SIZE vertices at once, with the same results as the functions above.
+void TransformVertices(const InputVertexData* src, OutputVertexData* dst, u32 count,
+                       bool hasNormal, bool nbt, bool specialCase);
 }
@@ -74,7 +74,7 @@ static Common::Event s_sync_wakeup_event;
 
 void DoState(PointerWrap& p)
 {
-  p.DoArray(s_video_buffer, FIFO_SIZE);
+  p.DoMemoryRegion(s_video_buffer, FIFO_SIZE);
   u8* write_ptr = s_video_buffer_write_ptr;
   p.DoPointer(write_ptr, s_video_buffer);
   s_video_buffer_write_ptr = write_ptr;
@@ -0,0 +1,127 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+
+namespace
+{
+struct TestState
+{
+  u32 number = 0;
+  std::string text;
+  std::vector<u8> data;
+  std::map<u32, u64> map;
+
+  void DoState(PointerWrap& p)
+  {
+    p.Do(number);
+    p.Do(text);
+    p.Do(data);
+    p.DoMarker("TestState");
+    p.Do(map);
+  }
+};
+
+TestState MakeTestState()
+{
+  TestState state;
+  state.number = 0x12345678;
+  state.text = "savestate";
+  state.data.resize(3000);
+  for (size_t i = 0; i < state.data.size(); ++i)
+    state.data[i] = static_cast<u8>(i * 7);
+  state.map = {{1, 2}, {3, 4}, {5, 6}};
+  return state;
+}
+}  // namespace
+
+TEST(ChunkedWriteBuffer, WritesAcrossChunks)
+{
+  ChunkedWriteBuffer buffer(16);
+  std::vector<u8> expected;
+  for (u8 i = 0; i < 100; ++i)
+  {
+    std::vector<u8> bytes(i % 23, i);
+    buffer.Write(bytes.data(), bytes.size());
+    expected.insert(expected.end(), bytes.begin(), bytes.end());
+  }
+
+  ASSERT_EQ(expected.size(), buffer.GetSize());
+  size_t offset = 0;
+  for (size_t i = 0; i < buffer.GetChunkCount(); ++i)
+  {
+    const size_t chunk_size = buffer.GetChunkDataSize(i);
+    EXPECT_EQ(0, std::memcmp(expected.data() + offset, buffer.GetChunk(i), chunk_size));
+    if (i + 1 < buffer.GetChunkCount())
+    {
+      EXPECT_EQ(0u, chunk_size % 16);
+    }
+    offset += chunk_size;
+  }
+  EXPECT_EQ(expected.size(), offset);
+
+  std::vector<u8> copy(buffer.GetSize());
+  buffer.CopyTo(copy.data());
+  EXPECT_EQ(expected, copy);
+}
+
+TEST(ChunkedWriteBuffer, ClearKeepsWorking)
+{
+  ChunkedWriteBuffer buffer(8);
+  const std::string first = "some longer text that fills several chunks";
+  buffer.Write(first.data(), first.size());
+
+  buffer.Clear();
+  EXPECT_EQ(0u, buffer.GetSize());
+  EXPECT_EQ(0u, buffer.GetChunkCount());
+
+  const std::string second = "short";
+  buffer.Write(second.data(), second.size());
+  ASSERT_EQ(second.size(), buffer.GetSize());
+  std::string copy(second.size(), '\0');
+  buffer.CopyTo(reinterpret_cast<u8*>(&copy[0]));
+  EXPECT_EQ(second, copy);
+}
+
+TEST(PointerWrap, StreamingWriteMatchesMeasuredWrite)
+{
+  TestState state = MakeTestState();
+
+  u8* ptr = nullptr;
+  PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+  state.DoState(measure);
+  std::vector<u8> expected(reinterpret_cast<size_t>(ptr));
+  ptr = expected.data();
+  PointerWrap write(&ptr, PointerWrap::MODE_WRITE);
+  state.DoState(write);
+
+  ChunkedWriteBuffer buffer(64);
+  ptr = nullptr;
+  PointerWrap stream(&ptr, &buffer);
+  state.DoState(stream);
+  EXPECT_EQ(PointerWrap::MODE_WRITE, stream.GetMode());
+  EXPECT_EQ(expected.size(), reinterpret_cast<size_t>(ptr));
+
+  std::vector<u8> streamed(buffer.GetSize());
+  buffer.CopyTo(streamed.data());
+  EXPECT_EQ(expected, streamed);
+
+  TestState loaded;
+  ptr = streamed.data();
+  PointerWrap read(&ptr, PointerWrap::MODE_READ);
+  loaded.DoState(read);
+  EXPECT_EQ(PointerWrap::MODE_READ, read.GetMode());
+  EXPECT_EQ(state.number, loaded.number);
+  EXPECT_EQ(state.text, loaded.text);
+  EXPECT_EQ(state.data, loaded.data);
+  EXPECT_EQ(state.map, loaded.map);
+}
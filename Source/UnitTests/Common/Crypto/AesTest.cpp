@@ -0,0 +1,58 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <array>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Crypto/AES.h"
+
+constexpr std::array<u8, 16> KEY{{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7,
+                                  0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c}};
+constexpr std::array<u8, 16> IV{{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+                                 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f}};
+
+// NIST SP 800-38A, F.2.1 (CBC-AES128), first two blocks
+constexpr std::array<u8, 32> PLAINTEXT{
+    {0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17,
+     0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf,
+     0x8e, 0x51}};
+constexpr std::array<u8, 32> CIPHERTEXT{
+    {0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19,
+     0x7d, 0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76,
+     0x78, 0xb2}};
+
+TEST(aes, ContextMatchesTestVectors)
+{
+  std::array<u8, 32> out;
+  Common::AES::CreateContextEncrypt(KEY.data())
+      ->CryptCBC(IV.data(), PLAINTEXT.data(), out.data(), out.size());
+  EXPECT_EQ(CIPHERTEXT, out);
+
+  Common::AES::CreateContextDecrypt(KEY.data())
+      ->CryptCBC(IV.data(), CIPHERTEXT.data(), out.data(), out.size());
+  EXPECT_EQ(PLAINTEXT, out);
+}
+
+TEST(aes, ContextMatchesDecryptEncrypt)
+{
+  // Long and odd enough to cover both the interleaved and the single block code paths
+  std::vector<u8> data(16 * 37);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<u8>(i * 7 + 3);
+
+  std::array<u8, 16> iv = IV;
+  const std::vector<u8> expected_encrypted =
+      Common::AES::Encrypt(KEY.data(), iv.data(), data.data(), data.size());
+  std::vector<u8> encrypted(data.size());
+  Common::AES::CreateContextEncrypt(KEY.data())
+      ->CryptCBC(IV.data(), data.data(), encrypted.data(), encrypted.size());
+  EXPECT_EQ(expected_encrypted, encrypted);
+
+  // Decrypt in place
+  Common::AES::CreateContextDecrypt(KEY.data())
+      ->CryptCBC(IV.data(), encrypted.data(), encrypted.data(), encrypted.size());
+  EXPECT_EQ(data, encrypted);
+}
@@ -0,0 +1,72 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <unordered_map>
+
+#include "Common/CommonTypes.h"
+#include "Common/FlatHashMap.h"
+
+TEST(FlatHashMap, InsertFindErase)
+{
+  Common::FlatHashMap<u32, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.Find(0));
+
+  map[0x80003100] = 1;
+  map[0x80003104] = 2;
+  EXPECT_EQ(2u, map.size());
+  ASSERT_NE(nullptr, map.Find(0x80003100));
+  EXPECT_EQ(1, *map.Find(0x80003100));
+  EXPECT_EQ(2, map[0x80003104]);
+  EXPECT_EQ(2u, map.size());
+
+  EXPECT_TRUE(map.Erase(0x80003100));
+  EXPECT_FALSE(map.Erase(0x80003100));
+  EXPECT_EQ(nullptr, map.Find(0x80003100));
+  EXPECT_EQ(0, map[0x80003100]);
+
+  map.Clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(nullptr, map.Find(0x80003104));
+}
+
+TEST(FlatHashMap, MatchesUnorderedMap)
+{
+  Common::FlatHashMap<u32, u32> map;
+  std::unordered_map<u32, u32> reference;
+
+  // Few distinct keys with the same low bits, so that there are long probe sequences
+  // and many erasures in the middle of them.
+  std::mt19937 rng(1234);
+  for (u32 i = 0; i < 100000; ++i)
+  {
+    const u32 key = (rng() % 512) << 12;
+    if (rng() % 3 == 0)
+    {
+      EXPECT_EQ(reference.erase(key) != 0, map.Erase(key));
+    }
+    else
+    {
+      map[key] = i;
+      reference[key] = i;
+    }
+  }
+
+  EXPECT_EQ(reference.size(), map.size());
+  for (const auto& entry : reference)
+  {
+    ASSERT_NE(nullptr, map.Find(entry.first));
+    EXPECT_EQ(entry.second, *map.Find(entry.first));
+  }
+
+  size_t count = 0;
+  map.ForEach([&](u32 key, u32 value) {
+    EXPECT_EQ(reference[key], value);
+    ++count;
+  });
+  EXPECT_EQ(reference.size(), count);
+}
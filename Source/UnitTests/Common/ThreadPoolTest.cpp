@@ -0,0 +1,31 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "Common/ThreadPool.h"
+
+TEST(ThreadPool, ParallelForCallsEveryItemOnce)
+{
+  Common::ThreadPool pool(3, "ThreadPoolTest");
+  EXPECT_EQ(3u, pool.GetWorkerCount());
+
+  for (size_t count : {0, 1, 2, 7, 1000})
+  {
+    std::vector<std::atomic<int>> calls(count);
+    pool.ParallelFor(count, [&](size_t i) { calls[i]++; });
+    for (const std::atomic<int>& c : calls)
+      EXPECT_EQ(1, c.load());
+  }
+}
+
+TEST(ThreadPool, NoWorkers)
+{
+  Common::ThreadPool pool(0, "ThreadPoolTest");
+  int sum = 0;
+  pool.ParallelFor(10, [&](size_t i) { sum += static_cast<int>(i); });
+  EXPECT_EQ(45, sum);
+}
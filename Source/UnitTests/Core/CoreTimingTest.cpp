@@ -4,10 +4,16 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <functional>
+#include <random>
 #include <string>
+#include <tuple>
+#include <vector>
 
+#include "Common/ChunkFile.h"
 #include "Common/Config/Config.h"
 #include "Common/FileUtil.h"
 #include "Core/ConfigManager.h"
@@ -347,3 +353,194 @@ TEST(CoreTiming, Overclocking)
   SConfig::GetInstance().m_OCFactor = 1.0;
   AdvanceAndCheck(4, MAX_SLICE_LENGTH);
 }
+
+namespace ReferenceQueueTest
+{
+constexpr int NUM_TYPES = 4;
+
+struct FiredEvent
+{
+  int type;
+  u64 userdata;
+  s64 lateness;
+
+  bool operator==(const FiredEvent& other) const
+  {
+    return std::tie(type, userdata, lateness) ==
+           std::tie(other.type, other.userdata, other.lateness);
+  }
+};
+
+// The binary heap that CoreTiming used before it had a timing wheel
+struct ReferenceEvent
+{
+  s64 time;
+  u64 fifo_order;
+  u64 userdata;
+  int type;
+
+  bool operator>(const ReferenceEvent& other) const
+  {
+    return std::tie(time, fifo_order) > std::tie(other.time, other.fifo_order);
+  }
+};
+
+static std::vector<ReferenceEvent> s_reference_queue;
+static u64 s_reference_fifo_id = 0;
+static std::vector<FiredEvent> s_fired;
+static std::array<CoreTiming::EventType*, NUM_TYPES> s_event_types;
+
+// Some events schedule another one from their callback, possibly into the past.
+static bool HasFollowUp(u64 userdata)
+{
+  return userdata != 0 && userdata % 4 == 0;
+}
+
+static s64 GetFollowUpDelay(u64 userdata)
+{
+  return static_cast<s64>(userdata % 3000) - 1000;
+}
+
+static int GetFollowUpType(u64 userdata)
+{
+  return static_cast<int>((userdata >> 12) % NUM_TYPES);
+}
+
+template <int TYPE>
+void Callback(u64 userdata, s64 lateness)
+{
+  s_fired.push_back({TYPE, userdata, lateness});
+  if (HasFollowUp(userdata))
+  {
+    CoreTiming::ScheduleEvent(GetFollowUpDelay(userdata), s_event_types[GetFollowUpType(userdata)],
+                              userdata / 4);
+  }
+}
+
+static void ReferenceSchedule(s64 time, int type, u64 userdata)
+{
+  s_reference_queue.push_back({time, s_reference_fifo_id++, userdata, type});
+  std::push_heap(s_reference_queue.begin(), s_reference_queue.end(),
+                 std::greater<ReferenceEvent>());
+}
+
+static void ReferenceRemove(int type)
+{
+  auto it = std::remove_if(s_reference_queue.begin(), s_reference_queue.end(),
+                           [type](const ReferenceEvent& ev) { return ev.type == type; });
+  s_reference_queue.erase(it, s_reference_queue.end());
+  std::make_heap(s_reference_queue.begin(), s_reference_queue.end(),
+                 std::greater<ReferenceEvent>());
+}
+
+static std::vector<FiredEvent> ReferenceAdvance(s64 global_timer)
+{
+  std::vector<FiredEvent> fired;
+  while (!s_reference_queue.empty() && s_reference_queue.front().time <= global_timer)
+  {
+    const ReferenceEvent ev = s_reference_queue.front();
+    std::pop_heap(s_reference_queue.begin(), s_reference_queue.end(),
+                  std::greater<ReferenceEvent>());
+    s_reference_queue.pop_back();
+
+    fired.push_back({ev.type, ev.userdata, global_timer - ev.time});
+    if (HasFollowUp(ev.userdata))
+    {
+      ReferenceSchedule(global_timer + GetFollowUpDelay(ev.userdata),
+                        GetFollowUpType(ev.userdata), ev.userdata / 4);
+    }
+  }
+  return fired;
+}
+
+static s64 ReferenceSliceLength(s64 global_timer)
+{
+  if (s_reference_queue.empty())
+    return MAX_SLICE_LENGTH;
+  return std::min<s64>(s_reference_queue.front().time - global_timer, MAX_SLICE_LENGTH);
+}
+
+static void SaveAndLoadState()
+{
+  u8* ptr = nullptr;
+  PointerWrap p_measure(&ptr, PointerWrap::MODE_MEASURE);
+  CoreTiming::DoState(p_measure);
+
+  std::vector<u8> buffer(reinterpret_cast<size_t>(ptr));
+  ptr = buffer.data();
+  PointerWrap p_write(&ptr, PointerWrap::MODE_WRITE);
+  CoreTiming::DoState(p_write);
+
+  ptr = buffer.data();
+  PointerWrap p_read(&ptr, PointerWrap::MODE_READ);
+  CoreTiming::DoState(p_read);
+  ASSERT_EQ(PointerWrap::MODE_READ, p_read.GetMode());
+}
+}
+
+// Runs a long random sequence of operations and checks that events run in the same order, with
+// the same lateness and the same slice lengths as with a binary heap.
+TEST(CoreTiming, MatchesReferenceQueue)
+{
+  using namespace ReferenceQueueTest;
+
+  ScopeInit guard;
+
+  s_reference_queue.clear();
+  s_reference_fifo_id = 0;
+  s_event_types = {{CoreTiming::RegisterEvent("callback0", Callback<0>),
+                    CoreTiming::RegisterEvent("callback1", Callback<1>),
+                    CoreTiming::RegisterEvent("callback2", Callback<2>),
+                    CoreTiming::RegisterEvent("callback3", Callback<3>)}};
+
+  // Enter slice 0
+  CoreTiming::Advance();
+
+  // Delays that end up on every level of the wheel, and beyond it
+  static constexpr std::array<s64, 6> MAX_DELAYS{
+      {100, 1000, 100000, INT64_C(1) << 26, INT64_C(1) << 34, INT64_C(1) << 40}};
+
+  std::mt19937_64 rng(1234);
+  for (int i = 0; i < 50000; ++i)
+  {
+    const u64 op = rng() % 32;
+    if (op < 16)
+    {
+      const s64 max_delay = MAX_DELAYS[rng() % MAX_DELAYS.size()];
+      const s64 delay = static_cast<s64>(rng() % max_delay) - 50;
+      const int type = static_cast<int>(rng() % NUM_TYPES);
+      const u64 userdata = rng() % 0x100000;
+
+      ReferenceSchedule(static_cast<s64>(CoreTiming::GetTicks()) + delay, type, userdata);
+      CoreTiming::ScheduleEvent(delay, s_event_types[type], userdata);
+    }
+    else if (op < 18)
+    {
+      const int type = static_cast<int>(rng() % NUM_TYPES);
+      ReferenceRemove(type);
+      CoreTiming::RemoveEvent(s_event_types[type]);
+    }
+    else if (op < 19)
+    {
+      // Skip ahead in time, so that the events far in the future get a chance to run.
+      CoreTiming::g.global_timer += static_cast<s64>(rng() % (INT64_C(1) << 36));
+    }
+    else if (op < 20)
+    {
+      SaveAndLoadState();
+    }
+    else
+    {
+      // Pretend we executed some of the cycles of the slice.
+      PowerPC::ppcState.downcount =
+          static_cast<int>(rng() % (std::max(PowerPC::ppcState.downcount, 0) + 1));
+
+      s_fired.clear();
+      CoreTiming::Advance();
+
+      ASSERT_EQ(ReferenceAdvance(CoreTiming::g.global_timer), s_fired) << "at step " << i;
+      ASSERT_EQ(ReferenceSliceLength(CoreTiming::g.global_timer), PowerPC::ppcState.downcount)
+          << "at step " << i;
+    }
+  }
+}
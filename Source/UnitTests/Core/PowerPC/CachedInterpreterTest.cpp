@@ -0,0 +1,255 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigLoaders/BaseConfigLoader.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "UICommon/UICommon.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+constexpr u32 CODE_ADDRESS = 0x1000;
+constexpr u32 DATA_ADDRESS = 0x2000;
+
+constexpr u32 DForm(u32 opcd, u32 d, u32 a, u32 imm)
+{
+  return opcd << 26 | d << 21 | a << 16 | (imm & 0xFFFF);
+}
+
+constexpr u32 XForm(u32 d, u32 a, u32 b, u32 subop, u32 rc = 0)
+{
+  return 31 << 26 | d << 21 | a << 16 | b << 11 | subop << 1 | rc;
+}
+
+constexpr u32 Rlwinm(u32 a, u32 s, u32 sh, u32 mb, u32 me)
+{
+  return 21 << 26 | s << 21 | a << 16 | sh << 11 | mb << 6 | me << 1;
+}
+
+constexpr u32 Bc(u32 bo, u32 bi, s32 offset)
+{
+  return 16 << 26 | bo << 21 | bi << 16 | (static_cast<u32>(offset) & 0xFFFC);
+}
+
+// Branch if the CR bit is set, without touching CTR.
+constexpr u32 BO_IF_TRUE = 12;
+constexpr u32 BO_IF_FALSE = 4;
+// Decrement CTR and branch if it's not zero.
+constexpr u32 BO_DNZ = 16;
+
+class CachedInterpreterTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_profile_path = File::CreateTempDir();
+    Core::DeclareAsCPUThread();
+    UICommon::SetUserDirectory(m_profile_path);
+    Config::Init();
+    Config::AddLayer(ConfigLoaders::GenerateBaseConfigLoader());
+    SConfig::Init();
+    Memory::Init();
+    PowerPC::Init(PowerPC::CPUCore::CachedInterpreter);
+    CoreTiming::Init();
+  }
+
+  void TearDown() override
+  {
+    CoreTiming::Shutdown();
+    PowerPC::Shutdown();
+    Memory::Shutdown();
+    SConfig::Shutdown();
+    Config::Shutdown();
+    Core::UndeclareAsCPUThread();
+    File::DeleteDirRecursively(m_profile_path);
+  }
+
+  // Compiles and runs one block of the given code. Address translation is off.
+  void RunBlock(const std::vector<u32>& code, u32 address = CODE_ADDRESS)
+  {
+    for (size_t i = 0; i < code.size(); ++i)
+      Memory::Write_U32(code[i], address + static_cast<u32>(i * 4));
+
+    PC = address;
+    // The first step only compiles the block.
+    PowerPC::SingleStep();
+    PowerPC::SingleStep();
+  }
+
+  std::string m_profile_path;
+};
+}  // namespace
+
+TEST_F(CachedInterpreterTest, IntegerInstructions)
+{
+  RunBlock({
+      DForm(14, 3, 0, 5),           // li r3, 5
+      DForm(15, 4, 3, 1),           // addis r4, r3, 1
+      DForm(14, 5, 4, -6),          // addi r5, r4, -6
+      Rlwinm(6, 5, 4, 0, 27),       // rlwinm r6, r5, 4, 0, 27
+      DForm(24, 6, 7, 0xF),         // ori r7, r6, 0xF
+      DForm(27, 7, 8, 0x8000),      // xoris r8, r7, 0x8000
+      XForm(9, 3, 4, 266),          // add r9, r3, r4
+      XForm(10, 3, 4, 40),          // subf r10, r3, r4
+      XForm(3, 11, 5, 444),         // or r11, r3, r5
+      XForm(5, 12, 6, 28),          // and r12, r5, r6
+      XForm(14, 3, 3, 266, 1),      // add. r14, r3, r3
+      DForm(26, 14, 15, 0xFFFF),    // xori r15, r14, 0xFFFF
+      Bc(BO_IF_TRUE, 0, 8),         // beq +8
+  });
+
+  EXPECT_EQ(5u, rGPR[3]);
+  EXPECT_EQ(0x10005u, rGPR[4]);
+  EXPECT_EQ(0xFFFFu, rGPR[5]);
+  EXPECT_EQ(0xFFFF0u, rGPR[6]);
+  EXPECT_EQ(0xFFFFFu, rGPR[7]);
+  EXPECT_EQ(0x800FFFFFu, rGPR[8]);
+  EXPECT_EQ(0x1000Au, rGPR[9]);
+  EXPECT_EQ(0x10000u, rGPR[10]);
+  EXPECT_EQ(0xFFFFu, rGPR[11]);
+  EXPECT_EQ(0xFFF0u, rGPR[12]);
+  EXPECT_EQ(10u, rGPR[14]);
+  EXPECT_EQ(0xFFF5u, rGPR[15]);
+
+  // add. is left to the interpreter, which sets CR0 to GT.
+  EXPECT_EQ(0x4u, PowerPC::GetCRField(0));
+  EXPECT_EQ(CODE_ADDRESS + 13 * 4, PC);
+}
+
+TEST_F(CachedInterpreterTest, LoadsAndStores)
+{
+  Memory::Write_U32(0x12345678, DATA_ADDRESS);
+  rGPR[1] = DATA_ADDRESS + 0x100;
+  rGPR[3] = DATA_ADDRESS;
+
+  RunBlock({
+      DForm(32, 4, 3, 0),         // lwz r4, 0(r3)
+      DForm(40, 5, 3, 2),         // lhz r5, 2(r3)
+      DForm(34, 6, 3, 1),         // lbz r6, 1(r3)
+      DForm(36, 4, 3, 0x10),      // stw r4, 0x10(r3)
+      DForm(44, 4, 3, 0x14),      // sth r4, 0x14(r3)
+      DForm(38, 4, 3, 0x17),      // stb r4, 0x17(r3)
+      DForm(37, 3, 1, -0x10),     // stwu r3, -0x10(r1)
+      Bc(BO_IF_TRUE, 0, 8),       // beq +8
+  });
+
+  EXPECT_EQ(0x12345678u, rGPR[4]);
+  EXPECT_EQ(0x5678u, rGPR[5]);
+  EXPECT_EQ(0x34u, rGPR[6]);
+  EXPECT_EQ(0x12345678u, Memory::Read_U32(DATA_ADDRESS + 0x10));
+  EXPECT_EQ(0x5678u, Memory::Read_U16(DATA_ADDRESS + 0x14));
+  EXPECT_EQ(0x78u, Memory::Read_U8(DATA_ADDRESS + 0x17));
+  EXPECT_EQ(DATA_ADDRESS + 0xF0, rGPR[1]);
+  EXPECT_EQ(DATA_ADDRESS, Memory::Read_U32(DATA_ADDRESS + 0xF0));
+}
+
+TEST_F(CachedInterpreterTest, CompareAndBranch)
+{
+  // Taken, signed.
+  rGPR[3] = static_cast<u32>(-1);
+  RunBlock({
+      DForm(11, 0, 3, 0),                   // cmpwi r3, 0
+      Bc(BO_IF_TRUE, 0, 0x40),              // blt +0x40
+  });
+  EXPECT_EQ(0x8u, PowerPC::GetCRField(0));
+  EXPECT_EQ(CODE_ADDRESS + 4 + 0x40, PC);
+
+  // Not taken, unsigned, in another CR field.
+  RunBlock(
+      {
+          DForm(10, 1 << 2, 3, 0),          // cmplwi cr1, r3, 0
+          Bc(BO_IF_TRUE, 4 + 0, 0x40),      // blt cr1, +0x40
+      },
+      CODE_ADDRESS + 0x100);
+  EXPECT_EQ(0x4u, PowerPC::GetCRField(1));
+  EXPECT_EQ(CODE_ADDRESS + 0x108, PC);
+
+  // Register compare, branch if not equal.
+  rGPR[4] = 7;
+  rGPR[5] = 7;
+  RunBlock(
+      {
+          XForm(2 << 2, 4, 5, 0),           // cmpw cr2, r4, r5
+          Bc(BO_IF_FALSE, 8 + 2, -0x20),    // bne cr2, -0x20
+      },
+      CODE_ADDRESS + 0x200);
+  EXPECT_EQ(0x2u, PowerPC::GetCRField(2));
+  EXPECT_EQ(CODE_ADDRESS + 0x208, PC);
+}
+
+TEST_F(CachedInterpreterTest, BranchesThatAreNotFused)
+{
+  // bdnz also decrements CTR, so it isn't folded into the compare.
+  rGPR[3] = 1;
+  CTR = 2;
+  RunBlock({
+      DForm(11, 0, 3, 1),           // cmpwi r3, 1
+      Bc(BO_DNZ, 0, 0x40),          // bdnz +0x40
+  });
+  EXPECT_EQ(0x2u, PowerPC::GetCRField(0));
+  EXPECT_EQ(1u, CTR);
+  EXPECT_EQ(CODE_ADDRESS + 4 + 0x40, PC);
+
+  // The branch tests a CR field other than the one that was compared.
+  PowerPC::SetCRField(1, 0x2);
+  RunBlock(
+      {
+          DForm(11, 0, 3, 1),           // cmpwi r3, 1
+          Bc(BO_IF_TRUE, 4 + 2, 0x40),  // beq cr1, +0x40
+      },
+      CODE_ADDRESS + 0x100);
+  EXPECT_EQ(CODE_ADDRESS + 0x104 + 0x40, PC);
+}
+
+TEST_F(CachedInterpreterTest, IdleLoops)
+{
+  Memory::Write_U32(0, DATA_ADDRESS);
+  rGPR[3] = DATA_ADDRESS;
+
+  // Polls memory until something else changes it.
+  const u64 idle_skips = CoreTiming::GetIdleSkips();
+  RunBlock({
+      DForm(32, 4, 3, 0),           // lwz r4, 0(r3)
+      DForm(11, 0, 4, 0),           // cmpwi r4, 0
+      Bc(BO_IF_TRUE, 2, -8),        // beq -8
+  });
+  EXPECT_EQ(CODE_ADDRESS, PC);
+  EXPECT_EQ(idle_skips + 1, CoreTiming::GetIdleSkips());
+
+  // Counts down, so every iteration does work.
+  rGPR[5] = 100;
+  RunBlock(
+      {
+          DForm(14, 5, 5, -1),          // addi r5, r5, -1
+          DForm(11, 0, 5, 0),           // cmpwi r5, 0
+          Bc(BO_IF_FALSE, 2, -8),       // bne -8
+      },
+      CODE_ADDRESS + 0x100);
+  EXPECT_EQ(CODE_ADDRESS + 0x100, PC);
+  EXPECT_EQ(idle_skips + 1, CoreTiming::GetIdleSkips());
+
+  // Writes to memory.
+  RunBlock(
+      {
+          DForm(36, 5, 3, 4),           // stw r5, 4(r3)
+          DForm(32, 4, 3, 0),           // lwz r4, 0(r3)
+          DForm(11, 0, 4, 0),           // cmpwi r4, 0
+          Bc(BO_IF_TRUE, 2, -12),       // beq -12
+      },
+      CODE_ADDRESS + 0x200);
+  EXPECT_EQ(CODE_ADDRESS + 0x200, PC);
+  EXPECT_EQ(idle_skips + 1, CoreTiming::GetIdleSkips());
+}
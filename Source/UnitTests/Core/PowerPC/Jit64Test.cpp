@@ -0,0 +1,97 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Config/Config.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigLoaders/BaseConfigLoader.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "UICommon/UICommon.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+constexpr u32 CODE_ADDRESS = 0x1000;
+constexpr u32 DATA_ADDRESS = 0x2000;
+
+constexpr u32 DForm(u32 opcd, u32 d, u32 a, u32 imm)
+{
+  return opcd << 26 | d << 21 | a << 16 | (imm & 0xFFFF);
+}
+
+constexpr u32 Bc(u32 bo, u32 bi, s32 offset)
+{
+  return 16 << 26 | bo << 21 | bi << 16 | (static_cast<u32>(offset) & 0xFFFC);
+}
+
+// Branch if the CR bit is set, without touching CTR.
+constexpr u32 BO_IF_TRUE = 12;
+
+class Jit64Test : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_profile_path = File::CreateTempDir();
+    Core::DeclareAsCPUThread();
+    UICommon::SetUserDirectory(m_profile_path);
+    Config::Init();
+    Config::AddLayer(ConfigLoaders::GenerateBaseConfigLoader());
+    SConfig::Init();
+    // Fastmem needs the exception handler, which only the emulation thread installs.
+    SConfig::GetInstance().bFastmem = false;
+    Memory::Init();
+    PowerPC::Init(PowerPC::CPUCore::JIT64);
+    CoreTiming::Init();
+  }
+
+  void TearDown() override
+  {
+    CoreTiming::Shutdown();
+    PowerPC::Shutdown();
+    Memory::Shutdown();
+    SConfig::Shutdown();
+    Config::Shutdown();
+    Core::UndeclareAsCPUThread();
+    File::DeleteDirRecursively(m_profile_path);
+  }
+
+  // Runs the given code until the end of the current timeslice. Address translation is off.
+  void Run(const std::vector<u32>& code, u32 address = CODE_ADDRESS)
+  {
+    for (size_t i = 0; i < code.size(); ++i)
+      Memory::Write_U32(code[i], address + static_cast<u32>(i * 4));
+
+    PC = address;
+    PowerPC::SingleStep();
+  }
+
+  std::string m_profile_path;
+};
+}  // namespace
+
+TEST_F(Jit64Test, IdleLoopsWithMergedBranches)
+{
+  Memory::Write_U32(0, DATA_ADDRESS);
+  rGPR[3] = DATA_ADDRESS;
+
+  // cmpwi and beq are merged into one compare and jump, which has to skip ahead too.
+  const u64 idle_skips = CoreTiming::GetIdleSkips();
+  Run({
+      DForm(32, 4, 3, 0),           // lwz r4, 0(r3)
+      DForm(11, 0, 4, 0),           // cmpwi r4, 0
+      Bc(BO_IF_TRUE, 2, -8),        // beq -8
+  });
+  EXPECT_EQ(CODE_ADDRESS, PC);
+  EXPECT_NE(idle_skips, CoreTiming::GetIdleSkips());
+}
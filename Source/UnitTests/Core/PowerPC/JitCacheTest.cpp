@@ -0,0 +1,180 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/CachedInterpreter/CachedInterpreter.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+
+// include order is important
+#include <gtest/gtest.h>  // NOLINT
+
+namespace
+{
+class TestBlockCache final : public JitBaseBlockCache
+{
+public:
+  explicit TestBlockCache(JitBase& jit) : JitBaseBlockCache(jit) {}
+
+  // Adds a block of num_instructions instructions that starts at address, as if it had
+  // been compiled. Address translation is off, so physical and effective addresses match.
+  JitBlock* AddBlock(u32 address, u32 num_instructions, const std::vector<u32>& exits)
+  {
+    JitBlock* block = AllocateBlock(address);
+    block->checkedEntry = nullptr;
+    block->normalEntry = nullptr;
+    block->codeSize = 0;
+    block->originalSize = num_instructions;
+    for (size_t i = 0; i < exits.size(); ++i)
+    {
+      // Only used to identify the exit. Recompiling a block gives its exits the same IDs.
+      const u32 exit_address = exits[i];
+      JitBlock::LinkData link_data;
+      link_data.exitPtrs = reinterpret_cast<u8*>(uintptr_t{address} * 4 + i);
+      link_data.exitAddress = exit_address;
+      link_data.linkStatus = false;
+      link_data.call = false;
+      block->linkData.push_back(link_data);
+    }
+
+    std::set<u32> physical_addresses;
+    for (u32 i = 0; i < num_instructions; ++i)
+      physical_addresses.insert(address + i * 4);
+    FinalizeBlock(*block, true, physical_addresses);
+    return block;
+  }
+
+  // The block that each exit currently jumps to, or nullptr if it goes to the dispatcher.
+  const JitBlock* GetLinkDestination(const JitBlock& block, size_t exit_index) const
+  {
+    auto it = m_links.find(block.linkData[exit_index].exitPtrs);
+    return it == m_links.end() ? nullptr : it->second;
+  }
+
+private:
+  void WriteLinkBlock(const JitBlock::LinkData& source, const JitBlock* dest) override
+  {
+    m_links[source.exitPtrs] = dest;
+  }
+
+  std::unordered_map<const u8*, const JitBlock*> m_links;
+};
+
+class JitCacheTest : public testing::Test
+{
+protected:
+  void SetUp() override { m_cache.Clear(); }
+
+  CachedInterpreter m_jit;
+  TestBlockCache m_cache{m_jit};
+};
+}  // namespace
+
+TEST_F(JitCacheTest, FindsBlocksByStartAddress)
+{
+  JitBlock* a = m_cache.AddBlock(0x3100, 4, {});
+  JitBlock* b = m_cache.AddBlock(0x3110, 8, {});
+
+  EXPECT_EQ(a, m_cache.GetBlockFromStartAddress(0x3100, 0));
+  EXPECT_EQ(b, m_cache.GetBlockFromStartAddress(0x3110, 0));
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(0x3104, 0));
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(0x3100, 0x10));
+
+  size_t count = 0;
+  m_cache.RunOnBlocks([&count](const JitBlock&) { ++count; });
+  EXPECT_EQ(2u, count);
+}
+
+TEST_F(JitCacheTest, ErasesOnlyOverlappingBlocks)
+{
+  // The second block crosses a page boundary.
+  m_cache.AddBlock(0x3100, 4, {});
+  m_cache.AddBlock(0x3FF0, 8, {});
+  m_cache.AddBlock(0x4100, 4, {});
+
+  m_cache.ErasePhysicalRange(0x3110, 0xEE0);
+  EXPECT_NE(nullptr, m_cache.GetBlockFromStartAddress(0x3100, 0));
+  EXPECT_NE(nullptr, m_cache.GetBlockFromStartAddress(0x3FF0, 0));
+
+  m_cache.ErasePhysicalRange(0x4008, 4);
+  EXPECT_NE(nullptr, m_cache.GetBlockFromStartAddress(0x3100, 0));
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(0x3FF0, 0));
+  EXPECT_NE(nullptr, m_cache.GetBlockFromStartAddress(0x4100, 0));
+
+  m_cache.ErasePhysicalRange(0, 0x01800000);
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(0x3100, 0));
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(0x4100, 0));
+}
+
+TEST_F(JitCacheTest, RelinksRecompiledBlocks)
+{
+  JitBlock* caller = m_cache.AddBlock(0x3100, 4, {0x3200, 0x3200, 0x3300});
+  EXPECT_EQ(nullptr, m_cache.GetLinkDestination(*caller, 0));
+
+  JitBlock* callee = m_cache.AddBlock(0x3200, 4, {0x3100});
+  EXPECT_EQ(callee, m_cache.GetLinkDestination(*caller, 0));
+  EXPECT_EQ(callee, m_cache.GetLinkDestination(*caller, 1));
+  EXPECT_EQ(nullptr, m_cache.GetLinkDestination(*caller, 2));
+  EXPECT_EQ(caller, m_cache.GetLinkDestination(*callee, 0));
+
+  m_cache.InvalidateICache(0x3200, 32, false);
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(0x3200, 0));
+  EXPECT_EQ(nullptr, m_cache.GetLinkDestination(*caller, 0));
+  EXPECT_EQ(nullptr, m_cache.GetLinkDestination(*caller, 1));
+  EXPECT_FALSE(caller->linkData[0].linkStatus);
+
+  callee = m_cache.AddBlock(0x3200, 2, {});
+  EXPECT_EQ(callee, m_cache.GetLinkDestination(*caller, 0));
+  EXPECT_EQ(callee, m_cache.GetLinkDestination(*caller, 1));
+  EXPECT_TRUE(caller->linkData[1].linkStatus);
+}
+
+TEST_F(JitCacheTest, ErasesSingleBlock)
+{
+  JitBlock* caller = m_cache.AddBlock(0x3100, 4, {0x3200});
+  JitBlock* callee = m_cache.AddBlock(0x3200, 4, {});
+  JitBlock* overlapping = m_cache.AddBlock(0x31F0, 8, {});
+  callee->run_count = 1000;
+  EXPECT_EQ(callee, m_cache.GetLinkDestination(*caller, 0));
+
+  m_cache.EraseBlock(*callee);
+  EXPECT_EQ(nullptr, m_cache.GetBlockFromStartAddress(0x3200, 0));
+  EXPECT_EQ(overlapping, m_cache.GetBlockFromStartAddress(0x31F0, 0));
+  EXPECT_EQ(nullptr, m_cache.GetLinkDestination(*caller, 0));
+  EXPECT_FALSE(caller->linkData[0].linkStatus);
+
+  callee = m_cache.AddBlock(0x3200, 4, {});
+  EXPECT_EQ(0u, callee->run_count);
+  EXPECT_EQ(callee, m_cache.GetLinkDestination(*caller, 0));
+}
+
+// Like loading a REL: code is repeatedly loaded into the same place and the instruction cache
+// is invalidated for it line by line, while blocks elsewhere stay valid.
+TEST_F(JitCacheTest, RepeatedLineInvalidation)
+{
+  constexpr u32 CODE_START = 0x00400000;
+  constexpr u32 CODE_SIZE = 0x00040000;
+  constexpr u32 BLOCK_SIZE = 0x40;
+  constexpr u32 COMMON_FUNCTION = 0x00003000;
+  constexpr int ROUNDS = 10;
+
+  JitBlock* common = m_cache.AddBlock(COMMON_FUNCTION, 8, {});
+
+  for (int round = 0; round < ROUNDS; ++round)
+  {
+    for (u32 address = CODE_START; address < CODE_START + CODE_SIZE; address += BLOCK_SIZE)
+      m_cache.AddBlock(address, BLOCK_SIZE / 4, {address + BLOCK_SIZE, COMMON_FUNCTION});
+    ASSERT_NE(nullptr, m_cache.GetBlockFromStartAddress(CODE_START, 0));
+
+    for (u32 address = CODE_START; address < CODE_START + CODE_SIZE; address += 32)
+      m_cache.InvalidateICache(address, 32, false);
+    for (u32 address = CODE_START; address < CODE_START + CODE_SIZE; address += BLOCK_SIZE)
+      ASSERT_EQ(nullptr, m_cache.GetBlockFromStartAddress(address, 0));
+  }
+
+  EXPECT_EQ(common, m_cache.GetBlockFromStartAddress(COMMON_FUNCTION, 0));
+}
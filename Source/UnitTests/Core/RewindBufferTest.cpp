@@ -0,0 +1,143 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+#include "Core/RewindBuffer.h"
+
+namespace
+{
+constexpr u32 PAGE_SIZE = State::RewindBuffer::PAGE_SIZE;
+constexpr u32 NUM_PAGES = 64;
+
+struct FakeSystem
+{
+  u32 counter = 0;
+  std::vector<u8> ram = std::vector<u8>(NUM_PAGES * PAGE_SIZE);
+  // Not a multiple of the page size on purpose
+  std::vector<u8> aram = std::vector<u8>(PAGE_SIZE + 123);
+
+  void DoState(PointerWrap& p)
+  {
+    p.Do(counter);
+    p.DoMemoryRegion(ram.data(), static_cast<u32>(ram.size()));
+    p.DoMarker("RAM");
+    p.DoMemoryRegion(aram.data(), static_cast<u32>(aram.size()));
+    p.DoMarker("ARAM");
+  }
+
+  State::RewindBuffer::DoStateFunction GetDoState()
+  {
+    return [this](PointerWrap& p) { DoState(p); };
+  }
+};
+}  // namespace
+
+TEST(RewindBuffer, MemoryRegionWithoutHandlerIsAnArray)
+{
+  FakeSystem system;
+  system.ram[5] = 42;
+
+  u8* ptr = nullptr;
+  PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+  system.DoState(p);
+  EXPECT_EQ(sizeof(u32) * 3 + system.ram.size() + system.aram.size(),
+            reinterpret_cast<size_t>(ptr));
+}
+
+TEST(RewindBuffer, RewindsInReverseOrder)
+{
+  FakeSystem system;
+  State::RewindBuffer buffer(SIZE_MAX);
+
+  for (u32 i = 0; i < 5; ++i)
+  {
+    system.counter = i;
+    system.ram[i * PAGE_SIZE] = static_cast<u8>(i + 1);
+    system.aram.back() = static_cast<u8>(i);
+    buffer.Capture(system.GetDoState());
+  }
+  EXPECT_EQ(5u, buffer.GetSnapshotCount());
+
+  system.ram.assign(system.ram.size(), 0xFF);
+  for (u32 i = 5; i-- > 0;)
+  {
+    ASSERT_TRUE(buffer.Rewind(system.GetDoState()));
+    EXPECT_EQ(i, system.counter);
+    EXPECT_EQ(i, system.aram.back());
+    for (u32 page = 0; page < 5; ++page)
+      EXPECT_EQ(page <= i ? page + 1 : 0, system.ram[page * PAGE_SIZE]);
+    EXPECT_EQ(0, system.ram[NUM_PAGES * PAGE_SIZE - 1]);
+  }
+
+  EXPECT_TRUE(buffer.IsEmpty());
+  EXPECT_EQ(0u, buffer.GetMemoryUsage());
+  EXPECT_FALSE(buffer.Rewind(system.GetDoState()));
+}
+
+TEST(RewindBuffer, OnlyChangedPagesAreStored)
+{
+  FakeSystem system;
+  State::RewindBuffer buffer(SIZE_MAX);
+
+  buffer.Capture(system.GetDoState());
+  const size_t base_usage = buffer.GetMemoryUsage();
+  EXPECT_GE(base_usage, system.ram.size() + system.aram.size());
+
+  system.ram[3 * PAGE_SIZE + 17] = 1;
+  buffer.Capture(system.GetDoState());
+  const size_t delta = buffer.GetMemoryUsage() - base_usage;
+  EXPECT_GE(delta, PAGE_SIZE);
+  EXPECT_LT(delta, 2 * PAGE_SIZE);
+}
+
+TEST(RewindBuffer, RebasesWhenMostPagesChanged)
+{
+  FakeSystem system;
+  State::RewindBuffer buffer(SIZE_MAX);
+
+  buffer.Capture(system.GetDoState());
+  const size_t base_usage = buffer.GetMemoryUsage();
+
+  system.ram.assign(system.ram.size(), 1);
+  buffer.Capture(system.GetDoState());
+  // This snapshot holds nearly all of RAM as changed pages, so the next one starts a new base.
+  system.ram[0] = 2;
+  buffer.Capture(system.GetDoState());
+  system.ram[1] = 3;
+  const size_t usage_before = buffer.GetMemoryUsage();
+  buffer.Capture(system.GetDoState());
+  EXPECT_LT(buffer.GetMemoryUsage() - usage_before, 2 * PAGE_SIZE);
+  EXPECT_GT(buffer.GetMemoryUsage(), 2 * base_usage);
+
+  system.ram.assign(system.ram.size(), 0);
+  ASSERT_TRUE(buffer.Rewind(system.GetDoState()));
+  EXPECT_EQ(2, system.ram[0]);
+  EXPECT_EQ(3, system.ram[1]);
+  EXPECT_EQ(1, system.ram.back());
+}
+
+TEST(RewindBuffer, DropsOldestSnapshotsOverBudget)
+{
+  FakeSystem system;
+  State::RewindBuffer buffer(SIZE_MAX);
+
+  for (u32 i = 0; i < 10; ++i)
+  {
+    system.counter = i;
+    system.ram[i * PAGE_SIZE] = 1;
+    buffer.Capture(system.GetDoState());
+  }
+  ASSERT_EQ(10u, buffer.GetSnapshotCount());
+
+  // Not even one full snapshot fits, but the newest one is kept anyway.
+  buffer.SetBudget(0);
+  EXPECT_EQ(1u, buffer.GetSnapshotCount());
+  ASSERT_TRUE(buffer.Rewind(system.GetDoState()));
+  EXPECT_EQ(9u, system.counter);
+}
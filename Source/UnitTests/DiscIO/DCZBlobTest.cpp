@@ -0,0 +1,123 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/File.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/DCZBlob.h"
+#include "DiscIO/LaggedFibonacciGenerator.h"
+
+namespace
+{
+constexpr size_t JUNK_SEED_INTERVAL = 0x8000;
+}  // namespace
+
+class DCZBlobTest : public testing::Test
+{
+protected:
+  DCZBlobTest() : m_temp_path(File::CreateTempDir()) {}
+  virtual ~DCZBlobTest() { File::DeleteDirRecursively(m_temp_path); }
+
+  // Fills every 0x8000 bytes with random data, zeroes, junk or random data followed by junk,
+  // like the padding between files on a disc. Returns how many bytes are random.
+  size_t WriteImage(const std::string& path, size_t size)
+  {
+    std::mt19937 rng(static_cast<u32>(size));
+    m_image.resize(size);
+
+    size_t random_bytes = 0;
+    for (size_t block = 0; block < size; block += JUNK_SEED_INTERVAL)
+    {
+      const size_t block_size = std::min(JUNK_SEED_INTERVAL, size - block);
+      u8* const out = m_image.data() + block;
+
+      size_t junk_start = 0;
+      switch (rng() % 4)
+      {
+      case 0:
+        junk_start = block_size;
+        break;
+      case 1:
+        std::fill_n(out, block_size, 0);
+        continue;
+      case 2:
+        break;
+      case 3:
+        junk_start = rng() % (block_size / 2);
+        break;
+      }
+
+      std::generate_n(out, junk_start, [&rng] { return static_cast<u8>(rng()); });
+      random_bytes += junk_start;
+
+      std::array<u32, DiscIO::LaggedFibonacciGenerator::SEED_SIZE> seed;
+      std::generate(seed.begin(), seed.end(), [&rng] { return static_cast<u32>(rng()); });
+      DiscIO::LaggedFibonacciGenerator lfg;
+      lfg.SetSeed(seed.data());
+      lfg.Forward(junk_start);
+      lfg.GetBytes(block_size - junk_start, out + junk_start);
+    }
+
+    File::IOFile file(path, "wb");
+    file.WriteBytes(m_image.data(), m_image.size());
+    return random_bytes;
+  }
+
+  std::string m_temp_path;
+  std::vector<u8> m_image;
+};
+
+TEST_F(DCZBlobTest, ReadsBackWhatWasWritten)
+{
+  const std::string image_path = m_temp_path + "/image.iso";
+  const std::string dcz_path = m_temp_path + "/image.dcz";
+  // Not a multiple of any chunk size, so that the last chunk is short
+  const size_t random_bytes = WriteImage(image_path, 0x301234);
+
+  for (const DiscIO::DCZCompression compression :
+       {DiscIO::DCZCompression::None, DiscIO::DCZCompression::Deflate})
+  {
+    // Chunks that don't line up with the junk seeds too
+    for (const u32 chunk_size : {0x40000u, 0x9000u})
+    {
+      ASSERT_TRUE(DiscIO::ConvertToDCZ(image_path, dcz_path, compression, 6, chunk_size));
+
+      std::unique_ptr<DiscIO::BlobReader> reader = DiscIO::CreateBlobReader(dcz_path);
+      ASSERT_NE(nullptr, reader);
+      ASSERT_EQ(DiscIO::BlobType::DCZ, reader->GetBlobType());
+      ASSERT_EQ(m_image.size(), reader->GetDataSize());
+
+      // Only the random bytes should take up space. Junk that is split between chunks
+      // may be too short to be found on one side of the split.
+      if (chunk_size % JUNK_SEED_INTERVAL == 0)
+      {
+        EXPECT_LT(reader->GetRawSize(), random_bytes + m_image.size() / 64);
+      }
+
+      std::vector<u8> data(m_image.size());
+      ASSERT_TRUE(reader->Read(0, data.size(), data.data()));
+      EXPECT_TRUE(data == m_image) << "chunk size " << chunk_size;
+
+      std::mt19937 rng(chunk_size);
+      for (int i = 0; i < 200; i++)
+      {
+        const size_t offset = rng() % m_image.size();
+        const size_t size = rng() % std::min<size_t>(m_image.size() - offset, 0x20000) + 1;
+        ASSERT_TRUE(reader->Read(offset, size, data.data()));
+        ASSERT_TRUE(std::equal(data.begin(), data.begin() + size, m_image.begin() + offset))
+            << "chunk size " << chunk_size << ", offset " << offset << ", size " << size;
+      }
+    }
+  }
+}
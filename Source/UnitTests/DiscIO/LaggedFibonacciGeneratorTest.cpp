@@ -0,0 +1,86 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "DiscIO/LaggedFibonacciGenerator.h"
+
+using DiscIO::LaggedFibonacciGenerator;
+
+namespace
+{
+constexpr size_t JUNK_SIZE = 0x8000;
+
+std::vector<u8> GenerateJunk(std::mt19937& rng)
+{
+  std::array<u32, LaggedFibonacciGenerator::SEED_SIZE> seed;
+  std::generate(seed.begin(), seed.end(), [&rng] { return static_cast<u32>(rng()); });
+
+  LaggedFibonacciGenerator lfg;
+  lfg.SetSeed(seed.data());
+  std::vector<u8> junk(JUNK_SIZE);
+  lfg.GetBytes(junk.size(), junk.data());
+  return junk;
+}
+}  // namespace
+
+TEST(LaggedFibonacciGenerator, SeedReproducesJunk)
+{
+  std::mt19937 rng(0);
+  for (int i = 0; i < 50; i++)
+  {
+    const std::vector<u8> junk = GenerateJunk(rng);
+    // Also start in later rounds of the generator, and in the middle of a round
+    const size_t offset = rng() % (JUNK_SIZE / 2) / 4 * 4;
+    const size_t size = JUNK_SIZE - offset;
+
+    std::array<u32, LaggedFibonacciGenerator::SEED_SIZE> seed;
+    ASSERT_EQ(size, LaggedFibonacciGenerator::GetSeed(junk.data() + offset, size, offset,
+                                                      seed.data()))
+        << "offset " << offset;
+
+    LaggedFibonacciGenerator lfg;
+    lfg.SetSeed(seed.data());
+    lfg.Forward(offset);
+    std::vector<u8> regenerated(size);
+    lfg.GetBytes(regenerated.size(), regenerated.data());
+    EXPECT_TRUE(std::equal(regenerated.begin(), regenerated.end(), junk.begin() + offset))
+        << "offset " << offset;
+  }
+}
+
+TEST(LaggedFibonacciGenerator, JunkEndsAtFirstDifferentByte)
+{
+  std::mt19937 rng(1);
+  std::vector<u8> data = GenerateJunk(rng);
+  data[0x5123] ^= 0xFF;
+
+  std::array<u32, LaggedFibonacciGenerator::SEED_SIZE> seed;
+  EXPECT_EQ(0x5123u - 0x100, LaggedFibonacciGenerator::GetSeed(
+                                 data.data() + 0x100, data.size() - 0x100, 0x100, seed.data()));
+}
+
+TEST(LaggedFibonacciGenerator, OtherDataIsRejected)
+{
+  std::mt19937 rng(2);
+  std::vector<u8> data(JUNK_SIZE);
+  std::generate(data.begin(), data.end(), [&rng] { return static_cast<u8>(rng()); });
+
+  std::array<u32, LaggedFibonacciGenerator::SEED_SIZE> seed;
+  for (size_t offset = 0; offset < 0x1000; offset += 4)
+  {
+    EXPECT_EQ(0u, LaggedFibonacciGenerator::GetSeed(data.data() + offset, data.size() - offset,
+                                                    offset, seed.data()));
+  }
+
+  // Junk that is shorter than the generator state can't be told apart from other data
+  const std::vector<u8> junk = GenerateJunk(rng);
+  EXPECT_EQ(0u, LaggedFibonacciGenerator::GetSeed(junk.data(), 0x800, 0, seed.data()));
+}
@@ -0,0 +1,134 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/Rasterizer.h"
+#include "VideoCommon/BPMemory.h"
+
+namespace
+{
+void ClearEfb()
+{
+  std::memset(EfbInterface::GetPixelPointer(0, 0, false), 0, EFB_WIDTH * EFB_HEIGHT * 3);
+  std::memset(EfbInterface::GetPixelPointer(0, 0, true), 0, EFB_WIDTH * EFB_HEIGHT * 3);
+}
+
+u64 HashEfb()
+{
+  u64 hash = 0xCBF29CE484222325;
+  for (u16 y = 0; y < EFB_HEIGHT; y++)
+  {
+    for (u16 x = 0; x < EFB_WIDTH; x++)
+    {
+      hash = (hash ^ EfbInterface::GetColor(x, y)) * 0x100000001B3;
+      hash = (hash ^ EfbInterface::GetDepth(x, y)) * 0x100000001B3;
+    }
+  }
+  return hash;
+}
+
+// Draws the same random triangles each time, which overlap each other and many tile edges.
+// Color and alpha updates are switched between batches, so that pixels are also partially
+// written.
+u64 DrawTriangles(u32 num_threads)
+{
+  Rasterizer::Init(num_threads);
+  ClearEfb();
+
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> position(-50.0f, EFB_WIDTH + 50.0f);
+  std::uniform_real_distribution<float> offset(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> depth(0.0f, 16777215.0f);
+  std::uniform_real_distribution<float> w(0.5f, 2.0f);
+  std::uniform_int_distribution<int> color(0, 255);
+
+  for (int batch = 0; batch < 30; batch++)
+  {
+    bpmem.blendmode.colorupdate = batch % 3 != 2;
+    bpmem.blendmode.alphaupdate = batch % 3 != 1;
+
+    for (int triangle = 0; triangle < 50; triangle++)
+    {
+      OutputVertexData vertices[3];
+      const float x = position(rng);
+      const float y = position(rng);
+      for (OutputVertexData& vertex : vertices)
+      {
+        vertex.screenPosition = Vec3(x + offset(rng), y + offset(rng), depth(rng));
+        vertex.projectedPosition.w = w(rng);
+        for (auto& channel : vertex.color)
+        {
+          for (u8& component : channel)
+            component = static_cast<u8>(color(rng));
+        }
+      }
+      Rasterizer::DrawTriangleFrontFace(&vertices[0], &vertices[1], &vertices[2]);
+    }
+    Rasterizer::DrawBinnedTriangles();
+  }
+
+  Rasterizer::Shutdown();
+  return HashEfb();
+}
+}  // namespace
+
+class SWRasterizerTest : public testing::TestWithParam<PEControl::PixelFormat>
+{
+protected:
+  void SetUp() override
+  {
+    std::memset(&bpmem, 0, sizeof(bpmem));
+    bpmem.zcontrol.pixel_format = GetParam();
+
+    // A single stage that passes the rasterized color through.
+    bpmem.genMode.numcolchans = 1;
+    bpmem.tevorders[0].colorchan0 = 0;
+    bpmem.combiners[0].colorC.a = TEVCOLORARG_ZERO;
+    bpmem.combiners[0].colorC.b = TEVCOLORARG_ZERO;
+    bpmem.combiners[0].colorC.c = TEVCOLORARG_ZERO;
+    bpmem.combiners[0].colorC.d = TEVCOLORARG_RASC;
+    bpmem.combiners[0].alphaC.a = TEVALPHAARG_ZERO;
+    bpmem.combiners[0].alphaC.b = TEVALPHAARG_ZERO;
+    bpmem.combiners[0].alphaC.c = TEVALPHAARG_ZERO;
+    bpmem.combiners[0].alphaC.d = TEVALPHAARG_RASA;
+
+    bpmem.alpha_test.comp0 = AlphaTest::ALWAYS;
+    bpmem.alpha_test.comp1 = AlphaTest::ALWAYS;
+    bpmem.zmode.testenable = 1;
+    bpmem.zmode.func = ZMode::GEQUAL;
+    bpmem.zmode.updateenable = 1;
+    bpmem.blendmode.blendenable = 1;
+    bpmem.blendmode.srcfactor = BlendMode::SRCALPHA;
+    bpmem.blendmode.dstfactor = BlendMode::INVSRCALPHA;
+
+    // The whole EFB.
+    bpmem.scissorOffset.x = 171;
+    bpmem.scissorOffset.y = 171;
+    bpmem.scissorTL.x = 342;
+    bpmem.scissorTL.y = 342;
+    bpmem.scissorBR.x = 342 + EFB_WIDTH - 1;
+    bpmem.scissorBR.y = 342 + EFB_HEIGHT - 1;
+  }
+};
+
+TEST_P(SWRasterizerTest, ThreadsDrawLikeOneThread)
+{
+  ClearEfb();
+  const u64 empty_hash = HashEfb();
+
+  const u64 single_threaded_hash = DrawTriangles(1);
+  ASSERT_NE(empty_hash, single_threaded_hash);
+  EXPECT_EQ(single_threaded_hash, DrawTriangles(4));
+}
+
+INSTANTIATE_TEST_CASE_P(PixelFormats, SWRasterizerTest,
+                        testing::Values(PEControl::RGB8_Z24, PEControl::RGBA6_Z24,
+                                        PEControl::Z24));
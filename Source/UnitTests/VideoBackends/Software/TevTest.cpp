@@ -0,0 +1,482 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <random>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/Tev.h"
+#ifdef _M_X86_64
+// gtest's TEST macro conflicts with the TEST method of the x64 emitter. Only TEST_F is used here.
+#undef TEST
+#include "VideoBackends/Software/TevJit.h"
+#endif
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/PixelShaderManager.h"
+
+namespace
+{
+enum
+{
+  ALP_C = Tev::ALP_C,
+  BLU_C = Tev::BLU_C,
+  GRN_C = Tev::GRN_C,
+  RED_C = Tev::RED_C
+};
+
+constexpr s16 BIAS_LUT[4] = {0, 128, -128, 0};
+constexpr u8 SCALE_LSHIFT_LUT[4] = {0, 1, 2, 0};
+constexpr u8 SCALE_RSHIFT_LUT[4] = {0, 0, 0, 1};
+
+// The TEV combiners as they were when one pixel was drawn at a time, for stages that don't
+// sample textures.
+class ReferenceTev
+{
+public:
+  ReferenceTev(const s16 (&konst)[4][4], const u8 (&color)[2][4]) : m_konst(konst), m_color(color)
+  {
+  }
+
+  // Returns the color that ends up in an RGB8 EFB.
+  u32 Draw()
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      m_reg[i][RED_C] = PixelShaderManager::constants.colors[i][0];
+      m_reg[i][GRN_C] = PixelShaderManager::constants.colors[i][1];
+      m_reg[i][BLU_C] = PixelShaderManager::constants.colors[i][2];
+      m_reg[i][ALP_C] = PixelShaderManager::constants.colors[i][3];
+    }
+
+    for (u32 stage = 0; stage <= bpmem.genMode.numtevstages; stage++)
+      DrawStage(stage);
+
+    const s16* color = m_reg[bpmem.combiners[bpmem.genMode.numtevstages].colorC.dest];
+    return static_cast<u8>(color[RED_C]) << 24 | static_cast<u8>(color[GRN_C]) << 16 |
+           static_cast<u8>(color[BLU_C]) << 8 | 0xFF;
+  }
+
+private:
+  struct Input
+  {
+    u32 a, b, c;
+    s32 d;
+  };
+
+  s16 Konst(u32 sel, int comp) const
+  {
+    constexpr s16 fixed[8] = {255, 223, 191, 159, 128, 96, 64, 32};
+    constexpr int components[4] = {RED_C, GRN_C, BLU_C, ALP_C};
+    if (sel < 8)
+      return fixed[sel];
+    if (sel >= 16)
+      return m_konst[(sel - 16) % 4][components[(sel - 16) / 4]];
+    if (sel >= 12 && comp != ALP_C)
+      return m_konst[sel - 12][comp];
+    return 0;
+  }
+
+  s16 ColorInput(u32 arg, int comp) const
+  {
+    if (arg < 8)
+      return m_reg[arg / 2][arg % 2 ? ALP_C : comp];
+
+    switch (arg)
+    {
+    case TEVCOLORARG_RASC:
+      return m_ras[comp];
+    case TEVCOLORARG_RASA:
+      return m_ras[ALP_C];
+    case TEVCOLORARG_ONE:
+      return 255;
+    case TEVCOLORARG_HALF:
+      return 128;
+    case TEVCOLORARG_KONST:
+      return m_stage_konst[comp];
+    default:
+      return 0;
+    }
+  }
+
+  s16 AlphaInput(u32 arg) const
+  {
+    if (arg < 4)
+      return m_reg[arg][ALP_C];
+
+    switch (arg)
+    {
+    case TEVALPHAARG_RASA:
+      return m_ras[ALP_C];
+    case TEVALPHAARG_KONST:
+      return m_stage_konst[ALP_C];
+    default:
+      return 0;
+    }
+  }
+
+  // a, b and c are 8 bits, and d is 11 bits and signed.
+  static Input MakeInput(s16 a, s16 b, s16 c, s16 d)
+  {
+    return {static_cast<u32>(a & 0xFF), static_cast<u32>(b & 0xFF), static_cast<u32>(c & 0xFF),
+            static_cast<s32>(static_cast<u32>(d) << 21) >> 21};
+  }
+
+  static bool Compare(u32 shift, u32 op, const Input (&in)[4], int comp)
+  {
+    const u32 a16 = in[GRN_C].a << 8 | in[RED_C].a;
+    const u32 b16 = in[GRN_C].b << 8 | in[RED_C].b;
+    const u32 a24 = in[BLU_C].a << 16 | a16;
+    const u32 b24 = in[BLU_C].b << 16 | b16;
+
+    switch (shift << 1 | op | 8)
+    {
+    case TEVCMP_R8_GT:
+      return in[RED_C].a > in[RED_C].b;
+    case TEVCMP_R8_EQ:
+      return in[RED_C].a == in[RED_C].b;
+    case TEVCMP_GR16_GT:
+      return a16 > b16;
+    case TEVCMP_GR16_EQ:
+      return a16 == b16;
+    case TEVCMP_BGR24_GT:
+      return a24 > b24;
+    case TEVCMP_BGR24_EQ:
+      return a24 == b24;
+    case TEVCMP_RGB8_GT:
+      return in[comp].a > in[comp].b;
+    default:
+      return in[comp].a == in[comp].b;
+    }
+  }
+
+  static s32 Lerp(const Input& in, u32 shift, s32 round)
+  {
+    const u32 c = in.c + (in.c >> 7);
+    return (static_cast<s32>(in.a * (256 - c) + in.b * c) << SCALE_LSHIFT_LUT[shift]) + round;
+  }
+
+  void SetRasColor(u32 stage, u32 swap)
+  {
+    const u32 channel = bpmem.tevorders[stage / 2].getColorChan(stage & 1);
+    if (channel > 1)
+    {
+      // The alpha bump is zero without indirect stages.
+      std::fill(std::begin(m_ras), std::end(m_ras), 0);
+      return;
+    }
+
+    const u8* color = m_color[channel];
+    m_ras[RED_C] = color[bpmem.tevksel[swap].swap1];
+    m_ras[GRN_C] = color[bpmem.tevksel[swap].swap2];
+    m_ras[BLU_C] = color[bpmem.tevksel[swap + 1].swap1];
+    m_ras[ALP_C] = color[bpmem.tevksel[swap + 1].swap2];
+  }
+
+  void DrawStage(u32 stage)
+  {
+    const TevKSel& ksel = bpmem.tevksel[stage / 2];
+    const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stage].colorC;
+    const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stage].alphaC;
+
+    for (int comp = 0; comp < 4; comp++)
+    {
+      m_stage_konst[comp] =
+          Konst(comp == ALP_C ? ksel.getKA(stage & 1) : ksel.getKC(stage & 1), comp);
+    }
+    SetRasColor(stage, ac.rswap * 2);
+
+    Input in[4];
+    for (int comp = BLU_C; comp <= RED_C; comp++)
+    {
+      in[comp] = MakeInput(ColorInput(cc.a, comp), ColorInput(cc.b, comp), ColorInput(cc.c, comp),
+                           ColorInput(cc.d, comp));
+    }
+    in[ALP_C] = MakeInput(AlphaInput(ac.a), AlphaInput(ac.b), AlphaInput(ac.c), AlphaInput(ac.d));
+
+    for (int comp = BLU_C; comp <= RED_C; comp++)
+    {
+      s16 result;
+      if (cc.bias == TEVBIAS_COMPARE)
+      {
+        result = in[comp].d + (Compare(cc.shift, cc.op, in, comp) ? in[comp].c : 0);
+      }
+      else
+      {
+        s32 temp = Lerp(in[comp], cc.shift, cc.shift == 3 ? 0 : cc.op ? 127 : 128) >> 8;
+        temp = cc.op ? -temp : temp;
+        result = (((in[comp].d + BIAS_LUT[cc.bias]) << SCALE_LSHIFT_LUT[cc.shift]) + temp) >>
+                 SCALE_RSHIFT_LUT[cc.shift];
+      }
+      m_reg[cc.dest][comp] = cc.clamp ? std::clamp<s16>(result, 0, 255) :
+                                        std::clamp<s16>(result, -1024, 1023);
+    }
+
+    s16 result;
+    if (ac.bias == TEVBIAS_COMPARE)
+    {
+      result = in[ALP_C].d + (Compare(ac.shift, ac.op, in, ALP_C) ? in[ALP_C].c : 0);
+    }
+    else
+    {
+      const s32 lerp = Lerp(in[ALP_C], ac.shift, ac.shift != 3 ? 0 : ac.op ? 127 : 128);
+      const s32 temp = ac.op ? (-lerp >> 8) : (lerp >> 8);
+      result = (((in[ALP_C].d + BIAS_LUT[ac.bias]) << SCALE_LSHIFT_LUT[ac.shift]) + temp) >>
+               SCALE_RSHIFT_LUT[ac.shift];
+    }
+    m_reg[ac.dest][ALP_C] =
+        ac.clamp ? std::clamp<s16>(result, 0, 255) : std::clamp<s16>(result, -1024, 1023);
+  }
+
+  const s16 (&m_konst)[4][4];
+  const u8 (&m_color)[2][4];
+  s16 m_reg[4][4];
+  s16 m_ras[4];
+  s16 m_stage_konst[4];
+};
+
+// Random combiners for up to 15 stages, which only use inputs that don't need textures.
+void RandomizeCombiners(std::mt19937& rng)
+{
+  constexpr u32 color_args[] = {
+      TEVCOLORARG_CPREV, TEVCOLORARG_APREV, TEVCOLORARG_C0,   TEVCOLORARG_A0,
+      TEVCOLORARG_C1,    TEVCOLORARG_A1,    TEVCOLORARG_C2,   TEVCOLORARG_A2,
+      TEVCOLORARG_RASC,  TEVCOLORARG_RASA,  TEVCOLORARG_ONE,  TEVCOLORARG_HALF,
+      TEVCOLORARG_KONST, TEVCOLORARG_ZERO};
+  constexpr u32 alpha_args[] = {TEVALPHAARG_APREV, TEVALPHAARG_A0,   TEVALPHAARG_A1,
+                                TEVALPHAARG_A2,    TEVALPHAARG_RASA, TEVALPHAARG_KONST,
+                                TEVALPHAARG_ZERO};
+  const auto color_arg = [&] { return color_args[rng() % std::size(color_args)]; };
+  const auto alpha_arg = [&] { return alpha_args[rng() % std::size(alpha_args)]; };
+
+  bpmem.genMode.numtevstages = rng() % 15;
+  for (u32 stage = 0; stage <= bpmem.genMode.numtevstages; stage++)
+  {
+    TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stage].colorC;
+    cc.hex = 0;
+    cc.a = color_arg();
+    cc.b = color_arg();
+    cc.c = color_arg();
+    cc.d = color_arg();
+    cc.bias = rng() % 4;
+    cc.op = rng() % 2;
+    cc.clamp = rng() % 2;
+    cc.shift = rng() % 4;
+    cc.dest = rng() % 4;
+
+    TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stage].alphaC;
+    ac.hex = 0;
+    ac.a = alpha_arg();
+    ac.b = alpha_arg();
+    ac.c = alpha_arg();
+    ac.d = alpha_arg();
+    ac.bias = rng() % 4;
+    ac.op = rng() % 2;
+    ac.clamp = rng() % 2;
+    ac.shift = rng() % 4;
+    ac.dest = rng() % 4;
+    ac.rswap = rng() % 4;
+
+    // Lerping between two zero inputs is common, and only leaves the rounding.
+    if (rng() % 4 == 0)
+      cc.a = cc.b = TEVCOLORARG_ZERO;
+    if (rng() % 4 == 0)
+      ac.a = ac.b = TEVALPHAARG_ZERO;
+  }
+
+  for (int i = 0; i < 8; i++)
+  {
+    TevKSel& ksel = bpmem.tevksel[i];
+    ksel.swap1 = rng() % 4;
+    ksel.swap2 = rng() % 4;
+    ksel.kcsel0 = rng() % 32;
+    ksel.kasel0 = rng() % 32;
+    ksel.kcsel1 = rng() % 32;
+    ksel.kasel1 = rng() % 32;
+
+    TwoTevStageOrders& order = bpmem.tevorders[i];
+    order.hex = 0;
+    order.colorchan0 = rng() % 8;
+    order.colorchan1 = rng() % 8;
+  }
+}
+
+// Adds a stage that outputs the alpha of the last stage as the color, so that it can be
+// read back from an RGB8 EFB.
+void AppendAlphaOutputStage()
+{
+  const u32 alpha_dest = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
+  const u32 stage = bpmem.genMode.numtevstages + 1;
+  bpmem.genMode.numtevstages = stage;
+
+  TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stage].colorC;
+  cc.hex = 0;
+  cc.a = TEVCOLORARG_ZERO;
+  cc.b = TEVCOLORARG_ZERO;
+  cc.c = TEVCOLORARG_ZERO;
+  cc.d = TEVCOLORARG_APREV + alpha_dest * 2;
+
+  TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stage].alphaC;
+  ac.hex = 0;
+  ac.a = TEVALPHAARG_ZERO;
+  ac.b = TEVALPHAARG_ZERO;
+  ac.c = TEVALPHAARG_ZERO;
+  ac.d = TEVALPHAARG_ZERO;
+}
+}  // namespace
+
+class SWTevTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    std::memset(&bpmem, 0, sizeof(bpmem));
+    bpmem.zcontrol.pixel_format = PEControl::RGB8_Z24;
+    bpmem.alpha_test.comp0 = AlphaTest::ALWAYS;
+    bpmem.alpha_test.comp1 = AlphaTest::ALWAYS;
+    bpmem.blendmode.colorupdate = 1;
+
+    m_tev.Init();
+    for (s32 lane = 0; lane < Tev::NUM_LANES; lane++)
+    {
+      m_tev.Position[lane][0] = lane % 2;
+      m_tev.Position[lane][1] = lane / 2;
+      m_tev.Position[lane][2] = 0;
+    }
+  }
+
+  // Sets random inputs for all lanes and random values for the TEV registers.
+  void RandomizeInputs(std::mt19937& rng)
+  {
+    std::uniform_int_distribution<int> reg_value(-1024, 1023);
+    for (int reg = 0; reg < 4; reg++)
+    {
+      for (int comp = 0; comp < 4; comp++)
+      {
+        PixelShaderManager::constants.colors[reg][comp] = reg_value(rng);
+        m_konst[reg][comp] = static_cast<s16>(reg_value(rng));
+        m_tev.SetRegColor(reg, comp, m_konst[reg][comp]);
+      }
+    }
+
+    for (auto& lane : m_colors)
+    {
+      for (auto& channel : lane)
+      {
+        for (u8& component : channel)
+          component = static_cast<u8>(rng());
+      }
+    }
+    std::memcpy(m_tev.Color, m_colors, sizeof(m_colors));
+  }
+
+  // Draws the lanes in mask over a cleared EFB and checks every pixel of the block.
+  void DrawAndCheck(u32 mask)
+  {
+    constexpr u32 CLEARED = 0x123456FF;
+    for (s32 lane = 0; lane < Tev::NUM_LANES; lane++)
+    {
+      u8 cleared[4] = {0xFF, 0x56, 0x34, 0x12};
+      EfbInterface::SetColor(m_tev.Position[lane][0], m_tev.Position[lane][1], cleared);
+    }
+
+    m_tev.Draw(mask);
+
+    for (s32 lane = 0; lane < Tev::NUM_LANES; lane++)
+    {
+      const u32 expected =
+          (mask & (1 << lane)) ? ReferenceTev(m_konst, m_colors[lane]).Draw() : CLEARED;
+      const u32 color = EfbInterface::GetColor(m_tev.Position[lane][0], m_tev.Position[lane][1]);
+      ASSERT_EQ(expected, color) << "lane " << lane << ", " << bpmem.genMode.numtevstages + 1
+                                 << " stages";
+    }
+  }
+
+  // Draws a 2x2 block for each of a fixed series of random configurations, and hashes the EFB
+  // area they cover.
+  u64 DrawBlocks(const std::function<Tev::CombinerFunction(const Tev&)>& get_combiners)
+  {
+    std::mt19937 rng(2);
+    for (int block = 0; block < NUM_BLOCKS; block++)
+    {
+      RandomizeCombiners(rng);
+      // Leave most configurations without compare stages, which aren't compiled.
+      if (block % 4 != 0)
+      {
+        for (TevStageCombiner& combiner : bpmem.combiners)
+        {
+          if (combiner.colorC.bias == TEVBIAS_COMPARE)
+            combiner.colorC.bias = TEVBIAS_ZERO;
+          if (combiner.alphaC.bias == TEVBIAS_COMPARE)
+            combiner.alphaC.bias = TEVBIAS_ZERO;
+        }
+      }
+      if (block % 2 != 0)
+        AppendAlphaOutputStage();
+      RandomizeInputs(rng);
+
+      for (s32 lane = 0; lane < Tev::NUM_LANES; lane++)
+      {
+        m_tev.Position[lane][0] = block % BLOCKS_PER_ROW * 2 + lane % 2;
+        m_tev.Position[lane][1] = block / BLOCKS_PER_ROW * 2 + lane / 2;
+      }
+      m_tev.SetCombiners(get_combiners(m_tev));
+      m_tev.Draw(rng() % 15 + 1);
+    }
+    m_tev.SetCombiners(nullptr);
+
+    u64 hash = 0xCBF29CE484222325;
+    for (u16 y = 0; y < NUM_BLOCKS / BLOCKS_PER_ROW * 2; y++)
+    {
+      for (u16 x = 0; x < BLOCKS_PER_ROW * 2; x++)
+        hash = (hash ^ EfbInterface::GetColor(x, y)) * 0x100000001B3;
+    }
+    return hash;
+  }
+
+  static constexpr int NUM_BLOCKS = 8192;
+  static constexpr int BLOCKS_PER_ROW = 128;
+
+  Tev m_tev;
+  s16 m_konst[4][4];
+  u8 m_colors[Tev::NUM_LANES][2][4];
+};
+
+TEST_F(SWTevTest, LanesMatchScalarCombiners)
+{
+  std::mt19937 rng(1);
+  for (int i = 0; i < 3000; i++)
+  {
+    RandomizeCombiners(rng);
+    RandomizeInputs(rng);
+    const u32 mask = rng() % 15 + 1;
+
+    DrawAndCheck(mask);
+    AppendAlphaOutputStage();
+    DrawAndCheck(mask);
+  }
+}
+
+#ifdef _M_X86_64
+TEST_F(SWTevTest, JitMatchesInterpreter)
+{
+  const u64 interpreted_hash = DrawBlocks([](const Tev&) { return nullptr; });
+
+  TevJit jit;
+  int num_compiled = 0;
+  const u64 compiled_hash = DrawBlocks([&](const Tev& tev) {
+    const Tev::CombinerFunction combiners = jit.GetCombiners(tev);
+    num_compiled += combiners != nullptr;
+    return combiners;
+  });
+
+  ASSERT_GT(num_compiled, NUM_BLOCKS / 2);
+  EXPECT_EQ(interpreted_hash, compiled_hash);
+}
+#endif
@@ -0,0 +1,233 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+#include "VideoBackends/Software/TextureSampler.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/TextureDecoder.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace
+{
+constexpr u32 TEXTURE_LINE = 0;
+// Far enough from the even half that the largest RGBA8 texture with its mip levels fits.
+constexpr u32 TEXTURE_ODD_LINE = 256 * 1024 / TMEM_LINE_SIZE;
+constexpr u32 TLUT_OFFSET = 1000;
+
+void WrapCoord(int* coord, int wrap_mode, int image_size)
+{
+  switch (wrap_mode)
+  {
+  case 0:  // clamp
+    *coord = std::clamp(*coord, 0, image_size);
+    break;
+  case 1:  // wrap
+    *coord %= image_size + 1;
+    *coord = *coord < 0 ? image_size + *coord : *coord;
+    break;
+  case 2:  // mirror
+  {
+    const int div = *coord / (image_size + 1);
+    *coord -= div * (image_size + 1);
+    *coord = *coord < 0 ? -*coord : *coord;
+    *coord = (div & 1) ? image_size - *coord : *coord;
+    break;
+  }
+  }
+}
+
+// Samples a texture in TMEM by decoding each texel it reads, like the sampler did before it
+// started decoding whole levels.
+void ReferenceSampleMip(s32 s, s32 t, s32 mip, bool linear, u8* sample)
+{
+  const TexMode0& tm0 = bpmem.tex[0].texMode0[0];
+  const TexImage0& ti0 = bpmem.tex[0].texImage0[0];
+  const TextureFormat format = static_cast<TextureFormat>(ti0.format);
+  const TLUTFormat tlut_format = static_cast<TLUTFormat>(bpmem.tex[0].texTlut[0].tlut_format);
+  const u8* tlut = &texMem[bpmem.tex[0].texTlut[0].tmem_offset << 9];
+  const u8* src = &texMem[bpmem.tex[0].texImage1[0].tmem_even * TMEM_LINE_SIZE];
+  const u8* src_odd = &texMem[bpmem.tex[0].texImage2[0].tmem_odd * TMEM_LINE_SIZE];
+
+  int width = ti0.width;
+  int height = ti0.height;
+  if (mip)
+  {
+    int mip_width = width + 1;
+    int mip_height = height + 1;
+    width >>= mip;
+    height >>= mip;
+    s >>= mip;
+    t >>= mip;
+    for (int i = 0; i < mip; i++)
+    {
+      mip_width = std::max(mip_width, TexDecoder_GetBlockWidthInTexels(format));
+      mip_height = std::max(mip_height, TexDecoder_GetBlockHeightInTexels(format));
+      src += (mip_width * mip_height * TexDecoder_GetTexelSizeInNibbles(format)) >> 1;
+      mip_width >>= 1;
+      mip_height >>= 1;
+    }
+  }
+
+  const auto decode = [&](int image_s, int image_t, u8* texel) {
+    WrapCoord(&image_s, tm0.wrap_s, width);
+    WrapCoord(&image_t, tm0.wrap_t, height);
+    if (format == TextureFormat::RGBA8)
+      TexDecoder_DecodeTexelRGBA8FromTmem(texel, src, src_odd, image_s, image_t, width);
+    else
+      TexDecoder_DecodeTexel(texel, src, image_s, image_t, width, format, tlut, tlut_format);
+  };
+
+  if (!linear)
+  {
+    decode(s >> 7, t >> 7, sample);
+    return;
+  }
+
+  s -= 64;
+  t -= 64;
+  const int image_s = s >> 7;
+  const int image_t = t >> 7;
+  const u32 fract_s = s & 0x7f;
+  const u32 fract_t = t & 0x7f;
+  const u32 weights[4] = {(128 - fract_s) * (128 - fract_t), fract_s * (128 - fract_t),
+                          (128 - fract_s) * fract_t, fract_s * fract_t};
+
+  u32 sum[4] = {};
+  for (int i = 0; i < 4; i++)
+  {
+    u8 texel[4];
+    decode(image_s + (i & 1), image_t + (i >> 1), texel);
+    for (int comp = 0; comp < 4; comp++)
+      sum[comp] += texel[comp] * weights[i];
+  }
+  for (int comp = 0; comp < 4; comp++)
+    sample[comp] = static_cast<u8>(sum[comp] >> 14);
+}
+
+void SetTexture(TextureFormat format, TLUTFormat tlut_format, int width, int height)
+{
+  bpmem.tex[0].texImage0[0].width = width - 1;
+  bpmem.tex[0].texImage0[0].height = height - 1;
+  bpmem.tex[0].texImage0[0].format = static_cast<u32>(format);
+  bpmem.tex[0].texImage1[0].tmem_even = TEXTURE_LINE;
+  bpmem.tex[0].texImage1[0].image_type = 1;
+  bpmem.tex[0].texImage2[0].tmem_odd = TEXTURE_ODD_LINE;
+  bpmem.tex[0].texTlut[0].tmem_offset = TLUT_OFFSET;
+  bpmem.tex[0].texTlut[0].tlut_format = static_cast<u32>(tlut_format);
+  TextureSampler::InvalidateBindings();
+}
+}  // namespace
+
+class SWTextureSamplerTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Usually done by the texture cache, which isn't needed here.
+    Common::SetHash64Function();
+
+    std::memset(&bpmem, 0, sizeof(bpmem));
+    g_ActiveConfig.bTexFmtOverlayEnable = false;
+    g_ActiveConfig.bTexFmtOverlayCenter = false;
+    TexDecoder_SetTexFmtOverlayOptions(false, false);
+  }
+
+  void TearDown() override
+  {
+    g_ActiveConfig.bTexFmtOverlayEnable = false;
+    TexDecoder_SetTexFmtOverlayOptions(false, false);
+    TextureSampler::Shutdown();
+  }
+};
+
+class SWTextureSamplerFormatTest : public SWTextureSamplerTest,
+                                   public testing::WithParamInterface<TextureFormat>
+{
+};
+
+TEST_P(SWTextureSamplerFormatTest, SamplesMatchPerTexelDecoding)
+{
+  std::mt19937 rng(static_cast<u32>(GetParam()));
+  std::generate(std::begin(texMem), std::end(texMem), [&rng] { return static_cast<u8>(rng()); });
+
+  for (int i = 0; i < 40; i++)
+  {
+    const int width = rng() % 128 + 1;
+    const int height = rng() % 128 + 1;
+    SetTexture(GetParam(), static_cast<TLUTFormat>(rng() % 3), width, height);
+    TexMode0& tm0 = bpmem.tex[0].texMode0[0];
+    tm0.wrap_s = rng() % 3;
+    tm0.wrap_t = rng() % 3;
+
+    // Also change the texture in place, which must not be missed by the cache.
+    if (i % 8 == 7)
+      texMem[rng() % 1024] ^= 0xFF;
+
+    std::uniform_int_distribution<s32> s_coord(-2 * width * 128, 3 * width * 128);
+    std::uniform_int_distribution<s32> t_coord(-2 * height * 128, 3 * height * 128);
+    for (int j = 0; j < 1000; j++)
+    {
+      const s32 s = s_coord(rng);
+      const s32 t = t_coord(rng);
+      const s32 mip = rng() % 4;
+      const bool linear = rng() % 2;
+
+      u8 expected[4];
+      u8 sample[4];
+      ReferenceSampleMip(s, t, mip, linear, expected);
+      TextureSampler::SampleMip(s, t, mip, linear, 0, sample);
+      ASSERT_EQ(0, std::memcmp(expected, sample, sizeof(sample)))
+          << width << "x" << height << " mip " << mip << " at " << s << ", " << t
+          << (linear ? " linear" : " nearest");
+    }
+  }
+}
+
+TEST_F(SWTextureSamplerTest, OverlayOptionsAreNotCached)
+{
+  std::memset(texMem, 0, sizeof(texMem));
+  SetTexture(TextureFormat::I8, TLUTFormat::IA8, 64, 64);
+
+  const auto hash_texels = [] {
+    u64 hash = 0xCBF29CE484222325;
+    for (s32 t = 0; t < 64; t++)
+    {
+      for (s32 s = 0; s < 64; s++)
+      {
+        u8 sample[4];
+        TextureSampler::SampleMip(s << 7, t << 7, 0, false, 0, sample);
+        u32 value;
+        std::memcpy(&value, sample, sizeof(value));
+        hash = (hash ^ value) * 0x100000001B3;
+      }
+    }
+    return hash;
+  };
+
+  const u64 plain_hash = hash_texels();
+
+  g_ActiveConfig.bTexFmtOverlayEnable = true;
+  TexDecoder_SetTexFmtOverlayOptions(true, false);
+  TextureSampler::InvalidateBindings();
+  EXPECT_NE(plain_hash, hash_texels());
+
+  g_ActiveConfig.bTexFmtOverlayEnable = false;
+  TexDecoder_SetTexFmtOverlayOptions(false, false);
+  TextureSampler::InvalidateBindings();
+  EXPECT_EQ(plain_hash, hash_texels());
+}
+
+INSTANTIATE_TEST_CASE_P(Formats, SWTextureSamplerFormatTest,
+                        testing::Values(TextureFormat::I4, TextureFormat::I8, TextureFormat::IA4,
+                                        TextureFormat::IA8, TextureFormat::RGB565,
+                                        TextureFormat::RGB5A3, TextureFormat::RGBA8,
+                                        TextureFormat::C4, TextureFormat::C8,
+                                        TextureFormat::C14X2, TextureFormat::CMPR));
@@ -0,0 +1,162 @@
+// Copyright 2018 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/TransformUnit.h"
+#include "VideoCommon/XFMemory.h"
+
+namespace
+{
+bool IsSameVertex(const OutputVertexData& a, const OutputVertexData& b)
+{
+  return std::memcmp(&a.mvPosition, &b.mvPosition, sizeof(a.mvPosition)) == 0 &&
+         std::memcmp(&a.projectedPosition, &b.projectedPosition, sizeof(a.projectedPosition)) ==
+             0 &&
+         std::memcmp(&a.normal, &b.normal, sizeof(a.normal)) == 0 &&
+         std::memcmp(&a.color, &b.color, sizeof(a.color)) == 0 &&
+         std::memcmp(&a.texCoords, &b.texCoords, sizeof(a.texCoords)) == 0;
+}
+
+// Random matrices, lights and channel setups. Zero attenuation factors and normals are common
+// enough to be worth hitting often, as they take their own paths through the lighting.
+void RandomizeXF(std::mt19937& rng)
+{
+  std::uniform_real_distribution<float> value(-4.0f, 4.0f);
+  const auto maybe_zero = [&] { return rng() % 8 == 0 ? 0.0f : value(rng); };
+
+  for (float& m : xfmem.posMatrices)
+    m = value(rng);
+  for (float& m : xfmem.normalMatrices)
+    m = value(rng);
+  for (float& m : xfmem.postMatrices)
+    m = value(rng);
+  for (float& p : xfmem.projection.rawProjection)
+    p = value(rng);
+  xfmem.projection.type = rng() % 2;
+
+  for (Light& light : xfmem.lights)
+  {
+    const u32 color = rng();
+    std::memcpy(light.color, &color, sizeof(light.color));
+    for (int i = 0; i < 3; i++)
+    {
+      light.cosatt[i] = maybe_zero();
+      light.distatt[i] = maybe_zero();
+      light.dpos[i] = maybe_zero();
+      light.ddir[i] = maybe_zero();
+    }
+  }
+
+  for (int chan = 0; chan < 2; chan++)
+  {
+    xfmem.color[chan].hex = rng();
+    xfmem.alpha[chan].hex = rng();
+    if (rng() % 2)
+    {
+      xfmem.color[chan].enablelighting = 1;
+      xfmem.alpha[chan].enablelighting = 1;
+    }
+    // The reserved diffuse function is invalid.
+    if (xfmem.color[chan].diffusefunc == 3)
+      xfmem.color[chan].diffusefunc = 2;
+    if (xfmem.alpha[chan].diffusefunc == 3)
+      xfmem.alpha[chan].diffusefunc = 1;
+    xfmem.matColor[chan] = rng();
+    xfmem.ambColor[chan] = rng();
+  }
+
+  xfmem.numTexGen.numTexGens = rng() % 3;
+  for (TexMtxInfo& info : xfmem.texMtxInfo)
+  {
+    info.hex = 0;
+    info.projection = rng() % 2;
+    info.inputform = rng() % 2;
+    info.sourcerow = XF_SRCTEX0_INROW + rng() % 2;
+  }
+}
+
+void RandomizeVertex(std::mt19937& rng, InputVertexData* vertex)
+{
+  std::uniform_real_distribution<float> value(-4.0f, 4.0f);
+
+  std::memset(vertex, 0, sizeof(*vertex));
+  vertex->posMtx = rng() % 64;
+  for (u8& mtx : vertex->texMtx)
+    mtx = rng() % 64;
+  vertex->position = Vec3(value(rng), value(rng), value(rng));
+  for (Vec3& normal : vertex->normal)
+  {
+    normal = rng() % 8 == 0 ? Vec3(0.0f, 0.0f, 0.0f) :
+                              Vec3(value(rng), value(rng), value(rng));
+  }
+  for (auto& color : vertex->color)
+  {
+    for (u8& component : color)
+      component = static_cast<u8>(rng());
+  }
+  for (auto& coord : vertex->texCoords)
+  {
+    coord[0] = value(rng);
+    coord[1] = value(rng);
+  }
+}
+}  // namespace
+
+TEST(SWTransformUnit, BatchesMatchSingleVertices)
+{
+  std::mt19937 rng(42);
+  for (int i = 0; i < 3000; i++)
+  {
+    RandomizeXF(rng);
+
+    const bool has_normal = rng() % 4 != 0;
+    const bool nbt = has_normal && rng() % 2;
+    const u32 count = rng() % TransformUnit::BATCH_SIZE + 1;
+    const bool shared_mtx = rng() % 2;
+
+    InputVertexData src[TransformUnit::BATCH_SIZE];
+    for (u32 v = 0; v < count; v++)
+    {
+      RandomizeVertex(rng, &src[v]);
+      if (shared_mtx)
+        src[v].posMtx = 3;
+    }
+
+    // Sometimes put a light right on the first vertex.
+    if (rng() % 8 == 0)
+    {
+      OutputVertexData transformed;
+      TransformUnit::TransformPosition(&src[0], &transformed);
+      Light& light = xfmem.lights[rng() % 8];
+      light.dpos[0] = transformed.mvPosition.x;
+      light.dpos[1] = transformed.mvPosition.y;
+      light.dpos[2] = transformed.mvPosition.z;
+    }
+
+    OutputVertexData expected[TransformUnit::BATCH_SIZE];
+    OutputVertexData batched[TransformUnit::BATCH_SIZE];
+    for (u32 v = 0; v < count; v++)
+    {
+      std::memset(&expected[v], 0, sizeof(expected[v]));
+      TransformUnit::TransformPosition(&src[v], &expected[v]);
+      if (has_normal)
+        TransformUnit::TransformNormal(&src[v], nbt, &expected[v]);
+      TransformUnit::TransformColor(&src[v], &expected[v]);
+      TransformUnit::TransformTexCoord(&src[v], &expected[v], false);
+    }
+    TransformUnit::TransformVertices(src, batched, count, has_normal, nbt, false);
+
+    for (u32 v = 0; v < count; v++)
+    {
+      EXPECT_TRUE(IsSameVertex(expected[v], batched[v]))
+          << "configuration " << i << ", vertex " << v << " of " << count;
+    }
+  }
+}